@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -117,6 +117,13 @@ enum UserInterfaceNotification
    notifyPlayerHit,
    notifyPlayerDrowning,
    notifyPlayerDead,
+
+   /// notifies that the player moved to another tile or level
+   notifyPlayerTileChanged,
+
+   /// notifies that tiles of the current level were modified, e.g. through
+   /// the debug server
+   notifyTilemapChanged,
 };
 
 /// callback interface
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,23 +21,47 @@
 //
 #include "pch.hpp"
 #include "ArchiveFile.hpp"
+#include "MemoryReader.hpp"
 #include "Uw2decode.hpp"
+#include <algorithm>
+#include <cstring>
 
 using Base::ArchiveFile;
 
+/// size of a single arena chunk; larger blocks get their own chunk
+const size_t c_arenaChunkSize = 0x10000;
+
 ArchiveFile::ArchiveFile(Base::SDL_RWopsPtr rwops, bool uw2Mode)
-   :m_archiveFile(rwops),
+   :m_archiveFile(std::make_shared<Base::MemoryMappedFile>(rwops)),
+   m_arenaChunkFree(0),
    m_uw2Mode(uw2Mode)
 {
-   Uint16 count = m_archiveFile.Read16();
+   ReadHeader();
+}
+
+ArchiveFile::ArchiveFile(std::shared_ptr<const Base::MemoryMappedFile> file, bool uw2Mode)
+   :m_archiveFile(file),
+   m_arenaChunkFree(0),
+   m_uw2Mode(uw2Mode)
+{
+   UaAssert(file != nullptr);
+
+   ReadHeader();
+}
+
+void ArchiveFile::ReadHeader()
+{
+   Base::MemoryReader reader{ Base::ByteSpan(m_archiveFile->GetData(), m_archiveFile->GetSize()) };
+
+   Uint16 count = reader.Read16();
 
    if (m_uw2Mode)
-      m_archiveFile.Read32(); // extra In32 in uw2 mode
+      reader.Read32(); // extra In32 in uw2 mode
 
    m_offsetList.resize(count);
 
    for (size_t index = 0; index < count; index++)
-      m_offsetList[index] = m_archiveFile.Read32();
+      m_offsetList[index] = reader.Read32();
 
    // read in extended tables, in uw2 mode
    if (m_uw2Mode)
@@ -46,17 +70,24 @@ ArchiveFile::ArchiveFile(Base::SDL_RWopsPtr rwops, bool uw2Mode)
 
       for (size_t index = 0; index < count; index++)
       {
-         Uint32 flags = m_archiveFile.Read32();
+         Uint32 flags = reader.Read32();
          //UaAssert((flags & 1) != 0); // flag is always set, except for scd.ark
          m_fileEntryInfoList[index].m_isCompressed = (flags & 2) != 0;
          m_fileEntryInfoList[index].m_allocatedExtraSpace = (flags & 4) != 0;
       }
 
       for (size_t index = 0; index < count; index++)
-         m_fileEntryInfoList[index].m_dataSize = m_archiveFile.Read32();
+         m_fileEntryInfoList[index].m_dataSize = reader.Read32();
 
       for (size_t index = 0; index < count; index++)
-         m_fileEntryInfoList[index].m_availSize = m_archiveFile.Read32();
+         m_fileEntryInfoList[index].m_availSize = reader.Read32();
+
+      m_decodedBlockList.resize(count);
+   }
+   else
+   {
+      m_sortedOffsetList = m_offsetList;
+      std::sort(m_sortedOffsetList.begin(), m_sortedOffsetList.end());
    }
 }
 
@@ -71,22 +102,102 @@ bool ArchiveFile::IsAvailable(size_t index) const
    return m_offsetList[index] != 0 && m_fileEntryInfoList[index].m_dataSize > 0;
 }
 
-/// Returns file from archive; note that this function returns a SDL_RWops
-/// pointer that may depend on the archive file's internal SDL_RWops struct.
-/// Only use one archive file pointer at one time!
-/// \note In uw1 the caller must know how long the file block is in order to
-/// not read beyond the file; usually this is the case with all known formats.
-Base::File ArchiveFile::GetFile(size_t index)
+/// Returns data block from archive. In uw1 the block size isn't stored in the
+/// archive, so the block extends up to the next block or the end of the file;
+/// the caller must know how long the block actually is. In uw2 compressed
+/// blocks are decoded once and then returned from the cache.
+/// \param index block index
+/// \return span with block data; valid as long as the archive file exists
+Base::ByteSpan ArchiveFile::GetBlock(size_t index)
 {
    UaAssert(index < GetNumFiles());
    UaAssert(true == IsAvailable(index));
 
-   m_archiveFile.Seek(m_offsetList[index], Base::seekBegin);
+   Uint32 offset = m_offsetList[index];
 
-   // in uw1 mode, just return file
    if (!m_uw2Mode)
-      return m_archiveFile;
+   {
+      auto iter = std::upper_bound(m_sortedOffsetList.begin(), m_sortedOffsetList.end(), offset);
+
+      size_t size = iter != m_sortedOffsetList.end()
+         ? *iter - offset
+         : m_archiveFile->GetSize() - std::min<size_t>(offset, m_archiveFile->GetSize());
+
+      return m_archiveFile->GetSpan(offset, size);
+   }
+
+   const ArchiveFileEntryInfo& info = m_fileEntryInfoList[index];
+   if (!info.m_isCompressed)
+      return m_archiveFile->GetSpan(offset, info.m_dataSize);
+
+   if (m_decodedBlockList[index].m_data == nullptr)
+      m_decodedBlockList[index] = DecodeBlock(index);
+
+   return m_decodedBlockList[index];
+}
+
+/// Returns file from archive; the file reads from memory owned by the archive
+/// file object, so the file must not be used after the archive file object
+/// was destroyed.
+/// \note In uw1 the caller must know how long the file block is in order to
+/// not read beyond the file; usually this is the case with all known formats.
+Base::File ArchiveFile::GetFile(size_t index)
+{
+   Base::ByteSpan block = GetBlock(index);
+
+   return Base::File(MakeRWopsPtr(SDL_RWFromConstMem(block.m_data, static_cast<int>(block.m_size))));
+}
+
+/// Decodes the block in a single pass into a buffer that is large enough for
+/// any block of the entry's data size, then copies the decoded data to the
+/// arena.
+Base::ByteSpan ArchiveFile::DecodeBlock(size_t index)
+{
+   const ArchiveFileEntryInfo& info = m_fileEntryInfoList[index];
+   UaAssert(info.m_dataSize > 0); // trying to load entry that has size 0?
+
+   Base::ByteSpan source = m_archiveFile->GetSpan(m_offsetList[index], info.m_dataSize);
+
+   Uint32 maxSize = Base::Uw2GetMaxDecodedSize(source);
+   if (m_decodeBuffer.size() < maxSize)
+      m_decodeBuffer.resize(maxSize);
+
+   Uint32 decodedSize = 0;
+   UaVerify(true == Base::Uw2Decode(source, m_decodeBuffer.data(), maxSize, decodedSize));
+
+   Uint8* destBuffer = AllocateArena(decodedSize);
+   if (decodedSize > 0)
+      memcpy(destBuffer, m_decodeBuffer.data(), decodedSize);
+
+   return Base::ByteSpan(destBuffer, decodedSize);
+}
+
+/// Allocates memory from the current arena chunk, or starts a new chunk when
+/// the block doesn't fit anymore. Blocks larger than a chunk get their own
+/// chunk, in order to not waste the remaining space in the current chunk.
+Uint8* ArchiveFile::AllocateArena(size_t size)
+{
+   if (size > c_arenaChunkSize)
+   {
+      std::unique_ptr<Uint8[]> chunk{ new Uint8[size] };
+      Uint8* data = chunk.get();
+
+      // insert before the current chunk, so that its free space stays usable
+      m_arenaChunkList.insert(
+         m_arenaChunkList.empty() ? m_arenaChunkList.end() : m_arenaChunkList.end() - 1,
+         std::move(chunk));
+
+      return data;
+   }
+
+   if (size > m_arenaChunkFree || m_arenaChunkList.empty())
+   {
+      m_arenaChunkList.push_back(std::unique_ptr<Uint8[]>{ new Uint8[c_arenaChunkSize] });
+      m_arenaChunkFree = c_arenaChunkSize;
+   }
+
+   Uint8* data = m_arenaChunkList.back().get() + (c_arenaChunkSize - m_arenaChunkFree);
+   m_arenaChunkFree -= size;
 
-   // decode uw2 block
-   return Base::Uw2Decode(m_archiveFile, m_fileEntryInfoList[index].m_isCompressed, m_fileEntryInfoList[index].m_dataSize);
+   return data;
 }
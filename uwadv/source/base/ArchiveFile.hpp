@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,6 +22,8 @@
 #pragma once
 
 #include "File.hpp"
+#include "MemoryMappedFile.hpp"
+#include <memory>
 
 namespace Base
 {
@@ -52,25 +54,45 @@ namespace Base
    /// \brief Archive file class
    /// Manages archive files (extension .ark) that contain blocks of data, e.g.
    /// for level maps or conversations. Not all blocks may contain actual data.
-   /// The archive file class supports uw2 packed blocks.
+   /// The archive file class supports uw2 packed blocks. The archive is kept
+   /// in memory, either as memory mapped file or read from a SDL_RWops
+   /// pointer, and blocks are returned as read-only spans into the archive.
+   /// Decoded uw2 blocks are cached in an arena that lives as long as the
+   /// archive file object.
    class ArchiveFile
    {
    public:
-      /// ctor; uses opened SDL_RWops pointer
+      /// ctor; reads all data from opened SDL_RWops pointer
       ArchiveFile(SDL_RWopsPtr rwops, bool uw2Mode = false);
 
+      /// ctor; uses memory mapped file; the file may be shared with other archives
+      ArchiveFile(std::shared_ptr<const MemoryMappedFile> file, bool uw2Mode = false);
+
       /// returns number of files in archive
       size_t GetNumFiles() const { return m_offsetList.size(); }
 
       /// checks if an archive file slot is available
       bool IsAvailable(size_t index) const;
 
+      /// returns data block of archive file; decodes uw2 blocks when necessary
+      ByteSpan GetBlock(size_t index);
+
       /// returns archive file
       Base::File GetFile(size_t index);
 
    private:
-      /// archive file
-      Base::File m_archiveFile;
+      /// reads archive header
+      void ReadHeader();
+
+      /// decodes compressed uw2 block
+      ByteSpan DecodeBlock(size_t index);
+
+      /// allocates memory for decoded block from the arena
+      Uint8* AllocateArena(size_t size);
+
+   private:
+      /// archive file contents
+      std::shared_ptr<const MemoryMappedFile> m_archiveFile;
 
       /// file offsets for all files in archive
       std::vector<Uint32> m_offsetList;
@@ -78,6 +100,21 @@ namespace Base
       /// infos for all entries in archive (only used in uw2 mode)
       std::vector<ArchiveFileEntryInfo> m_fileEntryInfoList;
 
+      /// sorted file offsets, to determine block sizes in uw1 mode
+      std::vector<Uint32> m_sortedOffsetList;
+
+      /// cached decoded blocks, for compressed blocks in uw2 mode
+      std::vector<ByteSpan> m_decodedBlockList;
+
+      /// arena chunks that store decoded blocks
+      std::vector<std::unique_ptr<Uint8[]>> m_arenaChunkList;
+
+      /// buffer that compressed blocks are decoded into
+      std::vector<Uint8> m_decodeBuffer;
+
+      /// number of free bytes in the last arena chunk
+      size_t m_arenaChunkFree;
+
       /// archive in uw2 mode?
       bool m_uw2Mode;
    };
@@ -0,0 +1,116 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file BitReader.hpp
+/// \brief reader for bit streams in memory
+//
+#pragma once
+
+#include "MemoryMappedFile.hpp"
+
+namespace Base
+{
+   /// \brief Reader for bit streams in memory
+   /// \details Reads values with arbitrary bit counts from a span of memory,
+   /// most significant bit first, as used by the nibble based run-length
+   /// encoded images and the Huffman coded strings. Bits are buffered in a
+   /// 64-bit value, so that bytes are only fetched every few values. Reading
+   /// past the end of the data returns zero bits. The reader doesn't own the
+   /// memory.
+   class BitReader
+   {
+   public:
+      /// ctor; reads from given span
+      explicit BitReader(ByteSpan span)
+         :m_data(span.m_data),
+         m_end(span.m_data + span.m_size),
+         m_bitBuffer(0),
+         m_bitsAvailable(0),
+         m_paddingBits(0)
+      {
+      }
+
+      /// returns next bits without consuming them; up to 32 bits can be peeked
+      unsigned int PeekBits(unsigned int count)
+      {
+         UaAssert(count > 0 && count <= 32);
+
+         if (m_bitsAvailable < count)
+            Refill();
+
+         return static_cast<unsigned int>(m_bitBuffer >> (64 - count));
+      }
+
+      /// skips bits; the bits must have been peeked before
+      void SkipBits(unsigned int count)
+      {
+         UaAssert(count <= m_bitsAvailable);
+
+         m_bitBuffer <<= count;
+         m_bitsAvailable -= count;
+      }
+
+      /// reads bits; up to 32 bits can be read at once
+      unsigned int ReadBits(unsigned int count)
+      {
+         unsigned int value = PeekBits(count);
+         SkipBits(count);
+         return value;
+      }
+
+      /// returns if all bits of the data were read
+      bool IsAtEnd() const
+      {
+         return m_data >= m_end && m_bitsAvailable <= m_paddingBits;
+      }
+
+   private:
+      /// fills up the bit buffer with the next bytes; pads with zero bytes at the end
+      void Refill()
+      {
+         while (m_bitsAvailable <= 56)
+         {
+            Uint64 value = 0;
+            if (m_data < m_end)
+               value = *m_data++;
+            else
+               m_paddingBits += 8;
+
+            m_bitBuffer |= value << (56 - m_bitsAvailable);
+            m_bitsAvailable += 8;
+         }
+      }
+
+   private:
+      /// pointer to next byte to fetch
+      const Uint8* m_data;
+
+      /// end of data
+      const Uint8* m_end;
+
+      /// buffered bits, starting with the most significant bit
+      Uint64 m_bitBuffer;
+
+      /// number of bits available in the bit buffer
+      unsigned int m_bitsAvailable;
+
+      /// number of zero bits in the bit buffer that were added after the end of the data
+      unsigned int m_paddingBits;
+   };
+
+} // namespace Base
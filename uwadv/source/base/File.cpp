@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -30,7 +30,7 @@ File::File(const std::string& filename, Base::FileOpenMode openMode)
    UaAssert(!filename.empty());
 
    SDL_RWops* rwops = SDL_RWFromFile(filename.c_str(),
-      openMode == modeRead ? "rb" : "wb");
+      openMode == modeRead ? "rb" : openMode == modeWrite ? "wb" : "r+b");
 
    m_rwops = MakeRWopsPtr(rwops);
 }
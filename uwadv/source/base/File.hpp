@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -34,6 +34,7 @@ namespace Base
    {
       modeRead,   ///< open in read mode
       modeWrite,  ///< create a new file in write mode
+      modeReadWrite, ///< open an existing file for reading and writing
    };
 
    /// seek mode for File::Seek()
@@ -0,0 +1,305 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameProfiler.cpp
+/// \brief frame phase profiler implementation
+//
+#include "pch.hpp"
+#include "FrameProfiler.hpp"
+#include "TextFile.hpp"
+#include <algorithm>
+#include <cmath>
+
+using Base::FrameProfiler;
+using Base::ProfileScope;
+
+/// profiler that is recording a frame on the current thread
+static thread_local const FrameProfiler* t_recordingProfiler = nullptr;
+
+/// names of all frame phases
+static const char* c_framePhaseNames[Base::framePhaseMax] =
+{
+   "tick",
+   "events",
+   "render",
+   "physics",
+   "scripting",
+   "render-tiles",
+   "render-objects",
+};
+
+FrameProfiler::FrameProfiler()
+   :m_enabled(true),
+   m_msecPerCount(1000.0 / SDL_GetPerformanceFrequency()),
+   m_frames(new FrameRecord[c_numFrames]),
+   m_frameSequence(new std::atomic<Uint64>[c_numFrames]),
+   m_currentFrame(nullptr),
+   m_nextFrameNumber(0)
+{
+   for (unsigned int index = 0; index < c_numFrames; index++)
+      m_frameSequence[index].store(0, std::memory_order_relaxed);
+}
+
+FrameProfiler& FrameProfiler::GetInstance()
+{
+   static FrameProfiler s_instance;
+   return s_instance;
+}
+
+/// Starts recording a new frame. When the last frame wasn't ended, it is
+/// discarded, e.g. when the game loop skipped rendering.
+void FrameProfiler::BeginFrame()
+{
+   if (!m_enabled)
+      return;
+
+   unsigned int slot = static_cast<unsigned int>(m_nextFrameNumber % c_numFrames);
+
+   // mark slot as being written, before writing the frame
+   m_frameSequence[slot].store(0, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+
+   m_currentFrame = &m_frames[slot];
+   m_currentFrame->m_frameNumber = m_nextFrameNumber;
+   m_currentFrame->m_startCounter = SDL_GetPerformanceCounter();
+   m_currentFrame->m_endCounter = m_currentFrame->m_startCounter;
+   std::fill(std::begin(m_currentFrame->m_phaseCounts), std::end(m_currentFrame->m_phaseCounts), 0);
+   m_currentFrame->m_numSpans = 0;
+
+   t_recordingProfiler = this;
+}
+
+/// Ends recording the current frame and makes it available to readers.
+void FrameProfiler::EndFrame()
+{
+   if (m_currentFrame == nullptr)
+      return;
+
+   m_currentFrame->m_endCounter = SDL_GetPerformanceCounter();
+
+   unsigned int slot = static_cast<unsigned int>(m_nextFrameNumber % c_numFrames);
+   m_frameSequence[slot].store(m_nextFrameNumber + 1, std::memory_order_release);
+
+   m_nextFrameNumber++;
+   m_numCommittedFrames.store(m_nextFrameNumber, std::memory_order_release);
+
+   m_currentFrame = nullptr;
+   t_recordingProfiler = nullptr;
+}
+
+bool FrameProfiler::IsRecording() const
+{
+   return t_recordingProfiler == this && m_currentFrame != nullptr;
+}
+
+/// Adds a span to the current frame. Must only be called on the thread that
+/// is recording the frame.
+/// \param phase frame phase of the span
+/// \param startCounter performance counter at start of the span
+/// \param endCounter performance counter at end of the span
+void FrameProfiler::AddSpan(FramePhase phase, Uint64 startCounter, Uint64 endCounter)
+{
+   UaAssert(IsRecording());
+   UaAssert(phase < framePhaseMax);
+
+   m_currentFrame->m_phaseCounts[phase] += endCounter - startCounter;
+
+   if (m_currentFrame->m_numSpans < c_maxSpansPerFrame)
+   {
+      Span& span = m_currentFrame->m_spans[m_currentFrame->m_numSpans++];
+      span.m_phase = phase;
+      span.m_startCounter = startCounter;
+      span.m_endCounter = endCounter;
+   }
+}
+
+/// Returns copies of the most recently recorded frames. Frames that are
+/// overwritten by the recording thread while copying are left out.
+/// \param frames vector to store frames in, oldest first
+void FrameProfiler::GetRecentFrames(std::vector<FrameRecord>& frames) const
+{
+   frames.clear();
+
+   Uint64 numFrames = m_numCommittedFrames.load(std::memory_order_acquire);
+   Uint64 firstFrame = numFrames > c_numFrames ? numFrames - c_numFrames : 0;
+
+   frames.reserve(static_cast<size_t>(numFrames - firstFrame));
+
+   for (Uint64 frameNumber = firstFrame; frameNumber < numFrames; frameNumber++)
+   {
+      unsigned int slot = static_cast<unsigned int>(frameNumber % c_numFrames);
+
+      if (m_frameSequence[slot].load(std::memory_order_acquire) != frameNumber + 1)
+         continue;
+
+      FrameRecord frame = m_frames[slot];
+
+      // check that the frame wasn't overwritten while copying
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_frameSequence[slot].load(std::memory_order_relaxed) != frameNumber + 1)
+         continue;
+
+      frames.push_back(frame);
+   }
+}
+
+/// Calculates frame time statistics. Percentiles use the nearest rank
+/// method.
+/// \return frame time statistics; m_numFrames is 0 when no frames were
+/// recorded yet
+Base::FrameTimeStatistics FrameProfiler::CalcStatistics() const
+{
+   std::vector<FrameRecord> frames;
+   GetRecentFrames(frames);
+
+   FrameTimeStatistics statistics;
+   if (frames.empty())
+      return statistics;
+
+   std::vector<double> frameTimes;
+   frameTimes.reserve(frames.size());
+
+   double sum = 0.0;
+   for (const FrameRecord& frame : frames)
+   {
+      double frameTime = CountsToMsec(frame.m_endCounter - frame.m_startCounter);
+      frameTimes.push_back(frameTime);
+      sum += frameTime;
+   }
+
+   std::sort(frameTimes.begin(), frameTimes.end());
+
+   auto percentile = [&](double percent)
+   {
+      size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * frameTimes.size()));
+      return frameTimes[rank > 0 ? rank - 1 : 0];
+   };
+
+   statistics.m_numFrames = static_cast<unsigned int>(frameTimes.size());
+   statistics.m_averageTime = sum / frameTimes.size();
+   statistics.m_percentile50 = percentile(50.0);
+   statistics.m_percentile90 = percentile(90.0);
+   statistics.m_percentile99 = percentile(99.0);
+   statistics.m_maxTime = frameTimes.back();
+
+   return statistics;
+}
+
+/// Writes the most recent frames as CSV file. Each line contains the frame
+/// number, the start time relative to the first frame, the frame time and
+/// the time spent in each phase, in milliseconds.
+/// \param filename filename of CSV file to write
+/// \return true when the file was written
+bool FrameProfiler::WriteCsv(const std::string& filename) const
+{
+   std::vector<FrameRecord> frames;
+   GetRecentFrames(frames);
+
+   Base::TextFile file{ filename, Base::modeWrite };
+   if (!file.IsOpen())
+      return false;
+
+   std::string line{ "frame,start_ms,frame_ms" };
+   for (const char* phaseName : c_framePhaseNames)
+      line += Base::String::Format(",%s_ms", phaseName);
+
+   file.WriteLine(line);
+
+   Uint64 baseCounter = frames.empty() ? 0 : frames.front().m_startCounter;
+
+   for (const FrameRecord& frame : frames)
+   {
+      line = Base::String::Format("%llu,%.3f,%.3f",
+         static_cast<unsigned long long>(frame.m_frameNumber),
+         CountsToMsec(frame.m_startCounter - baseCounter),
+         CountsToMsec(frame.m_endCounter - frame.m_startCounter));
+
+      for (Uint64 phaseCounts : frame.m_phaseCounts)
+         line += Base::String::Format(",%.3f", CountsToMsec(phaseCounts));
+
+      file.WriteLine(line);
+   }
+
+   return true;
+}
+
+/// Writes the most recent frames as JSON file in the Chrome trace event
+/// format, which can be viewed with chrome://tracing or Perfetto. Every
+/// frame and every recorded span is written as complete event.
+/// \param filename filename of JSON file to write
+/// \return true when the file was written
+bool FrameProfiler::WriteChromeTrace(const std::string& filename) const
+{
+   std::vector<FrameRecord> frames;
+   GetRecentFrames(frames);
+
+   Base::TextFile file{ filename, Base::modeWrite };
+   if (!file.IsOpen())
+      return false;
+   file.WriteLine("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+   Uint64 baseCounter = frames.empty() ? 0 : frames.front().m_startCounter;
+   bool firstEvent = true;
+
+   auto writeEvent = [&](const char* name, Uint64 startCounter, Uint64 endCounter)
+   {
+      file.WriteLine(Base::String::Format(
+         "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+         firstEvent ? "" : ",",
+         name,
+         CountsToMsec(startCounter - baseCounter) * 1000.0,
+         CountsToMsec(endCounter - startCounter) * 1000.0));
+
+      firstEvent = false;
+   };
+
+   for (const FrameRecord& frame : frames)
+   {
+      writeEvent("frame", frame.m_startCounter, frame.m_endCounter);
+
+      for (unsigned int spanIndex = 0; spanIndex < frame.m_numSpans; spanIndex++)
+      {
+         const Span& span = frame.m_spans[spanIndex];
+         writeEvent(GetPhaseName(span.m_phase), span.m_startCounter, span.m_endCounter);
+      }
+   }
+
+   file.WriteLine("]}");
+
+   return true;
+}
+
+const char* FrameProfiler::GetPhaseName(FramePhase phase)
+{
+   UaAssert(phase < framePhaseMax);
+   return phase < framePhaseMax ? c_framePhaseNames[phase] : "unknown";
+}
+
+ProfileScope::ProfileScope(FramePhase phase)
+   :m_phase(phase),
+   m_startCounter(FrameProfiler::GetInstance().IsRecording() ? SDL_GetPerformanceCounter() : 0)
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+   // a frame may have been ended or started in the meantime
+   FrameProfiler& profiler = FrameProfiler::GetInstance();
+   if (m_startCounter != 0 && profiler.IsRecording())
+      profiler.AddSpan(m_phase, m_startCounter, SDL_GetPerformanceCounter());
+}
@@ -0,0 +1,219 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameProfiler.hpp
+/// \brief frame phase profiler
+//
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <string>
+
+namespace Base
+{
+   /// phases of a frame that are profiled
+   enum FramePhase
+   {
+      framePhaseTick = 0,     ///< game logic tick
+      framePhaseEvents,       ///< processing SDL events
+      framePhaseRender,       ///< rendering the screen
+      framePhasePhysics,      ///< evaluating physics
+      framePhaseScripting,    ///< calling Lua scripts
+      framePhaseRenderTiles,  ///< rendering level tiles
+      framePhaseRenderObjects,   ///< rendering level objects
+      framePhaseMax,
+   };
+
+   /// frame time statistics, in milliseconds
+   struct FrameTimeStatistics
+   {
+      /// number of frames the statistics are calculated from
+      unsigned int m_numFrames = 0;
+
+      /// average frame time
+      double m_averageTime = 0.0;
+
+      /// median frame time
+      double m_percentile50 = 0.0;
+
+      /// 90th percentile of frame times
+      double m_percentile90 = 0.0;
+
+      /// 99th percentile of frame times
+      double m_percentile99 = 0.0;
+
+      /// maximum frame time
+      double m_maxTime = 0.0;
+   };
+
+   /// \brief frame phase profiler
+   /// \details Records the time spent in the phases of the most recent frames
+   /// in a ring buffer. Frames are started and ended by the main game loop;
+   /// phases are timed with ProfileScope objects. Only scopes on the thread
+   /// that started the frame are recorded. Recorded frames can be read from
+   /// any thread without locking, e.g. to calculate frame time percentiles,
+   /// or to write them as CSV or Chrome trace JSON file.
+   class FrameProfiler
+   {
+   public:
+      /// number of frames kept in the ring buffer
+      static const unsigned int c_numFrames = 512;
+
+      /// max. number of spans recorded per frame; more spans only count to
+      /// the phase times
+      static const unsigned int c_maxSpansPerFrame = 32;
+
+      /// time span of a single phase
+      struct Span
+      {
+         /// phase of the span
+         FramePhase m_phase;
+
+         /// performance counter at start of the span
+         Uint64 m_startCounter;
+
+         /// performance counter at end of the span
+         Uint64 m_endCounter;
+      };
+
+      /// recorded frame
+      struct FrameRecord
+      {
+         /// frame number, counting from 0
+         Uint64 m_frameNumber;
+
+         /// performance counter at start of the frame
+         Uint64 m_startCounter;
+
+         /// performance counter at end of the frame
+         Uint64 m_endCounter;
+
+         /// performance counts spent in each phase
+         Uint64 m_phaseCounts[framePhaseMax];
+
+         /// number of recorded spans
+         unsigned int m_numSpans;
+
+         /// recorded spans, in the order they ended
+         Span m_spans[c_maxSpansPerFrame];
+      };
+
+      /// ctor
+      FrameProfiler();
+      /// deleted copy ctor
+      FrameProfiler(const FrameProfiler&) = delete;
+      /// deleted assignment operator
+      FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+      /// returns the profiler instance used by the game loop and ProfileScope
+      static FrameProfiler& GetInstance();
+
+      /// enables or disables recording frames
+      void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+      /// returns if recording frames is enabled
+      bool IsEnabled() const { return m_enabled; }
+
+      /// starts recording a new frame on the calling thread
+      void BeginFrame();
+
+      /// ends recording the current frame
+      void EndFrame();
+
+      /// returns if a frame is currently recorded on the calling thread
+      bool IsRecording() const;
+
+      /// adds a time span of a phase to the current frame
+      void AddSpan(FramePhase phase, Uint64 startCounter, Uint64 endCounter);
+
+      /// returns the most recently recorded frames, oldest first
+      void GetRecentFrames(std::vector<FrameRecord>& frames) const;
+
+      /// calculates frame time statistics of the most recent frames
+      FrameTimeStatistics CalcStatistics() const;
+
+      /// writes most recent frames as CSV file; returns false on errors
+      bool WriteCsv(const std::string& filename) const;
+
+      /// writes most recent frames as Chrome trace event JSON file; returns
+      /// false on errors
+      bool WriteChromeTrace(const std::string& filename) const;
+
+      /// returns name of a frame phase
+      static const char* GetPhaseName(FramePhase phase);
+
+   private:
+      /// converts a performance counter difference to milliseconds
+      double CountsToMsec(Uint64 counts) const
+      {
+         return counts * m_msecPerCount;
+      }
+
+   private:
+      /// indicates if recording frames is enabled
+      bool m_enabled;
+
+      /// milliseconds per performance counter count
+      double m_msecPerCount;
+
+      /// ring buffer with recorded frames
+      std::unique_ptr<FrameRecord[]> m_frames;
+
+      /// frame number plus 1 stored in each ring buffer entry; 0 while the
+      /// entry is written
+      std::unique_ptr<std::atomic<Uint64>[]> m_frameSequence;
+
+      /// number of frames that were completely recorded
+      std::atomic<Uint64> m_numCommittedFrames{ 0 };
+
+      /// current frame that is recorded; only valid while recording
+      FrameRecord* m_currentFrame;
+
+      /// number of the next frame to record
+      Uint64 m_nextFrameNumber;
+   };
+
+   /// \brief profile scope
+   /// \details Records the time between construction and destruction of the
+   /// object as span of a frame phase, when a frame is currently recorded on
+   /// the calling thread.
+   class ProfileScope
+   {
+   public:
+      /// ctor; starts timing the phase
+      explicit ProfileScope(FramePhase phase);
+
+      /// dtor; adds the phase span to the current frame
+      ~ProfileScope();
+
+      /// deleted copy ctor
+      ProfileScope(const ProfileScope&) = delete;
+      /// deleted assignment operator
+      ProfileScope& operator=(const ProfileScope&) = delete;
+
+   private:
+      /// phase to time
+      FramePhase m_phase;
+
+      /// performance counter at start; 0 when not recording
+      Uint64 m_startCounter;
+   };
+
+} // namespace Base
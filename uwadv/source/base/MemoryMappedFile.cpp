@@ -0,0 +1,152 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file MemoryMappedFile.cpp
+/// \brief read-only memory mapped file implementation
+//
+#include "pch.hpp"
+#include "MemoryMappedFile.hpp"
+#include "Exception.hpp"
+#include <SDL2/SDL_rwops.h>
+#ifdef HAVE_WIN32
+#include "String.hpp"
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using Base::MemoryMappedFile;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename)
+{
+   UaAssert(!filename.empty());
+
+#ifdef HAVE_WIN32
+   HANDLE fileHandle = ::CreateFileW(Base::String::ConvertToUnicode(filename).c_str(),
+      GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+   if (fileHandle == INVALID_HANDLE_VALUE)
+      throw Base::FileSystemException("couldn't open file", filename, ::GetLastError());
+
+   LARGE_INTEGER fileSize = {};
+   if (!::GetFileSizeEx(fileHandle, &fileSize))
+   {
+      DWORD lastError = ::GetLastError();
+      ::CloseHandle(fileHandle);
+      throw Base::FileSystemException("couldn't determine file size", filename, lastError);
+   }
+
+   m_size = static_cast<size_t>(fileSize.QuadPart);
+
+   // empty files can't be mapped
+   if (m_size == 0)
+   {
+      ::CloseHandle(fileHandle);
+      return;
+   }
+
+   m_mappingHandle = ::CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+   // the mapping keeps its own reference to the file
+   ::CloseHandle(fileHandle);
+
+   if (m_mappingHandle == nullptr)
+      throw Base::FileSystemException("couldn't map file", filename, ::GetLastError());
+
+   m_data = static_cast<const Uint8*>(::MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+   if (m_data == nullptr)
+   {
+      DWORD lastError = ::GetLastError();
+      ::CloseHandle(m_mappingHandle);
+      throw Base::FileSystemException("couldn't map file", filename, lastError);
+   }
+#else
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd == -1)
+      throw Base::FileSystemException("couldn't open file", filename, errno);
+
+   struct stat fileStat = {};
+   if (::fstat(fd, &fileStat) != 0)
+   {
+      int lastError = errno;
+      ::close(fd);
+      throw Base::FileSystemException("couldn't determine file size", filename, lastError);
+   }
+
+   m_size = static_cast<size_t>(fileStat.st_size);
+
+   // empty files can't be mapped
+   if (m_size == 0)
+   {
+      ::close(fd);
+      return;
+   }
+
+   void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   // the mapping keeps its own reference to the file
+   ::close(fd);
+
+   if (data == MAP_FAILED)
+      throw Base::FileSystemException("couldn't map file", filename, errno);
+
+   m_data = static_cast<const Uint8*>(data);
+#endif
+
+   m_isMapped = true;
+}
+
+MemoryMappedFile::MemoryMappedFile(Base::SDL_RWopsPtr rwops)
+{
+   UaAssert(rwops.get() != nullptr);
+
+   // streams don't necessarily know their size, so read in chunks
+   const size_t chunkSize = 0x10000;
+
+   size_t bytesRead = 0;
+   do
+   {
+      m_buffer.resize(m_buffer.size() + chunkSize);
+
+      bytesRead = SDL_RWread(rwops.get(), m_buffer.data() + m_size, 1, chunkSize);
+      m_size += bytesRead;
+
+   } while (bytesRead == chunkSize);
+
+   m_buffer.resize(m_size);
+   m_buffer.shrink_to_fit();
+
+   m_data = m_buffer.data();
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+   if (!m_isMapped)
+      return;
+
+#ifdef HAVE_WIN32
+   ::UnmapViewOfFile(m_data);
+   ::CloseHandle(m_mappingHandle);
+#else
+   ::munmap(const_cast<Uint8*>(m_data), m_size);
+#endif
+}
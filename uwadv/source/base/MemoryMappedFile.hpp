@@ -0,0 +1,111 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file MemoryMappedFile.hpp
+/// \brief read-only memory mapped file
+//
+#pragma once
+
+#include "Base.hpp"
+#include <string>
+#include <algorithm>
+#include <vector>
+
+namespace Base
+{
+   /// \brief read-only view on a range of bytes
+   struct ByteSpan
+   {
+      /// ctor
+      ByteSpan(const Uint8* data = nullptr, size_t size = 0)
+         :m_data(data),
+         m_size(size)
+      {
+      }
+
+      /// returns if the span contains no bytes
+      bool IsEmpty() const { return m_size == 0; }
+
+      /// pointer to first byte
+      const Uint8* m_data;
+
+      /// number of bytes
+      size_t m_size;
+   };
+
+   /// \brief Read-only memory mapped file
+   /// \details Maps a file on disk into memory, so that its contents can be
+   /// parsed directly, without reading it through SDL_RWops first. Files
+   /// that can't be mapped, e.g. files inside zip archives, can be read into
+   /// memory from a SDL_RWops pointer instead. The file contents stay valid
+   /// as long as the object exists.
+   class MemoryMappedFile
+   {
+   public:
+      /// ctor; maps file with given filename
+      explicit MemoryMappedFile(const std::string& filename);
+
+      /// ctor; reads all data of opened SDL_RWops pointer into memory
+      explicit MemoryMappedFile(SDL_RWopsPtr rwops);
+
+      /// dtor; unmaps file
+      ~MemoryMappedFile();
+
+      /// deleted copy ctor
+      MemoryMappedFile(const MemoryMappedFile&) = delete;
+      /// deleted assignment operator
+      MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+      /// returns if the file is mapped, or if it was read into memory
+      bool IsMapped() const { return m_isMapped; }
+
+      /// returns pointer to the file contents
+      const Uint8* GetData() const { return m_data; }
+
+      /// returns size of the file contents
+      size_t GetSize() const { return m_size; }
+
+      /// returns span of file contents; the span is clipped to the file size
+      ByteSpan GetSpan(size_t offset, size_t size) const
+      {
+         if (offset > m_size)
+            offset = m_size;
+
+         return ByteSpan(m_data + offset, std::min(size, m_size - offset));
+      }
+
+   private:
+      /// pointer to file contents
+      const Uint8* m_data = nullptr;
+
+      /// size of file contents
+      size_t m_size = 0;
+
+      /// indicates if the file is mapped
+      bool m_isMapped = false;
+
+      /// file contents, when read from a SDL_RWops pointer
+      std::vector<Uint8> m_buffer;
+
+#ifdef HAVE_WIN32
+      /// file mapping handle
+      void* m_mappingHandle = nullptr;
+#endif
+   };
+
+} // namespace Base
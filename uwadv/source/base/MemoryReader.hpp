@@ -0,0 +1,145 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file MemoryReader.hpp
+/// \brief reader for data in memory
+//
+#pragma once
+
+#include "File.hpp"
+#include "MemoryMappedFile.hpp"
+#include <cstring>
+#include <memory>
+
+namespace Base
+{
+   /// \brief Reader for data in memory
+   /// \details Reads data from a span of memory, using the same interface for
+   /// reading as the File class, so that importers can parse data blocks
+   /// directly from memory mapped files. The Read16 and Read32 functions
+   /// always read little-endian values. Reading past the end of the data
+   /// returns zero values. When the reader is created from a memory mapped
+   /// file, it keeps the file alive; otherwise it doesn't own the memory.
+   class MemoryReader
+   {
+   public:
+      /// default ctor; reader has no data
+      MemoryReader()
+         :m_pos(0)
+      {
+      }
+
+      /// ctor; reads from given span
+      explicit MemoryReader(ByteSpan span)
+         :m_span(span),
+         m_pos(0)
+      {
+      }
+
+      /// ctor; reads from whole memory mapped file, keeping the file alive
+      explicit MemoryReader(std::shared_ptr<const MemoryMappedFile> file)
+         :m_span(file->GetData(), file->GetSize()),
+         m_pos(0),
+         m_file(file)
+      {
+      }
+
+      /// returns if reader has data
+      bool IsOpen() const { return m_span.m_data != nullptr; }
+
+      /// returns data length
+      long FileLength() const { return static_cast<long>(m_span.m_size); }
+
+      /// tells current position
+      long Tell() const { return static_cast<long>(m_pos); }
+
+      /// seeks to position; the position is clipped to the data length
+      void Seek(long offset, SeekMode seekMode)
+      {
+         UaAssert(seekMode == seekBegin || seekMode == seekCurrent);
+
+         long newPos = seekMode == seekBegin ? offset : static_cast<long>(m_pos) + offset;
+         m_pos = newPos < 0 ? 0 : std::min(static_cast<size_t>(newPos), m_span.m_size);
+      }
+
+      /// reads 8-bit value
+      Uint8 Read8()
+      {
+         return m_pos < m_span.m_size ? m_span.m_data[m_pos++] : 0;
+      }
+
+      /// reads 16-bit value
+      Uint16 Read16()
+      {
+         if (m_span.m_size - m_pos < 2)
+         {
+            m_pos = m_span.m_size;
+            return 0;
+         }
+
+         const Uint8* data = m_span.m_data + m_pos;
+         m_pos += 2;
+         return static_cast<Uint16>(data[0] | (data[1] << 8));
+      }
+
+      /// reads 32-bit value
+      Uint32 Read32()
+      {
+         if (m_span.m_size - m_pos < 4)
+         {
+            m_pos = m_span.m_size;
+            return 0;
+         }
+
+         const Uint8* data = m_span.m_data + m_pos;
+         m_pos += 4;
+         return static_cast<Uint32>(data[0]) |
+            (static_cast<Uint32>(data[1]) << 8) |
+            (static_cast<Uint32>(data[2]) << 16) |
+            (static_cast<Uint32>(data[3]) << 24);
+      }
+
+      /// reads array into buffer; returns number of bytes read
+      size_t ReadBuffer(Uint8* buffer, size_t length)
+      {
+         length = std::min(length, m_span.m_size - m_pos);
+         if (length > 0)
+            memcpy(buffer, m_span.m_data + m_pos, length);
+
+         m_pos += length;
+         return length;
+      }
+
+      /// returns span of the remaining data, starting at the current position
+      ByteSpan GetRemaining() const
+      {
+         return ByteSpan(m_span.m_data + m_pos, m_span.m_size - m_pos);
+      }
+
+   private:
+      /// span to read from
+      ByteSpan m_span;
+
+      /// current read position
+      size_t m_pos;
+
+      /// memory mapped file, when reading from a file
+      std::shared_ptr<const MemoryMappedFile> m_file;
+   };
+
+} // namespace Base
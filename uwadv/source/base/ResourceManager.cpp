@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2006,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 #include "ResourceManager.hpp"
 #include "Settings.hpp"
 #include "FileSystem.hpp"
+#include "MemoryMappedFile.hpp"
 #include <SDL2/SDL_rwops.h>
 #include <algorithm>
 #include <zzip/zzip.h>
@@ -158,19 +159,63 @@ Base::SDL_RWopsPtr ResourceManager::GetUnderworldFile(
    const std::string& relativeFilename) const
 {
    // check zip archives
-   if (resourcePath == resourceGameUw)
+   std::string zipArchiveFilename;
+   if (FindUnderworldZipArchiveFilename(resourcePath, relativeFilename, zipArchiveFilename))
+      return MakeRWopsPtr(::SDL_RWFromZZIP(zipArchiveFilename.c_str(), "rb"));
+
+   // check file system
+   return GetFile(GetUnderworldFilename(resourcePath, relativeFilename));
+}
+
+/// Files on the file system are memory mapped; files stored in zip archives
+/// can't be mapped and are read into memory instead.
+std::shared_ptr<const Base::MemoryMappedFile> ResourceManager::MapUnderworldFile(
+   Base::UnderworldResourcePath resourcePath,
+   const std::string& relativeFilename) const
+{
+   // check zip archives
+   std::string zipArchiveFilename;
+   if (FindUnderworldZipArchiveFilename(resourcePath, relativeFilename, zipArchiveFilename))
    {
-      std::string lowercaseRelativeFilename = relativeFilename;
-      String::Lowercase(lowercaseRelativeFilename);
+      SDL_RWopsPtr rwops = MakeRWopsPtr(::SDL_RWFromZZIP(zipArchiveFilename.c_str(), "rb"));
+      if (rwops == nullptr)
+         throw Base::FileSystemException("couldn't open uw game file in zip archive", zipArchiveFilename, ENOENT);
 
-      auto iter = m_mapRelativeLowercaseFilenamesToZipArchiveFilename.find(lowercaseRelativeFilename);
-      if (iter != m_mapRelativeLowercaseFilenamesToZipArchiveFilename.end())
-      {
-         return MakeRWopsPtr(::SDL_RWFromZZIP(iter->second.c_str(), "rb"));
-      }
+      return std::make_shared<Base::MemoryMappedFile>(rwops);
    }
 
    // check file system
+   std::string filename = GetUnderworldFilename(resourcePath, relativeFilename);
+   MapUnderworldFilename(filename);
+
+   if (!Base::FileSystem::FileExists(filename))
+      throw Base::FileSystemException("couldn't find uw game file", filename, ENOENT);
+
+   return std::make_shared<Base::MemoryMappedFile>(filename);
+}
+
+bool ResourceManager::FindUnderworldZipArchiveFilename(
+   Base::UnderworldResourcePath resourcePath,
+   const std::string& relativeFilename, std::string& zipArchiveFilename) const
+{
+   if (resourcePath != resourceGameUw)
+      return false;
+
+   std::string lowercaseRelativeFilename = relativeFilename;
+   String::Lowercase(lowercaseRelativeFilename);
+
+   auto iter = m_mapRelativeLowercaseFilenamesToZipArchiveFilename.find(lowercaseRelativeFilename);
+   if (iter == m_mapRelativeLowercaseFilenamesToZipArchiveFilename.end())
+      return false;
+
+   zipArchiveFilename = iter->second;
+   return true;
+}
+
+std::string ResourceManager::GetUnderworldFilename(
+   Base::UnderworldResourcePath resourcePath,
+   const std::string& relativeFilename) const
+{
    std::string basePath;
    switch (resourcePath)
    {
@@ -179,8 +224,7 @@ Base::SDL_RWopsPtr ResourceManager::GetUnderworldFile(
    case resourceGameUw2: basePath = m_uw2Path; break;
    }
 
-   std::string filename = basePath + relativeFilename;
-   return GetFile(filename);
+   return basePath + relativeFilename;
 }
 
 Base::SDL_RWopsPtr ResourceManager::GetFile(const std::string& absoluteFilename) const
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2006,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 
 namespace Base
 {
@@ -35,6 +36,7 @@ namespace Base
    };
 
    class Settings;
+   class MemoryMappedFile;
 
    /// \brief Resource manager
    /// Manages access to resource files.
@@ -60,6 +62,9 @@ namespace Base
       /// returns ultima underworld file
       SDL_RWopsPtr GetUnderworldFile(UnderworldResourcePath resourcePath, const std::string& relativeFilename) const;
 
+      /// returns ultima underworld file, mapped into memory
+      std::shared_ptr<const MemoryMappedFile> MapUnderworldFile(UnderworldResourcePath resourcePath, const std::string& relativeFilename) const;
+
       /// returns a file that already has a full path
       SDL_RWopsPtr GetFile(const std::string& absoluteFilename) const;
 
@@ -95,6 +100,13 @@ namespace Base
       void CheckAndAddZipArchive(const std::string& zipFilename,
          const std::map<std::string, std::string>& mapRelativeLowercaseFilenamesToZipArchiveFilename);
 
+      /// finds the zip archive filename of an underworld file, if it's stored in a zip archive
+      bool FindUnderworldZipArchiveFilename(UnderworldResourcePath resourcePath,
+         const std::string& relativeFilename, std::string& zipArchiveFilename) const;
+
+      /// returns the file system filename of an underworld file
+      std::string GetUnderworldFilename(UnderworldResourcePath resourcePath, const std::string& relativeFilename) const;
+
       /// maps a requested filename to a real file system filename, for the underworld data files
       void MapUnderworldFilename(std::string& filenameToMap) const;
 
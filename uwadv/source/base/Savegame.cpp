@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -42,7 +42,9 @@ using Base::SavegamesManager;
 ///              classes required a new version.
 /// - version 4: version 0.11; objectlist has an extra Uint8 flags value to
 ///              recognize empty object lists for uw2
-const Uint32 Savegame::s_currentVersion = 4;
+/// - version 5: levels have an extra Uint8 flag; levels that weren't modified
+///              aren't stored and are loaded from the game files instead
+const Uint32 Savegame::s_currentVersion = 5;
 
 /// savegame error message
 const char* c_savegameNotFound = "savegame file not found";
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -51,6 +51,9 @@ namespace Detail
       { "cutscene-narration",    Base::settingCutsceneNarration },
       { "audio-enabled",         Base::settingAudioEnabled },
       { "win32-midi-device",     Base::settingWin32MidiDevice },
+      { "palette-shader",        Base::settingPaletteShader },
+      { "vsync",                 Base::settingVsync },
+      { "frame-rate-limit",      Base::settingFrameRateLimit },
    };
 
 } // namespace Detail
@@ -69,6 +72,8 @@ Settings::Settings()
    SetValue(settingFullscreen, false);
    SetValue(settingCutsceneNarration, std::string("sound"));
    SetValue(settingWin32MidiDevice, -1);
+   SetValue(settingVsync, true);
+   SetValue(settingFrameRateLimit, 0);
 }
 
 /// Can be called more than once; settings that are already set are
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -76,6 +76,16 @@ namespace Base
 
       /// int value with midi device to use; -1 for default
       settingWin32MidiDevice,
+
+      /// boolean value that indicates if level textures are kept as 8-bit
+      /// palette indices and are drawn using a palette lookup shader
+      settingPaletteShader,
+
+      /// boolean value that indicates if vsync should be used
+      settingVsync,
+
+      /// int value with the max. number of frames per second; 0 for no limit
+      settingFrameRateLimit,
    };
 
    /// base game type enum
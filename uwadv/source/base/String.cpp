@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -32,7 +32,12 @@ std::string Base::String::Format(const char* format, ...)
    va_list args;
    va_start(args, format);
 
-   int length = vsnprintf(nullptr, 0, format, args);
+   // the argument list can't be used twice without copying it
+   va_list argsCopy;
+   va_copy(argsCopy, args);
+
+   int length = vsnprintf(nullptr, 0, format, argsCopy);
+   va_end(argsCopy);
 
    std::vector<char> buffer;
    buffer.resize(length + 1, 0);
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -17,151 +17,333 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 /// \file Uw2decode.cpp
-/// \brief Ultima Underworld 2 .ark compression format decoder
+/// \brief Ultima Underworld 2 .ark compression format decoder and encoder
 //
 #include "pch.hpp"
 #include "Uw2decode.hpp"
-
-using Base::File;
-using Base::SDL_RWopsPtr;
+#include <cstring>
 
 namespace Detail
 {
-   /// \brief Data decoding for uw2 compression format
-   /// See uw-formats.txt for a detailed description how the data is compressed.
-   /// The code was adapted from the LoW project: http://low.sourceforge.net/
-   Uint32 Uw2DecodeData(const std::vector<Uint8>& sourceData, Uint8* destBuffer, Uint32 destSize)
-   {
-      Uint32 destCount = 0;
+   /// size of the unused header at the start of compressed blocks
+   const size_t c_uw2HeaderSize = 4;
+
+   /// size of the window that copy records can refer to
+   const int c_uw2WindowSize = 0x1000;
+
+   /// offset added to the position in copy records
+   const int c_uw2PositionOffset = 18;
+
+   /// minimum number of bytes in a copy record
+   const size_t c_uw2MinCopyCount = 3;
+
+   /// maximum number of bytes in a copy record
+   const size_t c_uw2MaxCopyCount = 18;
 
-      if (destBuffer == NULL)
-         destSize = 1; // when not passing a buffer, just set dest size to 1 to keep loop running
+   /// number of hash chain heads used by the encoder
+   const size_t c_uw2HashSize = 0x2000;
 
-      // compressed data
-      Uint8* ubuf = destBuffer;
-      const Uint8* cp = sourceData.data() + 4; // for some reason the first 4 bytes are not used
-      const Uint8* ce = sourceData.data() + sourceData.size();
-      Uint8* up = ubuf;
-      Uint8* ue = ubuf + destSize;
+   /// maximum number of hash chain entries the encoder checks for a match
+   const unsigned int c_uw2MaxChainLength = 64;
 
-      while (up < ue && cp < ce)
+   /// returns hash of the 3 bytes at given data pointer
+   inline size_t Uw2Hash(const Uint8* data)
+   {
+      return ((data[0] << 5) ^ (data[1] << 2) ^ data[2] ^ (data[0] >> 3)) & (c_uw2HashSize - 1);
+   }
+
+   /// \brief Encodes data with LZSS matches that the uw2 decoder understands
+   /// Uses hash chains over 3-byte sequences to find the longest match in the
+   /// last 4k bytes; the matches are chosen greedily.
+   class Uw2Encoder
+   {
+   public:
+      /// ctor
+      Uw2Encoder(Base::ByteSpan source, std::vector<Uint8>& compressedData)
+         :m_source(source),
+         m_compressedData(compressedData),
+         m_flagsPos(0),
+         m_numItems(8)
       {
-         unsigned char bits = *cp++;
-         //UaTrace(" bits: %02x\n",bits);
+         m_hashHeads.resize(c_uw2HashSize, -1);
+         m_hashChain.resize(c_uw2WindowSize, -1);
+      }
 
-         for (int i = 0; i < 8; i++, bits >>= 1)
+      /// encodes all data
+      void Encode()
+      {
+         size_t pos = 0;
+         while (pos < m_source.m_size)
          {
-            if (bits & 1)
+            size_t matchPos = 0;
+            size_t matchLength = FindMatch(pos, matchPos);
+
+            if (matchLength >= c_uw2MinCopyCount)
             {
-               //UaTrace("copy byte: %02x (to %04x)\n",*cp,up-ubuf);
-               if (up != NULL)
-                  *up++ = *cp++;
-               else
-                  cp++;
+               AddCopyRecord(pos, matchPos, matchLength);
+
+               for (size_t index = 0; index < matchLength; index++)
+                  InsertHash(pos + index);
 
-               destCount++;
+               pos += matchLength;
             }
             else
             {
-               signed int m1 = *cp++; // m1: pos
-               signed int m2 = *cp++; // m2: run
+               AddLiteral(m_source.m_data[pos]);
+               InsertHash(pos);
+               pos++;
+            }
+         }
+      }
 
-               m1 |= (m2 & 0xF0) << 4;
+   private:
+      /// finds longest match for the data at given position
+      size_t FindMatch(size_t pos, size_t& matchPos) const
+      {
+         size_t maxLength = std::min(c_uw2MaxCopyCount, m_source.m_size - pos);
+         if (maxLength < c_uw2MinCopyCount)
+            return 0;
 
-               // correct for sign bit
-               if (m1 & 0x800)
-                  m1 |= 0xFFFFF000;
+         const Uint8* data = m_source.m_data;
+         size_t bestLength = 0;
 
-               // add offsets
-               m2 = (m2 & 0x0F) + 3;
-               m1 += 18;
+         int candidate = m_hashHeads[Uw2Hash(data + pos)];
+         for (unsigned int chainLength = 0;
+            candidate >= 0 && chainLength < c_uw2MaxChainLength;
+            chainLength++)
+         {
+            size_t candidatePos = static_cast<size_t>(candidate);
+            if (pos - candidatePos > static_cast<size_t>(c_uw2WindowSize))
+               break;
 
-               destCount += m2; // add count
+            // matches may overlap the current position
+            size_t length = 0;
+            while (length < maxLength && data[candidatePos + length] == data[pos + length])
+               length++;
 
-               if (up != NULL)
-               {
-                  if (m1 > up - ubuf)
-                     throw Base::RuntimeException("Uw2DecodeData: pos exceeds buffer!");
+            if (length > bestLength)
+            {
+               bestLength = length;
+               matchPos = candidatePos;
 
-                  // adjust pos to current 4k segment
-                  while (m1 < (up - ubuf - 0x1000))
-                     m1 += 0x1000;
+               if (length == maxLength)
+                  break;
+            }
 
-                  //UaTrace("copy from: pos: %03x, run: %02x\n",m1,m2);
+            int next = m_hashChain[candidatePos & (c_uw2WindowSize - 1)];
+            if (next >= candidate)
+               break; // chain entry was already overwritten
 
-                  while (m2-- && up < ue)
-                     *up++ = ubuf[m1++];
-               }
-            }
+            candidate = next;
+         }
 
-            // stop if source or destination buffer pointer overrun
-            if (up >= ue || cp >= ce)
-               break;
+         return bestLength;
+      }
+
+      /// inserts hash for the data at given position
+      void InsertHash(size_t pos)
+      {
+         if (pos + c_uw2MinCopyCount > m_source.m_size)
+            return;
+
+         size_t hash = Uw2Hash(m_source.m_data + pos);
+         m_hashChain[pos & (c_uw2WindowSize - 1)] = m_hashHeads[hash];
+         m_hashHeads[hash] = static_cast<int>(pos);
+      }
+
+      /// starts a new flags byte, when necessary, and sets the flag for the next item
+      void AddFlag(bool isLiteral)
+      {
+         if (m_numItems == 8)
+         {
+            m_flagsPos = m_compressedData.size();
+            m_compressedData.push_back(0);
+            m_numItems = 0;
          }
+
+         if (isLiteral)
+            m_compressedData[m_flagsPos] |= static_cast<Uint8>(1 << m_numItems);
+
+         m_numItems++;
       }
 
-      //UaTrace(" decoded %04x compressed bytes to %04x uncompressed data.\n",
-      //   cp - &sourceData[4], destCount);
-      return destCount;
-   }
+      /// adds a literal byte
+      void AddLiteral(Uint8 value)
+      {
+         AddFlag(true);
+         m_compressedData.push_back(value);
+      }
 
-   /// \brief Close callback for SDL_RWops struct; used when reading decoded uw2 data
-   /// Frees memory when SDL_RWclose is called
-   /// \param rwops pointer to the rwops struct to be freed
-   int Uw2DecodeClose(SDL_RWops* rwops)
-   {
-      // free mem and reset pointers
-      delete[] rwops->hidden.mem.base;
-      rwops->hidden.mem.base = 0;
-      rwops->hidden.mem.here = 0;
-      rwops->hidden.mem.stop = 0;
-      return 0;
-   }
+      /// Adds a copy record; the decoder adjusts the stored 12-bit position
+      /// to the 4k window before the current position, so storing the
+      /// position modulo 4k is sufficient.
+      void AddCopyRecord(size_t pos, size_t matchPos, size_t matchLength)
+      {
+         UaAssert(matchPos < pos && pos - matchPos <= static_cast<size_t>(c_uw2WindowSize));
+
+         AddFlag(false);
+
+         unsigned int storedPos = (matchPos - c_uw2PositionOffset) & (c_uw2WindowSize - 1);
+         m_compressedData.push_back(static_cast<Uint8>(storedPos & 0xff));
+         m_compressedData.push_back(static_cast<Uint8>(((storedPos >> 4) & 0xf0) |
+            (matchLength - c_uw2MinCopyCount)));
+      }
+
+   private:
+      /// source data
+      Base::ByteSpan m_source;
+
+      /// compressed data
+      std::vector<Uint8>& m_compressedData;
+
+      /// most recent position for each hash value
+      std::vector<int> m_hashHeads;
+
+      /// previous position with the same hash, for the last 4k positions
+      std::vector<int> m_hashChain;
+
+      /// position of the current flags byte
+      size_t m_flagsPos;
+
+      /// number of items in the current flags byte
+      unsigned int m_numItems;
+   };
 
 } // namespace Detail
 
-/// Reads in compressed blocks from uw2 .ark files and creates a file with
-/// decoded data. Note that the given file must already be at the proper block
-/// start position.
+/// Each compressed byte expands to at most 9 decoded bytes, since a 2-byte
+/// copy record produces at most 18 bytes.
+/// \param source compressed source data of block
+/// \return maximum number of decoded bytes
+Uint32 Base::Uw2GetMaxDecodedSize(Base::ByteSpan source)
+{
+   if (source.m_size <= Detail::c_uw2HeaderSize)
+      return 0;
+
+   return static_cast<Uint32>((source.m_size - Detail::c_uw2HeaderSize) * 9);
+}
+
+/// Decodes compressed blocks from uw2 .ark files in a single pass. See
+/// uw-formats.txt for a detailed description how the data is compressed.
+/// Runs of 8 literal bytes and copy records that don't overlap the current
+/// position are copied in bulk. Copy records referring to positions before
+/// the start of the block produce zero bytes. The algorithm was originally
+/// adapted from the LoW project: http://low.sourceforge.net/
 ///
-/// \param file file in .ark format, at the block start position
-/// \param isCompressed indicates if block is actually compressed
-/// \param dataSize number of source bytes in block (either compressed or uncompressed)
-Base::File Base::Uw2Decode(const Base::File& file, bool isCompressed, Uint32 dataSize)
+/// \param source compressed source data of block
+/// \param destBuffer destination buffer
+/// \param destSize size of destination buffer; Uw2GetMaxDecodedSize() returns
+///        a size that is always sufficient
+/// \param decodedSize number of decoded bytes
+/// \return true when the block was decoded, or false when the destination
+///         buffer was too small
+bool Base::Uw2Decode(Base::ByteSpan source, Uint8* destBuffer, Uint32 destSize, Uint32& decodedSize)
 {
-   UaAssert(dataSize > 0); // trying to load entry that has size 0?
+   decodedSize = 0;
 
-   // read in source data
-   std::vector<Uint8> sourceData;
-   sourceData.resize(dataSize);
+   if (source.m_size <= Detail::c_uw2HeaderSize)
+      return true;
 
-   Uint8* destBuffer = NULL;
-   Uint32 destSize = dataSize;
+   // for some reason the first 4 bytes are not used
+   const Uint8* cp = source.m_data + Detail::c_uw2HeaderSize;
+   const Uint8* ce = source.m_data + source.m_size;
+   Uint8* up = destBuffer;
+   Uint8* ue = destBuffer + destSize;
 
-   if (isCompressed)
+   while (cp < ce)
    {
-      // read in data
-      file.ReadBuffer(&sourceData[0], dataSize);
+      unsigned int bits = *cp++;
 
-      // find out decoded length and allocate memory
-      destSize = Detail::Uw2DecodeData(sourceData, NULL, 0);
+      // fast path for 8 literal bytes
+      if (bits == 0xff && ce - cp >= 8 && ue - up >= 8)
+      {
+         memcpy(up, cp, 8);
+         up += 8;
+         cp += 8;
+         continue;
+      }
 
-      destBuffer = new Uint8[destSize];
+      for (int i = 0; i < 8 && cp < ce; i++, bits >>= 1)
+      {
+         if (bits & 1)
+         {
+            if (up >= ue)
+            {
+               decodedSize = static_cast<Uint32>(up - destBuffer);
+               return false;
+            }
 
-      // decode it
-      UaVerify(destSize == Detail::Uw2DecodeData(sourceData, destBuffer, destSize));
-   }
-   else
-   {
-      // just copy the data
-      destBuffer = new Uint8[dataSize];
-      file.ReadBuffer(destBuffer, dataSize);
+            *up++ = *cp++;
+            continue;
+         }
+
+         // incomplete copy record at the end of the block
+         if (ce - cp < 2)
+         {
+            cp = ce;
+            break;
+         }
+
+         int pos = cp[0] | ((cp[1] & 0xf0) << 4);
+         size_t count = (cp[1] & 0x0f) + Detail::c_uw2MinCopyCount;
+         cp += 2;
+
+         // correct for sign bit, and add offset
+         if (pos & 0x800)
+            pos -= Detail::c_uw2WindowSize;
+         pos += Detail::c_uw2PositionOffset;
+
+         int current = static_cast<int>(up - destBuffer);
+         if (pos > current)
+            throw Base::RuntimeException("Uw2Decode: pos exceeds buffer!");
+
+         // adjust pos to the 4k window before the current position
+         int windowStart = current - Detail::c_uw2WindowSize;
+         if (pos < windowStart)
+            pos += ((windowStart - pos + Detail::c_uw2WindowSize - 1) / Detail::c_uw2WindowSize) * Detail::c_uw2WindowSize;
+
+         if (count > static_cast<size_t>(ue - up))
+         {
+            decodedSize = static_cast<Uint32>(up - destBuffer);
+            return false;
+         }
+
+         // positions before the start of the block
+         for (; pos < 0 && count > 0; pos++, count--)
+            *up++ = 0;
+
+         if (static_cast<size_t>(pos) + count <= static_cast<size_t>(up - destBuffer))
+         {
+            memcpy(up, destBuffer + pos, count);
+            up += count;
+         }
+         else
+         {
+            // overlapping copy repeats the bytes just decoded
+            const Uint8* from = destBuffer + pos;
+            while (count--)
+               *up++ = *from++;
+         }
+      }
    }
 
-   // create rwops struct from decoded data
-   SDL_RWopsPtr rwops = MakeRWopsPtr(SDL_RWFromMem(destBuffer, destSize));
+   decodedSize = static_cast<Uint32>(up - destBuffer);
+   return true;
+}
+
+/// Encodes data so that Uw2Decode() restores it. The header stores the
+/// decoded size, which the decoder ignores.
+/// \param source data to encode
+/// \param compressedData compressed block data, including the header
+void Base::Uw2Encode(Base::ByteSpan source, std::vector<Uint8>& compressedData)
+{
+   compressedData.clear();
+   compressedData.reserve(Detail::c_uw2HeaderSize + source.m_size + source.m_size / 8 + 1);
 
-   rwops->close = Detail::Uw2DecodeClose;
+   Uint32 decodedSize = static_cast<Uint32>(source.m_size);
+   for (size_t index = 0; index < Detail::c_uw2HeaderSize; index++)
+      compressedData.push_back(static_cast<Uint8>(decodedSize >> (index * 8)));
 
-   return Base::File(rwops);
+   Detail::Uw2Encoder encoder{ source, compressedData };
+   encoder.Encode();
 }
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -17,15 +17,22 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 //
 /// \file Uw2decode.hpp
-/// \brief Ultima Underworld 2 .ark compression format decoder
+/// \brief Ultima Underworld 2 .ark compression format decoder and encoder
 //
 #pragma once
 
-#include "File.hpp"
+#include "MemoryMappedFile.hpp"
+#include <vector>
 
 namespace Base
 {
-   /// \brief decodes uw2 data block from .ark file and returns file with content
-   Base::File Uw2Decode(const Base::File& file, bool isCompressed, Uint32 dataSize);
+   /// returns maximum size of decoded data for a compressed uw2 data block
+   Uint32 Uw2GetMaxDecodedSize(ByteSpan source);
+
+   /// \brief decodes compressed uw2 data block from .ark file into buffer
+   bool Uw2Decode(ByteSpan source, Uint8* destBuffer, Uint32 destSize, Uint32& decodedSize);
+
+   /// \brief encodes data into compressed uw2 data block
+   void Uw2Encode(ByteSpan source, std::vector<Uint8>& compressedData);
 
 } // namespace Base
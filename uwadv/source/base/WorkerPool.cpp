@@ -0,0 +1,144 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerPool.cpp
+/// \brief pool of worker threads
+//
+#include "pch.hpp"
+#include "WorkerPool.hpp"
+
+using Base::WorkerPool;
+
+/// \param numThreads number of worker threads to start; when 0, all work is
+/// done on the calling thread
+WorkerPool::WorkerPool(unsigned int numThreads)
+{
+   m_threads.reserve(numThreads);
+   for (unsigned int index = 0; index < numThreads; index++)
+      m_threads.emplace_back(&WorkerPool::ThreadProc, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+   }
+
+   m_workAvailable.notify_all();
+
+   for (std::thread& thread : m_threads)
+      thread.join();
+}
+
+/// Runs a function for all work items, distributed on the worker threads and
+/// the calling thread. Returns when all items are done. When a work item
+/// throws an exception, the remaining items are still processed, and the
+/// first exception is re-thrown afterwards.
+/// \param numItems number of work items
+/// \param func function to call with the index of each work item
+void WorkerPool::Run(size_t numItems, const std::function<void(size_t)>& func)
+{
+   if (m_threads.empty() || numItems <= 1)
+   {
+      for (size_t item = 0; item < numItems; item++)
+         func(item);
+      return;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_func = &func;
+      m_numItems = numItems;
+      m_nextItem = 0;
+      m_numBusyThreads = m_threads.size();
+      m_exception = nullptr;
+      m_generation++;
+   }
+
+   m_workAvailable.notify_all();
+
+   WorkOnItems();
+
+   std::exception_ptr exception;
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_workDone.wait(lock, [&]() { return m_numBusyThreads == 0; });
+
+      m_func = nullptr;
+      exception = m_exception;
+      m_exception = nullptr;
+   }
+
+   if (exception != nullptr)
+      std::rethrow_exception(exception);
+}
+
+/// Returns the default number of worker threads, which is one less than the
+/// number of hardware threads, since the calling thread works, too.
+unsigned int WorkerPool::GetDefaultNumThreads()
+{
+   unsigned int numHardwareThreads = std::thread::hardware_concurrency();
+   return numHardwareThreads > 1 ? numHardwareThreads - 1 : 0;
+}
+
+void WorkerPool::ThreadProc()
+{
+   unsigned int lastGeneration = 0;
+
+   for (;;)
+   {
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_workAvailable.wait(lock,
+            [&]() { return m_stop || m_generation != lastGeneration; });
+
+         if (m_stop)
+            return;
+
+         lastGeneration = m_generation;
+      }
+
+      WorkOnItems();
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (--m_numBusyThreads == 0)
+         m_workDone.notify_one();
+   }
+}
+
+void WorkerPool::WorkOnItems()
+{
+   for (;;)
+   {
+      size_t item = m_nextItem++;
+      if (item >= m_numItems)
+         break;
+
+      try
+      {
+         (*m_func)(item);
+      }
+      catch (...)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (m_exception == nullptr)
+            m_exception = std::current_exception();
+      }
+   }
+}
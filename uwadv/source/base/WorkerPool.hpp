@@ -0,0 +1,105 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerPool.hpp
+/// \brief pool of worker threads
+//
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace Base
+{
+   /// \brief pool of worker threads
+   /// \details Runs a number of independent work items in parallel. The
+   /// threads are started once and wait for work between calls to Run(). The
+   /// calling thread works on items, too, and Run() returns when all items
+   /// are done. Work items must not access thread-bound resources, such as
+   /// the OpenGL context.
+   class WorkerPool
+   {
+   public:
+      /// ctor; starts worker threads
+      explicit WorkerPool(unsigned int numThreads = GetDefaultNumThreads());
+
+      /// dtor; stops worker threads
+      ~WorkerPool();
+
+      /// deleted copy ctor
+      WorkerPool(const WorkerPool&) = delete;
+      /// deleted assignment operator
+      WorkerPool& operator=(const WorkerPool&) = delete;
+
+      /// returns number of worker threads, not counting the calling thread
+      unsigned int GetNumThreads() const { return static_cast<unsigned int>(m_threads.size()); }
+
+      /// runs function for all work items and waits until all are done
+      void Run(size_t numItems, const std::function<void(size_t)>& func);
+
+      /// returns default number of worker threads for this machine
+      static unsigned int GetDefaultNumThreads();
+
+   private:
+      /// thread function of worker threads
+      void ThreadProc();
+
+      /// works on items until no items are left
+      void WorkOnItems();
+
+   private:
+      /// worker threads
+      std::vector<std::thread> m_threads;
+
+      /// mutex protecting the members below
+      std::mutex m_mutex;
+
+      /// signaled when new work is available, or the pool is stopped
+      std::condition_variable m_workAvailable;
+
+      /// signaled when all worker threads are done with the current work
+      std::condition_variable m_workDone;
+
+      /// function for the current work items
+      const std::function<void(size_t)>* m_func = nullptr;
+
+      /// number of current work items
+      size_t m_numItems = 0;
+
+      /// next work item to process
+      std::atomic<size_t> m_nextItem{ 0 };
+
+      /// number of worker threads still working on the current items
+      size_t m_numBusyThreads = 0;
+
+      /// counter that is increased for every call to Run()
+      unsigned int m_generation = 0;
+
+      /// indicates if the worker threads should stop
+      bool m_stop = false;
+
+      /// first exception thrown by a work item
+      std::exception_ptr m_exception;
+   };
+
+} // namespace Base
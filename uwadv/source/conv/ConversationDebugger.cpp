@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2005,2019,2021 Underworld Adventures Team
+// Copyright (c) 2005,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -158,10 +158,12 @@ DebugServerCodeDebuggerType ConversationDebugger::GetDebuggerType() const
 
 void ConversationDebugger::PrepareDebugInfo()
 {
-   std::vector<std::string> stringBlock =
+   const std::vector<std::string_view>& stringViews =
       m_gameLogic.GetGameStrings().GetStringBlock(
          m_codeVM.GetStringBlock());
 
+   std::vector<std::string> stringBlock{ stringViews.begin(), stringViews.end() };
+
    Conv::CodeGraph codeGraph(
       m_codeVM.GetCodeSegment(),
       0,
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -28,6 +28,7 @@
 #include "IndexedImage.hpp"
 #include "ImageManager.hpp"
 #include "LevelEditor.hpp"
+#include "physics/PhysicsModel.hpp"
 #include <algorithm>
 
 /// debugger lib context
@@ -532,8 +533,9 @@ void DebugServer::SetTileInfoValue(size_t level,
    unsigned int xpos, unsigned int ypos, unsigned int type,
    unsigned int value)
 {
-   Underworld::TileInfo& tile = m_game->GetUnderworld().GetLevelList().
-      GetLevel(level).GetTilemap().GetTileInfo(xpos, ypos);
+   Underworld::Tilemap& tilemap = m_game->GetUnderworld().GetLevelList().
+      GetLevel(level).GetTilemap();
+   Underworld::TileInfo& tile = tilemap.GetTileInfo(xpos, ypos);
 
    switch (type)
    {
@@ -551,12 +553,15 @@ void DebugServer::SetTileInfoValue(size_t level,
       break;
    case debuggerTileInfoTextureWall:
       tile.m_textureWall = static_cast<Uint16>(value);
+      tilemap.AddUsedTexture(tile.m_textureWall);
       break;
    case debuggerTileInfoTextureFloor:
       tile.m_textureFloor = static_cast<Uint16>(value);
+      tilemap.AddUsedTexture(tile.m_textureFloor);
       break;
    case debuggerTileInfoTextureCeiling:
       tile.m_textureCeiling = static_cast<Uint16>(value);
+      tilemap.AddUsedTexture(tile.m_textureCeiling);
       break;
    case debuggerTileInfoObjectListStart:
       UaAssert(false); // TODO implement
@@ -567,6 +572,37 @@ void DebugServer::SetTileInfoValue(size_t level,
       UaAssert(false);
       break;
    }
+
+   m_game->GetUnderworld().GetLevelList().SetLevelModified(level);
+
+   // update collision geometry when the tile's shape was modified
+   bool isCurrentLevel =
+      level == m_game->GetUnderworld().GetPlayer().GetAttribute(Underworld::attrMapLevel);
+
+   if (isCurrentLevel &&
+      (type == debuggerTileInfoType || type == debuggerTileInfoFloorHeight ||
+         type == debuggerTileInfoCeilingHeight || type == debuggerTileInfoSlope))
+      m_game->GetPhysicsModel().InvalidateTile(xpos, ypos);
+
+   // let the renderers prepare tile geometry and textures again
+   if (isCurrentLevel)
+   {
+      IUserInterface* userInterface = m_game->GetGameLogic().GetUserInterface();
+      if (userInterface != NULL)
+         userInterface->Notify(notifyTilemapChanged);
+
+      m_levelEditors.erase(
+         std::remove_if(m_levelEditors.begin(), m_levelEditors.end(),
+            [](const std::weak_ptr<LevelEditor>& levelEditor) { return levelEditor.expired(); }),
+         m_levelEditors.end());
+
+      for (const std::weak_ptr<LevelEditor>& weakLevelEditor : m_levelEditors)
+      {
+         std::shared_ptr<LevelEditor> levelEditor = weakLevelEditor.lock();
+         if (levelEditor != nullptr)
+            levelEditor->InvalidateTilemap();
+      }
+   }
 }
 
 bool DebugServer::IsObjectListIndexAvail(size_t level, size_t pos) const
@@ -697,6 +733,8 @@ void DebugServer::SetObjectListInfo(size_t level,
       UaAssert(false);
       break;
    }
+
+   m_game->GetUnderworld().GetLevelList().SetLevelModified(level);
 }
 
 bool DebugServer::EnumGameStringsBlocks(size_t index,
@@ -721,7 +759,7 @@ bool DebugServer::EnumGameStringsBlocks(size_t index,
 
 size_t DebugServer::GetGameStringsBlockSize(size_t block)
 {
-   const std::vector<std::string>& stringBlock = m_game->GetGameStrings().GetStringBlock(static_cast<Uint16>(block));
+   const std::vector<std::string_view>& stringBlock = m_game->GetGameStrings().GetStringBlock(static_cast<Uint16>(block));
 
    return stringBlock.size();
 }
@@ -766,7 +804,7 @@ bool DebugServer::GetObjectListImagelist(size_t& numObjects, unsigned char* buff
       memcpy(&pixels[index * xres * yres], &imageList[index].GetPixels()[0], xres * yres);
 
    // convert color indices to 32-bit texture
-   Uint32* palptr = reinterpret_cast<Uint32*>(imageList[0].GetPalette().get());
+   Uint32* palptr = reinterpret_cast<Uint32*>(imageList[0].GetPalette()->Get());
    Uint32* texptr = reinterpret_cast<Uint32*>(buffer);
 
    for (size_t index = 0; index < xres * yres * max; index++)
@@ -787,9 +825,14 @@ ICodeDebugger* DebugServer::GetCodeDebugger(unsigned int debuggerId)
 
 std::shared_ptr<LevelEditor> DebugServer::CreateLevelEditor(const void* windowHandle)
 {
-   return std::make_shared<LevelEditor>(
+   std::shared_ptr<LevelEditor> levelEditor = std::make_shared<LevelEditor>(
       *m_game,
       windowHandle);
+
+   // remember level editor, to notify it when tiles are modified
+   m_levelEditors.push_back(levelEditor);
+
+   return levelEditor;
 }
 
 void DebugServer::AddMessage(DebugServerMessage& msg)
@@ -213,6 +213,9 @@ private:
    /// id of last code debugger
    unsigned int m_lastCodeDebuggerId;
 
+   /// all level editors created through the debug server
+   std::vector<std::weak_ptr<LevelEditor>> m_levelEditors;
+
    /// indicates if the debug server is running in the studio environment
    bool m_isStudioMode = false;
 };
@@ -25,6 +25,7 @@
 #include "GameConfigLoader.hpp"
 #include "import/Import.hpp"
 #include "import/GameStringsImporter.hpp"
+#include "import/LevelImporter.hpp"
 #include "physics/GeometryProvider.hpp"
 
 GameInstance::GameInstance()
@@ -132,6 +133,10 @@ void GameInstance::Tick(double elapsed)
 
 void GameInstance::InitGame()
 {
+   // stop loading levels in the background before the resources change
+   if (m_gameLogic != nullptr)
+      GetUnderworld().GetLevelList().CancelPrefetch();
+
    // rescan, with proper underworld path
    m_resourceManager->Rescan(m_settings);
 
@@ -153,6 +158,15 @@ void GameInstance::InitGame()
 
    m_gameLogic = std::make_unique<Underworld::GameLogic>(m_scripting.get());
 
+   // levels of the original games are loaded from the game files when first
+   // needed; this is also needed for savegames, which only store modified
+   // levels
+   if (gamePrefix == "uw1" || gamePrefix == "uw2" || gamePrefix == "uw_demo")
+   {
+      Import::LevelImporter levelImporter{ GetResourceManager() };
+      levelImporter.LoadLevels(m_settings, GetUnderworld().GetLevelList());
+   }
+
    UaTrace("loading game strings ... ");
    Import::GameStringsImporter importer(GetGameStrings());
    importer.LoadDefaultStringsPakFile(GetResourceManager());
@@ -62,6 +62,11 @@ void LevelEditor::SetWindowSize(unsigned int width, unsigned int height)
    m_viewport->SetViewport3D(0, 0, width, height);
 }
 
+void LevelEditor::InvalidateTilemap()
+{
+   m_renderer->InvalidateTilemap();
+}
+
 void LevelEditor::Render()
 {
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
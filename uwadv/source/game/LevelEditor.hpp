@@ -38,6 +38,9 @@ public:
    /// changes window size
    void SetWindowSize(unsigned int width, unsigned int height);
 
+   /// invalidates the tile geometry, e.g. after tiles were modified
+   void InvalidateTilemap();
+
    /// renders the underworld level being edited
    void Render();
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,6 +24,7 @@
 #include "ResourceManager.hpp"
 #include "File.hpp"
 #include "ArchiveFile.hpp"
+#include "MemoryReader.hpp"
 #include "CodeVM.hpp"
 #include "Exception.hpp"
 
@@ -82,12 +83,8 @@ void Import::LoadConvGlobals(Underworld::ConvGlobals& convGlobals,
 bool Import::LoadConvCode(Conv::CodeVM& vm, Base::Settings& settings, Base::ResourceManager& resourceManager,
    const char* cnvArkFilename, Uint16 conversationSlot)
 {
-   Base::SDL_RWopsPtr rwops = resourceManager.GetUnderworldFile(Base::resourceGameUw, cnvArkFilename);
-   if (rwops == NULL)
-      throw Base::Exception("could not open conversation file");
-
    bool isUw2 = settings.GetGameType() == Base::gameUw2;
-   Base::ArchiveFile arkFile(rwops, isUw2);
+   Base::ArchiveFile arkFile(resourceManager.MapUnderworldFile(Base::resourceGameUw, cnvArkFilename), isUw2);
 
    if (conversationSlot >= arkFile.GetNumFiles())
       throw Base::Exception("invalid conversation!");
@@ -98,7 +95,7 @@ bool Import::LoadConvCode(Conv::CodeVM& vm, Base::Settings& settings, Base::Reso
       return false;
    }
 
-   Base::File file = arkFile.GetFile(conversationSlot);
+   Base::MemoryReader file{ arkFile.GetBlock(conversationSlot) };
 
    Uint32 unknown1 = file.Read32(); // always 0x00000828
    UaAssert(unknown1 == 0x0828);
@@ -126,8 +123,6 @@ bool Import::LoadConvCode(Conv::CodeVM& vm, Base::Settings& settings, Base::Reso
    for (Uint16 i = 0; i < codeSize; i++)
       code[i] = file.Read16();
 
-   file.Close();
-
    // fix for Marrowsuck conversation; it has a wrong opcode on 0x076e
    if (conversationSlot == 6)
    {
@@ -154,7 +149,7 @@ bool Import::LoadConvCode(Conv::CodeVM& vm, Base::Settings& settings, Base::Reso
    return true;
 }
 
-void Import::LoadConvCodeImportedFunctions(Conv::CodeVM& vm, Base::File& file)
+void Import::LoadConvCodeImportedFunctions(Conv::CodeVM& vm, Base::MemoryReader& file)
 {
    std::map<Uint16, Conv::ImportedItem>& importedFunctions = vm.GetImportedFunctions();
    std::map<Uint16, Conv::ImportedItem>& importedGlobals = vm.GetImportedGlobals();
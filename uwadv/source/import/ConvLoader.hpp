@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,7 +27,7 @@ namespace Base
 {
    class ResourceManager;
    class Settings;
-   class File;
+   class MemoryReader;
 }
 
 namespace Underworld
@@ -52,6 +52,6 @@ namespace Import
       const char* cnvArkFilename, Uint16 conversationSlot);
 
    /// Loads imported functions list
-   void LoadConvCodeImportedFunctions(Conv::CodeVM& vm, Base::File& file);
+   void LoadConvCodeImportedFunctions(Conv::CodeVM& vm, Base::MemoryReader& file);
 
 } // namespace Import
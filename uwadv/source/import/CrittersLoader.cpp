@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,7 +24,7 @@
 #include "Critter.hpp"
 #include "CrittersLoader.hpp"
 #include "ResourceManager.hpp"
-#include "File.hpp"
+#include "MemoryReader.hpp"
 #include "String.hpp"
 #include <SDL2/SDL.h>
 
@@ -34,7 +34,7 @@
 //#define OMIT_1ST_PASS
 #undef OMIT_1ST_PASS
 
-void ImageDecodeRLE(Base::File& file, Uint8* pixels, unsigned int bits,
+void ImageDecodeRLE(Base::MemoryReader& file, Uint8* pixels, unsigned int bits,
    unsigned int datalen, unsigned int maxpix, unsigned char* auxPalettes,
    unsigned int padding = 0, unsigned int lineWidth = 0);
 
@@ -75,18 +75,18 @@ void Import::CrittersLoader::LoadCritterFrames(Critter& critter, const char* fil
    m_hotspotXYCoordinates.clear();
    m_imageSizes.clear();
 
-   Base::File segmentFileUw2;
+   Base::MemoryReader segmentFileUw2;
 
    unsigned char pageMapUw2[32][8] = {};
    if (isUw2)
    {
       // TODO load pg.mp only once for all animations
-      Base::File pageMapFile =
-         m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "crit/pg.mp");
+      Base::MemoryReader pageMapFile{
+         m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "crit/pg.mp") };
       pageMapFile.ReadBuffer(&pageMapUw2[0][0], sizeof(pageMapUw2));
 
-      segmentFileUw2 =
-         m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "crit/cr.an");
+      segmentFileUw2 = Base::MemoryReader{
+         m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "crit/cr.an") };
    }
 
    // do 2-pass loading:
@@ -140,7 +140,7 @@ void Import::CrittersLoader::LoadCritterFrames(Critter& critter, const char* fil
          if (!m_resourceManager.IsUnderworldFileAvailable(pagefile.c_str()))
             break; // no more page files
 
-         Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, pagefile.c_str());
+         Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, pagefile.c_str()) };
 
          // load animation
          Uint8 auxpal[32];
@@ -352,9 +352,6 @@ void Import::CrittersLoader::LoadCritterFrames(Critter& critter, const char* fil
             frame_offset += noffsets;
          }
 
-         // close pagefile
-         file.Close();
-
          // end of page file
          curpage++;
       }
@@ -379,7 +376,7 @@ void Import::CrittersLoader::LoadCrittersUw1(std::vector<Critter>& allCritters,
    const char* assocname =
       m_settings.GetBool(Base::settingUw1IsUwdemo) ? "crit/dassoc.anm" : "crit/assoc.anm";
 
-   Base::File assoc = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, assocname);
+   Base::MemoryReader assoc{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, assocname) };
    if (!assoc.IsOpen())
       throw Base::Exception("could not find assoc.anm");
 
@@ -447,7 +444,7 @@ void Import::CrittersLoader::LoadCrittersUw2(std::vector<Critter>& allCritters,
    unsigned int now = SDL_GetTicks();
 
    // load infos from "as.an"
-   Base::File assoc = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "crit/as.an");
+   Base::MemoryReader assoc{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "crit/as.an") };
    if (!assoc.IsOpen())
       throw Base::Exception("could not find as.an");
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,19 +23,18 @@
 #include "GameStringsImporter.hpp"
 #include "ResourceManager.hpp"
 #include "GameStrings.hpp"
+#include "HuffmanDecoder.hpp"
+#include "MemoryReader.hpp"
+#include "BitReader.hpp"
 
 using Import::GameStringsImporter;
 
-// define this when you can be sure the strings.pak is correct;
-// speeds up loading a bit
-#define HAVE_CORRECT_STRINGS_FILE
-
 /// Opens the strings.pak file in the data folder of the game. Files for uw1
 /// and uw2 have the same format.
 /// \param resourceManager resource manager
 void GameStringsImporter::LoadDefaultStringsPakFile(Base::ResourceManager& resourceManager)
 {
-   LoadStringsPakFile(resourceManager.GetUnderworldFile(Base::resourceGameUw, "data/strings.pak"));
+   LoadStringsPakFile(resourceManager.MapUnderworldFile(Base::resourceGameUw, "data/strings.pak"));
 }
 
 /// Opens a strings.pak file or a file that has the same format (e.g. created
@@ -50,137 +49,99 @@ void GameStringsImporter::LoadStringsPakFile(const char* filename)
    LoadStringsPakFile(Base::MakeRWopsPtr(rwops));
 }
 
+/// Reads the whole strings.pak file into memory before decoding it.
+/// \param rwops RWops object to read from
 void GameStringsImporter::LoadStringsPakFile(Base::SDL_RWopsPtr rwops)
 {
-   m_pak = Base::File(rwops);
-
-   m_fileSize = m_pak.FileLength();
+   LoadStringsPakFile(std::make_shared<Base::MemoryMappedFile>(rwops));
+}
 
-   m_allNodes.clear();
-   m_allBlockOffsets.clear();
+/// Reads the huffman tree and the block offsets. String blocks that are
+/// already present in the game strings object are replaced. The string blocks
+/// keep the memory mapped file alive until they are decoded.
+/// \param file memory mapped strings.pak file
+void GameStringsImporter::LoadStringsPakFile(std::shared_ptr<const Base::MemoryMappedFile> file)
+{
+   Base::MemoryReader pak{ file };
 
-   Uint16 numNodes = m_pak.Read16();
+   Uint16 numNodes = pak.Read16();
 
-   m_allNodes.resize(numNodes);
+   std::vector<HuffmanDecoder::Node> allNodes;
+   allNodes.resize(numNodes);
    for (Uint16 nodeIndex = 0; nodeIndex < numNodes; nodeIndex++)
    {
-      m_allNodes[nodeIndex].symbol = m_pak.Read8();
-      m_allNodes[nodeIndex].parent = m_pak.Read8();
-      m_allNodes[nodeIndex].left = m_pak.Read8();
-      m_allNodes[nodeIndex].right = m_pak.Read8();
+      allNodes[nodeIndex].symbol = pak.Read8();
+      allNodes[nodeIndex].parent = pak.Read8();
+      allNodes[nodeIndex].left = pak.Read8();
+      allNodes[nodeIndex].right = pak.Read8();
    }
 
-   Uint16 numBlocks = m_pak.Read16();
+   auto decoder = std::make_shared<const HuffmanDecoder>(allNodes);
 
-   for (Uint16 blockIndex = 0; blockIndex < numBlocks; blockIndex++)
-   {
-      Uint16 blockId = m_pak.Read16();
-      Uint32 offset = m_pak.Read32();
+   Uint16 numBlocks = pak.Read16();
 
-      m_allBlockOffsets[blockId] = offset;
-   }
-
-   for (auto iter = m_allBlockOffsets.begin(); iter != m_allBlockOffsets.end(); iter++)
+   for (Uint16 blockIndex = 0; blockIndex < numBlocks; blockIndex++)
    {
-      Uint16 blockId = iter->first;
-
-      if (!m_gs.IsBlockAvail(blockId))
-      {
-         m_gs.GetStringBlockSet().insert(blockId);
+      Uint16 blockId = pak.Read16();
+      Uint32 offset = pak.Read32();
 
-         m_gs.GetAllStrings()[blockId] = std::vector<std::string>();
-      }
-
-      LoadStringBlock(blockId);
+      m_gs.SetStringBlock(blockId,
+         [file, decoder, offset](std::string& text, std::vector<std::string_view>& strings)
+         {
+            DecodeStringBlock(*file, *decoder, offset, text, strings);
+         });
    }
 }
 
-/// Loads a single string block from file.
-/// \param blockId block id of string block to load
-/// \param strblock strings array that gets filled
-void GameStringsImporter::LoadStringBlock(Uint16 blockId)
+/// Decodes all strings of a string block. The strings are stored one after
+/// another in the text, and the string views are set up after decoding, since
+/// the text may be reallocated while decoding.
+/// \param pak memory mapped strings.pak file
+/// \param decoder huffman decoder for the .pak file
+/// \param offset offset of string block in the file
+/// \param text text to store all decoded strings
+/// \param strings string views to the decoded strings
+void GameStringsImporter::DecodeStringBlock(const Base::MemoryMappedFile& pak,
+   const HuffmanDecoder& decoder, Uint32 offset,
+   std::string& text, std::vector<std::string_view>& strings)
 {
-   std::vector<std::string>& stringBlock = m_gs.GetAllStrings()[blockId];
-   stringBlock.clear();
+   Base::ByteSpan block = pak.GetSpan(offset, pak.GetSize());
+   Base::MemoryReader blockReader{ block };
 
-   std::map<Uint16, Uint32>::iterator iter = m_allBlockOffsets.find(blockId);
-   if (iter == m_allBlockOffsets.end())
-   {
-      UaTrace("loading string block %04x failed\n", blockId);
-      return;
-   }
-
-   Uint32 offset = m_allBlockOffsets[blockId];
-
-   m_pak.Seek(offset, Base::seekBegin);
-
-   Uint16 numStrings = m_pak.Read16();
+   Uint16 numStrings = blockReader.Read16();
 
    // all string offsets
    std::vector<Uint16> stringOffsets;
    stringOffsets.resize(numStrings);
 
    for (Uint16 offsetIndex = 0; offsetIndex < numStrings; offsetIndex++)
-      stringOffsets[offsetIndex] = m_pak.Read16();
+      stringOffsets[offsetIndex] = blockReader.Read16();
+
+   size_t stringsStart = (numStrings + 1) * sizeof(Uint16);
 
-   Uint32 currentOffset = offset + (numStrings + 1) * sizeof(Uint16);
-   size_t nodenum = m_allNodes.size();
+   std::vector<size_t> stringEnds;
+   stringEnds.reserve(numStrings);
 
    for (Uint16 stringIndex = 0; stringIndex < numStrings; stringIndex++)
    {
-      m_pak.Seek(currentOffset + stringOffsets[stringIndex], Base::seekBegin);
-
-      char c;
-      std::string str;
+      size_t stringStart = std::min(stringsStart + stringOffsets[stringIndex], block.m_size);
 
-      int bit = 0;
-      int raw = 0;
+      Base::BitReader bitReader{
+         Base::ByteSpan{ block.m_data + stringStart, block.m_size - stringStart } };
 
-      do
-      {
-         size_t node = nodenum - 1; // starting node
-
-         // huffman tree decode loop
-         while (char(m_allNodes[node].left) != -1 && char(m_allNodes[node].right) != -1)
-         {
-            if (bit == 0)
-            {
-               bit = 8;
-               raw = m_pak.Read8();
-
-#ifndef HAVE_CORRECT_STRINGS_FILE
-               if (m_pak.Tell() >= m_fileSize)
-               {
-                  // premature end of file, should not happen
-                  stringIndex = numStrings;
-                  //blockId=sblocks;
-                  break;
-               }
-#endif
-            }
-
-            // decide which node is next
-            node = raw & 0x80 ? short(m_allNodes[node].right)
-               : short(m_allNodes[node].left);
-
-            raw <<= 1;
-            bit--;
-         }
-#ifndef HAVE_CORRECT_STRINGS_FILE
-         if (m_pak.Tell() >= m_fileSize)
-            break;
-#endif
-
-         // have a new symbol
-         c = static_cast<char>(m_allNodes[node].symbol);
-         if (c != '|')
-            str.append(1, c);
-
-      } while (c != '|');
-
-      stringBlock.push_back(str);
+      decoder.DecodeString(bitReader, text);
+      stringEnds.push_back(text.size());
    }
 
    // remove excess memory
-   std::vector<std::string>(stringBlock).swap(stringBlock);
+   text.shrink_to_fit();
+
+   strings.reserve(numStrings);
+
+   size_t stringStart = 0;
+   for (size_t stringEnd : stringEnds)
+   {
+      strings.push_back(std::string_view{ text.data() + stringStart, stringEnd - stringStart });
+      stringStart = stringEnd;
+   }
 }
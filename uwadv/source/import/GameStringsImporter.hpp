@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,9 +22,11 @@
 #pragma once
 
 #include "Base.hpp"
-#include "File.hpp"
-#include <map>
+#include "MemoryMappedFile.hpp"
 #include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
 
 class GameStrings;
 
@@ -35,7 +37,11 @@ namespace Base
 
 namespace Import
 {
-   /// importer for game strings
+   class HuffmanDecoder;
+
+   /// \brief importer for game strings
+   /// \details Only reads the huffman tree and the block offsets when loading;
+   /// the string blocks are decoded when they are first accessed.
    class GameStringsImporter
    {
    public:
@@ -54,34 +60,18 @@ namespace Import
       /// loads strings.pak file from RWops object
       void LoadStringsPakFile(Base::SDL_RWopsPtr rwops);
 
-   private:
-      /// loads string block from open .pak file
-      void LoadStringBlock(Uint16 blockId);
+      /// loads strings.pak file from memory mapped file
+      void LoadStringsPakFile(std::shared_ptr<const Base::MemoryMappedFile> file);
 
    private:
-      /// strings.pak huffman node structure
-      struct StringsPakHuffmanNode
-      {
-         int symbol; ///< character symbol in that node
-         int parent; ///< parent node
-         int left;   ///< left node (-1 when no node)
-         int right;  ///< right node
-      };
+      /// decodes string block at given offset of the .pak file
+      static void DecodeStringBlock(const Base::MemoryMappedFile& pak,
+         const HuffmanDecoder& decoder, Uint32 offset,
+         std::string& text, std::vector<std::string_view>& strings);
 
+   private:
       /// game strings object to populate
       GameStrings& m_gs;
-
-      /// .pak file
-      Base::File m_pak;
-
-      /// file size of .pak file
-      long m_fileSize;
-
-      /// a map of all blocks and their offsets available in the file
-      std::map<Uint16, Uint32> m_allBlockOffsets;
-
-      /// a vector with all huffman nodes for the given .pak file
-      std::vector<StringsPakHuffmanNode> m_allNodes;
    };
 
 } // namespace Import
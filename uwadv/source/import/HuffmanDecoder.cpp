@@ -0,0 +1,99 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file HuffmanDecoder.cpp
+/// \brief Huffman decoder for strings.pak files
+//
+#include "pch.hpp"
+#include "HuffmanDecoder.hpp"
+#include "BitReader.hpp"
+
+using Import::HuffmanDecoder;
+
+/// Nodes with child indices that don't point to a valid node are treated as
+/// leaf nodes.
+/// \param allNodes all huffman nodes; the last node is the root node
+HuffmanDecoder::HuffmanDecoder(const std::vector<Node>& allNodes)
+   :m_allNodes(allNodes)
+{
+   for (size_t nodeIndex = 0; nodeIndex < m_allNodes.size(); nodeIndex++)
+   {
+      Node& node = m_allNodes[nodeIndex];
+      if (!IsLeaf(nodeIndex) &&
+         (node.left >= m_allNodes.size() || node.right >= m_allNodes.size()))
+      {
+         UaTrace("invalid huffman node %zu; treating it as leaf\n", nodeIndex);
+         node.left = node.right = 0xff;
+      }
+   }
+
+   if (m_allNodes.empty())
+      return;
+
+   // walk the tree for all possible bit combinations
+   m_lookupTable.resize(1 << c_lookupBits);
+
+   size_t rootIndex = m_allNodes.size() - 1;
+   for (unsigned int bits = 0; bits < m_lookupTable.size(); bits++)
+   {
+      size_t nodeIndex = rootIndex;
+      unsigned int numBits = 0;
+
+      while (numBits < c_lookupBits && !IsLeaf(nodeIndex))
+      {
+         unsigned int bit = (bits >> (c_lookupBits - 1 - numBits)) & 1;
+         nodeIndex = GetChild(nodeIndex, bit);
+         numBits++;
+      }
+
+      LookupEntry& entry = m_lookupTable[bits];
+      entry.m_nodeIndex = static_cast<Uint16>(nodeIndex);
+      entry.m_numBits = static_cast<Uint8>(numBits);
+   }
+}
+
+/// Decodes symbols until the end marker '|' is found, or the end of the data
+/// was reached. Checking for the end of the data also ensures that decoding
+/// ends for trees that contain cycles.
+/// \param bitReader bit reader positioned at the start of the string
+/// \param text text to append the string to; the end marker isn't appended
+void HuffmanDecoder::DecodeString(Base::BitReader& bitReader, std::string& text) const
+{
+   // a tree with a single node wouldn't use up any bits
+   if (m_allNodes.empty() || IsLeaf(m_allNodes.size() - 1))
+      return;
+
+   while (!bitReader.IsAtEnd())
+   {
+      const LookupEntry& entry = m_lookupTable[bitReader.PeekBits(c_lookupBits)];
+      bitReader.SkipBits(entry.m_numBits);
+
+      size_t nodeIndex = entry.m_nodeIndex;
+      while (!IsLeaf(nodeIndex) && !bitReader.IsAtEnd())
+         nodeIndex = GetChild(nodeIndex, bitReader.ReadBits(1));
+
+      if (!IsLeaf(nodeIndex))
+         break; // premature end of data
+
+      char symbol = static_cast<char>(m_allNodes[nodeIndex].symbol);
+      if (symbol == '|')
+         break;
+
+      text.push_back(symbol);
+   }
+}
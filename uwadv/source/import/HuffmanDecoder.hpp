@@ -0,0 +1,95 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file HuffmanDecoder.hpp
+/// \brief Huffman decoder for strings.pak files
+//
+#pragma once
+
+#include "Base.hpp"
+#include <vector>
+#include <string>
+
+namespace Base
+{
+   class BitReader;
+}
+
+namespace Import
+{
+   /// \brief Huffman decoder for strings.pak files
+   /// \details Decodes symbols using a lookup table that is indexed with the
+   /// next c_lookupBits bits of the stream. Each table entry contains the node
+   /// reached after walking the Huffman tree with these bits, and the number
+   /// of bits actually used. When the node is a leaf, the symbol is decoded in
+   /// a single step; only longer codes walk the rest of the tree bit by bit.
+   class HuffmanDecoder
+   {
+   public:
+      /// strings.pak huffman node structure
+      struct Node
+      {
+         Uint8 symbol; ///< character symbol in that node
+         Uint8 parent; ///< parent node
+         Uint8 left;   ///< left node (0xff when no node)
+         Uint8 right;  ///< right node
+      };
+
+      /// ctor; takes all huffman nodes, with the last one being the root node
+      explicit HuffmanDecoder(const std::vector<Node>& allNodes);
+
+      /// decodes a string and appends it to the text
+      void DecodeString(Base::BitReader& bitReader, std::string& text) const;
+
+   private:
+      /// returns if node is a leaf node
+      bool IsLeaf(size_t nodeIndex) const
+      {
+         const Node& node = m_allNodes[nodeIndex];
+         return node.left == 0xff || node.right == 0xff;
+      }
+
+      /// returns the child node for given bit
+      size_t GetChild(size_t nodeIndex, unsigned int bit) const
+      {
+         const Node& node = m_allNodes[nodeIndex];
+         return bit != 0 ? node.right : node.left;
+      }
+
+   private:
+      /// number of bits used to index the lookup table
+      static const unsigned int c_lookupBits = 10;
+
+      /// lookup table entry
+      struct LookupEntry
+      {
+         /// node reached after walking the tree
+         Uint16 m_nodeIndex;
+
+         /// number of bits used to reach the node
+         Uint8 m_numBits;
+      };
+
+      /// all huffman nodes
+      std::vector<Node> m_allNodes;
+
+      /// lookup table, indexed by the next c_lookupBits bits
+      std::vector<LookupEntry> m_lookupTable;
+   };
+
+} // namespace Import
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,24 +23,24 @@
 #include "ImageLoader.hpp"
 #include "IndexedImage.hpp"
 #include "ResourceManager.hpp"
+#include "MemoryReader.hpp"
+#include "BitReader.hpp"
 #include <algorithm>
 
 using Import::ImageLoader;
 
 /// decodes the underworld rle format, for word lengths up to 8 bit, and
-/// stores the pixels in an array.
-void ImageDecodeRLE(Base::File& file, Uint8* pixels, unsigned int bits,
+/// stores the pixels in an array. The data is read starting at the current
+/// position of the given reader.
+void ImageDecodeRLE(Base::MemoryReader& file, Uint8* pixels, unsigned int bits,
    unsigned int datalen, unsigned int maxpix, unsigned char* auxPalettes,
    unsigned int padding = 0, unsigned int lineWidth = 0)
 {
    unsigned int linecount = 0;
    unsigned int bufpos = 0;
 
-   // bit extraction variables
-   unsigned int bits_avail = 0;
-   unsigned int rawbits = 0;
-   unsigned int bitmask = ((1 << bits) - 1) << (8 - bits);
-   unsigned int nibble;
+   // bit extraction
+   Base::BitReader bitReader{ file.GetRemaining() };
 
    // rle decoding vars
    unsigned int pixcount = 0;
@@ -52,38 +52,7 @@ void ImageDecodeRLE(Base::File& file, Uint8* pixels, unsigned int bits,
    while (datalen > 0 && pixcount < maxpix)
    {
       // get new bits
-      if (bits_avail < bits)
-      {
-         // not enough bits available
-         if (bits_avail > 0)
-         {
-            nibble = ((rawbits & bitmask) >> (8 - bits_avail));
-            nibble <<= (bits - bits_avail);
-         }
-         else
-            nibble = 0;
-
-         rawbits = (unsigned int)file.Read8();
-         if ((int)rawbits == EOF)
-            return;
-
-         //printf("fgetc: %02x\n",rawbits);
-
-         unsigned int shiftval = 8 - (bits - bits_avail);
-
-         nibble |= (rawbits >> shiftval);
-
-         rawbits = (rawbits << (8 - shiftval)) & 0xFF;
-
-         bits_avail = shiftval;
-      }
-      else
-      {
-         // we still have enough bits
-         nibble = (rawbits & bitmask) >> (8 - bits);
-         bits_avail -= bits;
-         rawbits <<= bits;
-      }
+      unsigned int nibble = bitReader.ReadBits(bits);
 
       //printf("nibble: %02x\n",nibble);
 
@@ -231,7 +200,7 @@ void ImageDecodeRLE(Base::File& file, Uint8* pixels, unsigned int bits,
 void ImageLoader::LoadPalettes(Palette256Ptr allPalettes[8])
 {
    const char* allPalettesName = "data/pals.dat";
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, allPalettesName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, allPalettesName) };
    if (!file.IsOpen())
    {
       std::string text("could not open palette file ");
@@ -261,7 +230,7 @@ void ImageLoader::LoadAuxPalettes(Uint8 allAuxPalettes[32][16])
 {
    const char* auxPalettesName = "data/allpals.dat";
 
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, auxPalettesName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, auxPalettesName) };
    if (!file.IsOpen())
       throw Base::Exception("could not open file allpals.dat");
 
@@ -273,7 +242,7 @@ void ImageLoader::LoadAuxPalettes(Uint8 allAuxPalettes[32][16])
 void ImageLoader::LoadImageGr(IndexedImage& image, const char* imageName,
    unsigned int imageNumber, Uint8 allAuxPalettes[32][16])
 {
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, imageName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, imageName) };
    if (!file.IsOpen())
    {
       std::string text("could not open image: ");
@@ -311,7 +280,7 @@ void ImageLoader::LoadImageGr(IndexedImage& image, const char* imageName,
 
 void ImageLoader::LoadImageByt(const char* imageName, Uint8* pixels)
 {
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, imageName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, imageName) };
    if (!file.IsOpen())
    {
       std::string text("could not open raw image: ");
@@ -327,7 +296,7 @@ void ImageLoader::LoadImageGrList(std::vector<IndexedImage>& imageList,
    const char* imageName, unsigned int imageFrom, unsigned int imageTo,
    Uint8 allAuxPalettes[32][16])
 {
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, imageName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, imageName) };
    if (!file.IsOpen())
    {
       std::string text("could not open image list: ");
@@ -379,7 +348,7 @@ void ImageLoader::LoadImageGrList(std::vector<IndexedImage>& imageList,
    }
 }
 
-void ImageLoader::LoadImageGrImpl(IndexedImage& img, Base::File& file,
+void ImageLoader::LoadImageGrImpl(IndexedImage& img, Base::MemoryReader& file,
    Uint8 auxPalettes[32][16], bool isSpecialPanelsGr, bool isUw2)
 {
    Uint8 type, width, height, auxpal = 0;
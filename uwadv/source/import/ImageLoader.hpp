@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,7 +27,7 @@ namespace Base
 {
    class Settings;
    class ResourceManager;
-   class File;
+   class MemoryReader;
 }
 
 class IndexedImage;
@@ -64,7 +64,7 @@ namespace Import
 
    private:
       /// loads *.gr image into pixels array
-      void LoadImageGrImpl(IndexedImage& image, Base::File& file, Uint8 auxPalettes[32][16],
+      void LoadImageGrImpl(IndexedImage& image, Base::MemoryReader& file, Uint8 auxPalettes[32][16],
          bool isSpecialPanelsGr, bool isUw2);
 
    private:
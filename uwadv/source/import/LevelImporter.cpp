@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -50,88 +50,111 @@ void LevelImporter::LoadLevels(const Base::Settings& settings, Underworld::Level
    }
 }
 
+/// Levels are loaded when first accessed, possibly on a worker thread; the
+/// resource manager must outlive the level list. The uw1 and uw2 levels share
+/// the memory mapped lev.ark file, which is only read from.
 void LevelImporter::LoadUwDemoLevel(Underworld::LevelList& levelList)
 {
-   UaTrace("importing uw_demo level map\n");
+   Base::ResourceManager& resourceManager = m_resourceManager;
+
+   levelList.Create(1,
+      [&resourceManager](size_t, Underworld::Level& level)
+      {
+         LevelImporter importer{ resourceManager };
+         importer.LoadUwDemoLevel(level);
+      });
+}
+
+void LevelImporter::LoadUw1Levels(Underworld::LevelList& levelList)
+{
+   Base::ResourceManager& resourceManager = m_resourceManager;
+   std::shared_ptr<const Base::MemoryMappedFile> levArk =
+      m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "data/lev.ark");
+
+   levelList.Create(9,
+      [&resourceManager, levArk](size_t levelIndex, Underworld::Level& level)
+      {
+         LevelImporter importer{ resourceManager };
+         importer.LoadUwLevel(level, levArk, levelIndex, false, 18, 27, 36);
+
+         if (levelIndex == 8)
+            level.GetTilemap().SetAutomapDisabled(true);
+      });
+}
 
-   std::vector<Underworld::Level>& allLevels = levelList.GetVectorLevels();
+void LevelImporter::LoadUw2Levels(Underworld::LevelList& levelList)
+{
+   Base::ResourceManager& resourceManager = m_resourceManager;
+   std::shared_ptr<const Base::MemoryMappedFile> levArk =
+      m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "data/lev.ark");
 
-   allLevels.clear();
-   allLevels.resize(1);
+   levelList.Create(80,
+      [&resourceManager, levArk](size_t levelIndex, Underworld::Level& level)
+      {
+         LevelImporter importer{ resourceManager };
+         importer.LoadUwLevel(level, levArk, levelIndex, true, 80, 160, 240);
+      });
+}
+
+void LevelImporter::LoadUwDemoLevel(Underworld::Level& level)
+{
+   UaTrace("importing uw_demo level map\n");
 
    // load uw_demo texture map
-   m_file = Base::File(m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "data/level13.txm"));
+   m_file = Base::MemoryReader{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "data/level13.txm") };
 
    std::vector<Uint16> textureMapping;
    LoadTextureMapping(textureMapping, false);
 
    // load tilemap
-   m_file = Base::File(m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "data/level13.st"));
+   m_file = Base::MemoryReader{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, "data/level13.st") };
 
    TileStartLinkList tileStartLinkList;
-   LoadTilemap(allLevels[0].GetTilemap(), textureMapping, tileStartLinkList, false);
+   LoadTilemap(level.GetTilemap(), textureMapping, tileStartLinkList, false);
 
    // load object list
-   LoadObjectList(allLevels[0].GetObjectList(), tileStartLinkList, textureMapping);
-}
-
-void LevelImporter::LoadUw1Levels(Underworld::LevelList& levelList)
-{
-   LoadUwLevels(levelList, false, 9, 18, 27, 36);
-   levelList.GetLevel(8).GetTilemap().SetAutomapDisabled(true);
+   LoadObjectList(level.GetObjectList(), tileStartLinkList, textureMapping);
 }
 
-void LevelImporter::LoadUw2Levels(Underworld::LevelList& levelList)
-{
-   LoadUwLevels(levelList, true, 80, 80, 160, 240);
-}
-
-void LevelImporter::LoadUwLevels(Underworld::LevelList& levelList, bool uw2Mode, unsigned int numLevels,
+/// Each level uses its own archive file object, so that levels can be loaded
+/// on different threads; the decoded uw2 blocks are freed after loading.
+void LevelImporter::LoadUwLevel(Underworld::Level& level,
+   std::shared_ptr<const Base::MemoryMappedFile> levArk, size_t levelIndex, bool uw2Mode,
    unsigned int textureMapOffset, unsigned int automapOffset, unsigned int mapNotesOffset)
 {
-   std::vector<Underworld::Level>& allLevels = levelList.GetVectorLevels();
+   Base::ArchiveFile levArkFile(levArk, uw2Mode);
 
-   allLevels.clear();
-   allLevels.resize(numLevels);
+   if (!levArkFile.IsAvailable(levelIndex))
+      return;
 
-   Base::ArchiveFile levArkFile(m_resourceManager.GetUnderworldFile(Base::resourceGameUw, "data/lev.ark"), uw2Mode);
+   // load texture mapping
+   UaAssert(true == levArkFile.IsAvailable(levelIndex + textureMapOffset));
+   m_file = Base::MemoryReader{ levArkFile.GetBlock(levelIndex + textureMapOffset) };
 
-   for (unsigned int levelIndex = 0; levelIndex < numLevels; levelIndex++)
-   {
-      if (!levArkFile.IsAvailable(levelIndex))
-         continue;
-
-      Underworld::Level& level = allLevels[levelIndex];
-
-      // load texture mapping
-      UaAssert(true == levArkFile.IsAvailable(levelIndex + textureMapOffset));
-      m_file = levArkFile.GetFile(levelIndex + textureMapOffset);
-
-      std::vector<Uint16> textureMapping;
-      LoadTextureMapping(textureMapping, uw2Mode);
+   std::vector<Uint16> textureMapping;
+   LoadTextureMapping(textureMapping, uw2Mode);
 
-      // load tilemap
-      m_file = levArkFile.GetFile(levelIndex);
+   // load tilemap
+   m_file = Base::MemoryReader{ levArkFile.GetBlock(levelIndex) };
 
-      TileStartLinkList tileStartLinkList;
-      LoadTilemap(level.GetTilemap(), textureMapping, tileStartLinkList, uw2Mode);
+   TileStartLinkList tileStartLinkList;
+   LoadTilemap(level.GetTilemap(), textureMapping, tileStartLinkList, uw2Mode);
 
-      // load object list
-      LoadObjectList(level.GetObjectList(), tileStartLinkList, textureMapping);
+   // load object list
+   LoadObjectList(level.GetObjectList(), tileStartLinkList, textureMapping);
 
-      // load automap
-      if (levArkFile.IsAvailable(levelIndex + automapOffset))
-      {
-         m_file = levArkFile.GetFile(levelIndex + automapOffset);
-         LoadAutomap(level.GetTilemap());
-      }
+   // load automap
+   if (levArkFile.IsAvailable(levelIndex + automapOffset))
+   {
+      m_file = Base::MemoryReader{ levArkFile.GetBlock(levelIndex + automapOffset) };
+      LoadAutomap(level.GetTilemap());
+   }
 
-      // load map notes
-      if (levArkFile.IsAvailable(levelIndex + mapNotesOffset))
-      {
-         m_file = levArkFile.GetFile(levelIndex + mapNotesOffset);
-         LoadMapNotes(level.GetMapNotes());
-      }
+   // load map notes
+   if (levArkFile.IsAvailable(levelIndex + mapNotesOffset))
+   {
+      m_file = Base::MemoryReader{ levArkFile.GetBlock(levelIndex + mapNotesOffset) };
+      LoadMapNotes(level.GetMapNotes());
    }
 }
 
@@ -175,6 +198,8 @@ void Import::LevelImporter::LoadObjectList(Underworld::ObjectList& objectList,
             objectList.SetListStart(link, xpos, ypos);
          }
       }
+
+   objectList.RebuildSpatialIndex();
 }
 
 void Import::LevelImporter::LoadAutomap(Underworld::Tilemap& tilemap)
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2003,2004,2005,2006,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2003,2004,2005,2006,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,8 +22,9 @@
 #pragma once
 
 #include "Base.hpp"
-#include "File.hpp"
+#include "MemoryReader.hpp"
 #include <vector>
+#include <memory>
 
 namespace Base
 {
@@ -33,6 +34,7 @@ namespace Base
 namespace Underworld
 {
    class LevelList;
+   class Level;
    class ObjectList;
    class Tilemap;
    class MapNotes;
@@ -69,23 +71,27 @@ namespace Import
       {
       }
 
-      /// loads levels, based on the game prefix
+      /// sets up level list to load levels, based on the game prefix
       void LoadLevels(const Base::Settings& settings, Underworld::LevelList& levelList);
 
-      /// loads uw_demo level into level list
+      /// sets up level list to load uw_demo level
       void LoadUwDemoLevel(Underworld::LevelList& levelList);
 
-      /// loads uw1 levels into level list
+      /// sets up level list to load uw1 levels
       void LoadUw1Levels(Underworld::LevelList& levelList);
 
-      /// loads uw2 levels into level list
+      /// sets up level list to load uw2 levels
       void LoadUw2Levels(Underworld::LevelList& levelList);
 
    private:
+      /// loads uw_demo level
+      void LoadUwDemoLevel(Underworld::Level& level);
+
       /// common uw1 and uw2 level loading
-      void LoadUwLevels(Underworld::LevelList& levelList, bool uw2Mode,
-         unsigned int numLevels, unsigned int textureMapOffset,
-         unsigned int automapOffset, unsigned int mapNotesOffset);
+      void LoadUwLevel(Underworld::Level& level,
+         std::shared_ptr<const Base::MemoryMappedFile> levArk, size_t levelIndex, bool uw2Mode,
+         unsigned int textureMapOffset, unsigned int automapOffset,
+         unsigned int mapNotesOffset);
 
       /// loads texture mapping from current file
       void LoadTextureMapping(std::vector<Uint16>& textureMapping, bool uw2Mode);
@@ -108,8 +114,8 @@ namespace Import
       /// resource manager
       Base::ResourceManager& m_resourceManager;
 
-      /// current file
-      Base::File m_file;
+      /// reader for current file
+      Base::MemoryReader m_file;
    };
 
 } // namespace Import
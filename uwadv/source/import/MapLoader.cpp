@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -91,10 +91,7 @@ void LevelImporter::LoadTilemap(Underworld::Tilemap& tilemap, std::vector<Uint16
          tileInfo.m_textureFloor = textureMapping[floorIndex + (uw2Mode ? 0 : 48)];
          tileInfo.m_textureCeiling = textureMapping[uw2Mode ? 32 : (9 + 48)];
 
-         std::set<Uint16>& setUsedTextures = tilemap.GetUsedTextures();
-         setUsedTextures.insert(tileInfo.m_textureWall);
-         setUsedTextures.insert(tileInfo.m_textureFloor);
-         setUsedTextures.insert(tileInfo.m_textureCeiling);
+         tilemap.AddUsedTextures(tileInfo);
 
          // tile object list start
          Uint16 uiLink = static_cast<Uint16>(GetBits(uiTileInfo2, 6, 10));
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,7 +23,8 @@
 #include "Model3D.hpp"
 #include "Model3DBuiltIn.hpp"
 #include "Renderer.hpp"
-#include "File.hpp"
+#include "MemoryReader.hpp"
+#include "FileSystem.hpp"
 #include "Math.hpp"
 #include <vector>
 #include <array>
@@ -223,21 +224,21 @@ static const double shorthand_texcoords[8] =
 };
 
 /// reads a 16-bit int as 8.8 fixed-point double value
-double ModelReadFixed(Base::File& file)
+double ModelReadFixed(Base::MemoryReader& file)
 {
    Sint16 val = static_cast<Sint16>(file.Read16());
    return val / 256.0;
 }
 
 /// reads a vertex number, ignoring the first 3 bits
-Uint16 ModelReadVertexNumber(Base::File& file)
+Uint16 ModelReadVertexNumber(Base::MemoryReader& file)
 {
    Uint16 val = file.Read16();
    return val >> 3;
 }
 
 /// reads a 16-bit int as 0.16 fixed-point double texture coordinate
-double ModelReadTextureCoord(Base::File& file)
+double ModelReadTextureCoord(Base::MemoryReader& file)
 {
    Uint16 val = static_cast<Uint16>(file.Read16());
    return val / 65535.0;
@@ -309,7 +310,7 @@ std::vector< Triangle3dTextured> Tessellate(const std::vector<Vertex3d>& vertice
    return resultTriangles;
 }
 
-void ModelParseNode(unsigned int modelNumber, bool isUw2, Base::File& file, Vector3d& origin,
+void ModelParseNode(unsigned int modelNumber, bool isUw2, Base::MemoryReader& file, Vector3d& origin,
    std::vector<Vector3d>& vertex_list,
    std::vector<Triangle3dTextured>& triangles,
    Uint8 palIndex,
@@ -855,10 +856,11 @@ void ModelParseNode(unsigned int modelNumber, bool isUw2, Base::File& file, Vect
 bool DecodeBuiltInModels(const char* filename,
    std::vector<Model3DPtr>& allModels, bool dump, bool isUw2)
 {
-   Base::File file(filename, Base::modeRead);
-   if (!file.IsOpen())
+   if (!Base::FileSystem::FileExists(filename))
       return false;
 
+   Base::MemoryReader file{ std::make_shared<Base::MemoryMappedFile>(filename) };
+
    Uint32 base = 0; // models list base address
 
    // search all offsets for model table begin
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -77,8 +77,8 @@ void ObjectListLoader::FollowLink(Uint16 link, Uint8 tilePosX, Uint8 tilePosY)
 Underworld::ObjectPtr ObjectListLoader::AddObject(Uint16 pos, Uint8 tilePosX, Uint8 tilePosY,
    Uint16 objectWord[4], Uint8* npcInfos)
 {
-   Underworld::ObjectPtr obj = pos < 0x100 ?
-      Underworld::ObjectPtr(new Underworld::NpcObject) : Underworld::ObjectPtr(new Underworld::Object);
+   Underworld::ObjectPtr obj = m_objectList.CreateObject(pos,
+      pos < 0x100 ? Underworld::objectNpc : Underworld::objectNormal);
 
    // set object properties
    Underworld::ObjectInfo& objInfo = obj->GetObjectInfo();
@@ -145,7 +145,6 @@ Underworld::ObjectPtr ObjectListLoader::AddObject(Uint16 pos, Uint8 tilePosX, Ui
       }
    }
 
-   m_objectList.SetObject(pos, obj);
    return obj;
 }
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2020,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2020,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,6 +24,7 @@
 #include "Texture.hpp"
 #include "ResourceManager.hpp"
 #include "File.hpp"
+#include "MemoryReader.hpp"
 #include <algorithm>
 #include <SDL_pnglite.h>
 
@@ -81,7 +82,7 @@ void Import::TextureLoader::LoadTextures(
    const char* textureName,
    Palette256Ptr palette)
 {
-   Base::File file = m_resourceManager.GetUnderworldFile(Base::resourceGameUw, textureName);
+   Base::MemoryReader file{ m_resourceManager.MapUnderworldFile(Base::resourceGameUw, textureName) };
    if (!file.IsOpen())
    {
       std::string text("could not open texture file: ");
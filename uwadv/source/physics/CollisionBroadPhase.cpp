@@ -0,0 +1,331 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CollisionBroadPhase.cpp
+/// \brief early rejection of triangles for collision detection
+/// \details The triangle plane normal n is stored as unnormalized cross
+/// product of the triangle edges, in normal space. Scaling a point p into
+/// ellipsoid space by dividing through the ellipsoid e turns the plane into
+/// one with normal n*e and the same plane distance d. With the sphere base
+/// point b and velocity v in ellipsoid space, the signed distances of the
+/// sphere center to the plane at the start and the end of the movement are
+/// (n*e.b + d) / |n*e| and (n*e.(b+v) + d) / |n*e|. When both are above 1 or
+/// both are below -1, the sphere with radius 1 can't touch the plane.
+//
+#include "pch.hpp"
+#include "CollisionBroadPhase.hpp"
+#include <SDL2/SDL_cpuinfo.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_INTRINSICS
+#include <immintrin.h>
+
+// gcc and clang need the target attribute to compile AVX2 intrinsics without
+// enabling AVX2 for the whole program
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+#endif
+
+using Physics::CollisionBroadPhase;
+using Physics::CollisionTrianglePlanes;
+
+/// sphere radius in ellipsoid space, including tolerance for rounding errors
+const float c_sphereRadiusLimit = 1.01f;
+
+/// tolerance for the back facing test, relative to the normal length
+const float c_facingTolerance = 1e-4f;
+
+/// \param ellipsoid ellipsoid radii of the physics body
+/// \param basePoint sphere base point, in ellipsoid space
+/// \param velocity sphere velocity, in ellipsoid space
+/// \param normalizedVelocity normalized sphere velocity, in ellipsoid space
+CollisionBroadPhase::CollisionBroadPhase(const Vector3d& ellipsoid, const Vector3d& basePoint,
+   const Vector3d& velocity, const Vector3d& normalizedVelocity)
+{
+   const double ellipsoidRadii[3] = { ellipsoid.x, ellipsoid.y, ellipsoid.z };
+   const double basePointCoords[3] = { basePoint.x, basePoint.y, basePoint.z };
+   const double velocityCoords[3] = { velocity.x, velocity.y, velocity.z };
+   const double directionCoords[3] = { normalizedVelocity.x, normalizedVelocity.y, normalizedVelocity.z };
+
+   for (unsigned int axis = 0; axis < 3; axis++)
+   {
+      m_ellipsoidSquared[axis] = static_cast<float>(ellipsoidRadii[axis] * ellipsoidRadii[axis]);
+      m_basePoint[axis] = static_cast<float>(basePointCoords[axis] * ellipsoidRadii[axis]);
+      m_velocity[axis] = static_cast<float>(velocityCoords[axis] * ellipsoidRadii[axis]);
+      m_direction[axis] = static_cast<float>(directionCoords[axis] * ellipsoidRadii[axis]);
+   }
+}
+
+/// \param implementation implementation to use; must be supported, which
+/// is not checked here, since this is called for every collision check
+/// \param planes triangle planes
+/// \param start index of first triangle plane to test
+/// \param count number of triangles to test; at most c_maxTriangles
+/// \return bit mask with a bit set for every candidate triangle; bit 0
+/// represents the triangle at index start
+Uint64 CollisionBroadPhase::FindCandidates(Implementation implementation,
+   const CollisionTrianglePlanes& planes, size_t start, size_t count) const
+{
+   UaAssert(count <= c_maxTriangles);
+
+   switch (implementation)
+   {
+   case implNone:
+      return count == c_maxTriangles ? ~Uint64(0) : (Uint64(1) << count) - 1;
+
+   case implAvx2: return FindCandidatesAvx2(planes, start, count);
+   case implSse2: return FindCandidatesSse2(planes, start, count);
+   default: return FindCandidatesScalar(planes, start, count);
+   }
+}
+
+/// \param implementation implementation to check
+/// \return true when the CPU supports the implementation
+bool CollisionBroadPhase::IsSupported(Implementation implementation)
+{
+   switch (implementation)
+   {
+   case implNone:
+   case implScalar:
+      return true;
+
+#ifdef HAVE_X86_INTRINSICS
+   case implSse2:
+      return SDL_HasSSE2() == SDL_TRUE;
+
+   case implAvx2:
+      return SDL_HasAVX2() == SDL_TRUE;
+#endif
+
+   default:
+      return false;
+   }
+}
+
+/// \return fastest implementation supported by the CPU
+CollisionBroadPhase::Implementation CollisionBroadPhase::GetBestImplementation()
+{
+   if (IsSupported(implAvx2))
+      return implAvx2;
+
+   if (IsSupported(implSse2))
+      return implSse2;
+
+   return implScalar;
+}
+
+Uint64 CollisionBroadPhase::FindCandidatesScalar(const CollisionTrianglePlanes& planes,
+   size_t start, size_t count) const
+{
+   Uint64 candidates = 0;
+
+   for (size_t index = 0; index < count; index++)
+   {
+      float normalX = planes.m_normalX[start + index];
+      float normalY = planes.m_normalY[start + index];
+      float normalZ = planes.m_normalZ[start + index];
+
+      float normalLength = std::sqrt(
+         normalX * normalX * m_ellipsoidSquared[0] +
+         normalY * normalY * m_ellipsoidSquared[1] +
+         normalZ * normalZ * m_ellipsoidSquared[2]);
+
+      float facing = normalX * m_direction[0] + normalY * m_direction[1] + normalZ * m_direction[2];
+
+      float startDistance = normalX * m_basePoint[0] + normalY * m_basePoint[1] +
+         normalZ * m_basePoint[2] + planes.m_distance[start + index];
+
+      float endDistance = startDistance +
+         normalX * m_velocity[0] + normalY * m_velocity[1] + normalZ * m_velocity[2];
+
+      float distanceLimit = c_sphereRadiusLimit * normalLength;
+
+      bool reject = facing > c_facingTolerance * normalLength ||
+         std::min(startDistance, endDistance) > distanceLimit ||
+         std::max(startDistance, endDistance) < -distanceLimit;
+
+      if (!reject)
+         candidates |= Uint64(1) << index;
+   }
+
+   return candidates;
+}
+
+/// SSE2 implementation; tests 4 triangles at once. The remaining triangles
+/// are tested with the scalar implementation.
+Uint64 CollisionBroadPhase::FindCandidatesSse2(const CollisionTrianglePlanes& planes,
+   size_t start, size_t count) const
+{
+   Uint64 candidates = 0;
+   size_t index = 0;
+
+#ifdef HAVE_X86_INTRINSICS
+   const __m128 ellipsoidX = _mm_set1_ps(m_ellipsoidSquared[0]);
+   const __m128 ellipsoidY = _mm_set1_ps(m_ellipsoidSquared[1]);
+   const __m128 ellipsoidZ = _mm_set1_ps(m_ellipsoidSquared[2]);
+   const __m128 directionX = _mm_set1_ps(m_direction[0]);
+   const __m128 directionY = _mm_set1_ps(m_direction[1]);
+   const __m128 directionZ = _mm_set1_ps(m_direction[2]);
+   const __m128 basePointX = _mm_set1_ps(m_basePoint[0]);
+   const __m128 basePointY = _mm_set1_ps(m_basePoint[1]);
+   const __m128 basePointZ = _mm_set1_ps(m_basePoint[2]);
+   const __m128 velocityX = _mm_set1_ps(m_velocity[0]);
+   const __m128 velocityY = _mm_set1_ps(m_velocity[1]);
+   const __m128 velocityZ = _mm_set1_ps(m_velocity[2]);
+   const __m128 sphereRadiusLimit = _mm_set1_ps(c_sphereRadiusLimit);
+   const __m128 facingTolerance = _mm_set1_ps(c_facingTolerance);
+   const __m128 zero = _mm_setzero_ps();
+
+   for (; index + 4 <= count; index += 4)
+   {
+      __m128 normalX = _mm_loadu_ps(planes.m_normalX + start + index);
+      __m128 normalY = _mm_loadu_ps(planes.m_normalY + start + index);
+      __m128 normalZ = _mm_loadu_ps(planes.m_normalZ + start + index);
+      __m128 distance = _mm_loadu_ps(planes.m_distance + start + index);
+
+      __m128 normalLength = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+         _mm_mul_ps(_mm_mul_ps(normalX, normalX), ellipsoidX),
+         _mm_mul_ps(_mm_mul_ps(normalY, normalY), ellipsoidY)),
+         _mm_mul_ps(_mm_mul_ps(normalZ, normalZ), ellipsoidZ)));
+
+      __m128 facing = _mm_add_ps(_mm_add_ps(
+         _mm_mul_ps(normalX, directionX),
+         _mm_mul_ps(normalY, directionY)),
+         _mm_mul_ps(normalZ, directionZ));
+
+      __m128 startDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+         _mm_mul_ps(normalX, basePointX),
+         _mm_mul_ps(normalY, basePointY)),
+         _mm_mul_ps(normalZ, basePointZ)),
+         distance);
+
+      __m128 endDistance = _mm_add_ps(startDistance, _mm_add_ps(_mm_add_ps(
+         _mm_mul_ps(normalX, velocityX),
+         _mm_mul_ps(normalY, velocityY)),
+         _mm_mul_ps(normalZ, velocityZ)));
+
+      __m128 distanceLimit = _mm_mul_ps(sphereRadiusLimit, normalLength);
+
+      __m128 reject = _mm_or_ps(_mm_or_ps(
+         _mm_cmpgt_ps(facing, _mm_mul_ps(facingTolerance, normalLength)),
+         _mm_cmpgt_ps(_mm_min_ps(startDistance, endDistance), distanceLimit)),
+         _mm_cmplt_ps(_mm_max_ps(startDistance, endDistance), _mm_sub_ps(zero, distanceLimit)));
+
+      Uint64 candidateBits = static_cast<Uint64>(~_mm_movemask_ps(reject) & 0xf);
+      candidates |= candidateBits << index;
+   }
+#endif
+
+   if (index < count)
+      candidates |= FindCandidatesScalar(planes, start + index, count - index) << index;
+
+   return candidates;
+}
+
+#ifdef HAVE_X86_INTRINSICS
+/// AVX2 implementation; tests 8 triangles at once.
+TARGET_AVX2
+static Uint64 FindCandidatesAvx2Kernel(const CollisionTrianglePlanes& planes,
+   size_t start, size_t& index, size_t count,
+   const float* ellipsoidSquared, const float* direction,
+   const float* basePoint, const float* velocity)
+{
+   const __m256 ellipsoidX = _mm256_set1_ps(ellipsoidSquared[0]);
+   const __m256 ellipsoidY = _mm256_set1_ps(ellipsoidSquared[1]);
+   const __m256 ellipsoidZ = _mm256_set1_ps(ellipsoidSquared[2]);
+   const __m256 directionX = _mm256_set1_ps(direction[0]);
+   const __m256 directionY = _mm256_set1_ps(direction[1]);
+   const __m256 directionZ = _mm256_set1_ps(direction[2]);
+   const __m256 basePointX = _mm256_set1_ps(basePoint[0]);
+   const __m256 basePointY = _mm256_set1_ps(basePoint[1]);
+   const __m256 basePointZ = _mm256_set1_ps(basePoint[2]);
+   const __m256 velocityX = _mm256_set1_ps(velocity[0]);
+   const __m256 velocityY = _mm256_set1_ps(velocity[1]);
+   const __m256 velocityZ = _mm256_set1_ps(velocity[2]);
+   const __m256 sphereRadiusLimit = _mm256_set1_ps(c_sphereRadiusLimit);
+   const __m256 facingTolerance = _mm256_set1_ps(c_facingTolerance);
+   const __m256 zero = _mm256_setzero_ps();
+
+   Uint64 candidates = 0;
+
+   for (; index + 8 <= count; index += 8)
+   {
+      __m256 normalX = _mm256_loadu_ps(planes.m_normalX + start + index);
+      __m256 normalY = _mm256_loadu_ps(planes.m_normalY + start + index);
+      __m256 normalZ = _mm256_loadu_ps(planes.m_normalZ + start + index);
+      __m256 distance = _mm256_loadu_ps(planes.m_distance + start + index);
+
+      __m256 normalLength = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(
+         _mm256_mul_ps(_mm256_mul_ps(normalX, normalX), ellipsoidX),
+         _mm256_mul_ps(_mm256_mul_ps(normalY, normalY), ellipsoidY)),
+         _mm256_mul_ps(_mm256_mul_ps(normalZ, normalZ), ellipsoidZ)));
+
+      __m256 facing = _mm256_add_ps(_mm256_add_ps(
+         _mm256_mul_ps(normalX, directionX),
+         _mm256_mul_ps(normalY, directionY)),
+         _mm256_mul_ps(normalZ, directionZ));
+
+      __m256 startDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+         _mm256_mul_ps(normalX, basePointX),
+         _mm256_mul_ps(normalY, basePointY)),
+         _mm256_mul_ps(normalZ, basePointZ)),
+         distance);
+
+      __m256 endDistance = _mm256_add_ps(startDistance, _mm256_add_ps(_mm256_add_ps(
+         _mm256_mul_ps(normalX, velocityX),
+         _mm256_mul_ps(normalY, velocityY)),
+         _mm256_mul_ps(normalZ, velocityZ)));
+
+      __m256 distanceLimit = _mm256_mul_ps(sphereRadiusLimit, normalLength);
+
+      // ordered, non-signaling compares; false for NaN, like the SSE2 compares
+      __m256 reject = _mm256_or_ps(_mm256_or_ps(
+         _mm256_cmp_ps(facing, _mm256_mul_ps(facingTolerance, normalLength), _CMP_GT_OQ),
+         _mm256_cmp_ps(_mm256_min_ps(startDistance, endDistance), distanceLimit, _CMP_GT_OQ)),
+         _mm256_cmp_ps(_mm256_max_ps(startDistance, endDistance),
+            _mm256_sub_ps(zero, distanceLimit), _CMP_LT_OQ));
+
+      Uint64 candidateBits = static_cast<Uint64>(~_mm256_movemask_ps(reject) & 0xff);
+      candidates |= candidateBits << index;
+   }
+
+   return candidates;
+}
+#endif
+
+Uint64 CollisionBroadPhase::FindCandidatesAvx2(const CollisionTrianglePlanes& planes,
+   size_t start, size_t count) const
+{
+   Uint64 candidates = 0;
+   size_t index = 0;
+
+#ifdef HAVE_X86_INTRINSICS
+   candidates = FindCandidatesAvx2Kernel(planes, start, index, count,
+      m_ellipsoidSquared, m_direction, m_basePoint, m_velocity);
+#endif
+
+   if (index < count)
+      candidates |= FindCandidatesScalar(planes, start + index, count - index) << index;
+
+   return candidates;
+}
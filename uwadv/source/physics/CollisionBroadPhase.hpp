@@ -0,0 +1,94 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CollisionBroadPhase.hpp
+/// \brief early rejection of triangles for collision detection
+//
+#pragma once
+
+#include "Math.hpp"
+#include "CollisionTriangleList.hpp"
+
+namespace Physics
+{
+   /// \brief Early rejection of triangles that a swept sphere can't collide with
+   /// \details Tests the triangle planes against the sphere moving in
+   /// ellipsoid space, several triangles at once. Triangles that are back
+   /// facing or whose plane isn't reached by the sphere are rejected; all
+   /// other triangles are candidates that CollisionDetection checks exactly.
+   /// The test is done in single precision with a small tolerance, so it
+   /// never rejects a triangle that the exact check would collide with.
+   /// Provides a scalar implementation and, on x86 CPUs, SSE2 and AVX2
+   /// implementations testing 4 or 8 triangles at once.
+   class CollisionBroadPhase
+   {
+   public:
+      /// broad phase implementation
+      enum Implementation
+      {
+         implNone = 0,  ///< no rejection; all triangles are candidates
+         implScalar,    ///< plain C++ loop
+         implSse2,      ///< SSE2 implementation, 4 triangles at once
+         implAvx2,      ///< AVX2 implementation, 8 triangles at once
+      };
+
+      /// max. number of triangles tested with one call to FindCandidates()
+      static const size_t c_maxTriangles = 64;
+
+      /// ctor; sets up sphere moving in ellipsoid space
+      CollisionBroadPhase(const Vector3d& ellipsoid, const Vector3d& basePoint,
+         const Vector3d& velocity, const Vector3d& normalizedVelocity);
+
+      /// returns bit mask of candidate triangles, using given implementation
+      Uint64 FindCandidates(Implementation implementation,
+         const CollisionTrianglePlanes& planes, size_t start, size_t count) const;
+
+      /// returns if the given implementation is supported by this CPU
+      static bool IsSupported(Implementation implementation);
+
+      /// returns the fastest implementation supported by this CPU
+      static Implementation GetBestImplementation();
+
+   private:
+      /// scalar implementation
+      Uint64 FindCandidatesScalar(const CollisionTrianglePlanes& planes,
+         size_t start, size_t count) const;
+
+      /// SSE2 implementation
+      Uint64 FindCandidatesSse2(const CollisionTrianglePlanes& planes,
+         size_t start, size_t count) const;
+
+      /// AVX2 implementation
+      Uint64 FindCandidatesAvx2(const CollisionTrianglePlanes& planes,
+         size_t start, size_t count) const;
+
+   private:
+      /// squared ellipsoid radii
+      float m_ellipsoidSquared[3];
+
+      /// sphere base point, scaled with the ellipsoid
+      float m_basePoint[3];
+
+      /// sphere velocity, scaled with the ellipsoid
+      float m_velocity[3];
+
+      /// normalized sphere velocity, scaled with the ellipsoid
+      float m_direction[3];
+   };
+
+} // namespace Physics
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -67,16 +67,28 @@ struct Physics::CollisionData
 
 CollisionDetection::CollisionDetection(const std::vector<Triangle3dTextured>& allTriangles,
    const PhysicsBody& body)
-   :m_allTriangles(allTriangles.begin(), allTriangles.end()),
+   :m_triangleRanges(&m_ownedTriangleRange),
+   m_numTriangleRanges(1),
+   m_ellipsoid(body.GetEllipsoid()),
+   m_broadPhaseImplementation(CollisionBroadPhase::GetBestImplementation()),
+   m_collisionRecursionDepth(0)
+{
+   m_ownedTriangles.AddTriangles(allTriangles);
+   m_ownedTriangleRange = m_ownedTriangles.GetRange();
+}
+
+/// The triangle ranges must stay valid as long as the object is used.
+/// \param triangleRanges array of triangle ranges to check
+/// \param numTriangleRanges number of triangle ranges in the array
+/// \param body physics body to check
+CollisionDetection::CollisionDetection(const CollisionTriangleRange* triangleRanges,
+   size_t numTriangleRanges, const PhysicsBody& body)
+   :m_triangleRanges(triangleRanges),
+   m_numTriangleRanges(numTriangleRanges),
+   m_ellipsoid(body.GetEllipsoid()),
+   m_broadPhaseImplementation(CollisionBroadPhase::GetBestImplementation()),
    m_collisionRecursionDepth(0)
 {
-   const Vector3d& ellipsoid = body.GetEllipsoid();
-   for (auto& triangle : m_allTriangles)
-   {
-      triangle.m_vertices[0].pos /= ellipsoid;
-      triangle.m_vertices[1].pos /= ellipsoid;
-      triangle.m_vertices[2].pos /= ellipsoid;
-   }
 }
 
 /// tracks object movement using current parameters
@@ -246,21 +258,53 @@ bool CollisionDetection::CollideWithWorld(CollisionData& data,
    return CollideWithWorld(data, pos, newVelocity);
 }
 
+/// Checks all triangles for collision. The broad phase rejects triangles
+/// that can't collide, in blocks of triangles; the remaining candidates are
+/// transformed to ellipsoid space and checked exactly, in the same order as
+/// they are stored.
 void CollisionDetection::CheckCollision(CollisionData& data)
 {
-   // check all triangles; already in ellipsoid space
-   size_t max = m_allTriangles.size();
-   for (size_t index = 0; index < max; index++)
+   CollisionBroadPhase broadPhase{ m_ellipsoid,
+      data.basePoint, data.velocity, data.normalizedVelocity };
+
+   const size_t maxTriangles = CollisionBroadPhase::c_maxTriangles;
+
+   size_t rangeOffset = 0;
+   for (size_t rangeIndex = 0; rangeIndex < m_numTriangleRanges; rangeIndex++)
    {
-      if (data.debugOutput)
-         UaTrace("    checking triangle %i...", index);
+      const CollisionTriangleRange& range = m_triangleRanges[rangeIndex];
+      size_t rangeSize = range.GetSize();
 
-      const Triangle3dTextured& tri = m_allTriangles[index];
+      for (size_t start = 0; start < rangeSize; start += maxTriangles)
+      {
+         size_t count = std::min(rangeSize - start, maxTriangles);
+
+         Uint64 candidates = broadPhase.FindCandidates(
+            m_broadPhaseImplementation, range.m_planes, start, count);
+
+         for (size_t index = start; candidates != 0; index++, candidates >>= 1)
+         {
+            if ((candidates & 1) == 0)
+               continue;
+
+            if (data.debugOutput)
+               UaTrace("    checking triangle %zu...", rangeOffset + index);
+
+            const CollisionTriangle& tri = range.m_begin[index];
+
+            Vector3d p1 = tri.m_points[0];
+            Vector3d p2 = tri.m_points[1];
+            Vector3d p3 = tri.m_points[2];
+
+            p1 /= m_ellipsoid;
+            p2 /= m_ellipsoid;
+            p3 /= m_ellipsoid;
+
+            CheckTriangle(data, p1, p2, p3);
+         }
+      }
 
-      CheckTriangle(data,
-         tri.m_vertices[0].pos,
-         tri.m_vertices[1].pos,
-         tri.m_vertices[2].pos);
+      rangeOffset += rangeSize;
    }
 }
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,8 @@
 
 #include "Math.hpp"
 #include "Triangle3d.hpp"
+#include "CollisionTriangleList.hpp"
+#include "CollisionBroadPhase.hpp"
 #include <vector>
 
 namespace UnitTest
@@ -40,13 +42,28 @@ namespace Physics
    class CollisionDetection
    {
    public:
-      /// ctor
+      /// ctor; copies the triangles
       CollisionDetection(const std::vector<Triangle3dTextured>& allTriangles,
          const PhysicsBody& body);
 
+      /// ctor; uses the triangle ranges without copying
+      CollisionDetection(const CollisionTriangleRange* triangleRanges,
+         size_t numTriangleRanges, const PhysicsBody& body);
+
+      /// deleted copy ctor
+      CollisionDetection(const CollisionDetection&) = delete;
+      /// deleted assignment operator
+      CollisionDetection& operator=(const CollisionDetection&) = delete;
+
       /// tracks object movement of given physics body
       void TrackObject(PhysicsBody& body);
 
+      /// sets broad phase implementation; the implementation must be supported
+      void SetBroadPhaseImplementation(CollisionBroadPhase::Implementation implementation)
+      {
+         m_broadPhaseImplementation = implementation;
+      }
+
    private:
       /// collides physics body with world and slides it along sliding plane
       bool CollideAndSlide(PhysicsBody& body, Vector3d& pos, Vector3d velocity);
@@ -81,8 +98,23 @@ namespace Physics
    private:
       friend class UnitTest::CollisionDetectionTest;
 
-      /// all triangles, in ellipsoid space
-      std::vector<Triangle3dTextured> m_allTriangles;
+      /// triangles copied in the ctor, if any
+      CollisionTriangleList m_ownedTriangles;
+
+      /// triangle range for the copied triangles
+      CollisionTriangleRange m_ownedTriangleRange;
+
+      /// ranges of all triangles to check, in normal space
+      const CollisionTriangleRange* m_triangleRanges;
+
+      /// number of triangle ranges
+      size_t m_numTriangleRanges;
+
+      /// ellipsoid of the tracked body; triangles are transformed to ellipsoid space when checked
+      Vector3d m_ellipsoid;
+
+      /// broad phase implementation used to reject triangles early
+      CollisionBroadPhase::Implementation m_broadPhaseImplementation;
 
       /// recursion depth for CollideWithWorld()
       int m_collisionRecursionDepth;
@@ -0,0 +1,134 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CollisionTriangleList.cpp
+/// \brief list of triangles used for collision detection
+//
+#include "pch.hpp"
+#include "CollisionTriangleList.hpp"
+
+using Physics::CollisionTriangleList;
+using Physics::CollisionTriangleRange;
+
+void CollisionTriangleList::Clear()
+{
+   m_triangles.clear();
+   m_normalX.clear();
+   m_normalY.clear();
+   m_normalZ.clear();
+   m_distance.clear();
+}
+
+void CollisionTriangleList::Resize(size_t count)
+{
+   m_triangles.resize(count);
+   m_normalX.resize(count);
+   m_normalY.resize(count);
+   m_normalZ.resize(count);
+   m_distance.resize(count);
+}
+
+void CollisionTriangleList::ShrinkToFit()
+{
+   m_triangles.shrink_to_fit();
+   m_normalX.shrink_to_fit();
+   m_normalY.shrink_to_fit();
+   m_normalZ.shrink_to_fit();
+   m_distance.shrink_to_fit();
+}
+
+/// Sets the triangle vertices and calculates the triangle plane.
+/// \param index index of triangle to set
+/// \param p1 first vertex
+/// \param p2 second vertex
+/// \param p3 third vertex
+void CollisionTriangleList::SetTriangle(size_t index,
+   const Vector3d& p1, const Vector3d& p2, const Vector3d& p3)
+{
+   CollisionTriangle& triangle = m_triangles[index];
+   triangle.m_points[0] = p1;
+   triangle.m_points[1] = p2;
+   triangle.m_points[2] = p3;
+
+   // same orientation as the normal of Plane3d(p1, p2, p3)
+   Vector3d normal = Vector3d::Cross(p2 - p1, p3 - p1);
+
+   m_normalX[index] = static_cast<float>(normal.x);
+   m_normalY[index] = static_cast<float>(normal.y);
+   m_normalZ[index] = static_cast<float>(normal.z);
+   m_distance[index] = static_cast<float>(-normal.Dot(p1));
+}
+
+/// \param allTriangles textured triangles to add
+void CollisionTriangleList::AddTriangles(const std::vector<Triangle3dTextured>& allTriangles)
+{
+   size_t start = GetSize();
+   Resize(start + allTriangles.size());
+
+   for (size_t index = 0; index < allTriangles.size(); index++)
+   {
+      const Triangle3dTextured& triangle = allTriangles[index];
+
+      SetTriangle(start + index,
+         triangle.m_vertices[0].pos,
+         triangle.m_vertices[1].pos,
+         triangle.m_vertices[2].pos);
+   }
+}
+
+/// \param range range of triangles to add, e.g. from another list
+void CollisionTriangleList::AddTriangles(const CollisionTriangleRange& range)
+{
+   size_t count = range.GetSize();
+
+   m_triangles.insert(m_triangles.end(), range.m_begin, range.m_end);
+   m_normalX.insert(m_normalX.end(), range.m_planes.m_normalX, range.m_planes.m_normalX + count);
+   m_normalY.insert(m_normalY.end(), range.m_planes.m_normalY, range.m_planes.m_normalY + count);
+   m_normalZ.insert(m_normalZ.end(), range.m_planes.m_normalZ, range.m_planes.m_normalZ + count);
+   m_distance.insert(m_distance.end(), range.m_planes.m_distance, range.m_planes.m_distance + count);
+}
+
+/// Returns a range of triangles. The range stays valid until the list is
+/// modified.
+/// \param start index of first triangle
+/// \param count number of triangles
+/// \return triangle range
+CollisionTriangleRange CollisionTriangleList::GetRange(size_t start, size_t count) const
+{
+   UaAssert(start + count <= GetSize());
+
+   CollisionTriangleRange range;
+   range.m_begin = m_triangles.data() + start;
+   range.m_end = range.m_begin + count;
+
+   range.m_planes.m_normalX = m_normalX.data() + start;
+   range.m_planes.m_normalY = m_normalY.data() + start;
+   range.m_planes.m_normalZ = m_normalZ.data() + start;
+   range.m_planes.m_distance = m_distance.data() + start;
+
+   return range;
+}
+
+void CollisionTriangleList::Swap(CollisionTriangleList& other)
+{
+   m_triangles.swap(other.m_triangles);
+   m_normalX.swap(other.m_normalX);
+   m_normalY.swap(other.m_normalY);
+   m_normalZ.swap(other.m_normalZ);
+   m_distance.swap(other.m_distance);
+}
@@ -0,0 +1,121 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CollisionTriangleList.hpp
+/// \brief list of triangles used for collision detection
+//
+#pragma once
+
+#include "Math.hpp"
+#include "Triangle3d.hpp"
+#include <vector>
+
+namespace Physics
+{
+   /// triangle used for collision detection; only stores the vertex positions
+   struct CollisionTriangle
+   {
+      /// vertex positions
+      Vector3d m_points[3];
+   };
+
+   /// \brief Triangle planes in structure-of-arrays layout
+   /// \details The planes aren't normalized; the normal is the cross product
+   /// of two triangle edges, so that the plane can be transformed into
+   /// ellipsoid space by scaling the normal with the ellipsoid.
+   struct CollisionTrianglePlanes
+   {
+      const float* m_normalX = nullptr; ///< normal x components
+      const float* m_normalY = nullptr; ///< normal y components
+      const float* m_normalZ = nullptr; ///< normal z components
+      const float* m_distance = nullptr; ///< plane distances
+   };
+
+   /// range of collision triangles, stored contiguously
+   struct CollisionTriangleRange
+   {
+      /// first triangle
+      const CollisionTriangle* m_begin = nullptr;
+
+      /// one past the last triangle
+      const CollisionTriangle* m_end = nullptr;
+
+      /// planes of the triangles; the first plane belongs to m_begin
+      CollisionTrianglePlanes m_planes;
+
+      /// returns if the range contains no triangles
+      bool IsEmpty() const { return m_begin == m_end; }
+
+      /// returns number of triangles in the range
+      size_t GetSize() const { return static_cast<size_t>(m_end - m_begin); }
+   };
+
+   /// \brief List of collision triangles
+   /// \details Stores the triangle vertices and, in separate arrays, the
+   /// triangle planes used by CollisionBroadPhase.
+   class CollisionTriangleList
+   {
+   public:
+      /// returns number of triangles
+      size_t GetSize() const { return m_triangles.size(); }
+
+      /// removes all triangles
+      void Clear();
+
+      /// resizes list; new triangles must be set with SetTriangle()
+      void Resize(size_t count);
+
+      /// frees unused memory
+      void ShrinkToFit();
+
+      /// sets triangle at given index
+      void SetTriangle(size_t index, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3);
+
+      /// adds textured triangles to the list
+      void AddTriangles(const std::vector<Triangle3dTextured>& allTriangles);
+
+      /// adds triangles of a range to the list
+      void AddTriangles(const CollisionTriangleRange& range);
+
+      /// returns range of triangles
+      CollisionTriangleRange GetRange(size_t start, size_t count) const;
+
+      /// returns range with all triangles
+      CollisionTriangleRange GetRange() const { return GetRange(0, GetSize()); }
+
+      /// swaps contents with other list
+      void Swap(CollisionTriangleList& other);
+
+   private:
+      /// triangles
+      std::vector<CollisionTriangle> m_triangles;
+
+      /// plane normal x components
+      std::vector<float> m_normalX;
+
+      /// plane normal y components
+      std::vector<float> m_normalY;
+
+      /// plane normal z components
+      std::vector<float> m_normalZ;
+
+      /// plane distances
+      std::vector<float> m_distance;
+   };
+
+} // namespace Physics
@@ -0,0 +1,189 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlowField.cpp
+/// \brief flow field leading to a target tile
+//
+#include "pch.hpp"
+#include "FlowField.hpp"
+
+using Physics::FlowField;
+using Physics::NavigationGrid;
+using Physics::NavigationDirection;
+
+/// number of tiles in the tilemap
+static const size_t c_numTiles = Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize;
+
+FlowField::FlowField(const NavigationGrid& grid)
+   :m_grid(grid),
+   m_hasTarget(false),
+   m_targetX(0),
+   m_targetY(0),
+   m_numFieldUpdates(0)
+{
+   for (Field& field : m_fields)
+   {
+      field.m_distances.resize(c_numTiles, Uint16(c_unreachable));
+      field.m_directions.resize(c_numTiles, navigationDirectionMax);
+   }
+}
+
+/// Setting the same target again keeps the fields.
+/// \param xpos x tile position of target
+/// \param ypos y tile position of target
+void FlowField::SetTarget(unsigned int xpos, unsigned int ypos)
+{
+   UaAssert(xpos < Underworld::c_underworldTilemapSize && ypos < Underworld::c_underworldTilemapSize);
+
+   if (m_hasTarget && m_targetX == xpos && m_targetY == ypos)
+      return;
+
+   m_hasTarget = true;
+   m_targetX = xpos;
+   m_targetY = ypos;
+
+   Invalidate();
+}
+
+void FlowField::ClearTarget()
+{
+   m_hasTarget = false;
+   Invalidate();
+}
+
+void FlowField::Invalidate()
+{
+   for (Field& field : m_fields)
+      field.m_isUpToDate = false;
+}
+
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \param flagMask combination of PathfindFlags bits
+/// \return direction to move in; navigationDirectionMax when the tile is the
+/// target or when the target can't be reached from the tile
+NavigationDirection FlowField::GetDirection(unsigned int xpos, unsigned int ypos, unsigned int flagMask)
+{
+   if (xpos >= Underworld::c_underworldTilemapSize || ypos >= Underworld::c_underworldTilemapSize)
+      return navigationDirectionMax;
+
+   const Field& field = GetField(flagMask);
+   return static_cast<NavigationDirection>(
+      field.m_directions[ypos * Underworld::c_underworldTilemapSize + xpos]);
+}
+
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \param flagMask combination of PathfindFlags bits
+/// \return path distance, in move costs as returned by
+/// NavigationGrid::GetMoveCost(), or c_unreachable
+Uint16 FlowField::GetDistance(unsigned int xpos, unsigned int ypos, unsigned int flagMask)
+{
+   if (xpos >= Underworld::c_underworldTilemapSize || ypos >= Underworld::c_underworldTilemapSize)
+      return c_unreachable;
+
+   const Field& field = GetField(flagMask);
+   return field.m_distances[ypos * Underworld::c_underworldTilemapSize + xpos];
+}
+
+const FlowField::Field& FlowField::GetField(unsigned int flagMask)
+{
+   UaAssert(flagMask < NavigationGrid::c_numFlagMasks);
+
+   if (!m_fields[flagMask].m_isUpToDate)
+      UpdateField(flagMask);
+
+   return m_fields[flagMask];
+}
+
+/// Searches backwards from the target tile: a tile is reached from an
+/// already settled tile when a move from the tile to the settled tile is
+/// possible. Since move costs are small integers, a bucket queue with one
+/// bucket per distance value (modulo the number of buckets) is used instead
+/// of a heap, so every tile is queued and settled in constant time.
+void FlowField::UpdateField(unsigned int flagMask)
+{
+   Field& field = m_fields[flagMask];
+   field.m_isUpToDate = true;
+   m_numFieldUpdates++;
+
+   std::fill(field.m_distances.begin(), field.m_distances.end(), Uint16(c_unreachable));
+   std::fill(field.m_directions.begin(), field.m_directions.end(), Uint8(navigationDirectionMax));
+
+   if (!m_hasTarget || !m_grid.IsBuilt())
+      return;
+
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+
+   Uint16 targetIndex = static_cast<Uint16>(m_targetY * size + m_targetX);
+   field.m_distances[targetIndex] = 0;
+
+   for (std::vector<Uint16>& bucket : m_buckets)
+      bucket.clear();
+
+   m_buckets[0].push_back(targetIndex);
+   size_t numQueued = 1;
+
+   for (unsigned int distance = 0; numQueued > 0; distance++)
+   {
+      std::vector<Uint16>& bucket = m_buckets[distance & (c_numBuckets - 1)];
+
+      // the bucket doesn't get new entries while processing it, since all
+      // move costs are larger than zero and smaller than c_numBuckets
+      for (size_t entry = 0; entry < bucket.size(); entry++)
+      {
+         Uint16 tileIndex = bucket[entry];
+
+         // skip entries that were queued again with a lower distance
+         if (field.m_distances[tileIndex] != distance)
+            continue;
+
+         int xpos = tileIndex % size;
+         int ypos = tileIndex / size;
+
+         for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+         {
+            // tile from which a move in direction dir leads to this tile
+            int x = xpos - NavigationGrid::GetDirectionX(dir);
+            int y = ypos - NavigationGrid::GetDirectionY(dir);
+
+            if (x < 0 || y < 0 || x >= static_cast<int>(size) || y >= static_cast<int>(size))
+               continue;
+
+            if (!m_grid.CanPass(static_cast<unsigned int>(x), static_cast<unsigned int>(y),
+               static_cast<NavigationDirection>(dir), flagMask))
+               continue;
+
+            Uint16 prevIndex = static_cast<Uint16>(y * size + x);
+            unsigned int prevDistance = distance + NavigationGrid::GetMoveCost(dir);
+
+            if (prevDistance < field.m_distances[prevIndex])
+            {
+               field.m_distances[prevIndex] = static_cast<Uint16>(prevDistance);
+               field.m_directions[prevIndex] = static_cast<Uint8>(dir);
+
+               m_buckets[prevDistance & (c_numBuckets - 1)].push_back(prevIndex);
+               numQueued++;
+            }
+         }
+      }
+
+      numQueued -= bucket.size();
+      bucket.clear();
+   }
+}
@@ -0,0 +1,119 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlowField.hpp
+/// \brief flow field leading to a target tile
+//
+#pragma once
+
+#include "NavigationGrid.hpp"
+#include <vector>
+
+namespace Physics
+{
+   /// \brief Flow field leading all tiles of a level to a target tile
+   /// \details Stores for every tile the path distance to the target tile and
+   /// the direction to move in to get nearer to the target. This lets many
+   /// objects follow the same target, e.g. critters chasing the player, by
+   /// reading a single tile each, instead of searching a path per object.
+   /// There is a separate field for every combination of pathfind flags. The
+   /// fields are computed with Dijkstra's algorithm, using a bucket queue,
+   /// when they are first read after the target was moved or the navigation
+   /// grid was modified; fields that aren't read aren't computed at all.
+   /// A field is computed from scratch each time. This visits each tile once,
+   /// and only happens when the player moves to another tile.
+   class FlowField
+   {
+   public:
+      /// distance of tiles that can't reach the target
+      static const Uint16 c_unreachable = 0xffff;
+
+      /// ctor
+      FlowField(const NavigationGrid& grid);
+
+      /// sets new target tile
+      void SetTarget(unsigned int xpos, unsigned int ypos);
+
+      /// clears target; all tiles are unreachable
+      void ClearTarget();
+
+      /// returns if a target is set
+      bool HasTarget() const { return m_hasTarget; }
+
+      /// marks all fields as outdated, e.g. when the navigation grid changed
+      void Invalidate();
+
+      /// returns direction to move in from given tile to get nearer to the target
+      NavigationDirection GetDirection(unsigned int xpos, unsigned int ypos, unsigned int flagMask);
+
+      /// returns path distance from given tile to the target
+      Uint16 GetDistance(unsigned int xpos, unsigned int ypos, unsigned int flagMask);
+
+      /// returns number of field computations done so far
+      unsigned int GetNumFieldUpdates() const { return m_numFieldUpdates; }
+
+   private:
+      /// flow field for one combination of pathfind flags
+      struct Field
+      {
+         /// indicates if the field matches the current target and grid
+         bool m_isUpToDate = false;
+
+         /// path distances to the target, indexed by ypos * 64 + xpos
+         std::vector<Uint16> m_distances;
+
+         /// directions to move in, indexed by ypos * 64 + xpos;
+         /// navigationDirectionMax at the target and for unreachable tiles
+         std::vector<Uint8> m_directions;
+      };
+
+      /// returns field for given flags, computing it when outdated
+      const Field& GetField(unsigned int flagMask);
+
+      /// computes field for given flags
+      void UpdateField(unsigned int flagMask);
+
+   private:
+      /// number of buckets in the bucket queue; must be larger than the
+      /// cost of a diagonal move, and a power of 2
+      static const unsigned int c_numBuckets = 16;
+
+      /// navigation grid to use
+      const NavigationGrid& m_grid;
+
+      /// indicates if a target is set
+      bool m_hasTarget;
+
+      /// target tile x position
+      unsigned int m_targetX;
+
+      /// target tile y position
+      unsigned int m_targetY;
+
+      /// fields for all flag combinations
+      Field m_fields[NavigationGrid::c_numFlagMasks];
+
+      /// bucket queue used while computing a field; contains tile indices
+      /// sorted by distance modulo the number of buckets
+      std::vector<Uint16> m_buckets[c_numBuckets];
+
+      /// number of field computations done so far
+      unsigned int m_numFieldUpdates;
+   };
+
+} // namespace Physics
@@ -0,0 +1,194 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelCollisionMesh.cpp
+/// \brief static collision geometry of a level
+//
+#include "pch.hpp"
+#include "LevelCollisionMesh.hpp"
+#include "GeometryProvider.hpp"
+#include "Level.hpp"
+
+using Physics::LevelCollisionMesh;
+using Physics::CollisionTriangleRange;
+
+LevelCollisionMesh::LevelCollisionMesh()
+   :m_level(nullptr),
+   m_numUnusedTriangles(0)
+{
+}
+
+/// Generates the triangles of all tiles of the level. The level must stay
+/// valid until the mesh is cleared or built for another level.
+/// \param level level to build collision mesh for
+void LevelCollisionMesh::Build(const Underworld::Level& level)
+{
+   Clear();
+
+   m_level = &level;
+   m_tiles.resize(Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize);
+
+   for (unsigned int ypos = 0; ypos < Underworld::c_underworldTilemapSize; ypos++)
+      for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
+         RebuildTile(xpos, ypos);
+
+   // don't waste memory on the growth reserve of the vectors
+   m_triangles.ShrinkToFit();
+}
+
+void LevelCollisionMesh::Clear()
+{
+   m_level = nullptr;
+   m_triangles.Clear();
+   m_tiles.clear();
+   m_invalidatedTiles.clear();
+   m_numUnusedTriangles = 0;
+}
+
+/// Invalidates the triangles of a tile. Since the walls of a tile depend on
+/// the heights of the adjacent tiles, these are invalidated as well. The
+/// triangles are generated again in UpdateInvalidatedTiles().
+/// \param xpos x tile position
+/// \param ypos y tile position
+void LevelCollisionMesh::InvalidateTile(unsigned int xpos, unsigned int ypos)
+{
+   if (!IsBuilt())
+      return;
+
+   const int offsets[5][2] = { { 0, 0 }, { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+   for (const auto& offset : offsets)
+   {
+      int x = static_cast<int>(xpos) + offset[0];
+      int y = static_cast<int>(ypos) + offset[1];
+
+      if (x < 0 || y < 0 ||
+         x >= static_cast<int>(Underworld::c_underworldTilemapSize) ||
+         y >= static_cast<int>(Underworld::c_underworldTilemapSize))
+         continue;
+
+      size_t tileIndex = static_cast<size_t>(y) * Underworld::c_underworldTilemapSize + x;
+
+      TileBucket& bucket = m_tiles[tileIndex];
+      if (!bucket.m_invalidated)
+      {
+         bucket.m_invalidated = true;
+         m_invalidatedTiles.push_back(tileIndex);
+      }
+   }
+}
+
+/// Generates the triangles of all invalidated tiles again. Triangle ranges
+/// returned by GetTileTriangles() before the call aren't valid anymore.
+void LevelCollisionMesh::UpdateInvalidatedTiles()
+{
+   for (size_t tileIndex : m_invalidatedTiles)
+   {
+      RebuildTile(
+         static_cast<unsigned int>(tileIndex % Underworld::c_underworldTilemapSize),
+         static_cast<unsigned int>(tileIndex / Underworld::c_underworldTilemapSize));
+   }
+
+   m_invalidatedTiles.clear();
+
+   // compact when more than a third of the array isn't used anymore
+   if (m_numUnusedTriangles > m_triangles.GetSize() / 3)
+      Compact();
+}
+
+/// Returns the triangles of a tile. The range stays valid until
+/// UpdateInvalidatedTiles() is called, or the mesh is built again.
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \return triangle range; empty for solid tiles or tiles outside the map
+CollisionTriangleRange LevelCollisionMesh::GetTileTriangles(unsigned int xpos, unsigned int ypos) const
+{
+   CollisionTriangleRange range;
+
+   if (!IsBuilt() ||
+      xpos >= Underworld::c_underworldTilemapSize ||
+      ypos >= Underworld::c_underworldTilemapSize)
+      return range;
+
+   const TileBucket& bucket = m_tiles[ypos * Underworld::c_underworldTilemapSize + xpos];
+
+   return m_triangles.GetRange(bucket.m_start, bucket.m_count);
+}
+
+/// Generates the tile's triangles and stores them in the tile's bucket. When
+/// the triangles don't fit into the space used before, they are appended to
+/// the triangle array and the old space remains unused until the next
+/// Compact().
+/// \param xpos x tile position
+/// \param ypos y tile position
+void LevelCollisionMesh::RebuildTile(unsigned int xpos, unsigned int ypos)
+{
+   UaAssert(m_level != nullptr);
+
+   m_tileTriangles.clear();
+
+   GeometryProvider provider{ *m_level };
+   provider.GetTileTriangles(xpos, ypos, m_tileTriangles);
+
+   TileBucket& bucket = m_tiles[ypos * Underworld::c_underworldTilemapSize + xpos];
+   bucket.m_invalidated = false;
+
+   size_t count = m_tileTriangles.size();
+
+   // the previously used triangles aren't used anymore
+   m_numUnusedTriangles += bucket.m_count;
+
+   if (count > bucket.m_capacity)
+   {
+      bucket.m_start = m_triangles.GetSize();
+      bucket.m_capacity = count;
+      m_triangles.Resize(m_triangles.GetSize() + count);
+   }
+   else
+      m_numUnusedTriangles -= count;
+
+   bucket.m_count = count;
+
+   for (size_t index = 0; index < count; index++)
+   {
+      const Triangle3dTextured& triangle = m_tileTriangles[index];
+
+      m_triangles.SetTriangle(bucket.m_start + index,
+         triangle.m_vertices[0].pos,
+         triangle.m_vertices[1].pos,
+         triangle.m_vertices[2].pos);
+   }
+}
+
+void LevelCollisionMesh::Compact()
+{
+   CollisionTriangleList compactedTriangles;
+
+   for (TileBucket& bucket : m_tiles)
+   {
+      size_t start = compactedTriangles.GetSize();
+
+      compactedTriangles.AddTriangles(m_triangles.GetRange(bucket.m_start, bucket.m_count));
+
+      bucket.m_start = start;
+      bucket.m_capacity = bucket.m_count;
+   }
+
+   m_triangles.Swap(compactedTriangles);
+   m_numUnusedTriangles = 0;
+}
@@ -0,0 +1,113 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelCollisionMesh.hpp
+/// \brief static collision geometry of a level
+//
+#pragma once
+
+#include "CollisionTriangleList.hpp"
+#include <vector>
+
+namespace Underworld
+{
+   class Level;
+}
+
+namespace Physics
+{
+   /// \brief Static collision geometry of a level
+   /// \details The triangles of all level tiles are generated once per level
+   /// and are stored in one flat array, bucketed by tile. Querying the
+   /// triangles of a tile returns a range into the array and doesn't
+   /// allocate. When tiles are modified, only the invalidated tiles are
+   /// generated again.
+   class LevelCollisionMesh
+   {
+   public:
+      /// ctor
+      LevelCollisionMesh();
+
+      /// builds collision mesh for all tiles of given level
+      void Build(const Underworld::Level& level);
+
+      /// clears collision mesh
+      void Clear();
+
+      /// returns if the mesh was built for a level
+      bool IsBuilt() const { return m_level != nullptr; }
+
+      /// invalidates a tile that was modified, as well as its neighbours
+      void InvalidateTile(unsigned int xpos, unsigned int ypos);
+
+      /// returns if there are invalidated tiles
+      bool HasInvalidatedTiles() const { return !m_invalidatedTiles.empty(); }
+
+      /// rebuilds triangles of all invalidated tiles
+      void UpdateInvalidatedTiles();
+
+      /// returns triangles of given tile
+      CollisionTriangleRange GetTileTriangles(unsigned int xpos, unsigned int ypos) const;
+
+      /// returns number of triangles stored for all tiles
+      size_t GetNumTriangles() const { return m_triangles.GetSize() - m_numUnusedTriangles; }
+
+   private:
+      /// triangles of a single tile
+      struct TileBucket
+      {
+         /// index of first triangle in m_triangles
+         size_t m_start = 0;
+
+         /// number of triangles
+         size_t m_count = 0;
+
+         /// number of triangles that fit at m_start without moving
+         size_t m_capacity = 0;
+
+         /// indicates if the tile was invalidated
+         bool m_invalidated = false;
+      };
+
+      /// generates triangles of a single tile and stores them in its bucket
+      void RebuildTile(unsigned int xpos, unsigned int ypos);
+
+      /// removes unused triangles between tile buckets
+      void Compact();
+
+   private:
+      /// level the mesh was built for
+      const Underworld::Level* m_level;
+
+      /// triangles of all tiles
+      CollisionTriangleList m_triangles;
+
+      /// tile buckets, indexed by ypos * 64 + xpos
+      std::vector<TileBucket> m_tiles;
+
+      /// indices of invalidated tiles
+      std::vector<size_t> m_invalidatedTiles;
+
+      /// number of triangles in m_triangles not used by any bucket
+      size_t m_numUnusedTriangles;
+
+      /// temporary triangle list used when generating tile triangles
+      std::vector<Triangle3dTextured> m_tileTriangles;
+   };
+
+} // namespace Physics
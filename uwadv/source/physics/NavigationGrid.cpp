@@ -0,0 +1,430 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file NavigationGrid.cpp
+/// \brief tile based navigation grid of a level
+//
+#include "pch.hpp"
+#include "NavigationGrid.hpp"
+#include "Level.hpp"
+
+using Physics::NavigationGrid;
+using Physics::NavigationDirection;
+
+/// opposite direction of straight directions
+static const NavigationDirection c_oppositeDirection[4] =
+{
+   Physics::navigationSouth, Physics::navigationWest,
+   Physics::navigationNorth, Physics::navigationEast,
+};
+
+/// straight directions that make up the diagonal directions
+static const NavigationDirection c_diagonalParts[4][2] =
+{
+   { Physics::navigationNorth, Physics::navigationEast },
+   { Physics::navigationSouth, Physics::navigationEast },
+   { Physics::navigationSouth, Physics::navigationWest },
+   { Physics::navigationNorth, Physics::navigationWest },
+};
+
+NavigationGrid::NavigationGrid()
+   :m_level(nullptr)
+{
+}
+
+/// Determines the terrain and the passable directions of all tiles of the
+/// level. The level must stay valid until the grid is cleared or built for
+/// another level.
+/// \param level level to build navigation grid for
+void NavigationGrid::Build(const Underworld::Level& level)
+{
+   Clear();
+
+   m_level = &level;
+
+   const size_t numTiles = Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize;
+
+   m_terrain.resize(numTiles);
+   for (unsigned int flagMask = 0; flagMask < c_numFlagMasks; flagMask++)
+   {
+      m_directionMasks[flagMask].resize(numTiles);
+      m_regions[flagMask].resize(numTiles);
+   }
+
+   m_regionStack.reserve(numTiles);
+
+   for (unsigned int ypos = 0; ypos < Underworld::c_underworldTilemapSize; ypos++)
+      for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
+         m_terrain[ypos * Underworld::c_underworldTilemapSize + xpos] =
+            static_cast<Uint8>(GetTerrainType(xpos, ypos));
+
+   for (unsigned int ypos = 0; ypos < Underworld::c_underworldTilemapSize; ypos++)
+      for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
+         UpdateDirectionMasks(xpos, ypos);
+
+   UpdateRegions();
+}
+
+void NavigationGrid::Clear()
+{
+   m_level = nullptr;
+   m_terrain.clear();
+
+   for (unsigned int flagMask = 0; flagMask < c_numFlagMasks; flagMask++)
+   {
+      m_directionMasks[flagMask].clear();
+      m_regions[flagMask].clear();
+   }
+}
+
+/// Updates the terrain of the tile. Since moves from the adjacent tiles
+/// (including diagonal moves around the tile) depend on the tile, the
+/// direction masks of all 8 adjacent tiles are updated as well. Regions are
+/// labeled again, since the tile may connect or split regions.
+/// \param xpos x tile position
+/// \param ypos y tile position
+void NavigationGrid::UpdateTile(unsigned int xpos, unsigned int ypos)
+{
+   if (!IsBuilt() ||
+      xpos >= Underworld::c_underworldTilemapSize ||
+      ypos >= Underworld::c_underworldTilemapSize)
+      return;
+
+   m_terrain[ypos * Underworld::c_underworldTilemapSize + xpos] =
+      static_cast<Uint8>(GetTerrainType(xpos, ypos));
+
+   for (int y = static_cast<int>(ypos) - 1; y <= static_cast<int>(ypos) + 1; y++)
+      for (int x = static_cast<int>(xpos) - 1; x <= static_cast<int>(xpos) + 1; x++)
+      {
+         if (x < 0 || y < 0 ||
+            x >= static_cast<int>(Underworld::c_underworldTilemapSize) ||
+            y >= static_cast<int>(Underworld::c_underworldTilemapSize))
+            continue;
+
+         UpdateDirectionMasks(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
+      }
+
+   UpdateRegions();
+}
+
+bool NavigationGrid::IsAccessible(unsigned int xpos, unsigned int ypos, unsigned int flagMask) const
+{
+   TerrainType terrain = static_cast<TerrainType>(
+      m_terrain[ypos * Underworld::c_underworldTilemapSize + xpos]);
+
+   return IsTerrainAccessible(terrain, flagMask);
+}
+
+NavigationGrid::TerrainType NavigationGrid::GetTerrainType(unsigned int xpos, unsigned int ypos) const
+{
+   UaAssert(m_level != nullptr);
+
+   const Underworld::TileInfo& tileInfo = m_level->GetTilemap().GetTileInfo(xpos, ypos);
+   if (tileInfo.m_type == Underworld::tileSolid)
+      return terrainSolid;
+
+   if (tileInfo.m_isDoorPresent && IsDoorClosed(xpos, ypos))
+      return terrainClosedDoor;
+
+   // bridges and doors take precedence over the floor texture
+   switch (m_level->GetAutomapFlagFromTile(xpos, ypos))
+   {
+   case Underworld::automapWater: return terrainWater;
+   case Underworld::automapLava: return terrainLava;
+   default:
+      break;
+   }
+
+   return terrainFloor;
+}
+
+/// Closed doors are door objects 0x0140..0x0147, including secret doors and
+/// the portcullis; open doors are 0x0148..0x014f.
+bool NavigationGrid::IsDoorClosed(unsigned int xpos, unsigned int ypos) const
+{
+   const Underworld::ObjectList& objectList = m_level->GetObjectList();
+   Uint16 pos = objectList.GetListStart(xpos, ypos);
+
+   while (pos != 0)
+   {
+      const Underworld::ObjectInfo& objInfo = objectList.GetObject(pos)->GetObjectInfo();
+
+      if (objInfo.m_itemID >= 0x0140 && objInfo.m_itemID <= 0x0147)
+         return true;
+
+      pos = objInfo.m_link;
+   }
+
+   return false;
+}
+
+bool NavigationGrid::IsTerrainAccessible(TerrainType terrain, unsigned int flagMask)
+{
+   if (terrain == terrainSolid || terrain == terrainClosedDoor)
+      return false;
+
+   if (terrain == terrainFloor || (flagMask & (1 << pathfindFlagCanFly)) != 0)
+      return true;
+
+   if (terrain == terrainWater)
+      return (flagMask & (1 << pathfindFlagCanSwim)) != 0;
+
+   return (flagMask & (1 << pathfindFlagCanWalkLava)) != 0;
+}
+
+/// Checks if the shared edge of the two tiles isn't blocked by diagonal
+/// walls, if there's space between floor and ceiling to pass, and, for
+/// walking, if the floor height difference at the edge can be stepped over.
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \param dir straight direction to adjacent tile
+/// \param canFly indicates if height differences can be flown over
+bool NavigationGrid::CanPassEdge(unsigned int xpos, unsigned int ypos,
+   NavigationDirection dir, bool canFly) const
+{
+   UaAssert(dir < navigationNorthEast);
+
+   int x = static_cast<int>(xpos) + GetDirectionX(dir);
+   int y = static_cast<int>(ypos) + GetDirectionY(dir);
+
+   if (x < 0 || y < 0 ||
+      x >= static_cast<int>(Underworld::c_underworldTilemapSize) ||
+      y >= static_cast<int>(Underworld::c_underworldTilemapSize))
+      return false;
+
+   const Underworld::Tilemap& tilemap = m_level->GetTilemap();
+   const Underworld::TileInfo& fromTile = tilemap.GetTileInfo(xpos, ypos);
+   const Underworld::TileInfo& toTile = tilemap.GetTileInfo(
+      static_cast<unsigned int>(x), static_cast<unsigned int>(y));
+
+   NavigationDirection oppositeDir = c_oppositeDirection[dir];
+
+   if (!IsSideOpen(fromTile, dir) || !IsSideOpen(toTile, oppositeDir))
+      return false;
+
+   // heights are compared in half height units
+   unsigned int fromHeight = GetEdgeFloorHeight(fromTile, dir);
+   unsigned int toHeight = GetEdgeFloorHeight(toTile, oppositeDir);
+
+   unsigned int ceiling = std::min(fromTile.m_ceiling, toTile.m_ceiling) * 2u;
+   if (ceiling <= std::max(fromHeight, toHeight))
+      return false;
+
+   if (canFly)
+      return true;
+
+   unsigned int heightDiff = fromHeight > toHeight ? fromHeight - toHeight : toHeight - fromHeight;
+   return heightDiff <= c_maxStepHeight * 2;
+}
+
+/// \param tileInfo tile info of tile
+/// \param dir straight direction of the tile side
+/// \return floor height at the middle of the side, in half height units
+unsigned int NavigationGrid::GetEdgeFloorHeight(const Underworld::TileInfo& tileInfo,
+   NavigationDirection dir)
+{
+   unsigned int height = tileInfo.m_floor * 2u;
+
+   Underworld::TilemapTileType risingType, fallingType;
+   switch (dir)
+   {
+   case navigationNorth:
+      risingType = Underworld::tileSlope_n;
+      fallingType = Underworld::tileSlope_s;
+      break;
+   case navigationEast:
+      risingType = Underworld::tileSlope_e;
+      fallingType = Underworld::tileSlope_w;
+      break;
+   case navigationSouth:
+      risingType = Underworld::tileSlope_s;
+      fallingType = Underworld::tileSlope_n;
+      break;
+   default:
+      risingType = Underworld::tileSlope_w;
+      fallingType = Underworld::tileSlope_e;
+      break;
+   }
+
+   if (tileInfo.m_type == risingType)
+      height += tileInfo.m_slope * 2u;
+   else if (tileInfo.m_type != fallingType &&
+      tileInfo.m_type >= Underworld::tileSlope_n && tileInfo.m_type <= Underworld::tileSlope_w)
+      height += tileInfo.m_slope; // side of a slope, going up halfway
+   return height;
+}
+
+bool NavigationGrid::IsSideOpen(const Underworld::TileInfo& tileInfo, NavigationDirection dir)
+{
+   switch (tileInfo.m_type)
+   {
+   case Underworld::tileSolid:
+      return false;
+   case Underworld::tileDiagonal_se:
+      return dir == navigationSouth || dir == navigationEast;
+   case Underworld::tileDiagonal_sw:
+      return dir == navigationSouth || dir == navigationWest;
+   case Underworld::tileDiagonal_nw:
+      return dir == navigationNorth || dir == navigationWest;
+   case Underworld::tileDiagonal_ne:
+      return dir == navigationNorth || dir == navigationEast;
+   default:
+      return true;
+   }
+}
+
+void NavigationGrid::UpdateDirectionMasks(unsigned int xpos, unsigned int ypos)
+{
+   const size_t tileIndex = ypos * Underworld::c_underworldTilemapSize + xpos;
+
+   // edges between this tile, the straight adjacent tiles and the corner
+   // tiles; index 0 is walking, 1 is flying
+   bool straightEdges[2][4];
+   bool cornerEdges[2][4][2];
+
+   for (unsigned int canFly = 0; canFly < 2; canFly++)
+   {
+      for (unsigned int dir = navigationNorth; dir < navigationNorthEast; dir++)
+         straightEdges[canFly][dir] =
+            CanPassEdge(xpos, ypos, static_cast<NavigationDirection>(dir), canFly != 0);
+
+      for (unsigned int diagonal = 0; diagonal < 4; diagonal++)
+      {
+         for (unsigned int part = 0; part < 2; part++)
+         {
+            // from the adjacent tile in one part direction, go on in the
+            // other part direction
+            NavigationDirection firstDir = c_diagonalParts[diagonal][part];
+            NavigationDirection secondDir = c_diagonalParts[diagonal][1 - part];
+
+            cornerEdges[canFly][diagonal][part] = straightEdges[canFly][firstDir] &&
+               CanPassEdge(xpos + GetDirectionX(firstDir),
+                  ypos + GetDirectionY(firstDir),
+                  secondDir, canFly != 0);
+         }
+      }
+   }
+
+   for (unsigned int flagMask = 0; flagMask < c_numFlagMasks; flagMask++)
+   {
+      Uint8 directionMask = 0;
+
+      if (m_terrain[tileIndex] != terrainSolid && m_terrain[tileIndex] != terrainClosedDoor)
+      {
+         unsigned int canFly = (flagMask & (1 << pathfindFlagCanFly)) != 0 ? 1 : 0;
+
+         bool accessible[navigationDirectionMax];
+
+         for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+         {
+            int x = static_cast<int>(xpos) + GetDirectionX(dir);
+            int y = static_cast<int>(ypos) + GetDirectionY(dir);
+
+            accessible[dir] = x >= 0 && y >= 0 &&
+               x < static_cast<int>(Underworld::c_underworldTilemapSize) &&
+               y < static_cast<int>(Underworld::c_underworldTilemapSize) &&
+               IsTerrainAccessible(static_cast<TerrainType>(
+                  m_terrain[y * Underworld::c_underworldTilemapSize + x]), flagMask);
+         }
+
+         for (unsigned int dir = navigationNorth; dir < navigationNorthEast; dir++)
+            if (straightEdges[canFly][dir] && accessible[dir])
+               directionMask |= 1 << dir;
+
+         // diagonal moves must not cut corners
+         for (unsigned int diagonal = 0; diagonal < 4; diagonal++)
+         {
+            NavigationDirection firstDir = c_diagonalParts[diagonal][0];
+            NavigationDirection secondDir = c_diagonalParts[diagonal][1];
+
+            if (accessible[navigationNorthEast + diagonal] &&
+               accessible[firstDir] && accessible[secondDir] &&
+               cornerEdges[canFly][diagonal][0] && cornerEdges[canFly][diagonal][1])
+               directionMask |= 1 << (navigationNorthEast + diagonal);
+         }
+      }
+
+      m_directionMasks[flagMask][tileIndex] = directionMask;
+   }
+}
+
+/// Labels the regions by flood filling from every tile that isn't labeled
+/// yet. Moves are treated as going both ways, e.g. a walker can leave a
+/// water tile but can't enter it, so a region may contain tiles that can't
+/// be reached from each other, but tiles in different regions are never
+/// connected by a path.
+void NavigationGrid::UpdateRegions()
+{
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+
+   for (unsigned int flagMask = 0; flagMask < c_numFlagMasks; flagMask++)
+   {
+      const std::vector<Uint8>& directionMasks = m_directionMasks[flagMask];
+      std::vector<Uint16>& regions = m_regions[flagMask];
+
+      std::fill(regions.begin(), regions.end(), c_noRegion);
+
+      Uint16 nextRegion = 0;
+
+      for (Uint16 startIndex = 0; startIndex < size * size; startIndex++)
+      {
+         if (regions[startIndex] != c_noRegion ||
+            m_terrain[startIndex] == terrainSolid || m_terrain[startIndex] == terrainClosedDoor)
+            continue;
+
+         Uint16 region = nextRegion++;
+
+         regions[startIndex] = region;
+         m_regionStack.push_back(startIndex);
+
+         while (!m_regionStack.empty())
+         {
+            Uint16 tileIndex = m_regionStack.back();
+            m_regionStack.pop_back();
+
+            int xpos = tileIndex % size;
+            int ypos = tileIndex / size;
+
+            for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+            {
+               int x = xpos + GetDirectionX(dir);
+               int y = ypos + GetDirectionY(dir);
+
+               if (x < 0 || y < 0 || x >= static_cast<int>(size) || y >= static_cast<int>(size))
+                  continue;
+
+               Uint16 nextIndex = static_cast<Uint16>(y * size + x);
+               if (regions[nextIndex] != c_noRegion)
+                  continue;
+
+               // opposite direction; diagonals are in the same order
+               unsigned int oppositeDir = dir < navigationNorthEast
+                  ? static_cast<unsigned int>(c_oppositeDirection[dir])
+                  : static_cast<unsigned int>(navigationNorthEast + ((dir - navigationNorthEast + 2) & 3));
+
+               if ((directionMasks[tileIndex] & (1 << dir)) != 0 ||
+                  (directionMasks[nextIndex] & (1 << oppositeDir)) != 0)
+               {
+                  regions[nextIndex] = region;
+                  m_regionStack.push_back(nextIndex);
+               }
+            }
+         }
+      }
+   }
+}
@@ -0,0 +1,205 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file NavigationGrid.hpp
+/// \brief tile based navigation grid of a level
+//
+#pragma once
+
+#include "Tilemap.hpp"
+#include <vector>
+
+namespace Underworld
+{
+   class Level;
+}
+
+namespace Physics
+{
+   /// pathfinding flags; used as bit index in a flag mask
+   enum PathfindFlags
+   {
+      pathfindFlagCanFly = 0,
+      pathfindFlagCanSwim,
+      pathfindFlagCanWalkLava,
+
+      pathfindFlagMax // must be the last element
+   };
+
+   /// direction to an adjacent tile; y axis points north
+   enum NavigationDirection
+   {
+      navigationNorth = 0,
+      navigationEast,
+      navigationSouth,
+      navigationWest,
+      navigationNorthEast,
+      navigationSouthEast,
+      navigationSouthWest,
+      navigationNorthWest,
+
+      navigationDirectionMax // must be the last element
+   };
+
+   /// \brief Tile based navigation grid of a level
+   /// \details Stores for every tile and every combination of pathfind flags
+   /// a bit mask of the directions in which an adjacent tile can be reached.
+   /// Passability is determined by the tile types, by the floor height
+   /// difference at the shared tile edge and by the terrain (water, lava)
+   /// of the adjacent tile; tiles with a closed door can't be entered.
+   /// Diagonal moves are only possible when both straight moves around the
+   /// corner are possible as well. The grid is built once per level;
+   /// checking passability doesn't need to look at the tilemap anymore.
+   /// Tiles are also labeled with connected regions, so that searching paths
+   /// between unconnected tiles can fail early.
+   class NavigationGrid
+   {
+   public:
+      /// max. floor height difference at a tile edge that can be walked
+      static const unsigned int c_maxStepHeight = 8;
+
+      /// number of combinations of pathfind flags
+      static const unsigned int c_numFlagMasks = 1 << pathfindFlagMax;
+
+      /// region label of tiles that can't be entered
+      static constexpr Uint16 c_noRegion = 0xffff;
+
+      /// ctor
+      NavigationGrid();
+
+      /// builds navigation grid for all tiles of given level
+      void Build(const Underworld::Level& level);
+
+      /// clears navigation grid
+      void Clear();
+
+      /// returns if the grid was built for a level
+      bool IsBuilt() const { return m_level != nullptr; }
+
+      /// updates a tile that was modified, as well as its neighbours
+      void UpdateTile(unsigned int xpos, unsigned int ypos);
+
+      /// returns bit mask of directions that can be passed from given tile
+      Uint8 GetPassableDirections(unsigned int xpos, unsigned int ypos, unsigned int flagMask) const
+      {
+         return m_directionMasks[flagMask][ypos * Underworld::c_underworldTilemapSize + xpos];
+      }
+
+      /// returns if adjacent tile can be reached from given tile and direction
+      bool CanPass(unsigned int xpos, unsigned int ypos,
+         NavigationDirection dir, unsigned int flagMask) const
+      {
+         return (GetPassableDirections(xpos, ypos, flagMask) & (1 << dir)) != 0;
+      }
+
+      /// returns if the tile can be entered at all with given flags
+      bool IsAccessible(unsigned int xpos, unsigned int ypos, unsigned int flagMask) const;
+
+      /// returns connected region label of a tile
+      Uint16 GetRegion(unsigned int xpos, unsigned int ypos, unsigned int flagMask) const
+      {
+         return m_regions[flagMask][ypos * Underworld::c_underworldTilemapSize + xpos];
+      }
+
+      /// returns if there may be a path between two tiles
+      bool IsConnected(unsigned int fromx, unsigned int fromy,
+         unsigned int tox, unsigned int toy, unsigned int flagMask) const
+      {
+         Uint16 region = GetRegion(fromx, fromy, flagMask);
+         return region != c_noRegion && region == GetRegion(tox, toy, flagMask);
+      }
+
+      /// returns cost of a move in given direction; diagonal moves cost
+      /// approximately sqrt(2) times the cost of straight moves
+      static unsigned int GetMoveCost(unsigned int dir)
+      {
+         return dir < navigationNorthEast ? 10 : 14;
+      }
+
+      /// returns x offset of a direction
+      static int GetDirectionX(unsigned int dir)
+      {
+         static const int c_offsetsX[navigationDirectionMax] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+         return c_offsetsX[dir];
+      }
+
+      /// returns y offset of a direction
+      static int GetDirectionY(unsigned int dir)
+      {
+         static const int c_offsetsY[navigationDirectionMax] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+         return c_offsetsY[dir];
+      }
+
+   private:
+      /// terrain type of a tile
+      enum TerrainType
+      {
+         terrainSolid = 0,
+         terrainFloor,
+         terrainWater,
+         terrainLava,
+         terrainClosedDoor,
+      };
+
+      /// determines terrain type of a tile
+      TerrainType GetTerrainType(unsigned int xpos, unsigned int ypos) const;
+
+      /// returns if a closed door object is in given tile
+      bool IsDoorClosed(unsigned int xpos, unsigned int ypos) const;
+
+      /// returns if the tile can be entered with given terrain and flags
+      static bool IsTerrainAccessible(TerrainType terrain, unsigned int flagMask);
+
+      /// returns if a move between two straight adjacent tiles is possible,
+      /// regardless of terrain
+      bool CanPassEdge(unsigned int xpos, unsigned int ypos,
+         NavigationDirection dir, bool canFly) const;
+
+      /// returns floor height at the middle of given tile side
+      static unsigned int GetEdgeFloorHeight(const Underworld::TileInfo& tileInfo,
+         NavigationDirection dir);
+
+      /// returns if the given tile side is open, considering diagonal walls
+      static bool IsSideOpen(const Underworld::TileInfo& tileInfo, NavigationDirection dir);
+
+      /// computes direction masks of a single tile; terrain of the adjacent
+      /// tiles must already be known
+      void UpdateDirectionMasks(unsigned int xpos, unsigned int ypos);
+
+      /// labels connected regions of all tiles
+      void UpdateRegions();
+
+   private:
+      /// level the grid was built for
+      const Underworld::Level* m_level;
+
+      /// terrain type of all tiles, indexed by ypos * 64 + xpos
+      std::vector<Uint8> m_terrain;
+
+      /// passable direction masks for all flag combinations, indexed by
+      /// ypos * 64 + xpos
+      std::vector<Uint8> m_directionMasks[c_numFlagMasks];
+
+      /// region labels for all flag combinations, indexed by ypos * 64 + xpos
+      std::vector<Uint16> m_regions[c_numFlagMasks];
+
+      /// tile stack used when labeling regions
+      std::vector<Uint16> m_regionStack;
+   };
+
+} // namespace Physics
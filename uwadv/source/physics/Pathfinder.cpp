@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2003,2019,2022 Underworld Adventures Team
+// Copyright (c) 2003,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,13 +21,456 @@
 //
 #include "pch.hpp"
 #include "Pathfinder.hpp"
+#include <algorithm>
+#include <functional>
 
+using Physics::Pathfinder;
 using Physics::PathfinderAStar;
+using Physics::PathfinderHierarchical;
+using Physics::NavigationGrid;
+using Physics::SectorGraph;
 
+/// number of tiles in the tilemap
+static const size_t c_numNodes = Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize;
+
+PathfinderAStar::PathfinderAStar(const NavigationGrid& grid)
+   :Pathfinder(grid),
+   m_generation(0),
+   m_nodes(c_numNodes, SearchNode{}),
+   m_heap(c_numNodes),
+   m_heapSize(0),
+   m_numExpandedNodes(0)
+{
+}
+
+/// Finds shortest path from start to target tile, considering the pathfind
+/// flags set. The path list contains all tiles to move to, excluding the
+/// start tile and including the target tile. The path list is cleared
+/// first; its memory is reused, so passing the same list again avoids
+/// allocations.
+/// \param fromx x tile position of start tile
+/// \param fromy y tile position of start tile
+/// \param tox x tile position of target tile
+/// \param toy y tile position of target tile
+/// \param pathlist path list to store path in
+/// \return true when a path was found
 bool PathfinderAStar::FindPath(unsigned int fromx, unsigned int fromy,
    unsigned int tox, unsigned int toy, PathList& pathlist)
 {
-   // TODO implement
+   pathlist.clear();
+   m_numExpandedNodes = 0;
+
+   if (!m_grid.IsBuilt() ||
+      fromx >= Underworld::c_underworldTilemapSize || fromy >= Underworld::c_underworldTilemapSize ||
+      tox >= Underworld::c_underworldTilemapSize || toy >= Underworld::c_underworldTilemapSize)
+      return false;
+
+   if (fromx == tox && fromy == toy)
+      return true;
+
+   if (!m_grid.IsAccessible(tox, toy, m_flagMask) ||
+      !m_grid.IsConnected(fromx, fromy, tox, toy, m_flagMask))
+      return false;
+
+   // start new search generation; clear all nodes when wrapping around
+   if (++m_generation == 0)
+   {
+      for (SearchNode& searchNode : m_nodes)
+         searchNode.m_generation = 0;
+      m_generation = 1;
+   }
+
+   const Uint16 startNode = static_cast<Uint16>(fromy * Underworld::c_underworldTilemapSize + fromx);
+   const Uint16 targetNode = static_cast<Uint16>(toy * Underworld::c_underworldTilemapSize + tox);
+
+   m_heapSize = 0;
+
+   SearchNode& start = m_nodes[startNode];
+   start.m_generation = m_generation;
+   start.m_costFromStart = 0;
+   start.m_totalCost = static_cast<Uint16>(GetHeuristicCost(fromx, fromy, tox, toy));
+   start.m_parentNode = startNode;
+   HeapPush(startNode);
+
+   while (m_heapSize > 0)
+   {
+      Uint16 node = HeapPop();
+      if (node == targetNode)
+      {
+         StorePath(startNode, targetNode, pathlist);
+         return true;
+      }
+
+      m_numExpandedNodes++;
+
+      unsigned int xpos = node % Underworld::c_underworldTilemapSize;
+      unsigned int ypos = node / Underworld::c_underworldTilemapSize;
+
+      Uint8 directionMask = m_grid.GetPassableDirections(xpos, ypos, m_flagMask);
+      Uint32 nodeCost = m_nodes[node].m_costFromStart;
+
+      for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+      {
+         if ((directionMask & (1 << dir)) == 0)
+            continue;
+
+         unsigned int nextx = xpos + NavigationGrid::GetDirectionX(dir);
+         unsigned int nexty = ypos + NavigationGrid::GetDirectionY(dir);
+
+         Uint16 nextNode = static_cast<Uint16>(nexty * Underworld::c_underworldTilemapSize + nextx);
+
+         Uint16 cost = static_cast<Uint16>(nodeCost + NavigationGrid::GetMoveCost(dir));
+
+         SearchNode& next = m_nodes[nextNode];
+         if (next.m_generation != m_generation)
+         {
+            // not visited yet
+            next.m_generation = m_generation;
+            next.m_costFromStart = cost;
+            next.m_totalCost = static_cast<Uint16>(cost + GetHeuristicCost(nextx, nexty, tox, toy));
+            next.m_parentNode = node;
+            HeapPush(nextNode);
+         }
+         else if (next.m_heapPos != c_nodeClosed && cost < next.m_costFromStart)
+         {
+            // found cheaper path to open node; with a consistent heuristic,
+            // closed nodes never have to be opened again
+            next.m_totalCost = static_cast<Uint16>(next.m_totalCost - (next.m_costFromStart - cost));
+            next.m_costFromStart = cost;
+            next.m_parentNode = node;
+
+            m_heap[next.m_heapPos] = GetHeapEntry(nextNode);
+            HeapSiftUp(next.m_heapPos);
+         }
+      }
+   }
 
    return false;
 }
+
+/// Uses the octile distance, which is the exact cost on an empty grid.
+Uint32 Pathfinder::GetHeuristicCost(unsigned int xpos, unsigned int ypos,
+   unsigned int tox, unsigned int toy)
+{
+   Uint32 dx = xpos > tox ? xpos - tox : tox - xpos;
+   Uint32 dy = ypos > toy ? ypos - toy : toy - ypos;
+
+   const Uint32 straightCost = NavigationGrid::GetMoveCost(navigationNorth);
+   const Uint32 diagonalCost = NavigationGrid::GetMoveCost(navigationNorthEast);
+
+   return straightCost * std::max(dx, dy) + (diagonalCost - straightCost) * std::min(dx, dy);
+}
+
+/// Nodes with lower total cost come first; on equal total cost, nodes
+/// nearer to the target are preferred. Costs of paths on the 64x64 tilemap
+/// fit into 16 bits; the node index is stored in the lowest 16 bits.
+Uint64 PathfinderAStar::GetHeapEntry(Uint16 node) const
+{
+   const SearchNode& searchNode = m_nodes[node];
+
+   return (Uint64(searchNode.m_totalCost) << 32) |
+      (Uint64(0xffff - searchNode.m_costFromStart) << 16) |
+      node;
+}
+
+void PathfinderAStar::HeapPush(Uint16 node)
+{
+   m_heap[m_heapSize] = GetHeapEntry(node);
+   m_nodes[node].m_heapPos = static_cast<Uint16>(m_heapSize);
+   m_heapSize++;
+
+   HeapSiftUp(m_heapSize - 1);
+}
+
+Uint16 PathfinderAStar::HeapPop()
+{
+   Uint16 node = static_cast<Uint16>(m_heap[0]);
+   m_nodes[node].m_heapPos = c_nodeClosed;
+
+   m_heapSize--;
+   if (m_heapSize > 0)
+   {
+      m_heap[0] = m_heap[m_heapSize];
+      m_nodes[static_cast<Uint16>(m_heap[0])].m_heapPos = 0;
+      HeapSiftDown(0);
+   }
+
+   return node;
+}
+
+void PathfinderAStar::HeapSiftUp(size_t heapPos)
+{
+   Uint64 entry = m_heap[heapPos];
+
+   while (heapPos > 0)
+   {
+      size_t parentPos = (heapPos - 1) / 2;
+      Uint64 parentEntry = m_heap[parentPos];
+
+      if (entry >= parentEntry)
+         break;
+
+      m_heap[heapPos] = parentEntry;
+      m_nodes[static_cast<Uint16>(parentEntry)].m_heapPos = static_cast<Uint16>(heapPos);
+      heapPos = parentPos;
+   }
+
+   m_heap[heapPos] = entry;
+   m_nodes[static_cast<Uint16>(entry)].m_heapPos = static_cast<Uint16>(heapPos);
+}
+
+void PathfinderAStar::HeapSiftDown(size_t heapPos)
+{
+   Uint64 entry = m_heap[heapPos];
+
+   for (;;)
+   {
+      size_t childPos = heapPos * 2 + 1;
+      if (childPos >= m_heapSize)
+         break;
+
+      if (childPos + 1 < m_heapSize && m_heap[childPos + 1] < m_heap[childPos])
+         childPos++;
+
+      Uint64 childEntry = m_heap[childPos];
+      if (childEntry >= entry)
+         break;
+
+      m_heap[heapPos] = childEntry;
+      m_nodes[static_cast<Uint16>(childEntry)].m_heapPos = static_cast<Uint16>(heapPos);
+      heapPos = childPos;
+   }
+
+   m_heap[heapPos] = entry;
+   m_nodes[static_cast<Uint16>(entry)].m_heapPos = static_cast<Uint16>(heapPos);
+}
+
+void PathfinderAStar::StorePath(Uint16 startNode, Uint16 targetNode, PathList& pathlist) const
+{
+   size_t length = 0;
+   for (Uint16 node = targetNode; node != startNode; node = m_nodes[node].m_parentNode)
+      length++;
+
+   pathlist.resize(length);
+
+   size_t index = length;
+   for (Uint16 node = targetNode; node != startNode; node = m_nodes[node].m_parentNode)
+   {
+      index--;
+      pathlist[index] = std::make_pair(
+         static_cast<unsigned int>(node % Underworld::c_underworldTilemapSize),
+         static_cast<unsigned int>(node / Underworld::c_underworldTilemapSize));
+   }
+}
+
+PathfinderHierarchical::PathfinderHierarchical(const NavigationGrid& grid, const SectorGraph& sectorGraph)
+   :Pathfinder(grid),
+   m_sectorGraph(sectorGraph),
+   m_refiner(grid),
+   m_generation(0),
+   m_nodes(c_numNodes, AbstractNode{}),
+   m_numRefinedSteps(0),
+   m_numExpandedNodes(0)
+{
+   m_openList.reserve(c_numNodes);
+}
+
+/// Finds path from start to target tile, considering the pathfind flags
+/// set. The path list contains the refined steps first, excluding the start
+/// tile; when the target is further away, the waypoints of the rest of the
+/// path follow, including the target tile. The path found may be slightly
+/// longer than the shortest path, since it has to pass the sector entrances.
+/// \param fromx x tile position of start tile
+/// \param fromy y tile position of start tile
+/// \param tox x tile position of target tile
+/// \param toy y tile position of target tile
+/// \param pathlist path list to store path in
+/// \return true when a path was found
+bool PathfinderHierarchical::FindPath(unsigned int fromx, unsigned int fromy,
+   unsigned int tox, unsigned int toy, PathList& pathlist)
+{
+   pathlist.clear();
+   m_numRefinedSteps = 0;
+   m_numExpandedNodes = 0;
+
+   if (!m_grid.IsBuilt() ||
+      fromx >= Underworld::c_underworldTilemapSize || fromy >= Underworld::c_underworldTilemapSize ||
+      tox >= Underworld::c_underworldTilemapSize || toy >= Underworld::c_underworldTilemapSize)
+      return false;
+
+   if (fromx == tox && fromy == toy)
+      return true;
+
+   if (!m_grid.IsAccessible(tox, toy, m_flagMask) ||
+      !m_grid.IsConnected(fromx, fromy, tox, toy, m_flagMask))
+      return false;
+
+   for (unsigned int flag = 0; flag < pathfindFlagMax; flag++)
+      m_refiner.SetFlag(static_cast<PathfindFlags>(flag), (m_flagMask & (1 << flag)) != 0);
+
+   unsigned int dx = fromx > tox ? fromx - tox : tox - fromx;
+   unsigned int dy = fromy > toy ? fromy - toy : toy - fromy;
+
+   unsigned int startSector = SectorGraph::GetSector(fromx, fromy);
+
+   // near targets are found faster without the sector graph; the path on the
+   // sector graph may also miss paths that only cross sectors diagonally
+   if (!m_sectorGraph.IsBuilt() ||
+      startSector == SectorGraph::GetSector(tox, toy) ||
+      std::max(dx, dy) <= SectorGraph::c_sectorSize ||
+      !FindAbstractPath(fromx, fromy, tox, toy))
+      return FindRefinedPath(fromx, fromy, tox, toy, pathlist);
+
+   // refine up to the first waypoint outside of the start sector
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+
+   size_t legEnd = 0;
+   while (legEnd + 1 < m_abstractPath.size() &&
+      SectorGraph::GetSector(m_abstractPath[legEnd] % size, m_abstractPath[legEnd] / size) == startSector)
+      legEnd++;
+
+   // when the graph isn't up to date, the first leg may not exist anymore
+   if (!FindRefinedPath(fromx, fromy, m_abstractPath[legEnd] % size, m_abstractPath[legEnd] / size, pathlist))
+      return FindRefinedPath(fromx, fromy, tox, toy, pathlist);
+
+   for (size_t index = legEnd + 1; index < m_abstractPath.size(); index++)
+      pathlist.push_back(std::make_pair(
+         static_cast<unsigned int>(m_abstractPath[index] % size),
+         static_cast<unsigned int>(m_abstractPath[index] / size)));
+
+   return true;
+}
+
+bool PathfinderHierarchical::FindRefinedPath(unsigned int fromx, unsigned int fromy,
+   unsigned int tox, unsigned int toy, PathList& pathlist)
+{
+   bool found = m_refiner.FindPath(fromx, fromy, tox, toy, pathlist);
+
+   m_numExpandedNodes += m_refiner.GetNumExpandedNodes();
+   m_numRefinedSteps = pathlist.size();
+
+   return found;
+}
+
+/// Runs A* on the sector graph. The start tile is connected to the
+/// entrances of its sector, and the entrances of the target sector are
+/// connected to the target tile, using the path costs inside the sectors.
+bool PathfinderHierarchical::FindAbstractPath(unsigned int fromx, unsigned int fromy,
+   unsigned int tox, unsigned int toy)
+{
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+
+   m_abstractPath.clear();
+   m_openList.clear();
+
+   // start new search generation; clear all nodes when wrapping around
+   if (++m_generation == 0)
+   {
+      for (AbstractNode& abstractNode : m_nodes)
+         abstractNode.m_generation = 0;
+      m_generation = 1;
+   }
+
+   const Uint16 startNode = static_cast<Uint16>(fromy * size + fromx);
+   const Uint16 targetNode = static_cast<Uint16>(toy * size + tox);
+   const unsigned int targetSector = SectorGraph::GetSector(tox, toy);
+
+   Uint16 startCosts[SectorGraph::c_numSectorTiles];
+   Uint16 targetCosts[SectorGraph::c_numSectorTiles];
+
+   m_sectorGraph.GetCostsInSector(startNode, m_flagMask, false, startCosts);
+   m_sectorGraph.GetCostsInSector(targetNode, m_flagMask, true, targetCosts);
+
+   for (Uint16 node : m_sectorGraph.GetSectorNodes(SectorGraph::GetSector(fromx, fromy), m_flagMask))
+   {
+      Uint16 cost = startCosts[SectorGraph::GetSectorTileIndex(node)];
+      if (cost != SectorGraph::c_unreachable)
+         RelaxNode(node, cost, startNode, tox, toy);
+   }
+
+   while (!m_openList.empty())
+   {
+      std::pop_heap(m_openList.begin(), m_openList.end(), std::greater<Uint64>());
+      Uint16 node = static_cast<Uint16>(m_openList.back());
+      m_openList.pop_back();
+
+      AbstractNode& abstractNode = m_nodes[node];
+      if (abstractNode.m_isClosed)
+         continue;
+
+      abstractNode.m_isClosed = true;
+
+      if (node == targetNode)
+      {
+         for (Uint16 pathNode = targetNode; pathNode != startNode; pathNode = m_nodes[pathNode].m_parentNode)
+            m_abstractPath.push_back(pathNode);
+
+         std::reverse(m_abstractPath.begin(), m_abstractPath.end());
+         return true;
+      }
+
+      m_numExpandedNodes++;
+
+      unsigned int xpos = node % size;
+      unsigned int ypos = node / size;
+      unsigned int sector = SectorGraph::GetSector(xpos, ypos);
+      Uint32 cost = abstractNode.m_costFromStart;
+
+      // moves to the other entrances of the sector
+      const std::vector<Uint16>& sectorNodes = m_sectorGraph.GetSectorNodes(sector, m_flagMask);
+      Uint8 nodeIndex = m_sectorGraph.GetNodeIndex(node, m_flagMask);
+
+      for (size_t index = 0; index < sectorNodes.size(); index++)
+      {
+         Uint16 sectorCost = m_sectorGraph.GetSectorCost(sector, nodeIndex, index, m_flagMask);
+         if (index != nodeIndex && sectorCost != SectorGraph::c_unreachable)
+            RelaxNode(sectorNodes[index], cost + sectorCost, node, tox, toy);
+      }
+
+      // moves over the sector border to entrances of adjacent sectors
+      for (unsigned int dir = navigationNorth; dir < navigationNorthEast; dir++)
+      {
+         if (!m_grid.CanPass(xpos, ypos, static_cast<NavigationDirection>(dir), m_flagMask))
+            continue;
+
+         unsigned int nextx = xpos + NavigationGrid::GetDirectionX(dir);
+         unsigned int nexty = ypos + NavigationGrid::GetDirectionY(dir);
+         Uint16 nextNode = static_cast<Uint16>(nexty * size + nextx);
+
+         if (SectorGraph::GetSector(nextx, nexty) != sector &&
+            m_sectorGraph.GetNodeIndex(nextNode, m_flagMask) != SectorGraph::c_noNode)
+            RelaxNode(nextNode, cost + NavigationGrid::GetMoveCost(dir), node, tox, toy);
+      }
+
+      // move to the target tile
+      if (sector == targetSector)
+      {
+         Uint16 targetCost = targetCosts[SectorGraph::GetSectorTileIndex(node)];
+         if (targetCost != SectorGraph::c_unreachable)
+            RelaxNode(targetNode, cost + targetCost, node, tox, toy);
+      }
+   }
+
+   return false;
+}
+
+void PathfinderHierarchical::RelaxNode(Uint16 node, Uint32 cost, Uint16 parentNode,
+   unsigned int tox, unsigned int toy)
+{
+   AbstractNode& abstractNode = m_nodes[node];
+
+   if (abstractNode.m_generation == m_generation &&
+      (abstractNode.m_isClosed || cost >= abstractNode.m_costFromStart))
+      return;
+
+   abstractNode.m_generation = m_generation;
+   abstractNode.m_costFromStart = static_cast<Uint16>(cost);
+   abstractNode.m_parentNode = parentNode;
+   abstractNode.m_isClosed = false;
+
+   Uint32 totalCost = cost + GetHeuristicCost(node % Underworld::c_underworldTilemapSize,
+      node / Underworld::c_underworldTilemapSize, tox, toy);
+
+   m_openList.push_back((Uint64(totalCost) << 32) | (Uint64(0xffff - cost) << 16) | node);
+   std::push_heap(m_openList.begin(), m_openList.end(), std::greater<Uint64>());
+}
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,24 +22,12 @@
 //
 #pragma once
 
+#include "NavigationGrid.hpp"
+#include "SectorGraph.hpp"
 #include <vector>
 
-namespace Underworld
-{
-   class Level;
-}
-
 namespace Physics
 {
-   enum PathfindFlags
-   {
-      pathfindFlagCanFly = 0,
-      pathfindFlagCanSwim,
-      pathfindFlagCanWalkLava,
-
-      pathfindFlagMax // must be the last element
-   };
-
    typedef std::vector<std::pair<unsigned int, unsigned int> > PathList;
 
    /// pathfinder base class
@@ -47,49 +35,213 @@ namespace Physics
    {
    public:
       /// ctor
-      Pathfinder(Underworld::Level& level)
-         :m_level(level)
+      Pathfinder(const NavigationGrid& grid)
+         :m_grid(grid),
+         m_flagMask(0)
       {
       }
 
+      /// dtor
+      virtual ~Pathfinder() {}
+
       /// sets pathfind flag
       void SetFlag(PathfindFlags flagType, bool value)
       {
-         m_pathFlags[flagType] = value;
+         if (value)
+            m_flagMask |= 1 << flagType;
+         else
+            m_flagMask &= ~(1 << flagType);
       }
 
       /// finds path
       virtual bool FindPath(unsigned int fromx, unsigned int fromy,
          unsigned int tox, unsigned int toy, PathList& pathlist) = 0;
 
-   private:
+   protected:
       /// checks if object can pass from xpos/ypos in specified direction
-      bool CanPass(unsigned int xpos, unsigned int ypos, unsigned int dir);
+      bool CanPass(unsigned int xpos, unsigned int ypos, NavigationDirection dir) const
+      {
+         return m_grid.CanPass(xpos, ypos, dir, m_flagMask);
+      }
 
-   private:
-      /// path flag array
-      bool m_pathFlags[pathfindFlagMax];
+      /// returns estimated cost from given tile to the target tile
+      static Uint32 GetHeuristicCost(unsigned int xpos, unsigned int ypos,
+         unsigned int tox, unsigned int toy);
+
+   protected:
+      /// navigation grid of the level to use for pathfinding
+      const NavigationGrid& m_grid;
 
-      /// current level to use for pathfinding
-      Underworld::Level& m_level;
+      /// path flags, as bit mask of PathfindFlags values
+      unsigned int m_flagMask;
    };
 
 
-   /// A* pathfinding algorithm
+   /// \brief A* pathfinding algorithm
+   /// \details Searches the navigation grid with 8 directions, using the
+   /// octile distance as heuristic. All node data and the binary heap used
+   /// as open list are allocated once in the ctor; the node data is
+   /// invalidated for the next query by incrementing a search generation
+   /// number, so a query doesn't allocate or clear any memory.
    class PathfinderAStar : public Pathfinder
    {
    public:
       /// ctor
-      PathfinderAStar(Underworld::Level& level)
-         :Pathfinder(level)
-      {
-      }
+      PathfinderAStar(const NavigationGrid& grid);
 
       /// finds path using A* algorithm
       virtual bool FindPath(unsigned int fromx, unsigned int fromy,
          unsigned int tox, unsigned int toy, PathList& pathlist) override;
 
+      /// returns number of nodes expanded in the last search
+      unsigned int GetNumExpandedNodes() const { return m_numExpandedNodes; }
+
+   private:
+      /// returns heap entry for node, ordered by the node's cost
+      Uint64 GetHeapEntry(Uint16 node) const;
+
+      /// inserts node into open list
+      void HeapPush(Uint16 node);
+
+      /// removes node with the lowest cost from open list
+      Uint16 HeapPop();
+
+      /// moves node up in the heap after its cost was lowered
+      void HeapSiftUp(size_t heapPos);
+
+      /// moves node down in the heap
+      void HeapSiftDown(size_t heapPos);
+
+      /// stores path from start to given target node in path list
+      void StorePath(Uint16 startNode, Uint16 targetNode, PathList& pathlist) const;
+
+   private:
+      /// search data of a node; kept together to access one cache line per node
+      struct SearchNode
+      {
+         /// search generation the node was last visited in
+         Uint32 m_generation;
+
+         /// cost from start tile to node
+         Uint16 m_costFromStart;
+
+         /// total estimated cost from start to target over node
+         Uint16 m_totalCost;
+
+         /// parent node on the best path to node
+         Uint16 m_parentNode;
+
+         /// position of node in the heap, or c_nodeClosed
+         Uint16 m_heapPos;
+      };
+
+      /// heap position of nodes that are closed
+      static const Uint16 c_nodeClosed = 0xffff;
+
+      /// current search generation; nodes with another generation number
+      /// weren't visited in the current search
+      Uint32 m_generation;
+
+      /// search data of all nodes, indexed by ypos * 64 + xpos
+      std::vector<SearchNode> m_nodes;
+
+      /// binary heap of open nodes; the entries contain the node costs, so
+      /// that comparing entries doesn't have to look up the node data
+      std::vector<Uint64> m_heap;
+
+      /// number of nodes in the heap
+      size_t m_heapSize;
+
+      /// number of nodes expanded in the last search
+      unsigned int m_numExpandedNodes;
+   };
+
+
+   /// \brief Hierarchical pathfinding algorithm
+   /// \details Searches a path on the sector graph first, from the start
+   /// tile over the sector entrances to the target tile. Only the first leg
+   /// of the path, up to the first entrance outside of the start sector, is
+   /// refined to single steps with the A* pathfinder; the rest of the path
+   /// consists of the entrance tiles as waypoints. Objects following the
+   /// path search again from the end of the refined steps, so that the
+   /// search effort is spread over the time it takes to walk the path.
+   /// Paths between tiles in the same or in nearby sectors are searched
+   /// with A* only. Invalidated sectors of the graph must be updated before
+   /// searching paths.
+   class PathfinderHierarchical : public Pathfinder
+   {
+   public:
+      /// ctor
+      PathfinderHierarchical(const NavigationGrid& grid, const SectorGraph& sectorGraph);
+
+      /// finds path using the sector graph, refining the first leg
+      virtual bool FindPath(unsigned int fromx, unsigned int fromy,
+         unsigned int tox, unsigned int toy, PathList& pathlist) override;
+
+      /// returns number of entries at the start of the last path that are
+      /// steps to adjacent tiles; the remaining entries are waypoints
+      size_t GetNumRefinedSteps() const { return m_numRefinedSteps; }
+
+      /// returns number of nodes expanded in the last search, on the sector
+      /// graph and while refining
+      unsigned int GetNumExpandedNodes() const { return m_numExpandedNodes; }
+
    private:
+      /// searches path with the A* pathfinder, storing only refined steps
+      bool FindRefinedPath(unsigned int fromx, unsigned int fromy,
+         unsigned int tox, unsigned int toy, PathList& pathlist);
+
+      /// searches path on the sector graph and stores it in m_abstractPath
+      bool FindAbstractPath(unsigned int fromx, unsigned int fromy,
+         unsigned int tox, unsigned int toy);
+
+      /// lowers cost of a node to given cost and adds it to the open list
+      void RelaxNode(Uint16 node, Uint32 cost, Uint16 parentNode,
+         unsigned int tox, unsigned int toy);
+
+   private:
+      /// search data of a sector graph node
+      struct AbstractNode
+      {
+         /// search generation the node was last visited in
+         Uint32 m_generation;
+
+         /// cost from start tile to node
+         Uint16 m_costFromStart;
+
+         /// parent node on the best path to node
+         Uint16 m_parentNode;
+
+         /// indicates if the node was already expanded
+         bool m_isClosed;
+      };
+
+      /// sector graph of the level
+      const SectorGraph& m_sectorGraph;
+
+      /// pathfinder used to refine the first leg of paths
+      PathfinderAStar m_refiner;
+
+      /// current search generation
+      Uint32 m_generation;
+
+      /// search data of all nodes, indexed by ypos * 64 + xpos
+      std::vector<AbstractNode> m_nodes;
+
+      /// heap of open nodes, with entries like PathfinderAStar uses; since
+      /// the graph is small, nodes are added again when their cost is
+      /// lowered, and outdated entries are skipped
+      std::vector<Uint64> m_openList;
+
+      /// path on the sector graph found in the last search; contains the
+      /// tile indices of the entrances and the target tile
+      std::vector<Uint16> m_abstractPath;
+
+      /// number of refined steps of the last path
+      size_t m_numRefinedSteps;
+
+      /// number of nodes expanded in the last search
+      unsigned int m_numExpandedNodes;
    };
 
 } // namespace Physics
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,24 +23,48 @@
 #include "PhysicsModel.hpp"
 #include "PhysicsBody.hpp"
 #include "CollisionDetection.hpp"
+#include "FrameProfiler.hpp"
+#include <algorithm>
 
 using Physics::PhysicsModel;
 
 PhysicsModel::PhysicsModel()
+   :m_sectorGraph(m_navigationGrid),
+   m_playerFlowField(m_navigationGrid)
 {
    std::uninitialized_fill(std::begin(m_params), std::end(m_params), false);
 }
 
-void PhysicsModel::Init(T_fnGetSurroundingTriangles fnGetSurroundingTriangles)
+void PhysicsModel::Init(T_fnGetObjectTriangles fnGetObjectTriangles)
 {
-   m_fnGetSurroundingTriangles = fnGetSurroundingTriangles;
+   m_fnGetObjectTriangles = fnGetObjectTriangles;
 
    // initial params
    SetPhysicsParam(physicsGravity, true);
 }
 
+/// Builds the static collision geometry, the navigation grid and the sector
+/// graph of the level. The level must stay valid until the next call. The player flow
+/// field has no target until the player's tile is set again.
+/// \param level level to prepare for
+void PhysicsModel::PrepareLevel(const Underworld::Level& level)
+{
+   m_collisionMesh.Build(level);
+   m_navigationGrid.Build(level);
+   m_sectorGraph.Build();
+   m_playerFlowField.ClearTarget();
+}
+
 void PhysicsModel::EvaluatePhysics(double elapsedTime)
 {
+   Base::ProfileScope scope{ Base::framePhasePhysics };
+
+   if (m_collisionMesh.HasInvalidatedTiles())
+      m_collisionMesh.UpdateInvalidatedTiles();
+
+   if (m_sectorGraph.HasInvalidatedSectors())
+      m_sectorGraph.Update();
+
    size_t max = m_trackedBodies.size();
    for (size_t index = 0; index < max; index++)
    {
@@ -51,20 +75,40 @@ void PhysicsModel::EvaluatePhysics(double elapsedTime)
    }
 }
 
+/// Tracks the body's movement, colliding it with the static level geometry
+/// of the tiles around the body and with the surrounding objects.
 /// \param body physics body to track
 void PhysicsModel::TrackObject(PhysicsBody& body)
 {
    Vector3d pos = body.GetPosition();
 
-   unsigned int xpos = static_cast<unsigned int>(pos.x);
-   unsigned int ypos = static_cast<unsigned int>(pos.y);
+   unsigned int xpos = static_cast<unsigned int>(std::max(pos.x, 0.0));
+   unsigned int ypos = static_cast<unsigned int>(std::max(pos.y, 0.0));
 
-   // retrieve all tile triangles to check
-   std::vector<Triangle3dTextured> allTriangles;
+   // collect tile triangles to check; tiles outside the map have no triangles
+   m_triangleRanges.clear();
 
-   if (m_fnGetSurroundingTriangles != nullptr)
-      m_fnGetSurroundingTriangles(xpos, ypos, allTriangles);
+   for (unsigned int y = ypos > 0 ? ypos - 1 : 0; y <= ypos + 1; y++)
+      for (unsigned int x = xpos > 0 ? xpos - 1 : 0; x <= xpos + 1; x++)
+      {
+         CollisionTriangleRange range = m_collisionMesh.GetTileTriangles(x, y);
+         if (!range.IsEmpty())
+            m_triangleRanges.push_back(range);
+      }
+
+   // collect object triangles
+   m_objectTriangles.clear();
+   m_objectCollisionTriangles.Clear();
+
+   if (m_fnGetObjectTriangles != nullptr)
+      m_fnGetObjectTriangles(xpos, ypos, m_objectTriangles);
+
+   if (!m_objectTriangles.empty())
+   {
+      m_objectCollisionTriangles.AddTriangles(m_objectTriangles);
+      m_triangleRanges.push_back(m_objectCollisionTriangles.GetRange());
+   }
 
-   CollisionDetection detection{ allTriangles, body };
+   CollisionDetection detection{ m_triangleRanges.data(), m_triangleRanges.size(), body };
    detection.TrackObject(body);
 }
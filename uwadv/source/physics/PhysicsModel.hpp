@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,9 +22,18 @@
 #pragma once
 
 #include "Triangle3d.hpp"
+#include "LevelCollisionMesh.hpp"
+#include "NavigationGrid.hpp"
+#include "SectorGraph.hpp"
+#include "FlowField.hpp"
 #include <vector>
 #include <functional>
 
+namespace Underworld
+{
+   class Level;
+}
+
 namespace Physics
 {
    class PhysicsBody;
@@ -39,10 +48,10 @@ namespace Physics
       physicsParamMax
    };
 
-   /// function type that returns surrounding triangles on given position
+   /// function type that returns triangles of objects surrounding given position
    typedef std::function<
       void(unsigned int xpos, unsigned int ypos, std::vector<Triangle3dTextured>& allTriangles)>
-      T_fnGetSurroundingTriangles;
+      T_fnGetObjectTriangles;
 
    /// physics model class
    class PhysicsModel
@@ -52,7 +61,39 @@ namespace Physics
       PhysicsModel();
 
       /// inits the physics model
-      void Init(T_fnGetSurroundingTriangles fnGetSurroundingTriangles);
+      void Init(T_fnGetObjectTriangles fnGetObjectTriangles);
+
+      /// prepares physics model for given level (e.g. when changing levels)
+      void PrepareLevel(const Underworld::Level& level);
+
+      /// invalidates collision geometry and navigation grid of a tile whose
+      /// shape was modified, e.g. through the debug server
+      void InvalidateTile(unsigned int xpos, unsigned int ypos)
+      {
+         m_collisionMesh.InvalidateTile(xpos, ypos);
+         m_navigationGrid.UpdateTile(xpos, ypos);
+         m_sectorGraph.InvalidateTile(xpos, ypos);
+         m_playerFlowField.Invalidate();
+      }
+
+      /// returns collision mesh of current level
+      const LevelCollisionMesh& GetCollisionMesh() const { return m_collisionMesh; }
+
+      /// returns navigation grid of current level
+      const NavigationGrid& GetNavigationGrid() const { return m_navigationGrid; }
+
+      /// returns sector graph of current level, used for hierarchical pathfinding
+      const SectorGraph& GetSectorGraph() const { return m_sectorGraph; }
+
+      /// sets tile the player is currently in, as target of the player flow field
+      void SetPlayerTile(unsigned int xpos, unsigned int ypos)
+      {
+         m_playerFlowField.SetTarget(xpos, ypos);
+      }
+
+      /// returns flow field leading to the player, e.g. for chasing critters;
+      /// nothing reads it yet, since critters don't move on their own yet
+      FlowField& GetPlayerFlowField() { return m_playerFlowField; }
 
       bool GetPhysicsParam(PhysicsParam param) const
       {
@@ -90,8 +131,29 @@ namespace Physics
       /// model parameters
       bool m_params[physicsParamMax];
 
-      /// function to get surrounding triangles
-      T_fnGetSurroundingTriangles m_fnGetSurroundingTriangles;
+      /// function to get triangles of surrounding objects
+      T_fnGetObjectTriangles m_fnGetObjectTriangles;
+
+      /// static collision geometry of the current level
+      LevelCollisionMesh m_collisionMesh;
+
+      /// navigation grid of the current level, used for pathfinding
+      NavigationGrid m_navigationGrid;
+
+      /// sector graph of the current level, used for hierarchical pathfinding
+      SectorGraph m_sectorGraph;
+
+      /// flow field leading to the player's tile
+      FlowField m_playerFlowField;
+
+      /// triangle ranges to check for the currently tracked body
+      std::vector<CollisionTriangleRange> m_triangleRanges;
+
+      /// triangles of objects surrounding the currently tracked body
+      std::vector<Triangle3dTextured> m_objectTriangles;
+
+      /// collision triangles of surrounding objects
+      CollisionTriangleList m_objectCollisionTriangles;
 
       /// list of pointer to bodies tracked by physics model
       std::vector<PhysicsBody*> m_trackedBodies;
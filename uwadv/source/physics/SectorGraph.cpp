@@ -0,0 +1,329 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SectorGraph.cpp
+/// \brief graph of sector entrances, for hierarchical pathfinding
+//
+#include "pch.hpp"
+#include "SectorGraph.hpp"
+#include <algorithm>
+#include <functional>
+
+using Physics::SectorGraph;
+using Physics::NavigationGrid;
+using Physics::NavigationDirection;
+
+/// runs of passable border tiles that are at least this long get an
+/// entrance at both ends instead of one in the middle
+static const unsigned int c_minLongEntranceLength = 4;
+
+SectorGraph::SectorGraph(const NavigationGrid& grid)
+   :m_grid(grid),
+   m_isBuilt(false),
+   m_invalidatedSectors(c_numSectors, false),
+   m_hasInvalidatedSectors(false)
+{
+}
+
+/// Finds the entrances of all sectors and computes the path costs between
+/// them, for all combinations of pathfind flags.
+void SectorGraph::Build()
+{
+   UaAssert(m_grid.IsBuilt());
+
+   Clear();
+
+   m_isBuilt = true;
+
+   const size_t numTiles = Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize;
+
+   for (Layer& layer : m_layers)
+      layer.m_nodeIndices.resize(numTiles, Uint8(c_noNode));
+
+   std::fill(m_invalidatedSectors.begin(), m_invalidatedSectors.end(), true);
+   m_hasInvalidatedSectors = true;
+
+   Update();
+}
+
+void SectorGraph::Clear()
+{
+   m_isBuilt = false;
+
+   for (Layer& layer : m_layers)
+   {
+      for (Sector& sector : layer.m_sectors)
+      {
+         sector.m_nodes.clear();
+         sector.m_costs.clear();
+      }
+
+      layer.m_nodeIndices.clear();
+   }
+
+   std::fill(m_invalidatedSectors.begin(), m_invalidatedSectors.end(), false);
+   m_hasInvalidatedSectors = false;
+}
+
+/// Since modifying a tile changes the passable directions of the tile and
+/// of its adjacent tiles, all sectors of these tiles are invalidated.
+/// \param xpos x tile position
+/// \param ypos y tile position
+void SectorGraph::InvalidateTile(unsigned int xpos, unsigned int ypos)
+{
+   if (!m_isBuilt ||
+      xpos >= Underworld::c_underworldTilemapSize ||
+      ypos >= Underworld::c_underworldTilemapSize)
+      return;
+
+   for (int y = static_cast<int>(ypos) - 1; y <= static_cast<int>(ypos) + 1; y++)
+      for (int x = static_cast<int>(xpos) - 1; x <= static_cast<int>(xpos) + 1; x++)
+      {
+         if (x < 0 || y < 0 ||
+            x >= static_cast<int>(Underworld::c_underworldTilemapSize) ||
+            y >= static_cast<int>(Underworld::c_underworldTilemapSize))
+            continue;
+
+         m_invalidatedSectors[GetSector(static_cast<unsigned int>(x), static_cast<unsigned int>(y))] = true;
+      }
+
+   m_hasInvalidatedSectors = true;
+}
+
+/// The entrances on the borders of an invalidated sector may have changed,
+/// so the adjacent sectors sharing the borders are computed again, too.
+void SectorGraph::Update()
+{
+   if (!m_hasInvalidatedSectors)
+      return;
+
+   std::vector<bool> updateSectors(m_invalidatedSectors);
+
+   for (unsigned int sector = 0; sector < c_numSectors; sector++)
+   {
+      if (!m_invalidatedSectors[sector])
+         continue;
+
+      unsigned int sectorX = sector % c_numSectorsPerSide;
+      unsigned int sectorY = sector / c_numSectorsPerSide;
+
+      if (sectorX > 0)
+         updateSectors[sector - 1] = true;
+      if (sectorX + 1 < c_numSectorsPerSide)
+         updateSectors[sector + 1] = true;
+      if (sectorY > 0)
+         updateSectors[sector - c_numSectorsPerSide] = true;
+      if (sectorY + 1 < c_numSectorsPerSide)
+         updateSectors[sector + c_numSectorsPerSide] = true;
+   }
+
+   for (unsigned int flagMask = 0; flagMask < NavigationGrid::c_numFlagMasks; flagMask++)
+      for (unsigned int sector = 0; sector < c_numSectors; sector++)
+         if (updateSectors[sector])
+            UpdateSector(sector, flagMask);
+
+   std::fill(m_invalidatedSectors.begin(), m_invalidatedSectors.end(), false);
+   m_hasInvalidatedSectors = false;
+}
+
+/// Runs Dijkstra's algorithm on the tiles of the sector; moves leaving the
+/// sector aren't considered. The heap used as open list is small enough to
+/// be kept on the stack, since every tile is settled only once and then
+/// adds at most one entry per direction.
+/// \param tileIndex tile index, as ypos * 64 + xpos
+/// \param flagMask combination of PathfindFlags bits
+/// \param toTile when true, the costs of paths from the sector tiles to the
+/// given tile are computed; when false, the costs of paths from the given
+/// tile to the sector tiles
+/// \param costs array to store costs in, indexed by GetSectorTileIndex();
+/// c_unreachable for tiles that can't be reached inside the sector
+void SectorGraph::GetCostsInSector(Uint16 tileIndex, unsigned int flagMask, bool toTile,
+   Uint16 (&costs)[c_numSectorTiles]) const
+{
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+   const unsigned int sectorSize = c_sectorSize;
+
+   unsigned int sectorX = tileIndex % size / sectorSize * sectorSize;
+   unsigned int sectorY = tileIndex / size / sectorSize * sectorSize;
+
+   std::fill(costs, costs + c_numSectorTiles, Uint16(c_unreachable));
+
+   // heap entries contain the cost in the upper bits and the sector tile
+   // index in the lowest 8 bits; outdated entries are skipped when popped
+   Uint32 heap[c_numSectorTiles * navigationDirectionMax + 1];
+   size_t heapSize = 0;
+
+   unsigned int startIndex = GetSectorTileIndex(tileIndex);
+   costs[startIndex] = 0;
+   heap[heapSize++] = startIndex;
+
+   const int sign = toTile ? -1 : 1;
+
+   while (heapSize > 0)
+   {
+      std::pop_heap(heap, heap + heapSize, std::greater<Uint32>());
+      heapSize--;
+
+      unsigned int localIndex = heap[heapSize] & 0xff;
+      Uint32 cost = heap[heapSize] >> 8;
+
+      if (cost != costs[localIndex])
+         continue;
+
+      int localX = static_cast<int>(localIndex % sectorSize);
+      int localY = static_cast<int>(localIndex / sectorSize);
+
+      for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+      {
+         int x = localX + sign * NavigationGrid::GetDirectionX(dir);
+         int y = localY + sign * NavigationGrid::GetDirectionY(dir);
+
+         if (x < 0 || y < 0 || x >= static_cast<int>(sectorSize) || y >= static_cast<int>(sectorSize))
+            continue;
+
+         // when searching backwards, the move goes from the next tile to this one
+         bool canPass = toTile
+            ? m_grid.CanPass(sectorX + x, sectorY + y, static_cast<NavigationDirection>(dir), flagMask)
+            : m_grid.CanPass(sectorX + localX, sectorY + localY, static_cast<NavigationDirection>(dir), flagMask);
+
+         if (!canPass)
+            continue;
+
+         unsigned int nextIndex = static_cast<unsigned int>(y) * sectorSize + x;
+         Uint32 nextCost = cost + NavigationGrid::GetMoveCost(dir);
+
+         if (nextCost < costs[nextIndex])
+         {
+            costs[nextIndex] = static_cast<Uint16>(nextCost);
+
+            heap[heapSize++] = (nextCost << 8) | nextIndex;
+            std::push_heap(heap, heap + heapSize, std::greater<Uint32>());
+         }
+      }
+   }
+}
+
+void SectorGraph::UpdateSector(unsigned int sector, unsigned int flagMask)
+{
+   Layer& layer = m_layers[flagMask];
+   Sector& sectorData = layer.m_sectors[sector];
+
+   for (Uint16 tileIndex : sectorData.m_nodes)
+      layer.m_nodeIndices[tileIndex] = c_noNode;
+
+   sectorData.m_nodes.clear();
+
+   for (unsigned int dir = navigationNorth; dir < navigationNorthEast; dir++)
+      AddBorderNodes(sector, static_cast<NavigationDirection>(dir), flagMask);
+
+   size_t numNodes = sectorData.m_nodes.size();
+   sectorData.m_costs.resize(numNodes * numNodes);
+
+   Uint16 costs[c_numSectorTiles];
+
+   for (size_t fromNode = 0; fromNode < numNodes; fromNode++)
+   {
+      GetCostsInSector(sectorData.m_nodes[fromNode], flagMask, false, costs);
+
+      for (size_t toNode = 0; toNode < numNodes; toNode++)
+         sectorData.m_costs[fromNode * numNodes + toNode] =
+            costs[GetSectorTileIndex(sectorData.m_nodes[toNode])];
+   }
+}
+
+/// Walks along the border tiles of the sector in given direction and
+/// determines the runs of tiles that can pass the border in any direction.
+/// The adjacent sector walks along the same border in the same order, so
+/// both sectors place their entrances on tiles facing each other.
+/// \param sector sector to add nodes to
+/// \param dir straight direction of the border, seen from the sector
+/// \param flagMask combination of PathfindFlags bits
+void SectorGraph::AddBorderNodes(unsigned int sector, NavigationDirection dir, unsigned int flagMask)
+{
+   const unsigned int size = Underworld::c_underworldTilemapSize;
+
+   unsigned int sectorX = sector % c_numSectorsPerSide * c_sectorSize;
+   unsigned int sectorY = sector / c_numSectorsPerSide * c_sectorSize;
+
+   int offsetX = NavigationGrid::GetDirectionX(dir);
+   int offsetY = NavigationGrid::GetDirectionY(dir);
+
+   // first border tile, and step along the border
+   unsigned int borderX = sectorX + (offsetX > 0 ? c_sectorSize - 1 : 0);
+   unsigned int borderY = sectorY + (offsetY > 0 ? c_sectorSize - 1 : 0);
+   unsigned int stepX = offsetX == 0 ? 1 : 0;
+   unsigned int stepY = offsetY == 0 ? 1 : 0;
+
+   int outsideX = static_cast<int>(borderX) + offsetX;
+   int outsideY = static_cast<int>(borderY) + offsetY;
+
+   if (outsideX < 0 || outsideY < 0 || outsideX >= static_cast<int>(size) || outsideY >= static_cast<int>(size))
+      return;
+
+   NavigationDirection oppositeDir = static_cast<NavigationDirection>((dir + 2) % 4);
+
+   bool isOpen[c_sectorSize + 1];
+   for (unsigned int index = 0; index < c_sectorSize; index++)
+   {
+      unsigned int xpos = borderX + index * stepX;
+      unsigned int ypos = borderY + index * stepY;
+
+      isOpen[index] = m_grid.CanPass(xpos, ypos, dir, flagMask) ||
+         m_grid.CanPass(xpos + offsetX, ypos + offsetY, oppositeDir, flagMask);
+   }
+
+   isOpen[c_sectorSize] = false;
+
+   Layer& layer = m_layers[flagMask];
+   Sector& sectorData = layer.m_sectors[sector];
+
+   unsigned int runStart = 0;
+   for (unsigned int index = 0; index <= c_sectorSize; index++)
+   {
+      if (isOpen[index])
+         continue;
+
+      unsigned int runLength = index - runStart;
+      if (runLength > 0)
+      {
+         unsigned int entrances[2] = { runStart + (runLength - 1) / 2, index - 1 };
+         unsigned int numEntrances = 1;
+
+         if (runLength >= c_minLongEntranceLength)
+         {
+            entrances[0] = runStart;
+            numEntrances = 2;
+         }
+
+         for (unsigned int entrance = 0; entrance < numEntrances; entrance++)
+         {
+            Uint16 tileIndex = static_cast<Uint16>(
+               (borderY + entrances[entrance] * stepY) * size + borderX + entrances[entrance] * stepX);
+
+            // corner tiles may already be an entrance of the other border
+            if (layer.m_nodeIndices[tileIndex] != c_noNode)
+               continue;
+
+            layer.m_nodeIndices[tileIndex] = static_cast<Uint8>(sectorData.m_nodes.size());
+            sectorData.m_nodes.push_back(tileIndex);
+         }
+      }
+
+      runStart = index + 1;
+   }
+}
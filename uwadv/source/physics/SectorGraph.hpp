@@ -0,0 +1,165 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SectorGraph.hpp
+/// \brief graph of sector entrances, for hierarchical pathfinding
+//
+#pragma once
+
+#include "NavigationGrid.hpp"
+#include <vector>
+
+namespace Physics
+{
+   /// \brief Graph of sector entrances, for hierarchical pathfinding
+   /// \details Clusters the tilemap into square sectors. Wherever tiles on
+   /// both sides of a sector border can pass to each other, entrances are
+   /// placed: one in the middle of short runs of passable border tiles, two
+   /// at the ends of longer runs. The entrance tiles are the nodes of the
+   /// graph. Nodes facing each other over a sector border are connected by
+   /// a single straight move; nodes of the same sector are connected with
+   /// the cost of the shortest path inside the sector, which is computed
+   /// when building the graph. There is a separate graph for every
+   /// combination of pathfind flags.
+   /// When a tile is modified, its sector and the adjacent sectors are
+   /// marked as invalidated, and are computed again by Update().
+   class SectorGraph
+   {
+   public:
+      /// number of tiles of a sector side
+      static const unsigned int c_sectorSize = 8;
+
+      /// number of sectors in each direction
+      static const unsigned int c_numSectorsPerSide = Underworld::c_underworldTilemapSize / c_sectorSize;
+
+      /// number of sectors in the tilemap
+      static const unsigned int c_numSectors = c_numSectorsPerSide * c_numSectorsPerSide;
+
+      /// number of tiles in a sector
+      static const unsigned int c_numSectorTiles = c_sectorSize * c_sectorSize;
+
+      /// node index of tiles that aren't an entrance
+      static const Uint8 c_noNode = 0xff;
+
+      /// path cost between tiles that can't reach each other
+      static const Uint16 c_unreachable = 0xffff;
+
+      /// ctor
+      SectorGraph(const NavigationGrid& grid);
+
+      /// builds the graph for all sectors; the navigation grid must be built
+      void Build();
+
+      /// clears graph
+      void Clear();
+
+      /// returns if the graph was built
+      bool IsBuilt() const { return m_isBuilt; }
+
+      /// marks sectors as invalidated that are affected by a modified tile
+      void InvalidateTile(unsigned int xpos, unsigned int ypos);
+
+      /// returns if there are invalidated sectors
+      bool HasInvalidatedSectors() const { return m_hasInvalidatedSectors; }
+
+      /// computes all invalidated sectors again
+      void Update();
+
+      /// returns sector of given tile
+      static unsigned int GetSector(unsigned int xpos, unsigned int ypos)
+      {
+         return (ypos / c_sectorSize) * c_numSectorsPerSide + xpos / c_sectorSize;
+      }
+
+      /// returns entrance nodes of a sector, as tile indices ypos * 64 + xpos
+      const std::vector<Uint16>& GetSectorNodes(unsigned int sector, unsigned int flagMask) const
+      {
+         return m_layers[flagMask].m_sectors[sector].m_nodes;
+      }
+
+      /// returns index of a tile in the nodes of its sector, or c_noNode
+      Uint8 GetNodeIndex(Uint16 tileIndex, unsigned int flagMask) const
+      {
+         return m_layers[flagMask].m_nodeIndices[tileIndex];
+      }
+
+      /// returns path cost inside a sector between two of its nodes
+      Uint16 GetSectorCost(unsigned int sector, unsigned int fromNode, unsigned int toNode,
+         unsigned int flagMask) const
+      {
+         const Sector& sectorData = m_layers[flagMask].m_sectors[sector];
+         return sectorData.m_costs[fromNode * sectorData.m_nodes.size() + toNode];
+      }
+
+      /// computes path costs inside the sector of given tile, between the
+      /// tile and all tiles of the sector
+      void GetCostsInSector(Uint16 tileIndex, unsigned int flagMask, bool toTile,
+         Uint16 (&costs)[c_numSectorTiles]) const;
+
+      /// returns index of a tile inside its sector
+      static unsigned int GetSectorTileIndex(Uint16 tileIndex)
+      {
+         return (tileIndex / Underworld::c_underworldTilemapSize % c_sectorSize) * c_sectorSize +
+            tileIndex % c_sectorSize;
+      }
+
+   private:
+      /// entrance nodes of a sector and path costs between them
+      struct Sector
+      {
+         /// entrance tiles, as tile indices
+         std::vector<Uint16> m_nodes;
+
+         /// path costs, indexed by fromNode * m_nodes.size() + toNode
+         std::vector<Uint16> m_costs;
+      };
+
+      /// graph for one combination of pathfind flags
+      struct Layer
+      {
+         /// all sectors
+         Sector m_sectors[c_numSectors];
+
+         /// node index of all tiles in their sector, indexed by ypos * 64 + xpos
+         std::vector<Uint8> m_nodeIndices;
+      };
+
+      /// computes nodes and costs of a sector
+      void UpdateSector(unsigned int sector, unsigned int flagMask);
+
+      /// adds entrance nodes of one sector border to the sector
+      void AddBorderNodes(unsigned int sector, NavigationDirection dir, unsigned int flagMask);
+
+   private:
+      /// navigation grid to use
+      const NavigationGrid& m_grid;
+
+      /// indicates if the graph was built
+      bool m_isBuilt;
+
+      /// graphs for all flag combinations
+      Layer m_layers[NavigationGrid::c_numFlagMasks];
+
+      /// flags for all sectors that must be computed again
+      std::vector<bool> m_invalidatedSectors;
+
+      /// indicates if any sector is invalidated
+      bool m_hasInvalidatedSectors;
+   };
+
+} // namespace Physics
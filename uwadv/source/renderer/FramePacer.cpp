@@ -0,0 +1,97 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FramePacer.cpp
+/// \brief frame pacer implementation
+//
+#include "pch.hpp"
+#include "FramePacer.hpp"
+
+/// time before the deadline where the pacer stops sleeping and starts
+/// spinning, in milliseconds
+const double c_frameSpinTimeMsec = 2.0;
+
+FramePacer::FramePacer()
+   :m_targetFrameRate(0),
+   m_countsPerFrame(0),
+   m_spinCounts(static_cast<Uint64>(c_frameSpinTimeMsec / 1000.0 * SDL_GetPerformanceFrequency())),
+   m_nextFrameCounter(0)
+{
+}
+
+/// Sets a new target frame rate and restarts pacing.
+/// \param framesPerSecond target frame rate in frames per second; 0 disables
+/// limiting the frame rate
+void FramePacer::SetTargetFrameRate(unsigned int framesPerSecond)
+{
+   m_targetFrameRate = framesPerSecond;
+   m_countsPerFrame = framesPerSecond == 0 ? 0 :
+      SDL_GetPerformanceFrequency() / framesPerSecond;
+
+   Reset();
+}
+
+void FramePacer::Reset()
+{
+   m_nextFrameCounter = 0;
+}
+
+/// Waits until the deadline of the next frame. The first call after Reset()
+/// only starts pacing. Doesn't wait when the frame rate isn't limited, or
+/// the frame is already late.
+void FramePacer::WaitForNextFrame()
+{
+   if (m_countsPerFrame == 0)
+      return;
+
+   Uint64 now = SDL_GetPerformanceCounter();
+
+   if (m_nextFrameCounter == 0)
+   {
+      m_nextFrameCounter = now + m_countsPerFrame;
+      return;
+   }
+
+   Uint64 deadline = m_nextFrameCounter;
+
+   if (now >= deadline)
+   {
+      // late; when more than a frame late, restart pacing from now
+      m_nextFrameCounter = now - deadline >= m_countsPerFrame
+         ? now + m_countsPerFrame
+         : deadline + m_countsPerFrame;
+      return;
+   }
+
+   Uint64 remainingCounts = deadline - now;
+   if (remainingCounts > m_spinCounts)
+   {
+      Uint32 sleepMsec = static_cast<Uint32>(
+         (remainingCounts - m_spinCounts) * 1000 / SDL_GetPerformanceFrequency());
+
+      if (sleepMsec > 0)
+         SDL_Delay(sleepMsec);
+   }
+
+   while (SDL_GetPerformanceCounter() < deadline)
+   {
+      // spin for the remaining time
+   }
+
+   m_nextFrameCounter = deadline + m_countsPerFrame;
+}
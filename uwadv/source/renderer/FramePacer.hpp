@@ -0,0 +1,62 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FramePacer.hpp
+/// \brief frame pacer
+//
+#pragma once
+
+/// \brief frame pacer
+/// \details Limits the frame rate of the game loop to a target frame rate,
+/// using the high resolution performance counter. The pacer sleeps until
+/// shortly before the next frame's deadline and spins for the remaining
+/// time, since sleeping is only accurate to about a millisecond. When a
+/// frame is more than a frame period late, pacing restarts from the current
+/// time instead of trying to catch up.
+class FramePacer
+{
+public:
+   /// ctor; doesn't limit the frame rate
+   FramePacer();
+
+   /// sets target frame rate; 0 disables limiting the frame rate
+   void SetTargetFrameRate(unsigned int framesPerSecond);
+
+   /// returns target frame rate; 0 when the frame rate isn't limited
+   unsigned int GetTargetFrameRate() const { return m_targetFrameRate; }
+
+   /// restarts pacing, e.g. after the game loop was paused
+   void Reset();
+
+   /// waits until the next frame should start
+   void WaitForNextFrame();
+
+private:
+   /// target frame rate
+   unsigned int m_targetFrameRate;
+
+   /// performance counter counts per frame; 0 when not limiting
+   Uint64 m_countsPerFrame;
+
+   /// performance counter counts to spin instead of sleeping
+   Uint64 m_spinCounts;
+
+   /// performance counter value of the next frame's deadline; 0 when pacing
+   /// hasn't started yet
+   Uint64 m_nextFrameCounter;
+};
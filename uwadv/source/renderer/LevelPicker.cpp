@@ -0,0 +1,246 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelPicker.cpp
+/// \brief level picking using ray casts
+//
+#include "pch.hpp"
+#include "LevelPicker.hpp"
+#include "UnderworldRenderer.hpp"
+#include "RenderOptions.hpp"
+#include "Level.hpp"
+#include <cmath>
+
+extern const double c_renderHeightScale;
+
+/// Object hits that are at most this distance behind a tile wall hit are
+/// still preferred, e.g. for decals or objects lying on the floor.
+const double c_objectPreferDistance = 0.01;
+
+LevelPicker::LevelPicker(UnderworldRenderer& renderer,
+   const RenderOptions& renderOptions, const Underworld::Level& level)
+   :m_renderer(renderer),
+   m_renderOptions(renderOptions),
+   m_level(level),
+   m_geometryProvider(level)
+{
+}
+
+/// Picks the nearest tile wall or object that is hit by a ray. The tile grid
+/// is traversed using a 2D DDA (digital differential analyzer) along the
+/// ray's x/y projection. Objects are tested in the 3x3 tiles around each
+/// traversed tile, since object sprites may reach into neighbouring tiles.
+/// \param origin ray origin
+/// \param dir normalized ray direction
+/// \param maxDistance maximum distance for hits
+/// \param result pick result; only valid when true is returned
+/// \return true when a tile wall or object was hit
+bool LevelPicker::Pick(const Vector3d& origin, const Vector3d& dir,
+   double maxDistance, LevelPickResult& result)
+{
+   m_checkedObjectTiles.reset();
+
+   result = LevelPickResult{};
+   result.m_distance = maxDistance;
+
+   if (origin.x < 0.0 || origin.x >= 64.0 || origin.y < 0.0 || origin.y >= 64.0)
+      return false;
+
+   int tileX = static_cast<int>(origin.x);
+   int tileY = static_cast<int>(origin.y);
+
+   int stepX = dir.x < 0.0 ? -1 : 1;
+   int stepY = dir.y < 0.0 ? -1 : 1;
+
+   // ray distance needed to cross a whole tile, and to reach next tile border
+   double deltaX = dir.x != 0.0 ? std::abs(1.0 / dir.x) : HUGE_VAL;
+   double deltaY = dir.y != 0.0 ? std::abs(1.0 / dir.y) : HUGE_VAL;
+
+   double nextX = dir.x != 0.0
+      ? ((stepX > 0 ? tileX + 1.0 : double(tileX)) - origin.x) / dir.x
+      : HUGE_VAL;
+   double nextY = dir.y != 0.0
+      ? ((stepY > 0 ? tileY + 1.0 : double(tileY)) - origin.y) / dir.y
+      : HUGE_VAL;
+
+   bool found = false;
+
+   for (;;)
+   {
+      CheckTile(tileX, tileY, origin, dir, result, found);
+
+      for (int y = tileY - 1; y <= tileY + 1; y++)
+         for (int x = tileX - 1; x <= tileX + 1; x++)
+            if (x >= 0 && x < 64 && y >= 0 && y < 64)
+               CheckTileObjects(x, y, origin, dir, result, found);
+
+      // distance where ray leaves the current tile
+      double exitDistance = std::min(nextX, nextY);
+
+      // no nearer hit possible in the following tiles
+      if (exitDistance >= result.m_distance)
+         break;
+
+      if (nextX < nextY)
+      {
+         tileX += stepX;
+         nextX += deltaX;
+      }
+      else
+      {
+         tileY += stepY;
+         nextY += deltaY;
+      }
+
+      if (tileX < 0 || tileX >= 64 || tileY < 0 || tileY >= 64)
+         break;
+   }
+
+   return found;
+}
+
+/// Intersects a ray with a triangle, using the Moeller-Trumbore algorithm.
+/// Both sides of the triangle are tested.
+/// \param origin ray origin
+/// \param dir ray direction
+/// \param triangle triangle to test
+/// \param distance distance along ray where the triangle was hit
+/// \return true when the triangle was hit in front of the ray origin
+bool LevelPicker::IntersectRayTriangle(const Vector3d& origin, const Vector3d& dir,
+   const Triangle3dTextured& triangle, double& distance)
+{
+   const double epsilon = 1e-9;
+
+   Vector3d edge1 = triangle.m_vertices[1].pos - triangle.m_vertices[0].pos;
+   Vector3d edge2 = triangle.m_vertices[2].pos - triangle.m_vertices[0].pos;
+
+   Vector3d pvec = Vector3d::Cross(dir, edge2);
+   double det = edge1.Dot(pvec);
+
+   // ray parallel to triangle plane, or degenerated triangle
+   if (std::abs(det) < epsilon)
+      return false;
+
+   double invDet = 1.0 / det;
+
+   Vector3d tvec = origin - triangle.m_vertices[0].pos;
+   double u = tvec.Dot(pvec) * invDet;
+   if (u < 0.0 || u > 1.0)
+      return false;
+
+   Vector3d qvec = Vector3d::Cross(tvec, edge1);
+   double v = dir.Dot(qvec) * invDet;
+   if (v < 0.0 || u + v > 1.0)
+      return false;
+
+   distance = edge2.Dot(qvec) * invDet;
+   return distance > 0.0;
+}
+
+/// Checks all triangles of a tile for hits nearer than the current result.
+/// \param x tile x coordinate
+/// \param y tile y coordinate
+/// \param origin ray origin
+/// \param dir ray direction
+/// \param result current pick result; updated when a nearer hit was found
+/// \param found set to true when the result was updated
+void LevelPicker::CheckTile(unsigned int x, unsigned int y,
+   const Vector3d& origin, const Vector3d& dir, LevelPickResult& result,
+   bool& found)
+{
+   m_triangles.clear();
+   m_geometryProvider.GetTileTriangles(x, y, m_triangles);
+
+   for (Triangle3dTextured& triangle : m_triangles)
+   {
+      for (Vertex3d& vertex : triangle.m_vertices)
+         vertex.pos.z *= c_renderHeightScale;
+
+      double distance = 0.0;
+      if (!IntersectRayTriangle(origin, dir, triangle, distance))
+         continue;
+
+      double limit = result.m_isObject
+         ? result.m_distance - c_objectPreferDistance
+         : result.m_distance;
+
+      if (distance < limit)
+      {
+         result.m_tileX = x;
+         result.m_tileY = y;
+         result.m_isObject = false;
+         result.m_id = triangle.m_textureNumber;
+         result.m_distance = distance;
+         found = true;
+      }
+   }
+}
+
+/// Checks all objects in a tile for hits nearer than the current result.
+/// Each tile's objects are only checked once per pick.
+/// \param x tile x coordinate
+/// \param y tile y coordinate
+/// \param origin ray origin
+/// \param dir ray direction
+/// \param result current pick result; updated when a nearer hit was found
+/// \param found set to true when the result was updated
+void LevelPicker::CheckTileObjects(unsigned int x, unsigned int y,
+   const Vector3d& origin, const Vector3d& dir, LevelPickResult& result,
+   bool& found)
+{
+   size_t tileIndex = y * 64 + x;
+   if (m_checkedObjectTiles.test(tileIndex))
+      return;
+
+   m_checkedObjectTiles.set(tileIndex);
+
+   const Underworld::ObjectList& objectList = m_level.GetObjectList();
+
+   Uint16 link = objectList.GetListStart(x, y);
+   while (link != 0)
+   {
+      const Underworld::Object& obj = *objectList.GetObject(link);
+
+      m_triangles.clear();
+      m_renderer.GetObjectPickTriangles(m_renderOptions, m_level, obj,
+         x, y, m_triangles);
+
+      for (const Triangle3dTextured& triangle : m_triangles)
+      {
+         double distance = 0.0;
+         if (!IntersectRayTriangle(origin, dir, triangle, distance))
+            continue;
+
+         double limit = result.m_isObject
+            ? result.m_distance
+            : result.m_distance + c_objectPreferDistance;
+
+         if (distance < limit)
+         {
+            result.m_tileX = x;
+            result.m_tileY = y;
+            result.m_isObject = true;
+            result.m_id = link;
+            result.m_distance = distance;
+            found = true;
+         }
+      }
+
+      link = obj.GetObjectInfo().m_link;
+   }
+}
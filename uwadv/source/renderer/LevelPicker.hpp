@@ -0,0 +1,107 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelPicker.hpp
+/// \brief level picking using ray casts
+//
+#pragma once
+
+#include "Vector3d.hpp"
+#include "Triangle3d.hpp"
+#include "GeometryProvider.hpp"
+#include <vector>
+#include <bitset>
+
+namespace Underworld
+{
+   class Level;
+}
+
+class UnderworldRenderer;
+struct RenderOptions;
+
+/// result of a level pick
+struct LevelPickResult
+{
+   /// tile x coordinate of picked target
+   unsigned int m_tileX = 0;
+
+   /// tile y coordinate of picked target
+   unsigned int m_tileY = 0;
+
+   /// indicates if an object was picked; otherwise a tile wall was picked
+   bool m_isObject = false;
+
+   /// object list pos of picked object, or texture number of picked tile
+   unsigned int m_id = 0;
+
+   /// distance from ray origin to picked target
+   double m_distance = 0.0;
+};
+
+/// \brief level picker
+/// \details Finds the tile wall or object hit by a ray shot into the rendered
+/// level. The ray walks through the 64x64 tile grid in the order the tiles
+/// are hit, so only tiles along the ray are tested, and the walk stops at
+/// the first tile that can't contain a nearer hit. All coordinates are in
+/// the rendered 3d world, with z coordinates scaled by c_renderHeightScale.
+class LevelPicker
+{
+public:
+   /// ctor
+   LevelPicker(UnderworldRenderer& renderer,
+      const RenderOptions& renderOptions, const Underworld::Level& level);
+
+   /// picks nearest tile wall or object hit by ray
+   bool Pick(const Vector3d& origin, const Vector3d& dir, double maxDistance,
+      LevelPickResult& result);
+
+   /// intersects ray with triangle
+   static bool IntersectRayTriangle(const Vector3d& origin, const Vector3d& dir,
+      const Triangle3dTextured& triangle, double& distance);
+
+private:
+   /// checks all triangles of a tile for ray hits
+   void CheckTile(unsigned int x, unsigned int y,
+      const Vector3d& origin, const Vector3d& dir, LevelPickResult& result,
+      bool& found);
+
+   /// checks all objects in a tile for ray hits
+   void CheckTileObjects(unsigned int x, unsigned int y,
+      const Vector3d& origin, const Vector3d& dir, LevelPickResult& result,
+      bool& found);
+
+private:
+   /// renderer that provides object geometry
+   UnderworldRenderer& m_renderer;
+
+   /// render options
+   const RenderOptions& m_renderOptions;
+
+   /// level to pick in
+   const Underworld::Level& m_level;
+
+   /// geometry provider for tile triangles
+   Physics::GeometryProvider m_geometryProvider;
+
+   /// triangles of tile or object currently tested; reused between tests
+   std::vector<Triangle3dTextured> m_triangles;
+
+   /// tiles whose objects were already tested
+   std::bitset<64 * 64> m_checkedObjectTiles;
+};
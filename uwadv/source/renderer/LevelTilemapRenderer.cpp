@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2020 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2020,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,26 +22,331 @@
 #include "pch.hpp"
 #include "LevelTilemapRenderer.hpp"
 #include "TextureManager.hpp"
+#include "OpenGL.hpp"
+#include <map>
 
 extern const double c_renderHeightScale;
 
+/// texture number used as key for the texture batch using the texture atlas
+const Uint16 c_textureAtlasBatch = 0xffff;
+
+/// Clips a polygon against a texture coordinate limit. Only the part of the
+/// polygon where the texture coordinate is on the given side of the limit is
+/// kept.
+/// \param polygon polygon vertices to clip
+/// \param clipU when true, the u texture coordinate is used; else v
+/// \param limit texture coordinate limit
+/// \param keepAbove when true, keeps the part above the limit; else below
+/// \param clippedPolygon clipped polygon vertices
+static void ClipPolygonAtTexCoord(const std::vector<Vertex3d>& polygon,
+   bool clipU, double limit, bool keepAbove,
+   std::vector<Vertex3d>& clippedPolygon)
+{
+   clippedPolygon.clear();
+
+   size_t max = polygon.size();
+   for (size_t index = 0; index < max; index++)
+   {
+      const Vertex3d& current = polygon[index];
+      const Vertex3d& next = polygon[(index + 1) % max];
+
+      double currentDist = (clipU ? current.u : current.v) - limit;
+      double nextDist = (clipU ? next.u : next.v) - limit;
+      if (!keepAbove)
+      {
+         currentDist = -currentDist;
+         nextDist = -nextDist;
+      }
+
+      if (currentDist >= 0.0)
+         clippedPolygon.push_back(current);
+
+      if ((currentDist >= 0.0) != (nextDist >= 0.0))
+      {
+         // add intersection point
+         double ratio = currentDist / (currentDist - nextDist);
+
+         Vertex3d intersection(
+            current.pos + (next.pos - current.pos) * ratio,
+            current.u + (next.u - current.u) * ratio,
+            current.v + (next.v - current.v) * ratio);
+
+         clippedPolygon.push_back(intersection);
+      }
+   }
+}
+
+/// Splits a triangle at all integral texture coordinates, so that the texture
+/// coordinates of every resulting triangle lie in a single [0; 1] texture
+/// cell. The texture coordinates of the resulting triangles are moved to
+/// the range [0; 1]. This way, textures normally used with GL_REPEAT can be
+/// mapped into a texture atlas.
+/// \param triangle triangle to split
+/// \param splitTriangles list of resulting triangles
+static void SplitTriangleAtTextureCells(const Triangle3dTextured& triangle,
+   std::vector<Triangle3dTextured>& splitTriangles)
+{
+   const double epsilon = 1e-6;
+
+   double minU = triangle.m_vertices[0].u, maxU = minU;
+   double minV = triangle.m_vertices[0].v, maxV = minV;
+   for (size_t vertexIndex = 1; vertexIndex < 3; vertexIndex++)
+   {
+      minU = std::min(minU, triangle.m_vertices[vertexIndex].u);
+      maxU = std::max(maxU, triangle.m_vertices[vertexIndex].u);
+      minV = std::min(minV, triangle.m_vertices[vertexIndex].v);
+      maxV = std::max(maxV, triangle.m_vertices[vertexIndex].v);
+   }
+
+   int cellMinU = static_cast<int>(floor(minU + epsilon));
+   int cellMaxU = std::max(cellMinU, static_cast<int>(ceil(maxU - epsilon)) - 1);
+   int cellMinV = static_cast<int>(floor(minV + epsilon));
+   int cellMaxV = std::max(cellMinV, static_cast<int>(ceil(maxV - epsilon)) - 1);
+
+   std::vector<Vertex3d> polygon, clippedPolygon;
+
+   for (int cellU = cellMinU; cellU <= cellMaxU; cellU++)
+      for (int cellV = cellMinV; cellV <= cellMaxV; cellV++)
+      {
+         polygon.assign(std::begin(triangle.m_vertices), std::end(triangle.m_vertices));
+
+         if (cellMinU != cellMaxU)
+         {
+            ClipPolygonAtTexCoord(polygon, true, cellU, true, clippedPolygon);
+            ClipPolygonAtTexCoord(clippedPolygon, true, cellU + 1.0, false, polygon);
+         }
+
+         if (cellMinV != cellMaxV)
+         {
+            ClipPolygonAtTexCoord(polygon, false, cellV, true, clippedPolygon);
+            ClipPolygonAtTexCoord(clippedPolygon, false, cellV + 1.0, false, polygon);
+         }
+
+         if (polygon.size() < 3)
+            continue;
+
+         for (Vertex3d& vertex : polygon)
+         {
+            vertex.u = std::min(1.0, std::max(0.0, vertex.u - cellU));
+            vertex.v = std::min(1.0, std::max(0.0, vertex.v - cellV));
+         }
+
+         // triangulate convex polygon as triangle fan
+         for (size_t index = 2; index < polygon.size(); index++)
+         {
+            splitTriangles.push_back(Triangle3dTextured(
+               polygon[0], polygon[index - 1], polygon[index],
+               triangle.m_textureNumber));
+         }
+      }
+}
+
 LevelTilemapRenderer::LevelTilemapRenderer(const Underworld::Level& level,
    TextureManager& textureManager)
    :m_level(level),
    m_textureManager(textureManager),
-   m_geometryProvider(level)
+   m_geometryProvider(level),
+   m_isMeshInvalid(true)
 {
 }
 
-/// Renders a single tile. The function renders all triangles of that tile.
-/// The function uses glPushName() to let the SelectPick() method know what
-/// triangles belong to what tile.
+/// Bakes the tile geometry of all tiles of the level into the vertex buffer.
+/// The triangles are grouped by stock texture, and inside each group ordered
+/// by tile, so that the visible tiles of a texture can be rendered with a
+/// single draw call. Triangles using textures that are packed into the
+/// texture atlas are split at the texture borders and are all put into a
+/// single group. Nothing is baked when vertex buffer objects aren't
+/// available.
+void LevelTilemapRenderer::PrepareMesh()
+{
+   if (!OpenGL::IsVertexBufferAvailable())
+   {
+      m_textureBatches.clear();
+      m_isMeshInvalid = false;
+      return;
+   }
+
+   const unsigned int tilemapSize = Underworld::c_underworldTilemapSize;
+
+   std::map<Uint16, std::vector<TileMeshVertex>> allTextureVertices;
+   std::map<Uint16, std::vector<TileMeshRange>> allTextureRanges;
+
+   std::vector<Triangle3dTextured> tileTriangles, allTriangles;
+   for (unsigned int ypos = 0; ypos < tilemapSize; ypos++)
+      for (unsigned int xpos = 0; xpos < tilemapSize; xpos++)
+      {
+         tileTriangles.clear();
+         m_geometryProvider.GetTileTriangles(xpos, ypos, tileTriangles);
+
+         allTriangles.clear();
+         for (const Triangle3dTextured& triangle : tileTriangles)
+         {
+            if (m_textureManager.IsInAtlas(triangle.m_textureNumber))
+               SplitTriangleAtTextureCells(triangle, allTriangles);
+            else
+               allTriangles.push_back(triangle);
+         }
+
+         unsigned int tileIndex = ypos * tilemapSize + xpos;
+
+         for (const Triangle3dTextured& triangle : allTriangles)
+         {
+            bool isInAtlas = m_textureManager.IsInAtlas(triangle.m_textureNumber);
+            Uint16 batchKey = isInAtlas ? c_textureAtlasBatch : triangle.m_textureNumber;
+
+            std::vector<TileMeshVertex>& textureVertices = allTextureVertices[batchKey];
+            std::vector<TileMeshRange>& textureRanges = allTextureRanges[batchKey];
+
+            // start new tile range, or extend the current one
+            if (textureRanges.empty() || textureRanges.back().m_tileIndex != tileIndex)
+            {
+               TileMeshRange range = { tileIndex, static_cast<GLint>(textureVertices.size()), 0 };
+               textureRanges.push_back(range);
+            }
+
+            for (size_t vertexIndex = 0; vertexIndex < 3; vertexIndex++)
+            {
+               const Vertex3d& vertex = triangle.m_vertices[vertexIndex];
+
+               double u = vertex.u, v = vertex.v;
+               if (isInAtlas)
+                  m_textureManager.MapAtlasTexCoords(triangle.m_textureNumber, u, v);
+
+               TileMeshVertex meshVertex =
+               {
+                  static_cast<GLfloat>(u),
+                  static_cast<GLfloat>(v),
+                  static_cast<GLfloat>(vertex.pos.x),
+                  static_cast<GLfloat>(vertex.pos.y),
+                  static_cast<GLfloat>(vertex.pos.z * c_renderHeightScale),
+               };
+
+               textureVertices.push_back(meshVertex);
+            }
+
+            textureRanges.back().m_count += 3;
+         }
+      }
+
+   // put all vertices into one buffer, and move the ranges accordingly
+   std::vector<TileMeshVertex> allVertices;
+   m_textureBatches.clear();
+
+   for (auto& textureVerticesPair : allTextureVertices)
+   {
+      GLint batchStart = static_cast<GLint>(allVertices.size());
+
+      allVertices.insert(allVertices.end(),
+         textureVerticesPair.second.begin(),
+         textureVerticesPair.second.end());
+
+      TextureBatch batch;
+      batch.m_textureNumber = textureVerticesPair.first;
+      batch.m_tileRanges.swap(allTextureRanges[textureVerticesPair.first]);
+
+      for (TileMeshRange& range : batch.m_tileRanges)
+         range.m_first += batchStart;
+
+      m_textureBatches.push_back(std::move(batch));
+   }
+
+   m_vertexBuffer.Free();
+   m_vertexBuffer.Generate();
+   m_vertexBuffer.Bind();
+   m_vertexBuffer.Upload(allVertices.data(), sizeof(TileMeshVertex), allVertices.size());
+   m_vertexBuffer.Unbind();
+
+   m_isMeshInvalid = false;
+
+   UaTrace("baked %zu tile vertices in %zu texture batches\n",
+      allVertices.size(), m_textureBatches.size());
+}
+
+/// Renders all given tiles. When the baked tile geometry is outdated, it is
+/// baked again first. For each texture (or the texture atlas), the vertex
+/// ranges of all visible tiles are collected, adjacent ranges are merged and
+/// rendered in a single glMultiDrawArrays() call. When vertex buffer objects
+/// aren't available, the tiles are rendered one at a time in immediate mode.
+/// \param visibleTiles list of visible tiles to render
+void LevelTilemapRenderer::RenderTiles(const std::vector<QuadTileCoordinates>& visibleTiles)
+{
+   if (!OpenGL::IsVertexBufferAvailable())
+   {
+      for (const QuadTileCoordinates& tilePos : visibleTiles)
+         RenderTile(tilePos.first, tilePos.second);
+
+      return;
+   }
+
+   if (m_isMeshInvalid)
+      PrepareMesh();
+
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   m_visibleTiles.reset();
+   for (const QuadTileCoordinates& tilePos : visibleTiles)
+      m_visibleTiles.set(tilePos.second * Underworld::c_underworldTilemapSize + tilePos.first);
+
+   m_vertexBuffer.Bind();
+   gl.m_interleavedArrays(GL_T2F_V3F, 0, nullptr);
+
+   for (const TextureBatch& batch : m_textureBatches)
+   {
+      m_batchFirst.clear();
+      m_batchCount.clear();
+
+      for (const TileMeshRange& range : batch.m_tileRanges)
+      {
+         if (!m_visibleTiles.test(range.m_tileIndex))
+            continue;
+
+         // merge with last range when the vertices follow directly
+         if (!m_batchFirst.empty() &&
+            m_batchFirst.back() + m_batchCount.back() == range.m_first)
+         {
+            m_batchCount.back() += range.m_count;
+         }
+         else
+         {
+            m_batchFirst.push_back(range.m_first);
+            m_batchCount.push_back(range.m_count);
+         }
+      }
+
+      if (m_batchFirst.empty())
+         continue;
+
+      if (batch.m_textureNumber == c_textureAtlasBatch)
+      {
+         m_textureManager.UseAtlas();
+      }
+      else
+      {
+         m_textureManager.Use(batch.m_textureNumber);
+
+         // set texture parameter
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      }
+
+      gl.m_multiDrawArrays(GL_TRIANGLES, m_batchFirst.data(), m_batchCount.data(),
+         static_cast<GLsizei>(m_batchFirst.size()));
+
+      if (batch.m_textureNumber == c_textureAtlasBatch)
+         m_textureManager.UnuseAtlas();
+   }
+
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glDisableClientState(GL_VERTEX_ARRAY);
+   m_vertexBuffer.Unbind();
+}
+
+/// Renders a single tile. The function renders all triangles of that tile in
+/// immediate mode.
 /// \param xpos tile x coordinate of visible tile
 /// \param ypos tile y coordinate of visible tile
 void LevelTilemapRenderer::RenderTile(unsigned int xpos, unsigned int ypos)
 {
-   glPushName((ypos << 8) + xpos);
-
    std::vector<Triangle3dTextured> allTriangles;
    m_geometryProvider.GetTileTriangles(xpos, ypos, allTriangles);
 
@@ -56,9 +361,6 @@ void LevelTilemapRenderer::RenderTile(unsigned int xpos, unsigned int ypos)
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-      // remember used texture number
-      glPushName(triangle.m_textureNumber + 0x0400);
-
       glBegin(GL_TRIANGLES);
       for (size_t vertexIndex = 0; vertexIndex < 3; vertexIndex++)
       {
@@ -67,8 +369,5 @@ void LevelTilemapRenderer::RenderTile(unsigned int xpos, unsigned int ypos)
             triangle.m_vertices[vertexIndex].pos.z * c_renderHeightScale);
       }
       glEnd();
-      glPopName();
    }
-
-   glPopName();
 }
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,8 +21,10 @@
 //
 #pragma once
 
+#include <bitset>
 #include "Quadtree.hpp"
 #include "GeometryProvider.hpp"
+#include "VertexBufferObject.hpp"
 
 namespace Underworld
 {
@@ -30,7 +32,13 @@ namespace Underworld
 }
 class TextureManager;
 
-/// level tile renderer class
+/// \brief level tile renderer class
+/// \details The tile geometry of the whole level is baked once into a vertex
+/// buffer object, grouped by stock texture. Textures packed into the texture
+/// atlas of the texture manager share a single group. Rendering the visible
+/// tiles then only needs one draw call per group. RenderTile() renders a single
+/// tile in immediate mode and is used when the level wasn't prepared, or when
+/// vertex buffer objects aren't available.
 class LevelTilemapRenderer
 {
 public:
@@ -38,10 +46,52 @@ public:
    LevelTilemapRenderer(const Underworld::Level& level,
       TextureManager& m_textureManager);
 
+   /// returns level that the tilemap renderer was created for
+   const Underworld::Level& GetLevel() const { return m_level; }
+
+   /// bakes the tile geometry of the level into the vertex buffer
+   void PrepareMesh();
+
+   /// renders all given tiles, using the baked tile geometry
+   void RenderTiles(const std::vector<QuadTileCoordinates>& visibleTiles);
+
    /// renders a single tile
    void RenderTile(unsigned int xpos, unsigned int ypos);
 
 private:
+   /// vertex of the baked mesh; layout matches GL_T2F_V3F
+   struct TileMeshVertex
+   {
+      /// texture coordinates
+      GLfloat u, v;
+
+      /// vertex position, with z already scaled by c_renderHeightScale
+      GLfloat x, y, z;
+   };
+
+   /// range of vertices in the vertex buffer that belong to a single tile
+   struct TileMeshRange
+   {
+      /// tile index; calculated as ypos * tilemap size + xpos
+      unsigned int m_tileIndex;
+
+      /// first vertex in vertex buffer
+      GLint m_first;
+
+      /// number of vertices
+      GLsizei m_count;
+   };
+
+   /// all tile vertex ranges that use the same stock texture
+   struct TextureBatch
+   {
+      /// stock texture number, or c_textureAtlasBatch for the texture atlas
+      Uint16 m_textureNumber;
+
+      /// vertex ranges for tiles, ordered by vertex buffer position
+      std::vector<TileMeshRange> m_tileRanges;
+   };
+
    /// ref to level
    const Underworld::Level& m_level;
 
@@ -50,4 +100,22 @@ private:
 
    /// geometry provider for level
    Physics::GeometryProvider m_geometryProvider;
+
+   /// vertex buffer containing the baked tile geometry
+   VertexBufferObject m_vertexBuffer;
+
+   /// all texture batches of the baked tile geometry
+   std::vector<TextureBatch> m_textureBatches;
+
+   /// indicates if the baked tile geometry has to be baked again
+   bool m_isMeshInvalid;
+
+   /// visible tiles of the currently rendered frame
+   std::bitset<Underworld::c_underworldTilemapSize * Underworld::c_underworldTilemapSize> m_visibleTiles;
+
+   /// first vertex indices of current texture batch; kept to prevent allocations
+   std::vector<GLint> m_batchFirst;
+
+   /// vertex counts of current texture batch; kept to prevent allocations
+   std::vector<GLsizei> m_batchCount;
 };
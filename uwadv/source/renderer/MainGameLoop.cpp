@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019 Underworld Adventures Team
+// Copyright (c) 2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,38 +21,59 @@
 //
 #include "pch.hpp"
 #include "MainGameLoop.hpp"
+#include "FrameProfiler.hpp"
+#include <algorithm>
 
 MainGameLoop::MainGameLoop(const char* windowTitle, bool updateFrameCount)
    :m_windowTitle(windowTitle),
    m_updateFrameCount(updateFrameCount),
    m_exitLoop(false),
-   m_appActive(true)
+   m_appActive(true),
+   m_tickInterpolation(1.0)
 {
 }
 
+/// Runs the game loop until QuitLoop() is called or the application is quit.
+/// Game logic ticks are processed with a fixed tick rate, while frames are
+/// rendered as often as the frame pacer and vsync allow. Timing uses the high
+/// resolution performance counter. Before rendering, the fraction of the
+/// current tick interval that already passed is available with
+/// GetTickInterpolation().
+/// \param tickRate number of game logic ticks per second
 void MainGameLoop::RunGameLoop(unsigned int tickRate)
 {
    UaTrace("main loop started\n");
 
-   Uint32 now, then;
-   Uint32 fcstart;
+   const Uint64 countsPerSecond = SDL_GetPerformanceFrequency();
+   const Uint64 countsPerTick = countsPerSecond / tickRate;
+
+   Uint64 now, then;
+   Uint64 fcstart;
    unsigned int ticks = 0, renders = 0;
 
-   fcstart = then = SDL_GetTicks();
+   fcstart = then = SDL_GetPerformanceCounter();
 
    bool resetTickTimer = false;
 
+   Base::FrameProfiler& profiler = Base::FrameProfiler::GetInstance();
+
+   m_framePacer.Reset();
    m_exitLoop = false;
 
    while (!m_exitLoop)
    {
-      now = SDL_GetTicks();
+      profiler.BeginFrame();
+
+      now = SDL_GetPerformanceCounter();
 
-      while ((now - then) > (1000.0 / tickRate))
+      while ((now - then) > countsPerTick)
       {
-         then += Uint32(1000.0 / tickRate);
+         then += countsPerTick;
 
-         OnTick(resetTickTimer);
+         {
+            Base::ProfileScope scope{ Base::framePhaseTick };
+            OnTick(resetTickTimer);
+         }
 
          ticks++;
 
@@ -60,7 +81,10 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
             break;
       }
 
-      ProcessEvents();
+      {
+         Base::ProfileScope scope{ Base::framePhaseEvents };
+         ProcessEvents();
+      }
 
       if (m_exitLoop)
          break;
@@ -68,7 +92,7 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
       // reset timer when needed
       if (resetTickTimer)
       {
-         then = now = SDL_GetTicks();
+         then = now = SDL_GetPerformanceCounter();
          resetTickTimer = false;
       }
 
@@ -76,27 +100,38 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
       {
          // as we're not visible, just wait for next event
          SDL_WaitEvent(NULL);
+         m_framePacer.Reset();
          continue;
       }
 
-      OnRender();
+      m_tickInterpolation = std::min(1.0,
+         double(SDL_GetPerformanceCounter() - then) / countsPerTick);
+
+      {
+         Base::ProfileScope scope{ Base::framePhaseRender };
+         OnRender();
+      }
 
       renders++;
 
-      if ((now - then) > (1000.0 / tickRate))
-         then = now - Uint32(1000.0 / tickRate);
+      if ((now - then) > countsPerTick)
+         then = now - countsPerTick;
 
       if (m_updateFrameCount)
       {
-         now = SDL_GetTicks();
+         now = SDL_GetPerformanceCounter();
 
-         if (now - fcstart > 2000)
+         if (now - fcstart > 2 * countsPerSecond)
          {
+            Base::FrameTimeStatistics statistics = profiler.CalcStatistics();
+            double elapsedSeconds = double(now - fcstart) / countsPerSecond;
+
             // set new caption
             char buffer[256];
-            snprintf(buffer, sizeof(buffer), "%s: %3.1f ticks/s, %3.1f frames/s",
+            snprintf(buffer, sizeof(buffer), "%s: %3.1f ticks/s, %3.1f frames/s, frame time p50 %.1f ms, p99 %.1f ms",
                m_windowTitle.c_str(),
-               ticks * 1000.0 / (now - fcstart), renders * 1000.0 / (now - fcstart));
+               ticks / elapsedSeconds, renders / elapsedSeconds,
+               statistics.m_percentile50, statistics.m_percentile99);
 
             UpdateCaption(buffer);
 
@@ -106,13 +141,16 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
 #ifdef HAVE_DEBUG
             // reset time count when rendering lasted longer than 5 seconds
             // it's likely that we just debugged through some code
-            if (now - then > 5000)
+            if (now - then > 5 * countsPerSecond)
                then = now;
 #endif
          }
       }
 
-      SDL_Delay(1); // give up time slice
+      // give up time slice until the next frame is due
+      m_framePacer.WaitForNextFrame();
+
+      profiler.EndFrame();
    }
 
    UaTrace("main loop ended\n\n");
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019 Underworld Adventures Team
+// Copyright (c) 2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <atomic>
+#include "FramePacer.hpp"
 
 union SDL_Event;
 
@@ -39,6 +40,17 @@ public:
    /// quits game loop; can be called from other threads
    void QuitLoop();
 
+   /// sets frame rate limit; 0 renders as often as possible, or as vsync
+   /// allows
+   void SetFrameRateLimit(unsigned int framesPerSecond)
+   {
+      m_framePacer.SetTargetFrameRate(framesPerSecond);
+   }
+
+   /// returns the fraction of the current tick interval that has already
+   /// passed; in the range [0; 1]; valid while rendering
+   double GetTickInterpolation() const { return m_tickInterpolation; }
+
    // new virtual methods
 
    /// called to update caption
@@ -69,4 +81,10 @@ private:
 
    /// indicates if the application is currently active (in foreground)
    bool m_appActive;
+
+   /// frame pacer to limit the frame rate
+   FramePacer m_framePacer;
+
+   /// fraction of the current tick interval that has already passed
+   double m_tickInterpolation;
 };
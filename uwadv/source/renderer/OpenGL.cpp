@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,6 +22,85 @@
 #include "pch.hpp"
 #include "OpenGL.hpp"
 
+OpenGLFunctions OpenGL::s_functions;
+
+/// Loads an OpenGL function using SDL_GL_GetProcAddress().
+/// \param function function pointer to set; nullptr when not available
+/// \param name name of OpenGL function
+template <typename T>
+static void LoadFunction(T& function, const char* name)
+{
+   function = reinterpret_cast<T>(SDL_GL_GetProcAddress(name));
+}
+
+/// Loads all OpenGL functions that are not linked, since not all platforms
+/// export them. The functions may depend on the OpenGL context, so this must
+/// be called after the context was created.
+void OpenGL::LoadFunctions()
+{
+   LoadFunction(s_functions.m_interleavedArrays, "glInterleavedArrays");
+   LoadFunction(s_functions.m_multiDrawArrays, "glMultiDrawArrays");
+   LoadFunction(s_functions.m_genBuffers, "glGenBuffers");
+   LoadFunction(s_functions.m_bindBuffer, "glBindBuffer");
+   LoadFunction(s_functions.m_bufferData, "glBufferData");
+   LoadFunction(s_functions.m_deleteBuffers, "glDeleteBuffers");
+
+   LoadFunction(s_functions.m_activeTexture, "glActiveTexture");
+   LoadFunction(s_functions.m_createShader, "glCreateShader");
+   LoadFunction(s_functions.m_shaderSource, "glShaderSource");
+   LoadFunction(s_functions.m_compileShader, "glCompileShader");
+   LoadFunction(s_functions.m_getShaderiv, "glGetShaderiv");
+   LoadFunction(s_functions.m_getShaderInfoLog, "glGetShaderInfoLog");
+   LoadFunction(s_functions.m_deleteShader, "glDeleteShader");
+   LoadFunction(s_functions.m_createProgram, "glCreateProgram");
+   LoadFunction(s_functions.m_attachShader, "glAttachShader");
+   LoadFunction(s_functions.m_linkProgram, "glLinkProgram");
+   LoadFunction(s_functions.m_getProgramiv, "glGetProgramiv");
+   LoadFunction(s_functions.m_getProgramInfoLog, "glGetProgramInfoLog");
+   LoadFunction(s_functions.m_deleteProgram, "glDeleteProgram");
+   LoadFunction(s_functions.m_useProgram, "glUseProgram");
+   LoadFunction(s_functions.m_getUniformLocation, "glGetUniformLocation");
+   LoadFunction(s_functions.m_uniform1i, "glUniform1i");
+
+   UaTrace("OpenGL: vertex buffer objects are %savailable, shaders are %savailable\n",
+      IsVertexBufferAvailable() ? "" : "not ",
+      IsShaderAvailable() ? "" : "not ");
+}
+
+/// Returns if all functions needed for rendering from vertex buffer objects
+/// are available. When not, geometry must be rendered in immediate mode.
+bool OpenGL::IsVertexBufferAvailable()
+{
+   return s_functions.m_interleavedArrays != nullptr &&
+      s_functions.m_multiDrawArrays != nullptr &&
+      s_functions.m_genBuffers != nullptr &&
+      s_functions.m_bindBuffer != nullptr &&
+      s_functions.m_bufferData != nullptr &&
+      s_functions.m_deleteBuffers != nullptr;
+}
+
+/// Returns if all functions needed for compiling and using GLSL shader
+/// programs are available. When not, textures must be uploaded as RGBA.
+bool OpenGL::IsShaderAvailable()
+{
+   return s_functions.m_activeTexture != nullptr &&
+      s_functions.m_createShader != nullptr &&
+      s_functions.m_shaderSource != nullptr &&
+      s_functions.m_compileShader != nullptr &&
+      s_functions.m_getShaderiv != nullptr &&
+      s_functions.m_getShaderInfoLog != nullptr &&
+      s_functions.m_deleteShader != nullptr &&
+      s_functions.m_createProgram != nullptr &&
+      s_functions.m_attachShader != nullptr &&
+      s_functions.m_linkProgram != nullptr &&
+      s_functions.m_getProgramiv != nullptr &&
+      s_functions.m_getProgramInfoLog != nullptr &&
+      s_functions.m_deleteProgram != nullptr &&
+      s_functions.m_useProgram != nullptr &&
+      s_functions.m_getUniformLocation != nullptr &&
+      s_functions.m_uniform1i != nullptr;
+}
+
 bool OpenGL::IsOpenGLES()
 {
 #ifdef HAVE_ANDROID
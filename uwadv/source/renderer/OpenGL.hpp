@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,10 +21,99 @@
 //
 #pragma once
 
+/// function type of glInterleavedArrays(); OpenGL 1.1 has no typedef for it
+typedef void (APIENTRYP T_fnGlInterleavedArrays)(GLenum format, GLsizei stride, const void* pointer);
+
+/// \brief OpenGL functions loaded at runtime
+/// \details opengl32.lib on Windows only exports OpenGL 1.1 functions, and
+/// OpenGL ES lacks some of the functions, so the functions are loaded with
+/// SDL_GL_GetProcAddress() instead of being linked. Functions that aren't
+/// available are nullptr.
+struct OpenGLFunctions
+{
+   /// glInterleavedArrays(); OpenGL 1.1, not available on OpenGL ES
+   T_fnGlInterleavedArrays m_interleavedArrays = nullptr;
+
+   /// glMultiDrawArrays(); OpenGL 1.4, not available on OpenGL ES
+   PFNGLMULTIDRAWARRAYSPROC m_multiDrawArrays = nullptr;
+
+   /// glGenBuffers(); OpenGL 1.5
+   PFNGLGENBUFFERSPROC m_genBuffers = nullptr;
+
+   /// glBindBuffer(); OpenGL 1.5
+   PFNGLBINDBUFFERPROC m_bindBuffer = nullptr;
+
+   /// glBufferData(); OpenGL 1.5
+   PFNGLBUFFERDATAPROC m_bufferData = nullptr;
+
+   /// glDeleteBuffers(); OpenGL 1.5
+   PFNGLDELETEBUFFERSPROC m_deleteBuffers = nullptr;
+
+   /// glActiveTexture(); OpenGL 1.3
+   PFNGLACTIVETEXTUREPROC m_activeTexture = nullptr;
+
+   /// glCreateShader(); OpenGL 2.0
+   PFNGLCREATESHADERPROC m_createShader = nullptr;
+
+   /// glShaderSource(); OpenGL 2.0
+   PFNGLSHADERSOURCEPROC m_shaderSource = nullptr;
+
+   /// glCompileShader(); OpenGL 2.0
+   PFNGLCOMPILESHADERPROC m_compileShader = nullptr;
+
+   /// glGetShaderiv(); OpenGL 2.0
+   PFNGLGETSHADERIVPROC m_getShaderiv = nullptr;
+
+   /// glGetShaderInfoLog(); OpenGL 2.0
+   PFNGLGETSHADERINFOLOGPROC m_getShaderInfoLog = nullptr;
+
+   /// glDeleteShader(); OpenGL 2.0
+   PFNGLDELETESHADERPROC m_deleteShader = nullptr;
+
+   /// glCreateProgram(); OpenGL 2.0
+   PFNGLCREATEPROGRAMPROC m_createProgram = nullptr;
+
+   /// glAttachShader(); OpenGL 2.0
+   PFNGLATTACHSHADERPROC m_attachShader = nullptr;
+
+   /// glLinkProgram(); OpenGL 2.0
+   PFNGLLINKPROGRAMPROC m_linkProgram = nullptr;
+
+   /// glGetProgramiv(); OpenGL 2.0
+   PFNGLGETPROGRAMIVPROC m_getProgramiv = nullptr;
+
+   /// glGetProgramInfoLog(); OpenGL 2.0
+   PFNGLGETPROGRAMINFOLOGPROC m_getProgramInfoLog = nullptr;
+
+   /// glDeleteProgram(); OpenGL 2.0
+   PFNGLDELETEPROGRAMPROC m_deleteProgram = nullptr;
+
+   /// glUseProgram(); OpenGL 2.0
+   PFNGLUSEPROGRAMPROC m_useProgram = nullptr;
+
+   /// glGetUniformLocation(); OpenGL 2.0
+   PFNGLGETUNIFORMLOCATIONPROC m_getUniformLocation = nullptr;
+
+   /// glUniform1i(); OpenGL 2.0
+   PFNGLUNIFORM1IPROC m_uniform1i = nullptr;
+};
+
 /// OpenGL helper class
 class OpenGL
 {
 public:
+   /// loads OpenGL functions; must be called with a current OpenGL context
+   static void LoadFunctions();
+
+   /// returns OpenGL functions loaded with LoadFunctions()
+   static const OpenGLFunctions& GetFunctions() { return s_functions; }
+
+   /// indicates if tiles can be rendered from vertex buffer objects
+   static bool IsVertexBufferAvailable();
+
+   /// indicates if GLSL shader programs can be used
+   static bool IsShaderAvailable();
+
    /// indicates if the current platform only supports OpenGL ES
    static bool IsOpenGLES();
 
@@ -33,4 +122,8 @@ public:
 
    /// output some OpenGL diagnostics
    static void PrintOpenGLDiagnostics();
+
+private:
+   /// OpenGL functions loaded at runtime
+   static OpenGLFunctions s_functions;
 };
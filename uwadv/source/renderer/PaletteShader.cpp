@@ -0,0 +1,254 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteShader.cpp
+/// \brief palette lookup shader implementation
+//
+#include "pch.hpp"
+#include "PaletteShader.hpp"
+#include "OpenGL.hpp"
+
+/// vertex shader; passes through vertex color and texture coordinates, and
+/// calculates the fog coordinate like the fixed function pipeline does
+static const char* c_paletteVertexShader =
+"#version 110\n"
+"void main()\n"
+"{\n"
+"   gl_Position = ftransform();\n"
+"   gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+"   gl_FrontColor = gl_Color;\n"
+"   gl_FogFragCoord = abs((gl_ModelViewMatrix * gl_Vertex).z);\n"
+"}\n";
+
+/// fragment shader; looks up the texel's palette index in the palette
+/// texture, modulates it with the vertex color and applies GL_EXP2 fog
+static const char* c_paletteFragmentShader =
+"#version 110\n"
+"uniform sampler2D indexTexture;\n"
+"uniform sampler2D paletteTexture;\n"
+"uniform bool fogEnabled;\n"
+"void main()\n"
+"{\n"
+"   float index = texture2D(indexTexture, gl_TexCoord[0].st).r;\n"
+"   vec4 color = gl_Color *\n"
+"      texture2D(paletteTexture, vec2((index * 255.0 + 0.5) / 256.0, 0.5));\n"
+"   if (fogEnabled)\n"
+"   {\n"
+"      float fogAmount = gl_Fog.density * gl_FogFragCoord;\n"
+"      float fogFactor = clamp(exp(-fogAmount * fogAmount), 0.0, 1.0);\n"
+"      color.rgb = mix(gl_Fog.color.rgb, color.rgb, fogFactor);\n"
+"   }\n"
+"   gl_FragColor = color;\n"
+"}\n";
+
+PaletteShader::PaletteShader()
+   :m_program(0),
+   m_paletteTextureName(0),
+   m_fogEnabledLocation(-1)
+{
+}
+
+PaletteShader::~PaletteShader()
+{
+   Done();
+}
+
+/// Compiles and links the shader program and creates the palette texture.
+/// Fails when the OpenGL implementation doesn't provide the shader functions,
+/// doesn't support GLSL 1.10, or the shaders can't be compiled; callers then
+/// have to use RGBA textures.
+/// \return true when the shader program is available
+bool PaletteShader::Init()
+{
+   Done();
+
+   if (OpenGL::IsOpenGLES())
+      return false; // shaders use the fixed function pipeline state
+
+   if (!OpenGL::IsShaderAvailable())
+   {
+      UaTrace("PaletteShader: OpenGL shader functions aren't available\n");
+      return false;
+   }
+
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   const GLubyte* glslVersion = glGetString(GL_SHADING_LANGUAGE_VERSION);
+   if (glslVersion == nullptr)
+   {
+      // clear error when GL_SHADING_LANGUAGE_VERSION is unknown
+      glGetError();
+
+      UaTrace("PaletteShader: GLSL isn't supported\n");
+      return false;
+   }
+
+   GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, c_paletteVertexShader);
+   GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, c_paletteFragmentShader);
+
+   if (vertexShader != 0 && fragmentShader != 0)
+   {
+      m_program = gl.m_createProgram();
+      gl.m_attachShader(m_program, vertexShader);
+      gl.m_attachShader(m_program, fragmentShader);
+      gl.m_linkProgram(m_program);
+
+      GLint linkStatus = GL_FALSE;
+      gl.m_getProgramiv(m_program, GL_LINK_STATUS, &linkStatus);
+      if (linkStatus != GL_TRUE)
+      {
+         char infoLog[512] = {};
+         gl.m_getProgramInfoLog(m_program, sizeof(infoLog), nullptr, infoLog);
+         UaTrace("PaletteShader: error linking shader program: %s\n", infoLog);
+
+         gl.m_deleteProgram(m_program);
+         m_program = 0;
+      }
+   }
+
+   // the program keeps the shaders as long as they are needed
+   if (vertexShader != 0)
+      gl.m_deleteShader(vertexShader);
+
+   if (fragmentShader != 0)
+      gl.m_deleteShader(fragmentShader);
+
+   if (m_program == 0)
+      return false;
+
+   gl.m_useProgram(m_program);
+   gl.m_uniform1i(gl.m_getUniformLocation(m_program, "indexTexture"), 0);
+   gl.m_uniform1i(gl.m_getUniformLocation(m_program, "paletteTexture"), 1);
+   m_fogEnabledLocation = gl.m_getUniformLocation(m_program, "fogEnabled");
+   gl.m_useProgram(0);
+
+   // create palette texture on texture unit 1
+   gl.m_activeTexture(GL_TEXTURE1);
+
+   glGenTextures(1, &m_paletteTextureName);
+   glBindTexture(GL_TEXTURE_2D, m_paletteTextureName);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+   gl.m_activeTexture(GL_TEXTURE0);
+
+   GLenum error = glGetError();
+   if (error != GL_NO_ERROR)
+   {
+      UaTrace("PaletteShader: error during creating palette texture! (%u)\n", error);
+      Done();
+      return false;
+   }
+
+   UaTrace("PaletteShader: using GLSL version %s\n",
+      reinterpret_cast<const char*>(glslVersion));
+   return true;
+}
+
+/// Deletes shader program and palette texture.
+void PaletteShader::Done()
+{
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   if (m_program != 0)
+      gl.m_deleteProgram(m_program);
+
+   if (m_paletteTextureName != 0)
+      glDeleteTextures(1, &m_paletteTextureName);
+
+   m_program = 0;
+   m_paletteTextureName = 0;
+   m_fogEnabledLocation = -1;
+}
+
+/// Uploads a new palette to the palette texture. The texture binding of
+/// texture unit 0 isn't changed.
+/// \param paletteData 256 palette entries with 4 bytes each, in GL_RGBA
+/// format
+void PaletteShader::UploadPalette(const Uint8* paletteData)
+{
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   UaAssert(IsAvailable());
+
+   gl.m_activeTexture(GL_TEXTURE1);
+   glBindTexture(GL_TEXTURE_2D, m_paletteTextureName);
+
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1,
+      GL_RGBA, GL_UNSIGNED_BYTE, paletteData);
+
+   gl.m_activeTexture(GL_TEXTURE0);
+}
+
+/// Uses the shader program. The index texture must be bound to texture unit
+/// 0; the palette texture is bound to texture unit 1. Fog is applied when
+/// GL_FOG is currently enabled.
+void PaletteShader::Use() const
+{
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   UaAssert(IsAvailable());
+
+   gl.m_activeTexture(GL_TEXTURE1);
+   glBindTexture(GL_TEXTURE_2D, m_paletteTextureName);
+   gl.m_activeTexture(GL_TEXTURE0);
+
+   gl.m_useProgram(m_program);
+   gl.m_uniform1i(m_fogEnabledLocation, glIsEnabled(GL_FOG) ? 1 : 0);
+}
+
+/// Stops using the shader program.
+void PaletteShader::Unuse() const
+{
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+   gl.m_useProgram(0);
+}
+
+/// Compiles a shader of given type.
+/// \param shaderType shader type; GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+/// \param source shader source code
+/// \return shader name, or 0 when the shader couldn't be compiled
+GLuint PaletteShader::CompileShader(GLenum shaderType, const char* source)
+{
+   const OpenGLFunctions& gl = OpenGL::GetFunctions();
+
+   GLuint shader = gl.m_createShader(shaderType);
+   gl.m_shaderSource(shader, 1, &source, nullptr);
+   gl.m_compileShader(shader);
+
+   GLint compileStatus = GL_FALSE;
+   gl.m_getShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+   if (compileStatus != GL_TRUE)
+   {
+      char infoLog[512] = {};
+      gl.m_getShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+      UaTrace("PaletteShader: error compiling %s shader: %s\n",
+         shaderType == GL_VERTEX_SHADER ? "vertex" : "fragment", infoLog);
+
+      gl.m_deleteShader(shader);
+      return 0;
+   }
+
+   return shader;
+}
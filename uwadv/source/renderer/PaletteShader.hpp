@@ -0,0 +1,78 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteShader.hpp
+/// \brief palette lookup shader
+//
+#pragma once
+
+#include <SDL2/SDL_opengl.h>
+
+/// \brief palette lookup shader
+/// \details Resolves the colors of 8-bit indexed textures in a fragment
+/// shader, using a 256x1 palette texture bound to texture unit 1. This
+/// allows keeping textures as 8-bit indices on the graphics card, and palette
+/// animations only need to upload the 1 KB palette texture. The shader
+/// applies the fixed function pipeline's vertex color and GL_EXP2 fog, so
+/// that indexed geometry looks the same as geometry that is rendered with
+/// RGBA textures. Index textures must use GL_NEAREST filtering, since
+/// filtering indices would produce wrong colors.
+class PaletteShader
+{
+public:
+   /// ctor
+   PaletteShader();
+   /// dtor
+   ~PaletteShader();
+   /// deleted copy ctor
+   PaletteShader(const PaletteShader&) = delete;
+   /// deleted assignment operator
+   PaletteShader& operator=(const PaletteShader&) = delete;
+
+   /// compiles shader program and creates the palette texture
+   bool Init();
+
+   /// cleans up shader program and palette texture
+   void Done();
+
+   /// returns if the shader program is available
+   bool IsAvailable() const { return m_program != 0; }
+
+   /// uploads 256 palette entries in GL_RGBA format
+   void UploadPalette(const Uint8* paletteData);
+
+   /// uses the shader program for rendering indexed textures
+   void Use() const;
+
+   /// switches back to fixed function rendering
+   void Unuse() const;
+
+private:
+   /// compiles a single shader; returns 0 on errors
+   static GLuint CompileShader(GLenum shaderType, const char* source);
+
+private:
+   /// shader program name
+   GLuint m_program;
+
+   /// palette texture name
+   GLuint m_paletteTextureName;
+
+   /// location of the "fogEnabled" uniform
+   GLint m_fogEnabledLocation;
+};
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019,2021 Underworld Adventures Team
+// Copyright (c) 2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,6 +27,7 @@ struct RenderOptions
    /// creates default render options object
    RenderOptions()
       :m_renderVisibleTilesUsingOctree(true),
+      m_useTilePvs(true),
       m_useFog(true),
       m_renderBoundingBoxes(false),
       m_renderHiddenObjects(false)
@@ -38,6 +39,11 @@ struct RenderOptions
    /// renders all tiles (useful for mapdisp tool)
    bool m_renderVisibleTilesUsingOctree;
 
+   /// indicates if the precomputed potentially visible set of tiles should
+   /// be used to skip tiles hidden behind walls; only used together with
+   /// m_renderVisibleTilesUsingOctree
+   bool m_useTilePvs;
+
    /// indicates if fog should be used to hide distant tiles
    bool m_useFog;
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019,2022 Underworld Adventures Team
+// Copyright (c) 2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -83,6 +83,30 @@ void RenderWindow::SetFullscreen(bool fullscreen)
    glViewport(0, 0, m_width, m_height);
 }
 
+/// Enables or disables waiting for the vertical retrace when swapping
+/// buffers. When enabling, adaptive vsync is tried first, which doesn't wait
+/// when a frame already missed the retrace.
+/// \param enabled true to enable vsync
+/// \return false when the requested mode isn't supported
+bool RenderWindow::SetVsync(bool enabled)
+{
+   if (!enabled)
+      return SDL_GL_SetSwapInterval(0) == 0;
+
+   return SDL_GL_SetSwapInterval(-1) == 0 ||
+      SDL_GL_SetSwapInterval(1) == 0;
+}
+
+unsigned int RenderWindow::GetDisplayRefreshRate() const
+{
+   SDL_DisplayMode displayMode = { 0 };
+   if (SDL_GetWindowDisplayMode(m_window, &displayMode) != 0 ||
+      displayMode.refresh_rate <= 0)
+      return 0;
+
+   return static_cast<unsigned int>(displayMode.refresh_rate);
+}
+
 void RenderWindow::GetWindowSize(int& width, int& height) const
 {
    SDL_GetWindowSize(m_window, &width, &height);
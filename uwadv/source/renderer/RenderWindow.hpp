@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019,2022 Underworld Adventures Team
+// Copyright (c) 2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -37,6 +37,12 @@ public:
    /// sets fullscreen mode (or goes back to windowed mode)
    void SetFullscreen(bool fullscreen);
 
+   /// enables or disables vsync; returns false when not supported
+   bool SetVsync(bool enabled);
+
+   /// returns refresh rate of the window's display, or 0 when unknown
+   unsigned int GetDisplayRefreshRate() const;
+
    /// returns current window size
    void GetWindowSize(int& width, int& height) const;
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 #include "Renderer.hpp"
 #include "UnderworldRenderer.hpp"
 #include "Viewport.hpp"
+#include "LevelPicker.hpp"
 #include "Critter.hpp"
 #include "Model3D.hpp"
 #include "Underworld.hpp"
@@ -33,7 +34,9 @@
 
 Renderer::Renderer()
    :m_viewOffset(0.0, 0.0, 0.0),
-   m_rendererImpl(nullptr)
+   m_rendererImpl(nullptr),
+   m_numTickViews(0),
+   m_tickInterpolation(1.0)
 {
    if (SDL_Init(SDL_INIT_VIDEO) < 0)
    {
@@ -59,6 +62,10 @@ Renderer::~Renderer()
 /// \param game game instance
 void Renderer::InitGame(IGameInstance& game)
 {
+   // load OpenGL functions that aren't linked, now that there's an OpenGL
+   // context
+   OpenGL::LoadFunctions();
+
    // check if textures > 256 x 256 are supported
    if (OpenGL::GetMaxTextureSize() <= 256)
       throw Base::Exception("OpenGL doesn't support textures larger than 256x256!");
@@ -140,19 +147,19 @@ void Renderer::SetupFor3D(const Vector3d& viewOffset,
 /// \param underworld underworld object
 void Renderer::RenderUnderworld(const Underworld::Underworld& underworld)
 {
-   const Underworld::Player& player = underworld.GetPlayer();
-
-   double playerHeight = 0.6 + player.GetHeight();
-   Vector3d pos(player.GetXPos(), player.GetYPos(), playerHeight);
-
-   pos += m_viewOffset;
+   Vector3d pos;
+   double panAngle = 0.0, rotateAngle = 0.0;
+   CalcPlayerView(underworld.GetPlayer(), pos, panAngle, rotateAngle);
 
    // render map
-   m_rendererImpl->Render(m_renderOptions, underworld.GetCurrentLevel(), pos, player.GetPanAngle(),
-      player.GetRotateAngle(), m_fieldOfView);
+   m_rendererImpl->Render(m_renderOptions, underworld.GetCurrentLevel(), pos, panAngle,
+      rotateAngle, m_fieldOfView);
 }
 
-/// Finds out selected object or tile wall by picking.
+/// Finds out selected object or tile wall by picking. A ray is cast from the
+/// player's eye through the mouse position, and the nearest tile wall or
+/// object it hits is returned. This is done on the CPU and doesn't need to
+/// render the scene again.
 /// \param underworld underworld object
 /// \param xpos mouse x position in real window coordinates
 /// \param ypos mouse y position in real window coordinates
@@ -162,89 +169,35 @@ void Renderer::RenderUnderworld(const Underworld::Underworld& underworld)
 ///              walls were picked
 /// \param id object list pos of picked object, or texture number of picked
 ///           tile wall
-/// picking tutorial:
-/// http://www.lighthouse3d.com/opengl/picking/index.php3
 /// \returns true when an object or texture was found, or false when not
 bool Renderer::SelectPick(const Underworld::Underworld& underworld, unsigned int xpos,
    unsigned int ypos, unsigned int& tilex, unsigned int& tiley, bool& isObject,
    unsigned int& id)
 {
-   // set selection buffer
-   GLuint selectionBuffer[64];
-   {
-      glSelectBuffer(64, selectionBuffer);
-
-      // render objects in selection mode
-      glRenderMode(GL_SELECT);
-
-      // init name stack
-      glInitNames();
-   }
-
-   // save projection matrix on stack
-   glMatrixMode(GL_PROJECTION);
-   glPushMatrix();
-
-   // set up projection matrix for selection rendering
-   m_viewport->SetupCamera3D(m_fieldOfView, m_farDistance,
-      true, xpos, ypos);
+   Vector3d pos;
+   double panAngle = 0.0, rotateAngle = 0.0;
+   CalcPlayerView(underworld.GetPlayer(), pos, panAngle, rotateAngle);
 
-   // render scene
-   m_rendererImpl->SetSelectionMode(true);
-   RenderUnderworld(underworld);
-   m_rendererImpl->SetSelectionMode(false);
-
-   // switch off selection mode
-   GLint hits = glRenderMode(GL_RENDER);
-
-   // restore previous projection matrix
-   glMatrixMode(GL_PROJECTION);
-   glPopMatrix();
-   glMatrixMode(GL_MODELVIEW);
-
-   // find out hit object
-   GLint hitIndex = 0;
-   if (hits > 0)
-   {
-      GLuint min = 0xffffffff;
-      unsigned int idx = 0;
+   Vector3d origin(pos.x, pos.y, pos.z * c_renderHeightScale);
 
-      for (int i = 0; i < hits && idx < 64; i++)
-      {
-         // get count of names stored in this record
-         GLuint namecount = selectionBuffer[idx++];
-
-         // check min. hit dist.
-         if (selectionBuffer[idx] < min)
-         {
-            // new min. hit dist.
-            min = selectionBuffer[idx++];
-            idx++; // jump over max. hit dist.
-            if (namecount > 0 && namecount == 2)
-               hitIndex = idx; // hit index
-         }
-         else
-            idx += 2; // jump over min./max. hit dist.
-
-         // move idx to next record
-         idx += namecount;
-      }
-   }
+   // transform ray direction from camera space to world space, reversing
+   // the rotations done in UnderworldRenderer::Render()
+   Vector3d dir = m_viewport->CalcPickRayDirection(m_fieldOfView, xpos, ypos);
+   dir.RotateX(-(panAngle + 270.0));
+   dir.RotateZ(-(-rotateAngle + 90.0));
 
-   if (hitIndex != 0)
-   {
-      GLuint coords = selectionBuffer[hitIndex];
-      GLuint renderId = selectionBuffer[hitIndex + 1];
+   LevelPicker picker(*m_rendererImpl, m_renderOptions, underworld.GetCurrentLevel());
 
-      tilex = coords & 0x00ff;
-      tiley = (coords >> 8) & 0x00ff;
-      isObject = renderId < 0x0400;
-      id = renderId - (isObject ? 0 : 0x0400);
+   LevelPickResult result;
+   if (!picker.Pick(origin, dir, m_farDistance, result))
+      return false;
 
-      return true;
-   }
+   tilex = result.m_tileX;
+   tiley = result.m_tileY;
+   isObject = result.m_isObject;
+   id = result.m_id;
 
-   return false;
+   return true;
 }
 
 /// Prepares renderer for new level.
@@ -252,6 +205,17 @@ bool Renderer::SelectPick(const Underworld::Underworld& underworld, unsigned int
 void Renderer::PrepareLevel(Underworld::Level& level)
 {
    m_rendererImpl->PrepareLevel(level);
+
+   // don't interpolate between views of different levels
+   m_numTickViews = 0;
+}
+
+/// Invalidates the tile geometry of the level prepared with PrepareLevel().
+/// Must be called when tiles of the level were modified; the geometry is
+/// prepared again before the next frame is rendered.
+void Renderer::InvalidateTilemap()
+{
+   m_rendererImpl->InvalidateTilemap();
 }
 
 /// Does tick processing for renderer for texture and critter frames
@@ -262,6 +226,60 @@ void Renderer::Tick(double tickRate)
    m_rendererImpl->Tick(tickRate);
 }
 
+/// Stores the player's view state at the end of a game tick. The player
+/// moves in tick steps only; when the frame rate is higher than the tick
+/// rate, the view is interpolated between the last two stored states so that
+/// movement doesn't stutter.
+/// \param player player to store view state from
+void Renderer::StoreTickViewState(const Underworld::Player& player)
+{
+   m_previousTickView = m_lastTickView;
+
+   m_lastTickView.m_pos = Vector3d(player.GetXPos(), player.GetYPos(), player.GetHeight());
+   m_lastTickView.m_panAngle = player.GetPanAngle();
+   m_lastTickView.m_rotateAngle = player.GetRotateAngle();
+
+   if (m_numTickViews < 2)
+      m_numTickViews++;
+}
+
+/// Calculates the player's view position and angles used for rendering. The
+/// current player state is moved back by the part of the last tick's movement
+/// that lies in the future of the current frame. Mouse look changes done
+/// since the last tick are kept, so the view stays responsive.
+/// \param player player to calculate view for
+/// \param pos view position, including view offset
+/// \param panAngle view pan angle
+/// \param rotateAngle view rotate angle
+void Renderer::CalcPlayerView(const Underworld::Player& player, Vector3d& pos,
+   double& panAngle, double& rotateAngle) const
+{
+   pos = Vector3d(player.GetXPos(), player.GetYPos(), player.GetHeight());
+   panAngle = player.GetPanAngle();
+   rotateAngle = player.GetRotateAngle();
+
+   if (m_numTickViews >= 2 && m_tickInterpolation < 1.0)
+   {
+      Vector3d deltaPos = m_lastTickView.m_pos - m_previousTickView.m_pos;
+
+      // a large jump means teleporting; don't interpolate
+      if (deltaPos.Length() < 1.0)
+      {
+         double deltaRotate = std::fmod(
+            m_lastTickView.m_rotateAngle - m_previousTickView.m_rotateAngle + 540.0, 360.0) - 180.0;
+         double deltaPan = m_lastTickView.m_panAngle - m_previousTickView.m_panAngle;
+
+         double factor = m_tickInterpolation - 1.0;
+         pos += deltaPos * factor;
+         rotateAngle += deltaRotate * factor;
+         panAngle += deltaPan * factor;
+      }
+   }
+
+   pos.z += 0.6;
+   pos += m_viewOffset;
+}
+
 void Renderer::GetModel3DBoundingTriangles(unsigned int x,
    unsigned int y, const Underworld::Object& object,
    std::vector<Triangle3dTextured>& allTriangles)
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -32,6 +32,7 @@ namespace Underworld
    class Underworld;
    class Level;
    class Object;
+   class Player;
 }
 
 class Viewport;
@@ -87,9 +88,21 @@ public:
    /// prepares renderer for given level (e.g. when changing levels)
    void PrepareLevel(Underworld::Level& level);
 
+   /// invalidates prepared tile geometry (e.g. when tiles were changed)
+   void InvalidateTilemap();
+
    /// does renderer-specific tick processing
    void Tick(double tickRate);
 
+   /// stores player view state at the end of a game tick
+   void StoreTickViewState(const Underworld::Player& player);
+
+   /// sets interpolation factor between last two ticks, in range [0; 1]
+   void SetTickInterpolation(double tickInterpolation)
+   {
+      m_tickInterpolation = tickInterpolation;
+   }
+
    /// returns 3d model bounding triangles if a 3d model exists
    void GetModel3DBoundingTriangles(unsigned int x, unsigned int y,
       const Underworld::Object& object,
@@ -108,6 +121,24 @@ public:
    static void ReadPixelsFromBackBuffer(unsigned int xres, unsigned int yres,
       std::vector<Uint32>& screenshotRgbaData);
 
+private:
+   /// player view state at a game tick
+   struct TickViewState
+   {
+      /// player eye position
+      Vector3d m_pos;
+
+      /// pan angle
+      double m_panAngle = 0.0;
+
+      /// rotate angle
+      double m_rotateAngle = 0.0;
+   };
+
+   /// calculates player view, interpolated between the last two ticks
+   void CalcPlayerView(const Underworld::Player& player, Vector3d& pos,
+      double& panAngle, double& rotateAngle) const;
+
 private:
    /// current render options
    RenderOptions m_renderOptions;
@@ -126,4 +157,16 @@ private:
 
    /// distance of far plane
    double m_farDistance;
+
+   /// view state of the tick before the last tick
+   TickViewState m_previousTickView;
+
+   /// view state of the last tick
+   TickViewState m_lastTickView;
+
+   /// number of tick view states stored since the level was prepared
+   unsigned int m_numTickViews;
+
+   /// interpolation factor between the last two ticks
+   double m_tickInterpolation;
 };
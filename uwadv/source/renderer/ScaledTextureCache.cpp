@@ -0,0 +1,419 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ScaledTextureCache.cpp
+/// \brief cache for scaled texture images
+//
+#include "pch.hpp"
+#include "ScaledTextureCache.hpp"
+#include "Scaler.hpp"
+#include "FileSystem.hpp"
+#include <cstring>
+
+/// cache filename, relative to cache folder
+const char* c_scaledTextureCacheFilename = "scaled-textures.cache";
+
+/// magic value at the start of the cache file: "UASC"
+const Uint32 c_cacheFileMagic = 0x43534155;
+
+/// magic value at the start of each record: "UASR"
+const Uint32 c_cacheRecordMagic = 0x52534155;
+
+/// cache file format version; must be increased when the format changes
+const Uint32 c_cacheFileVersion = 2;
+
+/// size of the file header
+const long c_cacheFileHeaderSize = 16;
+
+/// size of each record header
+const long c_cacheRecordHeaderSize = 32;
+
+/// alignment of records in the cache file
+const long c_cacheRecordAlignment = 16;
+
+/// offset of the flags in the file header
+const long c_cacheFileFlagsOffset = 12;
+
+/// file header flag: a record didn't fit into the cache file anymore; the
+/// file is recreated on opening
+const Uint32 c_cacheFileFlagFull = 1;
+
+/// Opens the cache file. When the file doesn't exist yet, is invalid, was
+/// written by another Scaler version or was marked as full by Store(), a new,
+/// empty cache file is created. When the file can't be opened, the cache stays
+/// closed, and all lookups fail.
+/// \param cacheFolder folder to store the cache file in; must end with a
+/// path separator
+void ScaledTextureCache::Open(const std::string& cacheFolder)
+{
+   Close();
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   if (!Base::FileSystem::FolderExists(cacheFolder))
+      Base::FileSystem::MakeFolder(cacheFolder);
+
+   m_filename = cacheFolder + c_scaledTextureCacheFilename;
+
+   if (Base::FileSystem::FileExists(m_filename))
+   {
+      Base::File file{ m_filename, Base::modeRead };
+
+      if (file.IsOpen() && ReadIndex(file))
+      {
+         UaTrace("opened scaled texture cache with %u images\n",
+            static_cast<unsigned int>(m_mapHashToEntry.size()));
+
+         // the file handle isn't used for lookups, since it may have buffered
+         // an incomplete record that is overwritten later
+         m_isOpen = true;
+         return;
+      }
+
+      m_mapHashToEntry.clear();
+   }
+
+   if (!CreateCacheFile())
+   {
+      UaTrace("couldn't create scaled texture cache file %s\n", m_filename.c_str());
+      return;
+   }
+
+   m_isOpen = true;
+}
+
+/// Closes the cache file; all further lookups fail. Must not be called while
+/// other threads use the cache.
+void ScaledTextureCache::Close()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   m_isOpen = false;
+   m_isFull = false;
+   m_readFileList.clear();
+   m_fileEndOffset = 0;
+   m_mapHashToEntry.clear();
+   m_pendingHashes.clear();
+}
+
+/// Looks up a scaled image in the cache. The unscaled image stored in the
+/// record must be equal to the given one.
+/// \param source unscaled RGBA image
+/// \param sourceWidth width of unscaled image
+/// \param sourceHeight height of unscaled image
+/// \param scaleFactor scale factor
+/// \param dest buffer for the scaled RGBA image; must be scaleFactor^2 times
+/// the size of the unscaled image
+/// \return true when the image was found in the cache and was copied to dest
+bool ScaledTextureCache::Lookup(const Uint32* source, unsigned int sourceWidth,
+   unsigned int sourceHeight, unsigned int scaleFactor, Uint32* dest)
+{
+   if (!IsOpen())
+      return false;
+
+   Uint64 hash = CalcHash(source, sourceWidth, sourceHeight, scaleFactor);
+
+   CacheEntry entry;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto iter = m_mapHashToEntry.find(hash);
+      if (iter == m_mapHashToEntry.end())
+         return false;
+
+      entry = iter->second;
+   }
+
+   if (entry.m_sourceWidth != sourceWidth ||
+      entry.m_sourceHeight != sourceHeight ||
+      entry.m_scaleFactor != scaleFactor)
+      return false;
+
+   Base::File file = AcquireReadFile();
+   if (!file.IsOpen())
+      return false;
+
+   size_t sourceLength = size_t(sourceWidth) * sourceHeight * sizeof(Uint32);
+   size_t dataLength = sourceLength * scaleFactor * scaleFactor;
+
+   // the scaled image is read into dest before comparing, to save a buffer
+   std::vector<Uint8> storedSource(sourceLength);
+
+   file.Seek(entry.m_sourceOffset, Base::seekBegin);
+   bool found =
+      file.ReadBuffer(storedSource.data(), sourceLength) == sourceLength &&
+      memcmp(storedSource.data(), source, sourceLength) == 0 &&
+      file.ReadBuffer(reinterpret_cast<Uint8*>(dest), dataLength) == dataLength;
+
+   ReleaseReadFile(file);
+
+   return found;
+}
+
+/// Stores a scaled image in the cache. Space for the record is reserved at
+/// the end of the cache file, and the record is written immediately, using
+/// its own file handle, so that lookups don't have to wait. The record is
+/// added to the index after it was written completely. When the record
+/// doesn't fit into the cache file anymore, the file is marked as full, so
+/// that it is recreated the next time it is opened.
+/// \param source unscaled RGBA image
+/// \param sourceWidth width of unscaled image
+/// \param sourceHeight height of unscaled image
+/// \param scaleFactor scale factor
+/// \param dest scaled RGBA image
+void ScaledTextureCache::Store(const Uint32* source, unsigned int sourceWidth,
+   unsigned int sourceHeight, unsigned int scaleFactor, const Uint32* dest)
+{
+   if (!IsOpen() || sourceWidth > 0xffff || sourceHeight > 0xffff)
+      return;
+
+   Uint64 hash = CalcHash(source, sourceWidth, sourceHeight, scaleFactor);
+
+   Uint32 sourceLength = sourceWidth * sourceHeight * sizeof(Uint32);
+   Uint32 dataLength = sourceLength * scaleFactor * scaleFactor;
+
+   long recordLength = AlignRecordLength(
+      c_cacheRecordHeaderSize + long(sourceLength) + long(dataLength));
+
+   long recordOffset = 0;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_mapHashToEntry.find(hash) != m_mapHashToEntry.end() ||
+         m_pendingHashes.find(hash) != m_pendingHashes.end())
+         return; // already stored, e.g. by another thread
+
+      if (m_fileEndOffset + recordLength > m_maxFileSize)
+      {
+         if (!m_isFull)
+            MarkCacheFileFull();
+
+         return;
+      }
+
+      recordOffset = m_fileEndOffset;
+      m_fileEndOffset += recordLength;
+      m_pendingHashes.insert(hash);
+   }
+
+   bool written = false;
+   {
+      Base::File file{ m_filename, Base::modeReadWrite };
+      if (file.IsOpen())
+      {
+         // record header
+         file.Seek(recordOffset, Base::seekBegin);
+         file.Write32(c_cacheRecordMagic);
+         file.Write32(static_cast<Uint32>(hash & 0xffffffff));
+         file.Write32(static_cast<Uint32>(hash >> 32));
+         file.Write16(static_cast<Uint16>(sourceWidth));
+         file.Write16(static_cast<Uint16>(sourceHeight));
+         file.Write32(scaleFactor);
+         file.Write32(dataLength);
+
+         for (long pos = 24; pos < c_cacheRecordHeaderSize; pos += 4)
+            file.Write32(0);
+
+         // unscaled and scaled image, with padding
+         file.WriteBuffer(reinterpret_cast<const Uint8*>(source), sourceLength);
+         file.WriteBuffer(reinterpret_cast<const Uint8*>(dest), dataLength);
+
+         for (long pos = c_cacheRecordHeaderSize + long(sourceLength) + long(dataLength);
+            pos < recordLength; pos++)
+            file.Write8(0);
+
+         written = true;
+      }
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_pendingHashes.erase(hash);
+
+   if (!written)
+      return;
+
+   CacheEntry entry;
+   entry.m_sourceWidth = static_cast<Uint16>(sourceWidth);
+   entry.m_sourceHeight = static_cast<Uint16>(sourceHeight);
+   entry.m_scaleFactor = static_cast<Uint8>(scaleFactor);
+   entry.m_sourceOffset = recordOffset + c_cacheRecordHeaderSize;
+
+   m_mapHashToEntry[hash] = entry;
+}
+
+/// Calculates a 64-bit FNV-1a hash over the unscaled image, its size and the
+/// scale factor.
+/// \param source unscaled RGBA image
+/// \param sourceWidth width of unscaled image
+/// \param sourceHeight height of unscaled image
+/// \param scaleFactor scale factor
+/// \return calculated hash
+Uint64 ScaledTextureCache::CalcHash(const Uint32* source, unsigned int sourceWidth,
+   unsigned int sourceHeight, unsigned int scaleFactor)
+{
+   const Uint64 fnvPrime = 0x100000001b3ULL;
+   Uint64 hash = 0xcbf29ce484222325ULL;
+
+   auto hashValue = [&](Uint32 value)
+   {
+      for (unsigned int byte = 0; byte < 4; byte++)
+      {
+         hash ^= (value >> (byte * 8)) & 0xff;
+         hash *= fnvPrime;
+      }
+   };
+
+   hashValue(sourceWidth);
+   hashValue(sourceHeight);
+   hashValue(scaleFactor);
+
+   size_t numPixels = size_t(sourceWidth) * sourceHeight;
+   for (size_t index = 0; index < numPixels; index++)
+      hashValue(source[index]);
+
+   return hash;
+}
+
+/// Returns the length of a record, including padding to the next record.
+/// \param length unpadded record length
+/// \return padded record length
+long ScaledTextureCache::AlignRecordLength(long length)
+{
+   return (length + c_cacheRecordAlignment - 1) & ~(c_cacheRecordAlignment - 1);
+}
+
+/// Checks the cache file header and reads all record headers to fill the
+/// index. Reading stops at the first invalid or incomplete record, e.g. when
+/// the program was stopped while writing a record; new records overwrite it.
+/// \return false when the cache file is invalid and must be recreated
+bool ScaledTextureCache::ReadIndex(Base::File& file)
+{
+   long fileLength = file.FileLength();
+   if (fileLength < c_cacheFileHeaderSize || fileLength > m_maxFileSize)
+      return false;
+
+   file.Seek(0, Base::seekBegin);
+   if (file.Read32() != c_cacheFileMagic ||
+      file.Read32() != c_cacheFileVersion ||
+      file.Read32() != Scaler::c_scalerVersion ||
+      (file.Read32() & c_cacheFileFlagFull) != 0)
+      return false;
+
+   long offset = c_cacheFileHeaderSize;
+   while (offset + c_cacheRecordHeaderSize <= fileLength)
+   {
+      file.Seek(offset, Base::seekBegin);
+
+      if (file.Read32() != c_cacheRecordMagic)
+         break;
+
+      Uint64 hash = file.Read32();
+      hash |= Uint64(file.Read32()) << 32;
+
+      CacheEntry entry;
+      entry.m_sourceWidth = file.Read16();
+      entry.m_sourceHeight = file.Read16();
+
+      Uint32 scaleFactor = file.Read32();
+      Uint32 dataLength = file.Read32();
+
+      if (scaleFactor < 2 || scaleFactor > 4 ||
+         dataLength != Uint32(entry.m_sourceWidth) * entry.m_sourceHeight *
+         scaleFactor * scaleFactor * sizeof(Uint32))
+         break;
+
+      long sourceLength = long(entry.m_sourceWidth) * entry.m_sourceHeight * sizeof(Uint32);
+      long recordLength = AlignRecordLength(c_cacheRecordHeaderSize + sourceLength + long(dataLength));
+      if (offset + recordLength > fileLength)
+         break;
+
+      entry.m_scaleFactor = static_cast<Uint8>(scaleFactor);
+      entry.m_sourceOffset = offset + c_cacheRecordHeaderSize;
+
+      m_mapHashToEntry[hash] = entry;
+
+      offset += recordLength;
+   }
+
+   m_fileEndOffset = offset;
+   return true;
+}
+
+/// Creates a new cache file, containing only the file header.
+/// \return true when the file was created
+bool ScaledTextureCache::CreateCacheFile()
+{
+   Base::File file{ m_filename, Base::modeWrite };
+   if (!file.IsOpen())
+      return false;
+
+   file.Write32(c_cacheFileMagic);
+   file.Write32(c_cacheFileVersion);
+   file.Write32(Scaler::c_scalerVersion);
+   file.Write32(0); // flags
+
+   m_fileEndOffset = c_cacheFileHeaderSize;
+   m_isFull = false;
+
+   return true;
+}
+
+/// Sets the "full" flag in the cache file header. The records already stored
+/// can still be looked up; the file is recreated the next time it is opened.
+/// Must be called with the mutex locked.
+void ScaledTextureCache::MarkCacheFileFull()
+{
+   m_isFull = true;
+
+   Base::File file{ m_filename, Base::modeReadWrite };
+   if (!file.IsOpen())
+      return;
+
+   file.Seek(c_cacheFileFlagsOffset, Base::seekBegin);
+   file.Write32(c_cacheFileFlagFull);
+
+   UaTrace("scaled texture cache is full; recreating it on next start\n");
+}
+
+/// Returns an unused file handle for reading, or opens a new one. Records are
+/// only added to the index after they were written and their file handle was
+/// closed, so all file handles can read them.
+/// \return file handle; may not be open when the file couldn't be opened
+Base::File ScaledTextureCache::AcquireReadFile()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (!m_readFileList.empty())
+      {
+         Base::File file = m_readFileList.back();
+         m_readFileList.pop_back();
+         return file;
+      }
+   }
+
+   return Base::File{ m_filename, Base::modeRead };
+}
+
+/// Returns a file handle for reading, so that the next lookup can use it.
+/// \param file file handle to return
+void ScaledTextureCache::ReleaseReadFile(Base::File file)
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_readFileList.push_back(file);
+}
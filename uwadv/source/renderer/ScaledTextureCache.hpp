@@ -0,0 +1,150 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ScaledTextureCache.hpp
+/// \brief cache for scaled texture images
+//
+#pragma once
+
+#include "File.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+
+/// \brief cache for scaled texture images
+/// \details Stores the output of the Scaler in a file, so that the same image
+/// doesn't have to be scaled again, e.g. on the next start or level change.
+/// Cache entries are found using a hash of the unscaled RGBA image, which
+/// covers both the image's pixels and the palette used, and the image size
+/// and scale factor. Each record also stores the unscaled image, which is
+/// compared on lookup, so that hash collisions can't return wrong images.
+/// The cache file is invalidated when the Scaler version changes.
+///
+/// Lookup() and Store() can be called from multiple threads. The mutex only
+/// protects the index; the file is read using one file handle per concurrent
+/// lookup, and each record is written using its own file handle.
+///
+/// The cache file consists of a file header and a sequence of records, each
+/// consisting of a fixed size record header, the unscaled RGBA image and the
+/// scaled RGBA image. Records start at 16 byte aligned offsets. New records
+/// are always appended. When the cache file reaches its maximum size, it is
+/// marked as full and recreated the next time it is opened.
+class ScaledTextureCache
+{
+public:
+   /// default maximum size of the cache file
+   static const long c_defaultMaxFileSize = 256 * 1024 * 1024;
+
+   /// ctor; the max. file size can be lowered for tests
+   explicit ScaledTextureCache(long maxFileSize = c_defaultMaxFileSize)
+      :m_maxFileSize(maxFileSize),
+      m_isOpen(false),
+      m_isFull(false),
+      m_fileEndOffset(0)
+   {
+   }
+
+   /// opens cache file in given folder; creates it when necessary
+   void Open(const std::string& cacheFolder);
+
+   /// closes cache file
+   void Close();
+
+   /// returns if the cache file is open
+   bool IsOpen() const { return m_isOpen; }
+
+   /// looks up scaled image for given unscaled image
+   bool Lookup(const Uint32* source, unsigned int sourceWidth,
+      unsigned int sourceHeight, unsigned int scaleFactor, Uint32* dest);
+
+   /// stores scaled image for given unscaled image
+   void Store(const Uint32* source, unsigned int sourceWidth,
+      unsigned int sourceHeight, unsigned int scaleFactor, const Uint32* dest);
+
+private:
+   /// calculates hash of unscaled image, size and scale factor
+   static Uint64 CalcHash(const Uint32* source, unsigned int sourceWidth,
+      unsigned int sourceHeight, unsigned int scaleFactor);
+
+   /// returns length of a record, including padding
+   static long AlignRecordLength(long length);
+
+   /// reads all record headers and fills index
+   bool ReadIndex(Base::File& file);
+
+   /// creates new, empty cache file
+   bool CreateCacheFile();
+
+   /// marks the cache file as full, so that it is recreated on next opening
+   void MarkCacheFileFull();
+
+   /// returns a file handle for reading; opens a new one when all are in use
+   Base::File AcquireReadFile();
+
+   /// returns file handle for reading, to be used by the next lookup
+   void ReleaseReadFile(Base::File file);
+
+private:
+   /// infos about a cache entry
+   struct CacheEntry
+   {
+      /// width of unscaled image
+      Uint16 m_sourceWidth;
+
+      /// height of unscaled image
+      Uint16 m_sourceHeight;
+
+      /// scale factor
+      Uint8 m_scaleFactor;
+
+      /// file offset of the unscaled RGBA image; the scaled image follows
+      long m_sourceOffset;
+   };
+
+   /// max. size of the cache file; records that don't fit anymore aren't
+   /// stored
+   long m_maxFileSize;
+
+   /// cache filename
+   std::string m_filename;
+
+   /// indicates if the cache file is open
+   std::atomic<bool> m_isOpen;
+
+   /// indicates if the cache file was marked as full
+   bool m_isFull;
+
+   /// file handles for reading that are currently unused
+   std::vector<Base::File> m_readFileList;
+
+   /// offset of the end of the last valid or reserved record; new records
+   /// are stored here
+   long m_fileEndOffset;
+
+   /// mapping from hash to cache entry
+   std::unordered_map<Uint64, CacheEntry> m_mapHashToEntry;
+
+   /// hashes of records that are currently being written
+   std::unordered_set<Uint64> m_pendingHashes;
+
+   /// mutex protecting index, read file handles, file end offset and full flag
+   std::mutex m_mutex;
+};
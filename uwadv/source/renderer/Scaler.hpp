@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2021 Underworld Adventures Team
+// Copyright (c) 2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -26,6 +26,10 @@
 class Scaler
 {
 public:
+   /// scaler version; must be increased whenever the scaled output changes,
+   /// in order to invalidate cached scaled images
+   static const unsigned int c_scalerVersion = 1;
+
    /// Scales 32-bit RGBA bitmap using scale factor
    static void Scale(unsigned int scaleFactor, const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight);
 
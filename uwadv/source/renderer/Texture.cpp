@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2020,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2020,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 #include "Texture.hpp"
 #include "IndexedImage.hpp"
 #include "Scaler.hpp"
+#include "ScaledTextureCache.hpp"
 
 #ifndef ANDROID
 #include <gl/GLU.h> // for gluBuild2DMipmaps
@@ -33,7 +34,8 @@ Texture::Texture()
    m_yres(0),
    m_u(0.0),
    m_v(0.0),
-   m_scaleFactor(1)
+   m_scaleFactor(1),
+   m_scaledTextureCache(nullptr)
 {
 }
 
@@ -123,7 +125,10 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
          *texptr2++ = palptr[pixels[y * origx + x]];
    }
 
-   if (m_scaleFactor > 1)
+   if (m_scaleFactor > 1 &&
+      (m_scaledTextureCache == nullptr ||
+         !m_scaledTextureCache->Lookup(unscaledTexelBuffer.data(),
+            m_xres, m_yres, m_scaleFactor, texelData)))
    {
       Scaler::Scale(
          m_scaleFactor,
@@ -131,6 +136,12 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
          texelData,
          m_xres,
          m_yres);
+
+      if (m_scaledTextureCache != nullptr)
+      {
+         m_scaledTextureCache->Store(unscaledTexelBuffer.data(),
+            m_xres, m_yres, m_scaleFactor, texelData);
+      }
    }
 }
 
@@ -244,12 +255,12 @@ void Texture::Upload(unsigned int textureIndex, bool useMipmaps)
 /// \param textureIndex index of texture to return texels
 const Uint32* Texture::GetTexels(unsigned int textureIndex) const
 {
-   return &m_texels[textureIndex * m_xres * m_yres];
+   return &m_texels[textureIndex * m_xres * m_yres * m_scaleFactor * m_scaleFactor];
 }
 
 /// Returns 32-bit texture pixels in GL_RGBA format for specified texture.
 /// \param textureIndex index of texture to return texels
 Uint32* Texture::GetTexels(unsigned int textureIndex)
 {
-   return &m_texels[textureIndex * m_xres * m_yres];
+   return &m_texels[textureIndex * m_xres * m_yres * m_scaleFactor * m_scaleFactor];
 }
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2020,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2020,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -31,6 +31,7 @@
 
 class IndexedImage;
 class Palette256;
+class ScaledTextureCache;
 
 /// \brief texture class; represents one or more texture images
 /// The Texture class can be used to store and upload textures to OpenGL.
@@ -64,6 +65,12 @@ public:
    /// loads texture from (seekable) rwops stream
    void Load(Base::SDL_RWopsPtr rwops);
 
+   /// sets cache to use for scaled texture images; may be nullptr
+   void SetScaledTextureCache(ScaledTextureCache* scaledTextureCache)
+   {
+      m_scaledTextureCache = scaledTextureCache;
+   }
+
 
    // texture usage
 
@@ -130,6 +137,9 @@ private:
    /// scale factor when scaling texture pixels; value values are 1, 2, 3 and 4
    unsigned int m_scaleFactor;
 
+   /// cache for scaled texture images; may be nullptr
+   ScaledTextureCache* m_scaledTextureCache;
+
    friend class TextureManager;
    friend class Critter;
 };
@@ -0,0 +1,310 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureAtlas.cpp
+/// \brief texture atlas implementation
+//
+#include "pch.hpp"
+#include "TextureAtlas.hpp"
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+TextureAtlas::TextureAtlas()
+   :m_textureName(0),
+   m_atlasSize(0),
+   m_cellSize(0),
+   m_gutterSize(0),
+   m_cellsPerRow(0),
+   m_numCells(0),
+   m_indexed(false)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+   Done();
+}
+
+/// Initializes the atlas for a number of cells. The atlas texture is square
+/// and has a size of 2^n texels; it grows until all cells fit, or the
+/// maximum atlas size is reached. The gutter around the cells is 1/8 of the
+/// cell size, which limits the number of mipmap levels that can be used
+/// without bleeding neighbour cells into each other.
+/// \param numCells number of cells to allocate
+/// \param cellSize size of a cell in texels; must be 2^n and at least 16
+/// \param maxAtlasSize maximum size of atlas texture, in texels
+/// \param indexed when true, the atlas stores 8-bit palette indices
+/// \return number of cells that fit into the atlas; may be less than
+/// numCells
+unsigned int TextureAtlas::Init(unsigned int numCells, unsigned int cellSize,
+   unsigned int maxAtlasSize, bool indexed)
+{
+   Done();
+
+   m_indexed = indexed;
+
+   UaAssert(cellSize >= 16 && (cellSize & (cellSize - 1)) == 0);
+
+   m_cellSize = cellSize;
+   m_gutterSize = cellSize / 8;
+
+   unsigned int cellStride = m_cellSize + 2 * m_gutterSize;
+
+   m_atlasSize = 16;
+   while (m_atlasSize < maxAtlasSize &&
+      (m_atlasSize / cellStride) * (m_atlasSize / cellStride) < numCells)
+      m_atlasSize <<= 1;
+
+   m_cellsPerRow = m_atlasSize / cellStride;
+   m_numCells = std::min(numCells, m_cellsPerRow * m_cellsPerRow);
+
+   if (m_numCells == 0)
+      return 0;
+
+   if (m_indexed)
+      m_indices.resize(m_atlasSize * m_atlasSize, 0);
+   else
+      m_texels.resize(m_atlasSize * m_atlasSize, 0x00000000);
+
+   glGenTextures(1, &m_textureName);
+
+   return m_numCells;
+}
+
+/// Frees atlas texels and OpenGL texture name.
+void TextureAtlas::Done()
+{
+   m_texels.clear();
+   m_indices.clear();
+
+   if (m_textureName != 0)
+      glDeleteTextures(1, &m_textureName);
+
+   m_textureName = 0;
+   m_numCells = 0;
+}
+
+/// Copies texels into a cell, including the gutter.
+/// \param cellIndex index of cell to set
+/// \param texels texels of the texture
+/// \param textureSize x and y resolution of texture
+/// \param destTexels atlas texels to copy to
+template <typename T>
+void TextureAtlas::CopyCell(unsigned int cellIndex, const T* texels,
+   unsigned int textureSize, std::vector<T>& destTexels) const
+{
+   UaAssert(cellIndex < m_numCells);
+   UaAssert(textureSize > 0 && textureSize <= m_cellSize);
+
+   unsigned int xpos = 0, ypos = 0;
+   GetCellPosition(cellIndex, xpos, ypos);
+
+   unsigned int cellStride = m_cellSize + 2 * m_gutterSize;
+   unsigned int enlargeShift = 0;
+   while ((textureSize << enlargeShift) < m_cellSize)
+      enlargeShift++;
+
+   for (unsigned int y = 0; y < cellStride; y++)
+   {
+      // wrap around gutter coordinates into the cell
+      unsigned int sourceY = ((y + m_cellSize - m_gutterSize) % m_cellSize) >> enlargeShift;
+
+      const T* sourceLine = texels + sourceY * textureSize;
+      T* destLine = &destTexels[(ypos + y) * m_atlasSize + xpos];
+
+      for (unsigned int x = 0; x < cellStride; x++)
+      {
+         unsigned int sourceX = ((x + m_cellSize - m_gutterSize) % m_cellSize) >> enlargeShift;
+         destLine[x] = sourceLine[sourceX];
+      }
+   }
+}
+
+/// Copies texels of a square texture into a cell. Textures smaller than the
+/// cell size are enlarged, using the nearest texel. The gutter is filled with
+/// the texels that would be visible when the texture was repeated.
+/// \param cellIndex index of cell to set
+/// \param texels 32-bit texels in GL_RGBA format
+/// \param textureSize x and y resolution of texture; must be 2^n and not
+/// larger than the cell size
+void TextureAtlas::SetCell(unsigned int cellIndex, const Uint32* texels,
+   unsigned int textureSize)
+{
+   UaAssert(!m_indexed);
+   CopyCell(cellIndex, texels, textureSize, m_texels);
+}
+
+/// Copies palette indices of a square texture into a cell of an indexed
+/// atlas, the same way as the 32-bit texels variant.
+/// \param cellIndex index of cell to set
+/// \param pixels 8-bit palette indices
+/// \param textureSize x and y resolution of texture; must be 2^n and not
+/// larger than the cell size
+void TextureAtlas::SetCell(unsigned int cellIndex, const Uint8* pixels,
+   unsigned int textureSize)
+{
+   UaAssert(m_indexed);
+   CopyCell(cellIndex, pixels, textureSize, m_indices);
+}
+
+/// Uploads the atlas texture. Mipmaps are generated by OpenGL, and the number
+/// of mipmap levels is limited so that the gutter still separates the cells
+/// on the smallest mipmap level. An indexed atlas is uploaded without
+/// mipmaps and uses nearest filtering.
+void TextureAtlas::Upload()
+{
+   Use();
+
+   GLint maxLevel = 0;
+   while ((m_gutterSize >> (maxLevel + 1)) > 0)
+      maxLevel++;
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   if (m_indexed)
+   {
+      // palette indices can't be filtered
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+      glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+      glTexImage2D(
+         GL_TEXTURE_2D,
+         0,
+         GL_LUMINANCE8,
+         m_atlasSize,
+         m_atlasSize,
+         0,
+         GL_LUMINANCE,
+         GL_UNSIGNED_BYTE,
+         m_indices.data());
+
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+   }
+   else
+   {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+      glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+      glTexImage2D(
+         GL_TEXTURE_2D,
+         0,
+         GL_RGBA,
+         m_atlasSize,
+         m_atlasSize,
+         0,
+         GL_RGBA,
+         GL_UNSIGNED_BYTE,
+         m_texels.data());
+   }
+
+   // check for errors
+   GLenum error = glGetError();
+   if (error != GL_NO_ERROR)
+      UaTrace("TextureAtlas: error during uploading texture! (%u)\n", error);
+}
+
+/// Uploads a single cell, including its gutter. Mipmap levels are
+/// regenerated by OpenGL, when used.
+/// \param cellIndex index of cell to upload
+void TextureAtlas::UploadCell(unsigned int cellIndex)
+{
+   UaAssert(cellIndex < m_numCells);
+
+   unsigned int xpos = 0, ypos = 0;
+   GetCellPosition(cellIndex, xpos, ypos);
+
+   unsigned int cellStride = m_cellSize + 2 * m_gutterSize;
+
+   Use();
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, m_atlasSize);
+
+   if (m_indexed)
+   {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+      glTexSubImage2D(
+         GL_TEXTURE_2D,
+         0,
+         xpos,
+         ypos,
+         cellStride,
+         cellStride,
+         GL_LUMINANCE,
+         GL_UNSIGNED_BYTE,
+         &m_indices[ypos * m_atlasSize + xpos]);
+
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+   }
+   else
+   {
+      glTexSubImage2D(
+         GL_TEXTURE_2D,
+         0,
+         xpos,
+         ypos,
+         cellStride,
+         cellStride,
+         GL_RGBA,
+         GL_UNSIGNED_BYTE,
+         &m_texels[ypos * m_atlasSize + xpos]);
+   }
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+/// Uses the atlas texture in OpenGL.
+void TextureAtlas::Use() const
+{
+   glBindTexture(GL_TEXTURE_2D, m_textureName);
+}
+
+/// Maps texture coordinates of a texture in a cell to atlas texture
+/// coordinates.
+/// \param cellIndex index of cell
+/// \param u u texture coordinate; must be in the range [0; 1]
+/// \param v v texture coordinate; must be in the range [0; 1]
+void TextureAtlas::MapTexCoords(unsigned int cellIndex, double& u, double& v) const
+{
+   unsigned int xpos = 0, ypos = 0;
+   GetCellPosition(cellIndex, xpos, ypos);
+
+   u = (xpos + m_gutterSize + u * m_cellSize) / m_atlasSize;
+   v = (ypos + m_gutterSize + v * m_cellSize) / m_atlasSize;
+}
+
+/// Returns the upper left texel position of the cell, including the gutter.
+/// \param cellIndex index of cell
+/// \param xpos x texel position of the cell
+/// \param ypos y texel position of the cell
+void TextureAtlas::GetCellPosition(unsigned int cellIndex,
+   unsigned int& xpos, unsigned int& ypos) const
+{
+   unsigned int cellStride = m_cellSize + 2 * m_gutterSize;
+
+   xpos = (cellIndex % m_cellsPerRow) * cellStride;
+   ypos = (cellIndex / m_cellsPerRow) * cellStride;
+}
@@ -0,0 +1,119 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureAtlas.hpp
+/// \brief texture atlas class
+//
+#pragma once
+
+#include <SDL2/SDL_opengl.h>
+#include <vector>
+
+/// \brief texture atlas; packs multiple square textures into one texture
+/// \details All textures are stored in equally sized square cells. Each cell
+/// is surrounded by a gutter that contains the wrapped around texels of the
+/// cell, so that texture filtering and mipmapping at the cell borders behaves
+/// as if the texture was used with GL_REPEAT. Texture coordinates have to be
+/// in the range [0; 1] and are mapped to the cell with MapTexCoords().
+/// Geometry with texture coordinates outside this range has to be split up
+/// first. An indexed atlas stores 8-bit palette indices instead of 32-bit
+/// texels; it has to be rendered using the PaletteShader, and doesn't use
+/// texture filtering and mipmaps.
+class TextureAtlas
+{
+public:
+   /// ctor
+   TextureAtlas();
+   /// dtor
+   ~TextureAtlas();
+   /// deleted copy ctor
+   TextureAtlas(const TextureAtlas&) = delete;
+   /// deleted assignment operator
+   TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+   /// initializes atlas; returns number of cells that fit into the atlas
+   unsigned int Init(unsigned int numCells, unsigned int cellSize,
+      unsigned int maxAtlasSize, bool indexed = false);
+
+   /// cleans up texture name and texels
+   void Done();
+
+   /// returns if the atlas is initialized and contains cells
+   bool IsAvailable() const { return m_textureName != 0; }
+
+   /// returns number of cells in the atlas
+   unsigned int GetNumCells() const { return m_numCells; }
+
+   /// returns if the atlas stores 8-bit palette indices
+   bool IsIndexed() const { return m_indexed; }
+
+   /// copies 32-bit texels of a square texture into a cell
+   void SetCell(unsigned int cellIndex, const Uint32* texels, unsigned int textureSize);
+
+   /// copies 8-bit palette indices of a square texture into a cell
+   void SetCell(unsigned int cellIndex, const Uint8* pixels, unsigned int textureSize);
+
+   /// uploads the whole atlas to OpenGL
+   void Upload();
+
+   /// uploads a single cell to OpenGL, e.g. for animated textures
+   void UploadCell(unsigned int cellIndex);
+
+   /// uses atlas texture in OpenGL
+   void Use() const;
+
+   /// maps texture coordinates in the range [0; 1] to atlas coordinates
+   void MapTexCoords(unsigned int cellIndex, double& u, double& v) const;
+
+private:
+   /// returns cell position of given cell, including the gutter
+   void GetCellPosition(unsigned int cellIndex, unsigned int& xpos, unsigned int& ypos) const;
+
+   /// copies texels of a square texture into a cell of the destination texels
+   template <typename T>
+   void CopyCell(unsigned int cellIndex, const T* texels, unsigned int textureSize,
+      std::vector<T>& destTexels) const;
+
+private:
+   /// texture name
+   GLuint m_textureName;
+
+   /// size of atlas texture, in texels
+   unsigned int m_atlasSize;
+
+   /// size of a single cell, in texels, without the gutter
+   unsigned int m_cellSize;
+
+   /// size of gutter on every side of a cell, in texels
+   unsigned int m_gutterSize;
+
+   /// number of cells in a row
+   unsigned int m_cellsPerRow;
+
+   /// number of cells in the atlas
+   unsigned int m_numCells;
+
+   /// indicates if the atlas stores 8-bit palette indices
+   bool m_indexed;
+
+   /// atlas texels; used when not indexed
+   std::vector<Uint32> m_texels;
+
+   /// atlas palette indices; used when indexed
+   std::vector<Uint8> m_indices;
+};
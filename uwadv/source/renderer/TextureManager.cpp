@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2020,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2020,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,11 +25,24 @@
 #include "GameInterface.hpp"
 #include "TextureLoader.hpp"
 #include "ImageManager.hpp"
+#include "OpenGL.hpp"
+#include "ResourceManager.hpp"
+#include "FileSystem.hpp"
+#include <algorithm>
 
 const double TextureManager::s_animationFramesPerSecond = 1.5;
 
+/// maximum size of the texture atlas texture, in texels
+const unsigned int c_maxTextureAtlasSize = 4096;
+
+/// value for m_uploadedPaletteFrame when no palette was uploaded yet
+const unsigned int c_noPaletteFrame = 0xffffffff;
+
 TextureManager::TextureManager()
-   :m_animationCount(0.0)
+   :m_animationCount(0.0),
+   m_animationFrame(0),
+   m_usePaletteShader(false),
+   m_uploadedPaletteFrame(c_noPaletteFrame)
 {
 }
 
@@ -128,6 +141,18 @@ void TextureManager::Init(IGameInstance& game)
    // now that all texture images are loaded, we can resize the texture array
    m_stockTextures.resize(m_allStockTextureImages.size());
 
+   // scaled stock textures are cached in the home folder; the cache is
+   // opened when textures are first prepared with a scale factor
+   m_scaledTextureCacheFolder = game.GetResourceManager().GetHomePath() +
+      "cache" + Base::FileSystem::PathSeparator;
+
+   for (Texture& texture : m_stockTextures)
+      texture.SetScaledTextureCache(&m_scaledTextureCache);
+
+   // the palette shader is only used for unscaled textures
+   m_usePaletteShader = settings.GetBool(Base::settingPaletteShader) &&
+      m_paletteShader.Init();
+
    // init stock texture objects
    Reset();
 }
@@ -142,6 +167,8 @@ void TextureManager::Tick(double tickRate)
    {
       m_animationCount -= 1.0 / s_animationFramesPerSecond;
 
+      m_animationFrame++;
+
       // next animation frame
       size_t max = m_stockTextureAnimationInfos.size();
       for (size_t index = 0; index < max; index++)
@@ -168,6 +195,10 @@ void TextureManager::Reset()
    for (size_t index = 0; index < max; index++)
       m_stockTextures[index].Done();
 
+   m_atlas.Done();
+   m_mapAtlasCells.clear();
+   m_atlasAnimatedTextures.clear();
+
    m_lastTextureName = 0;
 }
 
@@ -176,32 +207,117 @@ void TextureManager::Reset()
 /// \param scaleFactor scale factor for stock texture; valid values are 1, 2,
 /// 3 and 4
 void TextureManager::Prepare(unsigned int index, unsigned int scaleFactor)
+{
+   OpenScaledTextureCache(scaleFactor);
+
+   if (!InitStockTexture(index, scaleFactor))
+      return;
+
+   ConvertStockTexture(index);
+   UploadStockTexture(index);
+}
+
+/// Prepares multiple stock textures for use in OpenGL. Converting the images,
+/// including scaling them, is done in parallel on worker threads; only
+/// allocating texture names and uploading is done on the calling thread that
+/// owns the OpenGL context. The time used for each stage is traced.
+/// \param allIndices indices of stock textures to prepare; may contain
+/// duplicates
+/// \param scaleFactor scale factor for stock textures; valid values are 1,
+/// 2, 3 and 4
+void TextureManager::Prepare(const std::vector<unsigned int>& allIndices,
+   unsigned int scaleFactor)
+{
+   Uint64 startCounter = SDL_GetPerformanceCounter();
+
+   OpenScaledTextureCache(scaleFactor);
+
+   std::vector<unsigned int> preparedIndices{ allIndices };
+   std::sort(preparedIndices.begin(), preparedIndices.end());
+   preparedIndices.erase(
+      std::unique(preparedIndices.begin(), preparedIndices.end()),
+      preparedIndices.end());
+
+   preparedIndices.erase(
+      std::remove_if(preparedIndices.begin(), preparedIndices.end(),
+         [&](unsigned int index) { return !InitStockTexture(index, scaleFactor); }),
+      preparedIndices.end());
+
+   Uint64 initCounter = SDL_GetPerformanceCounter();
+
+   m_workerPool.Run(preparedIndices.size(),
+      [&](size_t item) { ConvertStockTexture(preparedIndices[item]); });
+
+   Uint64 convertCounter = SDL_GetPerformanceCounter();
+
+   for (unsigned int index : preparedIndices)
+      UploadStockTexture(index);
+
+   Uint64 uploadCounter = SDL_GetPerformanceCounter();
+
+   double msecPerCount = 1000.0 / SDL_GetPerformanceFrequency();
+   UaTrace("prepared %u textures: init %.1f ms, convert %.1f ms (%u threads), upload %.1f ms... ",
+      static_cast<unsigned int>(preparedIndices.size()),
+      (initCounter - startCounter) * msecPerCount,
+      (convertCounter - initCounter) * msecPerCount,
+      m_workerPool.GetNumThreads() + 1,
+      (uploadCounter - convertCounter) * msecPerCount);
+}
+
+/// Opens the scaled texture cache when textures are scaled, and it wasn't
+/// opened before. The cache file isn't created when scaling is turned off.
+/// \param scaleFactor scale factor for stock textures
+void TextureManager::OpenScaledTextureCache(unsigned int scaleFactor)
+{
+   if (scaleFactor <= 1 || m_scaledTextureCacheFolder.empty())
+      return;
+
+   m_scaledTextureCache.Open(m_scaledTextureCacheFolder);
+
+   // only try once, even when opening failed
+   m_scaledTextureCacheFolder.clear();
+}
+
+/// Initializes a stock texture and allocates its OpenGL texture names. Must
+/// be called on the thread owning the OpenGL context.
+/// \param index index of stock texture to initialize
+/// \param scaleFactor scale factor for stock texture
+/// \return true when the stock texture is available and was initialized
+bool TextureManager::InitStockTexture(unsigned int index, unsigned int scaleFactor)
 {
    if (index >= m_allStockTextureImages.size())
-      return; // not a valid index
+      return false; // not a valid index
 
    // image must not be empty, or the game data doesn't match the graphics
    UaAssert(!m_allStockTextureImages[index].GetPixels().empty());
 
    unsigned int maxPaletteIndex = m_stockTextureAnimationInfos[index].second;
    if (maxPaletteIndex < 1)
-      return; // not an available texture
+      return false; // not an available texture
 
    m_stockTextures[index].Init(maxPaletteIndex, scaleFactor);
+   return true;
+}
+
+/// Converts the image of a stock texture to texels, for all animation frames.
+/// Doesn't use OpenGL, so different stock textures can be converted in
+/// parallel.
+/// \param index index of stock texture to convert
+void TextureManager::ConvertStockTexture(unsigned int index)
+{
+   unsigned int maxPaletteIndex = m_stockTextureAnimationInfos[index].second;
 
    if (maxPaletteIndex == 1)
    {
-      // only allow mipmaps for non-object images
-      bool mipmap = (index < Base::c_stockTexturesObjects) || (index > Base::c_stockTexturesObjects + 0x0200);
-
       // unanimated texture
       // convert to texture object
       m_stockTextures[index].Convert(m_allStockTextureImages[index], 0);
-      m_stockTextures[index].Upload(0, mipmap); // upload texture with mipmaps
    }
    else
    {
-      Palette256& pal = *m_palette0;
+      // rotate a copy of the palette, since other textures may be converted
+      // at the same time
+      Palette256 pal{ *m_palette0 };
 
       unsigned int xres = m_allStockTextureImages[index].GetXRes();
       unsigned int yres = m_allStockTextureImages[index].GetXRes();
@@ -214,7 +330,6 @@ void TextureManager::Prepare(unsigned int index, unsigned int scaleFactor)
          for (unsigned int i = 0; i < 8; i++)
          {
             m_stockTextures[index].Convert(pixels, xres, yres, pal, i);
-            m_stockTextures[index].Upload(i, true); // upload texture with mipmaps
 
             // rotate entries
             pal.Rotate(16, 8, false);
@@ -226,7 +341,6 @@ void TextureManager::Prepare(unsigned int index, unsigned int scaleFactor)
          for (unsigned int i = 0; i < 4; i++)
          {
             m_stockTextures[index].Convert(pixels, xres, yres, pal, i);
-            m_stockTextures[index].Upload(i, true); // upload texture with mipmaps
 
             // rotate entries
             pal.Rotate(48, 4, true);
@@ -235,6 +349,37 @@ void TextureManager::Prepare(unsigned int index, unsigned int scaleFactor)
    }
 }
 
+/// Uploads all animation frames of a converted stock texture. Must be called
+/// on the thread owning the OpenGL context.
+/// \param index index of stock texture to upload
+void TextureManager::UploadStockTexture(unsigned int index)
+{
+   unsigned int maxPaletteIndex = m_stockTextureAnimationInfos[index].second;
+
+   if (maxPaletteIndex == 1)
+   {
+      // only allow mipmaps for non-object images
+      bool mipmap = (index < Base::c_stockTexturesObjects) || (index > Base::c_stockTexturesObjects + 0x0200);
+
+      m_stockTextures[index].Upload(0, mipmap); // upload texture with mipmaps
+   }
+   else if (maxPaletteIndex == 8 || maxPaletteIndex == 4)
+   {
+      // animated texture; upload all frames with mipmaps
+      for (unsigned int i = 0; i < maxPaletteIndex; i++)
+         m_stockTextures[index].Upload(i, true);
+   }
+}
+
+/// Returns if a stock texture was already prepared with Prepare(), since the
+/// last call to Reset().
+/// \param index index of stock texture
+bool TextureManager::IsPrepared(unsigned int index) const
+{
+   return index < m_stockTextures.size() &&
+      !m_stockTextures[index].m_texels.empty();
+}
+
 /// Uses a stock texture.
 /// \param index index of stock texture to use
 void TextureManager::Use(unsigned int index)
@@ -245,6 +390,170 @@ void TextureManager::Use(unsigned int index)
    m_stockTextures[index].Use(m_stockTextureAnimationInfos[index].first);
 }
 
+/// Packs stock textures into the texture atlas. The textures must already be
+/// prepared with Prepare(). Only square textures are packed; all cells have
+/// the size of the largest texture. When not all textures fit into the
+/// atlas, the remaining textures must be used separately with Use().
+/// When the palette shader is available and the textures aren't scaled, the
+/// atlas stores the 8-bit palette indices of the texture images, and
+/// animated textures are animated by uploading a rotated palette.
+/// \param allTextureIds stock texture indices to pack into the atlas
+void TextureManager::PrepareAtlas(const std::vector<unsigned int>& allTextureIds)
+{
+   m_atlas.Done();
+   m_mapAtlasCells.clear();
+   m_atlasAnimatedTextures.clear();
+
+   std::vector<unsigned int> atlasTextureIds;
+   unsigned int cellSize = 16;
+   bool indexed = m_usePaletteShader;
+
+   for (unsigned int index : allTextureIds)
+   {
+      if (index >= m_stockTextures.size())
+         continue;
+
+      const Texture& texture = m_stockTextures[index];
+      if (texture.m_texels.empty() || texture.GetXRes() != texture.GetYRes())
+         continue; // not prepared, or not square
+
+      // scaled textures only exist as RGBA texels, and the image must have
+      // the size of the texture
+      const IndexedImage& image = m_allStockTextureImages[index];
+      if (texture.m_scaleFactor != 1 ||
+         image.GetXRes() != texture.GetXRes() ||
+         image.GetYRes() != texture.GetYRes())
+         indexed = false;
+
+      atlasTextureIds.push_back(index);
+      cellSize = std::max(cellSize, texture.GetXRes());
+   }
+
+   unsigned int maxAtlasSize = std::min(OpenGL::GetMaxTextureSize(), c_maxTextureAtlasSize);
+
+   unsigned int numCells = m_atlas.Init(
+      static_cast<unsigned int>(atlasTextureIds.size()),
+      cellSize,
+      maxAtlasSize,
+      indexed);
+
+   for (unsigned int cellIndex = 0; cellIndex < numCells; cellIndex++)
+   {
+      unsigned int index = atlasTextureIds[cellIndex];
+      const Texture& texture = m_stockTextures[index];
+
+      m_mapAtlasCells[index] = cellIndex;
+
+      if (indexed)
+      {
+         m_atlas.SetCell(cellIndex,
+            m_allStockTextureImages[index].GetPixels().data(), texture.GetXRes());
+         continue;
+      }
+
+      unsigned int frame = m_stockTextureAnimationInfos[index].first;
+      m_atlas.SetCell(cellIndex, texture.GetTexels(frame), texture.GetXRes());
+
+      if (m_stockTextureAnimationInfos[index].second > 1)
+         m_atlasAnimatedTextures.push_back(std::make_pair(index, frame));
+   }
+
+   if (numCells > 0)
+      m_atlas.Upload();
+
+   m_uploadedPaletteFrame = c_noPaletteFrame;
+
+   UaTrace("packed %u of %zu textures into %s texture atlas\n",
+      numCells, atlasTextureIds.size(), indexed ? "indexed" : "RGBA");
+}
+
+/// Returns if a stock texture was packed into the texture atlas by
+/// PrepareAtlas().
+/// \param index stock texture index
+bool TextureManager::IsInAtlas(unsigned int index) const
+{
+   return m_mapAtlasCells.find(index) != m_mapAtlasCells.end();
+}
+
+/// Maps texture coordinates of a stock texture to texture coordinates in the
+/// texture atlas.
+/// \param index stock texture index; must be packed into the atlas
+/// \param u u texture coordinate; must be in the range [0; 1]
+/// \param v v texture coordinate; must be in the range [0; 1]
+void TextureManager::MapAtlasTexCoords(unsigned int index, double& u, double& v) const
+{
+   auto iter = m_mapAtlasCells.find(index);
+   UaAssert(iter != m_mapAtlasCells.end());
+
+   if (iter != m_mapAtlasCells.end())
+      m_atlas.MapTexCoords(iter->second, u, v);
+}
+
+/// Uses the texture atlas. Animated textures whose animation frame changed
+/// since the last call are updated in the atlas first. An indexed atlas is
+/// used together with the palette shader, and only the palette is uploaded
+/// when the animation frame changed.
+void TextureManager::UseAtlas()
+{
+   if (m_atlas.IsIndexed())
+   {
+      if (m_uploadedPaletteFrame != m_animationFrame)
+         UploadAnimatedPalette();
+
+      m_atlas.Use();
+      m_paletteShader.Use();
+      return;
+   }
+
+   for (std::pair<unsigned int, unsigned int>& animatedTexture : m_atlasAnimatedTextures)
+   {
+      unsigned int index = animatedTexture.first;
+      unsigned int frame = m_stockTextureAnimationInfos[index].first;
+
+      if (animatedTexture.second == frame)
+         continue;
+
+      animatedTexture.second = frame;
+
+      const Texture& texture = m_stockTextures[index];
+      unsigned int cellIndex = m_mapAtlasCells[index];
+
+      m_atlas.SetCell(cellIndex, texture.GetTexels(frame), texture.GetXRes());
+      m_atlas.UploadCell(cellIndex);
+   }
+
+   m_atlas.Use();
+}
+
+/// Stops using the texture atlas, switching back to fixed function rendering
+/// when the palette shader was used.
+void TextureManager::UnuseAtlas()
+{
+   if (m_atlas.IsIndexed())
+      m_paletteShader.Unuse();
+}
+
+/// Uploads palette 0 to the palette shader, rotated the same way as the
+/// animation frames of animated textures are converted in
+/// ConvertStockTexture(). Note that this animates all texels using the
+/// rotated palette entries, not only the texels of animated textures.
+void TextureManager::UploadAnimatedPalette()
+{
+   Palette256 pal{ *m_palette0 };
+
+   // lava: indices 16 through 23
+   for (unsigned int i = 0; i < m_animationFrame % 8; i++)
+      pal.Rotate(16, 8, false);
+
+   // water: indices 48 through 51
+   for (unsigned int i = 0; i < m_animationFrame % 4; i++)
+      pal.Rotate(48, 4, true);
+
+   m_paletteShader.UploadPalette(pal.Get());
+
+   m_uploadedPaletteFrame = m_animationFrame;
+}
+
 /// Uses a new texture name. Returns false when the texture is already in use.
 /// \param new_texname new texture name to use
 bool TextureManager::UsingNewTextureName(GLuint new_texname)
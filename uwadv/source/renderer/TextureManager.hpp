@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2020,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2020,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,8 +22,13 @@
 #pragma once
 
 #include <vector>
+#include <map>
 #include "Texture.hpp"
+#include "TextureAtlas.hpp"
+#include "ScaledTextureCache.hpp"
+#include "PaletteShader.hpp"
 #include "IndexedImage.hpp"
+#include "WorkerPool.hpp"
 
 class IGameInstance;
 
@@ -52,18 +57,58 @@ public:
    /// prepares a stock texture for usage in OpenGL
    void Prepare(unsigned int index, unsigned int scaleFactor);
 
+   /// prepares multiple stock textures for usage in OpenGL
+   void Prepare(const std::vector<unsigned int>& allIndices, unsigned int scaleFactor);
+
+   /// returns if a stock texture was already prepared
+   bool IsPrepared(unsigned int index) const;
+
    /// use a stock texture in OpenGL
    void Use(unsigned int index);
 
+   /// packs already prepared stock textures into the texture atlas
+   void PrepareAtlas(const std::vector<unsigned int>& allTextureIds);
+
+   /// returns if a stock texture was packed into the texture atlas
+   bool IsInAtlas(unsigned int index) const;
+
+   /// maps texture coordinates of a stock texture to the texture atlas
+   void MapAtlasTexCoords(unsigned int index, double& u, double& v) const;
+
+   /// uses the texture atlas in OpenGL
+   void UseAtlas();
+
+   /// stops using the texture atlas; must be called after rendering with it
+   void UnuseAtlas();
+
    /// should be called when a new texname is about to be used
    bool UsingNewTextureName(GLuint newTextureName);
 
    /// converts stock texture to external one
    void MapStockToExternalTexture(unsigned int index, Texture& texture);
 
+   /// returns worker threads, e.g. for other work when preparing a level
+   Base::WorkerPool& GetWorkerPool() { return m_workerPool; }
+
    /// sets new OpenGL color from palette 0
    void GetPaletteColor(Uint8 paletteIndex, Uint8& red, Uint8& green, Uint8& blue);
 
+protected:
+   /// opens scaled texture cache when textures are scaled
+   void OpenScaledTextureCache(unsigned int scaleFactor);
+
+   /// initializes stock texture and allocates texture names
+   bool InitStockTexture(unsigned int index, unsigned int scaleFactor);
+
+   /// converts stock texture image to texels
+   void ConvertStockTexture(unsigned int index);
+
+   /// uploads converted stock texture to OpenGL
+   void UploadStockTexture(unsigned int index);
+
+   /// uploads palette 0, rotated for the current animation frame
+   void UploadAnimatedPalette();
+
 protected:
    /// frames per second for animated textures
    static const double s_animationFramesPerSecond;
@@ -85,4 +130,36 @@ protected:
 
    /// time counter for animated textures
    double m_animationCount;
+
+   /// animation frame counter, used for palette animation
+   unsigned int m_animationFrame;
+
+   /// indicates if the palette shader should be used for the texture atlas
+   bool m_usePaletteShader;
+
+   /// palette lookup shader for an indexed texture atlas
+   PaletteShader m_paletteShader;
+
+   /// animation frame of the palette that was last uploaded to the palette
+   /// shader
+   unsigned int m_uploadedPaletteFrame;
+
+   /// texture atlas for stock textures
+   TextureAtlas m_atlas;
+
+   /// mapping from stock texture index to texture atlas cell
+   std::map<unsigned int, unsigned int> m_mapAtlasCells;
+
+   /// animated stock textures in the atlas, and the texture frame currently
+   /// stored in the atlas
+   std::vector<std::pair<unsigned int, unsigned int>> m_atlasAnimatedTextures;
+
+   /// cache for scaled stock textures
+   ScaledTextureCache m_scaledTextureCache;
+
+   /// folder of the scaled texture cache; empty when the cache was opened
+   std::string m_scaledTextureCacheFolder;
+
+   /// worker threads for converting stock textures
+   Base::WorkerPool m_workerPool;
 };
@@ -0,0 +1,822 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TilePvs.cpp
+/// \brief potentially visible set of tiles
+//
+#include "pch.hpp"
+#include "TilePvs.hpp"
+#include "Math.hpp"
+#include "WorkerPool.hpp"
+#include <cmath>
+#include <array>
+#include <bitset>
+#include <vector>
+#include <algorithm>
+
+/// number of rays cast from each ray origin, evenly distributed over 360 degrees
+const unsigned int c_numRaysPerOrigin = 256;
+
+/// ray directions, calculated once
+struct RayDirections
+{
+   /// ctor; calculates all directions
+   RayDirections()
+   {
+      for (unsigned int rayIndex = 0; rayIndex < c_numRaysPerOrigin; rayIndex++)
+      {
+         double angle = 2.0 * c_pi * rayIndex / c_numRaysPerOrigin;
+         m_dirs[rayIndex][0] = cos(angle);
+         m_dirs[rayIndex][1] = sin(angle);
+      }
+   }
+
+   /// x and y components of all directions
+   std::array<std::array<double, 2>, c_numRaysPerOrigin> m_dirs;
+};
+
+/// ray origins inside a tile, relative to the tile's lower left corner
+const double c_rayOrigins[][2] =
+{
+   { 0.5, 0.5 },
+   { 0.1, 0.1 }, { 0.9, 0.1 }, { 0.1, 0.9 }, { 0.9, 0.9 },
+};
+
+/// Openings are widened by this amount at tile corners touching a solid part,
+/// so that the line of sight test also finds lines only touching the solid
+/// part
+const double c_lineOfSightEpsilon = 1e-5;
+
+/// \brief set of lines v = m * u + c
+/// \details The set is stored as convex polygon in the (m, c) plane. Only
+/// lines with slopes 0 <= m <= 1 are stored; all other lines are covered by
+/// mirroring the tile grid and swapping its axes. With these slopes, crossing
+/// a tile edge only puts linear constraints on m and c.
+class LineSet
+{
+public:
+   /// ctor; starts with all lines that can cross the tile grid
+   LineSet()
+      :m_numPoints(4)
+   {
+      const double maxOffset = 256.0;
+      m_points[0] = { 0.0, -maxOffset };
+      m_points[1] = { 1.0, -maxOffset };
+      m_points[2] = { 1.0, maxOffset };
+      m_points[3] = { 0.0, maxOffset };
+   }
+
+   /// copy ctor; only copies the used polygon points
+   LineSet(const LineSet& lines)
+      :m_numPoints(lines.m_numPoints)
+   {
+      std::copy(lines.m_points.begin(), lines.m_points.begin() + m_numPoints,
+         m_points.begin());
+   }
+
+   /// returns if the set contains no more lines; sets that shrank to less
+   /// than a line through an opening of c_lineOfSightEpsilon count as empty
+   bool IsEmpty() const
+   {
+      const double minArea = 1e-14;
+
+      // area relative to the first point, to keep rounding errors small
+      double area = 0.0;
+      for (size_t index = 2; index < m_numPoints; index++)
+         area +=
+            (m_points[index - 1][0] - m_points[0][0]) * (m_points[index][1] - m_points[0][1]) -
+            (m_points[index][0] - m_points[0][0]) * (m_points[index - 1][1] - m_points[0][1]);
+
+      return area < 2.0 * minArea;
+   }
+
+   /// keeps all lines crossing the tile at given position
+   void ClipCrossingTile(double posU, double posV)
+   {
+      // m * posU + c <= posV + 1 and m * (posU + 1) + c >= posV
+      Clip(posU, 1.0, posV + 1.0);
+      Clip(-(posU + 1.0), -1.0, -posV);
+   }
+
+   /// returns if all lines cross the edge u = posU, between minV and maxV
+   bool AllCrossingEdgeU(double posU, double minV, double maxV) const
+   {
+      return IsInRange(posU, 1.0, minV, maxV);
+   }
+
+   /// returns if all lines cross the edge v = posV, between minU and maxU
+   bool AllCrossingEdgeV(double posV, double minU, double maxU) const
+   {
+      return IsInRange(minU, 1.0, -HUGE_VAL, posV) && IsInRange(maxU, 1.0, posV, HUGE_VAL);
+   }
+
+   /// keeps all lines crossing the edge u = posU, between minV and maxV
+   void ClipCrossingEdgeU(double posU, double minV, double maxV)
+   {
+      // minV <= m * posU + c <= maxV
+      Clip(posU, 1.0, maxV);
+      Clip(-posU, -1.0, -minV);
+   }
+
+   /// keeps all lines crossing the edge v = posV, between minU and maxU
+   void ClipCrossingEdgeV(double posV, double minU, double maxU)
+   {
+      // m * minU <= posV - c <= m * maxU
+      Clip(minU, 1.0, posV);
+      Clip(-maxU, -1.0, -posV);
+   }
+
+private:
+   /// returns if minValue <= factorM * m + factorC * c <= maxValue for all lines
+   bool IsInRange(double factorM, double factorC, double minValue, double maxValue) const
+   {
+      for (size_t index = 0; index < m_numPoints; index++)
+      {
+         double value = factorM * m_points[index][0] + factorC * m_points[index][1];
+         if (value < minValue || value > maxValue)
+            return false;
+      }
+
+      return true;
+   }
+
+   /// keeps all lines with factorM * m + factorC * c <= limit
+   void Clip(double factorM, double factorC, double limit)
+   {
+      std::array<std::array<double, 2>, c_maxPoints> clippedPoints;
+      size_t numClippedPoints = 0;
+
+      const std::array<double, 2>* point1 = &m_points[m_numPoints - 1];
+      double dist1 = factorM * (*point1)[0] + factorC * (*point1)[1] - limit;
+
+      for (size_t index = 0; index < m_numPoints; index++)
+      {
+         const std::array<double, 2>* point2 = &m_points[index];
+         double dist2 = factorM * (*point2)[0] + factorC * (*point2)[1] - limit;
+
+         // when the polygon gets too complex, the constraint is skipped;
+         // keeping more lines than needed is safe
+         if (numClippedPoints + 2 > c_maxPoints)
+            return;
+
+         if ((dist1 <= 0.0) != (dist2 <= 0.0))
+         {
+            double ratio = dist1 / (dist1 - dist2);
+            clippedPoints[numClippedPoints++] = {
+               (*point1)[0] + ratio * ((*point2)[0] - (*point1)[0]),
+               (*point1)[1] + ratio * ((*point2)[1] - (*point1)[1]) };
+         }
+
+         if (dist2 <= 0.0)
+            clippedPoints[numClippedPoints++] = *point2;
+
+         point1 = point2;
+         dist1 = dist2;
+      }
+
+      std::copy(clippedPoints.begin(), clippedPoints.begin() + numClippedPoints,
+         m_points.begin());
+      m_numPoints = numClippedPoints;
+   }
+
+private:
+   /// max. number of polygon points
+   static constexpr size_t c_maxPoints = 32;
+
+   /// polygon points, as (m, c) pairs
+   std::array<std::array<double, 2>, c_maxPoints> m_points;
+
+   /// number of polygon points
+   size_t m_numPoints;
+};
+
+/// \brief searches a line of sight between two tiles
+/// \details The tile grid is mirrored and possibly has its axes swapped, so
+/// that the target tile lies in positive u and v direction and all lines
+/// searched have slopes between 0 and 1. A line of sight then passes tile
+/// edges in increasing u and v, and a depth first search follows all tile
+/// sequences that lines from the start tile to the target tile can take.
+/// A line can only cross the part of an edge that is open on both tiles, and
+/// only passes tiles that are already known to be visible from the start.
+struct LineOfSightSearch
+{
+   /// returns the tile index for a tile in u/v coordinates
+   size_t GetTileIndex(int posU, int posV) const
+   {
+      int axisU = m_signU > 0 ? posU : -posU - 1;
+      int axisV = m_signV > 0 ? posV : -posV - 1;
+      return m_swapAxes ? axisU * 64 + axisV : axisV * 64 + axisU;
+   }
+
+   /// returns if a tile corner in u/v coordinates is surrounded by open tiles
+   bool IsCornerClear(int posU, int posV) const
+   {
+      int axisU = m_signU > 0 ? posU : -posU;
+      int axisV = m_signV > 0 ? posV : -posV;
+      return m_swapAxes
+         ? m_clearCorners.test(axisU * 65 + axisV)
+         : m_clearCorners.test(axisV * 65 + axisU);
+   }
+
+   /// Determines the open range of a tile edge, in u/v coordinates. Where an
+   /// end of the range is a corner touching a solid part, the range is
+   /// extended by c_lineOfSightEpsilon.
+   /// \param posU u coordinate of tile
+   /// \param posV v coordinate of tile
+   /// \param alongU true for the edges crossed when moving along u
+   /// \param upperEdge true for the upper edge, false for the lower one
+   /// \param minPos start of open range, relative to tile
+   /// \param maxPos end of open range, relative to tile
+   /// \return false when the edge is completely solid
+   bool GetOpenEdgeRange(int posU, int posV, bool alongU, bool upperEdge,
+      double& minPos, double& maxPos) const
+   {
+      // tile edges in world coordinates, and the range along the other axis
+      bool edgeAlongX = alongU != m_swapAxes;
+      bool upperWorldEdge = upperEdge == ((alongU ? m_signU : m_signV) > 0);
+      bool lowerEnd = false, upperEnd = false;
+
+      switch (m_tileTypes[GetTileIndex(posU, posV)])
+      {
+      case Underworld::tileSolid:
+         return false;
+
+      case Underworld::tileDiagonal_se:
+         lowerEnd = edgeAlongX && !upperWorldEdge;
+         upperEnd = !edgeAlongX && upperWorldEdge;
+         break;
+
+      case Underworld::tileDiagonal_sw:
+         lowerEnd = upperWorldEdge;
+         break;
+
+      case Underworld::tileDiagonal_nw:
+         lowerEnd = !edgeAlongX && !upperWorldEdge;
+         upperEnd = edgeAlongX && upperWorldEdge;
+         break;
+
+      case Underworld::tileDiagonal_ne:
+         upperEnd = !upperWorldEdge;
+         break;
+
+      default:
+         break;
+      }
+
+      // the edges of diagonal tiles that touch the solid part are only open
+      // at the end touching the diagonal wall
+      minPos = upperEnd ? 1.0 : 0.0;
+      maxPos = lowerEnd ? 0.0 : 1.0;
+
+      // the other axis may be mirrored, too
+      if ((alongU ? m_signV : m_signU) < 0)
+      {
+         std::swap(minPos, maxPos);
+         minPos = 1.0 - minPos;
+         maxPos = 1.0 - maxPos;
+      }
+
+      int edgeU = alongU ? posU + (upperEdge ? 1 : 0) : posU;
+      int edgeV = alongU ? posV : posV + (upperEdge ? 1 : 0);
+
+      if (minPos <= 0.0 && !IsCornerClear(edgeU, edgeV))
+      {
+         minPos = -c_lineOfSightEpsilon;
+         maxPos = std::max(maxPos, c_lineOfSightEpsilon);
+      }
+
+      if (maxPos >= 1.0 && !IsCornerClear(alongU ? edgeU : edgeU + 1, alongU ? edgeV + 1 : edgeV))
+      {
+         minPos = std::min(minPos, 1.0 - c_lineOfSightEpsilon);
+         maxPos = 1.0 + c_lineOfSightEpsilon;
+      }
+
+      return true;
+   }
+
+   /// moves along u, along v, and through the upper corner; the latter is
+   /// only needed for lines passing a corner between solid parts
+   static constexpr int c_moves[3][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+   /// determines the range on the upper edge of a tile where lines can
+   /// cross into the next tile, relative to the tile's lower corner
+   /// \return false when no line can cross into the next tile
+   bool GetCrossingRange(int posU, int posV, const int* move, double& minPos, double& maxPos) const
+   {
+      int nextU = posU + move[0];
+      int nextV = posV + move[1];
+      bool alongU = move[0] != 0;
+      bool throughCorner = move[0] != 0 && move[1] != 0;
+
+      if (nextU > m_targetU || nextV > m_targetV ||
+         (throughCorner && IsCornerClear(nextU, nextV)) ||
+         !GetOpenEdgeRange(posU, posV, alongU, true, minPos, maxPos))
+         return false;
+
+      if (throughCorner)
+      {
+         minPos = std::max(minPos, 1.0 - c_lineOfSightEpsilon);
+         maxPos = std::min(maxPos, 1.0 + c_lineOfSightEpsilon);
+      }
+
+      // the target tile is visible, even when the line hits its solid part
+      if (nextU == m_targetU && nextV == m_targetV)
+         return minPos <= maxPos;
+
+      if (!m_visibleTiles.test(GetTileIndex(nextU, nextV)))
+         return false;
+
+      double nextMinPos = 0.0, nextMaxPos = 0.0;
+      if (!GetOpenEdgeRange(nextU, nextV, alongU, false, nextMinPos, nextMaxPos))
+         return false;
+
+      // the edge of the next tile starts at the upper corner of this tile
+      if (throughCorner)
+      {
+         nextMinPos += 1.0;
+         nextMaxPos += 1.0;
+      }
+
+      minPos = std::max(minPos, nextMinPos);
+      maxPos = std::min(maxPos, nextMaxPos);
+      return minPos <= maxPos;
+   }
+
+   /// clips lines to those crossing into the next tile in given range
+   static void ClipCrossing(LineSet& lines, int posU, int posV, const int* move, double minPos, double maxPos)
+   {
+      if (move[0] != 0)
+         lines.ClipCrossingEdgeU(posU + 1, posV + minPos, posV + maxPos);
+      else
+         lines.ClipCrossingEdgeV(posV + 1, posU + minPos, posU + maxPos);
+   }
+
+   /// clips lines to the only way to leave the start tile or to enter the
+   /// target tile, if there is only one; this saves searching all paths
+   /// that end at a blocked entry of the target tile
+   /// \return false when there is no way at all
+   bool ClipSingleCrossings(int fromU, int fromV, LineSet& lines) const
+   {
+      for (bool atTarget : { false, true })
+      {
+         int numCrossings = 0;
+         const int* crossingMove = nullptr;
+         int crossingU = 0, crossingV = 0;
+         double crossingMinPos = 0.0, crossingMaxPos = 0.0;
+
+         for (const int* move : c_moves)
+         {
+            int posU = atTarget ? m_targetU - move[0] : fromU;
+            int posV = atTarget ? m_targetV - move[1] : fromV;
+            if (posU < fromU || posV < fromV ||
+               !m_visibleTiles.test(GetTileIndex(posU, posV)))
+               continue;
+
+            double minPos = 0.0, maxPos = 0.0;
+            if (!GetCrossingRange(posU, posV, move, minPos, maxPos))
+               continue;
+
+            numCrossings++;
+            crossingMove = move;
+            crossingU = posU;
+            crossingV = posV;
+            crossingMinPos = minPos;
+            crossingMaxPos = maxPos;
+         }
+
+         if (numCrossings == 0)
+            return false;
+
+         if (numCrossings == 1)
+            ClipCrossing(lines, crossingU, crossingV, crossingMove, crossingMinPos, crossingMaxPos);
+      }
+
+      return !lines.IsEmpty();
+   }
+
+   /// searches lines from given tile to the target tile
+   bool Search(int posU, int posV, const LineSet& lines) const
+   {
+      for (const int* move : c_moves)
+      {
+         double minPos = 0.0, maxPos = 0.0;
+         if (!GetCrossingRange(posU, posV, move, minPos, maxPos))
+            continue;
+
+         int nextU = posU + move[0];
+         int nextV = posV + move[1];
+         bool isTarget = nextU == m_targetU && nextV == m_targetV;
+
+         // most of the time, all lines cross the edge
+         if (move[0] != 0
+            ? lines.AllCrossingEdgeU(posU + 1, posV + minPos, posV + maxPos)
+            : lines.AllCrossingEdgeV(posV + 1, posU + minPos, posU + maxPos))
+         {
+            if (isTarget || Search(nextU, nextV, lines))
+               return true;
+
+            continue;
+         }
+
+         LineSet nextLines = lines;
+         ClipCrossing(nextLines, posU, posV, move, minPos, maxPos);
+         if (nextLines.IsEmpty())
+            continue;
+
+         if (isTarget || Search(nextU, nextV, nextLines))
+            return true;
+      }
+
+      return false;
+   }
+
+   /// tile types of all tiles
+   const std::vector<Underworld::TilemapTileType>& m_tileTypes;
+
+   /// tile corners that are surrounded by open tiles, indexed by y * 65 + x
+   const std::bitset<65 * 65>& m_clearCorners;
+
+   /// tiles known to be visible from the start tile; lines only pass these
+   const std::bitset<64 * 64>& m_visibleTiles;
+
+   /// indicates if u is the y axis and v the x axis
+   bool m_swapAxes;
+
+   /// direction of the u and v axes, in world coordinates
+   int m_signU, m_signV;
+
+   /// target tile, in u/v coordinates
+   int m_targetU, m_targetV;
+};
+
+/// Builds the potentially visible sets for all non-solid tiles of a tilemap.
+/// Rays find most visible tiles quickly; all tiles next to a visible tile
+/// that the rays missed are then checked with an exact line of sight test.
+/// \param tilemap tilemap to build sets for
+/// \param maxDistance maximum view distance, in tiles
+/// \param workerPool worker threads used to build the sets in parallel
+void TilePvs::Build(const Underworld::Tilemap& tilemap, double maxDistance,
+   Base::WorkerPool& workerPool)
+{
+   m_visibleSetIndex.assign(64 * 64, c_noVisibleSet);
+   m_visibleSets.clear();
+
+   // ray casting only needs the tile types
+   TileTypeList tileTypes(64 * 64);
+   for (unsigned int ypos = 0; ypos < 64; ypos++)
+      for (unsigned int xpos = 0; xpos < 64; xpos++)
+         tileTypes[ypos * 64 + xpos] = tilemap.GetTileInfo(xpos, ypos).m_type;
+
+   ClearCornerSet clearCorners;
+   for (int ypos = 0; ypos <= 64; ypos++)
+      for (int xpos = 0; xpos <= 64; xpos++)
+         clearCorners.set(ypos * 65 + xpos, IsCornerClear(tileTypes, xpos, ypos));
+
+   std::vector<unsigned int> openTiles;
+   for (unsigned int tileIndex = 0; tileIndex < 64 * 64; tileIndex++)
+   {
+      if (tileTypes[tileIndex] == Underworld::tileSolid)
+         continue;
+
+      m_visibleSetIndex[tileIndex] = static_cast<unsigned short>(openTiles.size());
+      openTiles.push_back(tileIndex);
+   }
+
+   // each tile's set only depends on the tile types, so the sets can be
+   // built in parallel
+   m_visibleSets.resize(openTiles.size());
+
+   workerPool.Run(openTiles.size(),
+      [&](size_t index)
+      {
+         unsigned int xpos = openTiles[index] % 64;
+         unsigned int ypos = openTiles[index] / 64;
+
+         CastRays(tileTypes, xpos, ypos, maxDistance, m_visibleSets[index]);
+         AddMissedTiles(tileTypes, clearCorners, xpos, ypos, maxDistance, m_visibleSets[index]);
+      });
+
+   m_isValid = true;
+}
+
+/// Casts rays from several points in a tile and marks all tiles hit as
+/// visible. The grid is traversed using a 2D DDA (digital differential
+/// analyzer); a ray stops at the first solid tile, or when it crosses the
+/// wall of a diagonal tile. The tile itself and its neighbours are always
+/// visible.
+/// \param tileTypes tile types of all tiles
+/// \param xpos x coordinate of tile
+/// \param ypos y coordinate of tile
+/// \param maxDistance maximum ray distance, in tiles
+/// \param visibleTiles set of visible tiles to fill
+void TilePvs::CastRays(const TileTypeList& tileTypes,
+   unsigned int xpos, unsigned int ypos, double maxDistance,
+   VisibleTileSet& visibleTiles)
+{
+   for (int y = int(ypos) - 1; y <= int(ypos) + 1; y++)
+      for (int x = int(xpos) - 1; x <= int(xpos) + 1; x++)
+         if (x >= 0 && x < 64 && y >= 0 && y < 64)
+            visibleTiles.set(y * 64 + x);
+
+   static const RayDirections rayDirections;
+
+   Underworld::TilemapTileType sourceTileType = tileTypes[ypos * 64 + xpos];
+
+   for (const double* rayOrigin : c_rayOrigins)
+   {
+      if (IsInSolidPart(sourceTileType, rayOrigin[0], rayOrigin[1]))
+         continue;
+
+      double originX = xpos + rayOrigin[0];
+      double originY = ypos + rayOrigin[1];
+
+      for (const std::array<double, 2>& dir : rayDirections.m_dirs)
+      {
+         double dirX = dir[0], dirY = dir[1];
+
+         int tileX = int(xpos), tileY = int(ypos);
+         int stepX = dirX < 0.0 ? -1 : 1;
+         int stepY = dirY < 0.0 ? -1 : 1;
+
+         // ray distance needed to cross a whole tile, and to reach next tile border
+         double deltaX = dirX != 0.0 ? std::abs(1.0 / dirX) : HUGE_VAL;
+         double deltaY = dirY != 0.0 ? std::abs(1.0 / dirY) : HUGE_VAL;
+
+         double nextX = dirX != 0.0
+            ? ((stepX > 0 ? tileX + 1.0 : double(tileX)) - originX) / dirX
+            : HUGE_VAL;
+         double nextY = dirY != 0.0
+            ? ((stepY > 0 ? tileY + 1.0 : double(tileY)) - originY) / dirY
+            : HUGE_VAL;
+
+         for (;;)
+         {
+            // leaving a diagonal tile through its solid part means the ray
+            // hit the diagonal wall
+            double exitDistance = std::min(nextX, nextY);
+            if (IsInSolidPart(tileTypes[tileY * 64 + tileX],
+               originX + dirX * exitDistance - tileX,
+               originY + dirY * exitDistance - tileY))
+               break;
+
+            if (exitDistance > maxDistance)
+               break;
+
+            if (nextX < nextY)
+            {
+               tileX += stepX;
+               nextX += deltaX;
+            }
+            else
+            {
+               tileY += stepY;
+               nextY += deltaY;
+            }
+
+            if (tileX < 0 || tileX >= 64 || tileY < 0 || tileY >= 64)
+               break;
+
+            visibleTiles.set(tileY * 64 + tileX);
+
+            Underworld::TilemapTileType nextTileType = tileTypes[tileY * 64 + tileX];
+            if (nextTileType == Underworld::tileSolid)
+               break;
+
+            // entering a diagonal tile through its solid part
+            if (IsInSolidPart(nextTileType,
+               originX + dirX * exitDistance - tileX,
+               originY + dirY * exitDistance - tileY))
+               break;
+         }
+      }
+   }
+}
+
+/// Checks all tiles next to visible non-solid tiles that the rays have
+/// missed, using an exact line of sight test. Along a line of sight, the
+/// Manhattan distance of the tiles passed to the start tile increases with
+/// every tile. Tiles are therefore checked in order of that distance, and
+/// each check only has to follow lines through tiles already found visible.
+/// A tile that isn't next to a visible tile can't be visible; for diagonal
+/// neighbours, the line has to pass the corner between them.
+/// \param tileTypes tile types of all tiles
+/// \param clearCorners tile corners that are surrounded by open tiles
+/// \param xpos x coordinate of tile
+/// \param ypos y coordinate of tile
+/// \param maxDistance maximum view distance, in tiles
+/// \param visibleTiles set of visible tiles to extend
+void TilePvs::AddMissedTiles(const TileTypeList& tileTypes,
+   const ClearCornerSet& clearCorners, unsigned int xpos, unsigned int ypos,
+   double maxDistance, VisibleTileSet& visibleTiles)
+{
+   int range = static_cast<int>(maxDistance) + 1;
+   int fromX = static_cast<int>(xpos), fromY = static_cast<int>(ypos);
+
+   // the tile and its neighbours are always visible
+   for (int distance = 2; distance <= 2 * range; distance++)
+      for (int offsetX = -std::min(distance, range); offsetX <= std::min(distance, range); offsetX++)
+      {
+         int offsetY = distance - std::abs(offsetX);
+         if (offsetY > range)
+            continue;
+
+         for (int tileY : { fromY - offsetY, fromY + offsetY })
+         {
+            int tileX = fromX + offsetX;
+            if ((offsetY == 0 && tileY != fromY) ||
+               tileX < 0 || tileX >= 64 || tileY < 0 || tileY >= 64 ||
+               visibleTiles.test(tileY * 64 + tileX))
+               continue;
+
+            // distance between the nearest points of both tiles
+            double distX = std::max(0, std::abs(offsetX) - 1);
+            double distY = std::max(0, offsetY - 1);
+            if (distX * distX + distY * distY > maxDistance * maxDistance ||
+               !HasVisibleNeighbour(tileTypes, clearCorners, visibleTiles, tileX, tileY) ||
+               !IsLineOfSightPossible(tileTypes, clearCorners, visibleTiles,
+                  fromX, fromY, tileX, tileY))
+               continue;
+
+            visibleTiles.set(tileY * 64 + tileX);
+         }
+      }
+}
+
+/// Returns if a tile has a visible non-solid neighbour that a line of sight
+/// could pass before reaching the tile.
+/// \param tileTypes tile types of all tiles
+/// \param clearCorners tile corners that are surrounded by open tiles
+/// \param visibleTiles set of visible tiles
+/// \param xpos x coordinate of tile
+/// \param ypos y coordinate of tile
+/// \return true when there's such a neighbour
+bool TilePvs::HasVisibleNeighbour(const TileTypeList& tileTypes,
+   const ClearCornerSet& clearCorners, const VisibleTileSet& visibleTiles,
+   int xpos, int ypos)
+{
+   for (int tileY = std::max(0, ypos - 1); tileY <= std::min(63, ypos + 1); tileY++)
+      for (int tileX = std::max(0, xpos - 1); tileX <= std::min(63, xpos + 1); tileX++)
+      {
+         if (!visibleTiles.test(tileY * 64 + tileX) ||
+            tileTypes[tileY * 64 + tileX] == Underworld::tileSolid)
+            continue;
+
+         // lines only pass to diagonal neighbours through corners between
+         // solid parts
+         if (tileX != xpos && tileY != ypos &&
+            clearCorners.test(std::max(tileY, ypos) * 65 + std::max(tileX, xpos)))
+            continue;
+
+         return true;
+      }
+
+   return false;
+}
+
+/// Returns if a line of sight from anywhere in the open part of a tile to
+/// any point of another tile exists. The line may only pass non-solid tiles
+/// and the open part of diagonal tiles.
+/// \param tileTypes tile types of all tiles
+/// \param clearCorners tile corners that are surrounded by open tiles
+/// \param visibleTiles tiles known to be visible from the tile to look from
+/// \param fromX x coordinate of tile to look from
+/// \param fromY y coordinate of tile to look from
+/// \param toX x coordinate of tile to look at
+/// \param toY y coordinate of tile to look at
+/// \return true when there's a line of sight
+bool TilePvs::IsLineOfSightPossible(const TileTypeList& tileTypes,
+   const ClearCornerSet& clearCorners, const VisibleTileSet& visibleTiles, int fromX, int fromY, int toX, int toY)
+{
+   for (bool swapAxes : { false, true })
+      for (int signU : { -1, 1 })
+         for (int signV : { -1, 1 })
+         {
+            int fromU = swapAxes ? fromY : fromX, fromV = swapAxes ? fromX : fromY;
+            int toU = swapAxes ? toY : toX, toV = swapAxes ? toX : toY;
+
+            if (signU < 0)
+            {
+               fromU = -fromU - 1;
+               toU = -toU - 1;
+            }
+
+            if (signV < 0)
+            {
+               fromV = -fromV - 1;
+               toV = -toV - 1;
+            }
+
+            if (toU < fromU || toV < fromV)
+               continue;
+
+            LineSet lines;
+            lines.ClipCrossingTile(fromU, fromV);
+            lines.ClipCrossingTile(toU, toV);
+            if (lines.IsEmpty())
+               continue;
+
+            LineOfSightSearch search{ tileTypes, clearCorners, visibleTiles, swapAxes, signU, signV, toU, toV };
+            if (search.ClipSingleCrossings(fromU, fromV, lines) &&
+               search.Search(fromU, fromV, lines))
+               return true;
+         }
+
+   return false;
+}
+
+/// Returns if the area around a tile corner is open in a tile; for diagonal
+/// tiles this is only the case for the open corner.
+/// \param tileType type of tile to check
+/// \param cornerX x coordinate of the corner, relative to the tile; 0 or 1
+/// \param cornerY y coordinate of the corner, relative to the tile; 0 or 1
+/// \return true when the area around the corner is open
+bool TilePvs::IsCornerOpen(Underworld::TilemapTileType tileType, int cornerX, int cornerY)
+{
+   switch (tileType)
+   {
+   case Underworld::tileSolid:
+      return false;
+
+   case Underworld::tileDiagonal_se:
+      return cornerX == 1 && cornerY == 0;
+
+   case Underworld::tileDiagonal_sw:
+      return cornerX == 0 && cornerY == 0;
+
+   case Underworld::tileDiagonal_nw:
+      return cornerX == 0 && cornerY == 1;
+
+   case Underworld::tileDiagonal_ne:
+      return cornerX == 1 && cornerY == 1;
+
+   default:
+      return true;
+   }
+}
+
+/// Returns if a tile corner is surrounded by open tiles. Lines passing other
+/// corners may only touch a solid part, so the line of sight test widens the
+/// openings at these corners and also tries to pass through the corner.
+/// \param tileTypes tile types of all tiles
+/// \param xpos x coordinate of the corner
+/// \param ypos y coordinate of the corner
+/// \return true when the corner is surrounded by open tiles
+bool TilePvs::IsCornerClear(const TileTypeList& tileTypes, int xpos, int ypos)
+{
+   if (xpos <= 0 || xpos >= 64 || ypos <= 0 || ypos >= 64)
+      return false;
+
+   return IsCornerOpen(tileTypes[(ypos - 1) * 64 + xpos - 1], 1, 1) &&
+      IsCornerOpen(tileTypes[(ypos - 1) * 64 + xpos], 0, 1) &&
+      IsCornerOpen(tileTypes[ypos * 64 + xpos - 1], 1, 0) &&
+      IsCornerOpen(tileTypes[ypos * 64 + xpos], 0, 0);
+}
+
+/// Returns if a point lies in the solid part of a tile. For diagonal tiles
+/// the half opposite to the open corner is solid; points on the diagonal
+/// wall itself are treated as open.
+/// \param tileType type of tile to check
+/// \param relX x coordinate, relative to the tile's lower left corner
+/// \param relY y coordinate, relative to the tile's lower left corner
+/// \return true when the point is in the solid part of the tile
+bool TilePvs::IsInSolidPart(Underworld::TilemapTileType tileType,
+   double relX, double relY)
+{
+   const double epsilon = 1e-6;
+
+   switch (tileType)
+   {
+   case Underworld::tileSolid:
+      return true;
+
+   case Underworld::tileDiagonal_se:
+      return relY - relX > epsilon;
+
+   case Underworld::tileDiagonal_sw:
+      return relX + relY - 1.0 > epsilon;
+
+   case Underworld::tileDiagonal_nw:
+      return relX - relY > epsilon;
+
+   case Underworld::tileDiagonal_ne:
+      return 1.0 - relX - relY > epsilon;
+
+   default:
+      return false;
+   }
+}
@@ -0,0 +1,122 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TilePvs.hpp
+/// \brief potentially visible set of tiles
+//
+#pragma once
+
+#include <vector>
+#include <bitset>
+#include "Tilemap.hpp"
+
+namespace Base
+{
+   class WorkerPool;
+}
+
+/// \brief potentially visible set of tiles
+/// \details Stores for every non-solid tile of a level the set of tiles that
+/// may be visible from anywhere inside the tile. Solid tiles and the solid
+/// half of diagonal tiles block the view. The set is determined by casting
+/// rays through the tile grid from several points in the tile; tiles next to
+/// visible tiles that no ray has hit are checked with an exact line of sight
+/// test. Floor and ceiling heights are ignored, so the set is conservative.
+class TilePvs
+{
+public:
+   /// ctor
+   TilePvs()
+      :m_isValid(false)
+   {
+   }
+
+   /// builds potentially visible sets for all tiles of a tilemap
+   void Build(const Underworld::Tilemap& tilemap, double maxDistance,
+      Base::WorkerPool& workerPool);
+
+   /// returns if the sets were built and are still valid
+   bool IsValid() const { return m_isValid; }
+
+   /// returns if a visible set is available for given tile
+   bool IsAvailable(unsigned int xpos, unsigned int ypos) const
+   {
+      return m_isValid && xpos < 64 && ypos < 64 &&
+         m_visibleSetIndex[ypos * 64 + xpos] != c_noVisibleSet;
+   }
+
+   /// returns if a tile is potentially visible from another tile
+   bool IsVisible(unsigned int fromX, unsigned int fromY,
+      unsigned int toX, unsigned int toY) const
+   {
+      return m_visibleSets[m_visibleSetIndex[fromY * 64 + fromX]].test(toY * 64 + toX);
+   }
+
+private:
+   /// set of visible tiles, indexed by y * 64 + x
+   typedef std::bitset<64 * 64> VisibleTileSet;
+
+   /// tile types of all tiles, indexed by y * 64 + x
+   typedef std::vector<Underworld::TilemapTileType> TileTypeList;
+
+   /// set of tile corners surrounded by open tiles, indexed by y * 65 + x
+   typedef std::bitset<65 * 65> ClearCornerSet;
+
+   /// casts rays from given tile and collects all tiles hit
+   static void CastRays(const TileTypeList& tileTypes,
+      unsigned int xpos, unsigned int ypos, double maxDistance,
+      VisibleTileSet& visibleTiles);
+
+   /// adds visible tiles that no ray has hit
+   static void AddMissedTiles(const TileTypeList& tileTypes,
+      const ClearCornerSet& clearCorners, unsigned int xpos, unsigned int ypos,
+      double maxDistance, VisibleTileSet& visibleTiles);
+
+   /// returns if a tile has a visible neighbour that lines of sight can pass
+   static bool HasVisibleNeighbour(const TileTypeList& tileTypes,
+      const ClearCornerSet& clearCorners, const VisibleTileSet& visibleTiles,
+      int xpos, int ypos);
+
+   /// returns if there's a line of sight between two tiles
+   static bool IsLineOfSightPossible(const TileTypeList& tileTypes,
+      const ClearCornerSet& clearCorners, const VisibleTileSet& visibleTiles,
+      int fromX, int fromY, int toX, int toY);
+
+   /// returns if the area around a tile corner is open in a tile
+   static bool IsCornerOpen(Underworld::TilemapTileType tileType, int cornerX, int cornerY);
+
+   /// returns if a tile corner is surrounded by open tiles
+   static bool IsCornerClear(const TileTypeList& tileTypes, int xpos, int ypos);
+
+   /// returns if a point in a tile lies in the solid part of the tile
+   static bool IsInSolidPart(Underworld::TilemapTileType tileType,
+      double relX, double relY);
+
+private:
+   /// index value for tiles without a visible set
+   static constexpr unsigned short c_noVisibleSet = 0xffff;
+
+   /// index into m_visibleSets for every tile
+   std::vector<unsigned short> m_visibleSetIndex;
+
+   /// visible sets for all non-solid tiles
+   std::vector<VisibleTileSet> m_visibleSets;
+
+   /// indicates if the sets are valid
+   bool m_isValid;
+};
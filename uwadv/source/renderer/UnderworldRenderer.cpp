@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,11 +24,18 @@
 #include "LevelTilemapRenderer.hpp"
 #include "RenderOptions.hpp"
 #include "Constants.hpp"
+#include "FrameProfiler.hpp"
 
 const double c_renderHeightScale = 0.125 * 0.25;
 
+/// distance of the view frustum's far plane, used to find visible tiles
+const double c_visibleTilesFarDistance = 8.0;
+
+const double UnderworldRenderer::c_critterSpriteWidth = 0.4;
+const double UnderworldRenderer::c_critterSpriteHeight = 0.88;
+
 UnderworldRenderer::UnderworldRenderer(IGameInstance& game)
-   :m_selectionMode(false)
+   :m_isTilemapInvalid(false)
 {
    m_textureManager.Init(game);
    m_modelManager.Init(game);
@@ -39,6 +46,10 @@ UnderworldRenderer::UnderworldRenderer(IGameInstance& game)
    m_scaleFactor = game.GetSettings().GetBool(Base::settingUwadvFeatures) ? 4 : 1;
 }
 
+UnderworldRenderer::~UnderworldRenderer()
+{
+}
+
 /// Does tick processing for renderer for texture and critter frames
 /// animation.
 /// \param tickRate tick rate in ticks/second
@@ -60,28 +71,26 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
    // reset stock texture usage
    m_textureManager.Reset();
 
-   // prepare all used wall/ceiling textures
-   {
-      const std::set<Uint16>& usedTextures = level.GetTilemap().GetUsedTextures();
+   // collect all textures to prepare
+   std::vector<unsigned int> allTextureIds;
 
-      for (Uint16 textureId : usedTextures)
-         m_textureManager.Prepare(textureId, m_scaleFactor);
-   }
+   // all used wall/ceiling textures
+   GetUsedTextureIds(level.GetTilemap(), allTextureIds);
 
-   // prepare all switch, door and tmobj textures
+   // all switch, door and tmobj textures
    {
-      for (unsigned int n = 0; n < 16; n++) m_textureManager.Prepare(Base::c_stockTexturesSwitches + n, m_scaleFactor);
-      for (unsigned int n = 0; n < 13; n++) m_textureManager.Prepare(Base::c_stockTexturesDoors + n, m_scaleFactor);
-      for (unsigned int n = 0; n < 33; n++) m_textureManager.Prepare(Base::c_stockTexturesTmobj + n, m_scaleFactor);
+      for (unsigned int n = 0; n < 16; n++) allTextureIds.push_back(Base::c_stockTexturesSwitches + n);
+      for (unsigned int n = 0; n < 13; n++) allTextureIds.push_back(Base::c_stockTexturesDoors + n);
+      for (unsigned int n = 0; n < 33; n++) allTextureIds.push_back(Base::c_stockTexturesTmobj + n);
    }
 
-   // prepare all object images
+   // all object images
    {
       for (unsigned int n = 0; n < 0x01c0; n++)
-         m_textureManager.Prepare(Base::c_stockTexturesObjects + n, m_scaleFactor);
+         allTextureIds.push_back(Base::c_stockTexturesObjects + n);
    }
 
-   // prepare all wall textures used by tmap objects
+   // all wall textures used by tmap objects
    {
       const Underworld::ObjectList& objectList = level.GetObjectList();
       for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
@@ -94,7 +103,7 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
                const Underworld::ObjectInfo& info = obj.GetObjectInfo();
 
                if (info.m_itemID == 0x016e || info.m_itemID == 0x016f)
-                  m_textureManager.Prepare(info.m_owner, m_scaleFactor);
+                  allTextureIds.push_back(info.m_owner);
 
                // next object in link chain
                link = obj.GetObjectInfo().m_link;
@@ -102,12 +111,81 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
          }
    }
 
+   m_textureManager.Prepare(allTextureIds, m_scaleFactor);
+
    UaTrace("done\npreparing critter images... ");
 
    // prepare critters controlled by critter frames manager
    m_critterManager.Prepare(&level.GetObjectList());
 
    UaTrace("done\n");
+
+   m_tilemapRenderer = std::make_unique<LevelTilemapRenderer>(level, m_textureManager);
+   PrepareTilemap(level);
+}
+
+/// Invalidates the texture atlas, the tile geometry and the potentially
+/// visible tile sets prepared in PrepareLevel(). They are prepared again
+/// before rendering the next frame. Has to be called when tiles of the
+/// prepared level were modified. Only sets a flag, so it may be called from
+/// threads not owning the OpenGL context.
+void UnderworldRenderer::InvalidateTilemap()
+{
+   m_isTilemapInvalid = true;
+}
+
+/// Collects the stock texture indices of all wall and floor textures used by
+/// a tilemap.
+/// \param tilemap tilemap to collect textures from
+/// \param usedTextureIds list to add the texture indices to
+void UnderworldRenderer::GetUsedTextureIds(const Underworld::Tilemap& tilemap,
+   std::vector<unsigned int>& usedTextureIds)
+{
+   const Underworld::TileTexturesSet& usedTextures = tilemap.GetUsedTextures();
+   for (Uint16 textureId = 0; textureId < Underworld::c_numTileTextures; textureId++)
+      if (usedTextures.test(textureId))
+         usedTextureIds.push_back(textureId);
+}
+
+/// Prepares everything needed to render the tiles of the prepared level:
+/// wall and floor textures that aren't prepared yet, e.g. after tiles were
+/// modified, the texture atlas, the baked tile geometry and the potentially
+/// visible tile sets.
+/// \param level level to prepare tiles for
+void UnderworldRenderer::PrepareTilemap(const Underworld::Level& level)
+{
+   std::vector<unsigned int> usedTextureIds;
+   GetUsedTextureIds(level.GetTilemap(), usedTextureIds);
+
+   std::vector<unsigned int> newTextureIds;
+   for (unsigned int textureId : usedTextureIds)
+      if (!m_textureManager.IsPrepared(textureId))
+         newTextureIds.push_back(textureId);
+
+   if (!newTextureIds.empty())
+      m_textureManager.Prepare(newTextureIds, m_scaleFactor);
+
+   UaTrace("packing texture atlas... ");
+
+   // pack wall/ceiling textures into the texture atlas, for rendering tiles
+   // in batches
+   m_textureManager.PrepareAtlas(usedTextureIds);
+
+   UaTrace("done\nbaking tile geometry... ");
+
+   // bake tile geometry of the level
+   m_tilemapRenderer->PrepareMesh();
+
+   UaTrace("done\nbuilding potentially visible tiles... ");
+
+   // one tile more than the far distance, since the viewer may be anywhere
+   // in the tile
+   m_tilePvs.Build(level.GetTilemap(), c_visibleTilesFarDistance + 1.0,
+      m_textureManager.GetWorkerPool());
+
+   UaTrace("done\n");
+
+   m_isTilemapInvalid = false;
 }
 
 /// Renders the visible parts of a level.
@@ -145,24 +223,40 @@ void UnderworldRenderer::Render(const RenderOptions& renderOptions,
       m_billboardUpVector.Normalize();
    }
 
-   LevelTilemapRenderer tileRenderer(level, m_textureManager);
-
    glColor3ub(192, 192, 192);
 
    Vector3d viewerPos{ -pos.x, -pos.y, -pos.z * c_renderHeightScale };
 
+   bool isLevelPrepared = m_tilemapRenderer != nullptr &&
+      &m_tilemapRenderer->GetLevel() == &level;
+
+   if (isLevelPrepared && m_isTilemapInvalid)
+      PrepareTilemap(level);
+
+   // collect all visible tiles
+   m_visibleTiles.clear();
+
    if (renderOptions.m_renderVisibleTilesUsingOctree)
    {
+      // use potentially visible set of the viewer's tile, if available
+      unsigned int viewerTileX = static_cast<unsigned int>(pos.x);
+      unsigned int viewerTileY = static_cast<unsigned int>(pos.y);
+
+      bool useTilePvs = renderOptions.m_useTilePvs && isLevelPrepared &&
+         pos.x >= 0.0 && pos.y >= 0.0 &&
+         m_tilePvs.IsAvailable(viewerTileX, viewerTileY);
+
       // draw all visible tiles
-      Frustum2d fr(pos.x, pos.y, rotateAngle, fieldOfView, 8.0);
+      Frustum2d fr(pos.x, pos.y, rotateAngle, fieldOfView, c_visibleTilesFarDistance);
 
       // find tiles
       Quad q(0, 64, 0, 64);
       q.FindVisibleTiles(fr,
          [&](unsigned int tilePosX, unsigned int tilePosY)
          {
-            tileRenderer.RenderTile(tilePosX, tilePosY);
-            RenderObjects(renderOptions, viewerPos, level, tilePosX, tilePosY);
+            if (!useTilePvs ||
+               m_tilePvs.IsVisible(viewerTileX, viewerTileY, tilePosX, tilePosY))
+               m_visibleTiles.push_back(std::make_pair(tilePosX, tilePosY));
          });
    }
    else
@@ -170,11 +264,33 @@ void UnderworldRenderer::Render(const RenderOptions& renderOptions,
       // draw all tiles
       for (unsigned int tilePosX = 0; tilePosX < 64; tilePosX++)
          for (unsigned int tilePosY = 0; tilePosY < 64; tilePosY++)
-         {
-            tileRenderer.RenderTile(tilePosX, tilePosY);
-            RenderObjects(renderOptions, viewerPos, level, tilePosX, tilePosY);
-         }
+            m_visibleTiles.push_back(std::make_pair(tilePosX, tilePosY));
    }
+
+   // when the level wasn't prepared, render tiles in immediate mode, one at a
+   // time
+   if (!isLevelPrepared)
+   {
+      LevelTilemapRenderer tileRenderer(level, m_textureManager);
+
+      for (const QuadTileCoordinates& tilePos : m_visibleTiles)
+      {
+         tileRenderer.RenderTile(tilePos.first, tilePos.second);
+         RenderObjects(renderOptions, viewerPos, level, tilePos.first, tilePos.second);
+      }
+
+      return;
+   }
+
+   {
+      Base::ProfileScope scope{ Base::framePhaseRenderTiles };
+      m_tilemapRenderer->RenderTiles(m_visibleTiles);
+   }
+
+   Base::ProfileScope scope{ Base::framePhaseRenderObjects };
+
+   for (const QuadTileCoordinates& tilePos : m_visibleTiles)
+      RenderObjects(renderOptions, viewerPos, level, tilePos.first, tilePos.second);
 }
 
 /// Renders all objects in a tile.
@@ -187,8 +303,6 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    const Vector3d& viewerPos, const Underworld::Level& level,
    unsigned int x, unsigned int y)
 {
-   glPushName((y << 8) + x);
-
    // enable alpha blending
    glEnable(GL_BLEND);
 
@@ -205,14 +319,9 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    {
       const Underworld::Object& obj = *objectList.GetObject(link);
 
-      // remember object list position for picking
-      glPushName(link);
-
       // render object
       RenderObject(renderOptions, viewerPos, level, obj, x, y);
 
-      glPopName();
-
       // next object in link chain
       link = obj.GetObjectInfo().m_link;
    }
@@ -220,8 +329,6 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    // disable alpha blending again
    glDisable(GL_ALPHA_TEST);
    glDisable(GL_BLEND);
-
-   glPopName();
 }
 
 /// Renders an object at a time. When a 3d model for that object exists, the
@@ -265,30 +372,13 @@ void UnderworldRenderer::RenderObject(const RenderOptions& renderOptions,
       if (!obj.IsNpcObject())
          return; // shouldn't happen
 
-      const Underworld::NpcObject& npc = obj.GetNpcObject();
-      const Underworld::NpcInfo& npcInfo = npc.GetNpcInfo();
-
-      // critter object
-      Critter& crit = m_critterManager.GetCritter(itemId - 0x0040);
-      unsigned int curframe = crit.GetFrame(npcInfo.m_animationState, npcInfo.m_animationFrame);
-      Texture& tex = crit.GetTexture(curframe);
+      double moveU = 0.0, moveV = 0.0;
+      Texture& tex = GetCritterTexture(obj, moveU, moveV);
 
       tex.Use(0);
 
-      // adjust height for hotspot
-      base.z -= 0.0;
-
-      double u = crit.GetHotspotU(curframe) / tex.GetTexU();
-      double v = crit.GetHotspotV(curframe) / tex.GetTexV();
-
-      u = 1.0 - u * 2.0;
-      v = v - 1.0;
-
-      // fix for rotworm; hotspot always too high
-      if (itemId == 0x0040) v += 0.25;
-
-      RenderSprite(renderOptions, base, 0.4, 0.88, true,
-         tex.GetTexU(), tex.GetTexV(), u, v);
+      RenderSprite(renderOptions, base, c_critterSpriteWidth, c_critterSpriteHeight, true,
+         tex.GetTexU(), tex.GetTexV(), moveU, moveV);
    }
    // switches/levers/buttons/pull chains
    else if ((itemId >= 0x0170 && itemId <= 0x017f) ||
@@ -325,39 +415,123 @@ void UnderworldRenderer::RenderObject(const RenderOptions& renderOptions,
    }
 }
 
-/// \details renders the following objects:
-/// - 0x0161 a_lever
-/// - 0x0162 a_switch
-/// - 0x0166 some writing
-/// - 0x017x buttons/switches/levers/pull chain
-void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int x, unsigned int y)
+/// Returns the triangles that cover an object as it is rendered. This is used
+/// for picking objects. Objects that are not rendered don't add triangles.
+/// All coordinates are in the rendered 3d world, with scaled z coordinates.
+/// Sprites use the billboard vectors of the last rendered frame.
+/// \param renderOptions render options to use
+/// \param level level in which object is
+/// \param obj object to get triangles for
+/// \param x x tile coordinate of object
+/// \param y y tile coordinate of object
+/// \param allTriangles list of triangles the object triangles are added to
+void UnderworldRenderer::GetObjectPickTriangles(const RenderOptions& renderOptions,
+   const Underworld::Level& level, const Underworld::Object& obj,
+   unsigned int x, unsigned int y,
+   std::vector<Triangle3dTextured>& allTriangles)
 {
-   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
+   // invisible objects can't be picked
+   if (!renderOptions.m_renderHiddenObjects && obj.GetObjectInfo().m_isHidden)
+      return;
 
-   Vector3d base(static_cast<double>(x), static_cast<double>(y),
-      posInfo.m_zpos * c_renderHeightScale);
+   Uint16 itemId = obj.GetObjectInfo().m_itemID;
 
-   Vector2d to_right;
+   // hack: objects not rendered in RenderObject()
+   if ((itemId >= 0x00da && itemId <= 0x00df) || itemId == 0x012e)
+      return;
 
-   const double wall_offset = m_selectionMode ? 0.02 : 0.00;
+   Vector3d base = CalcObjectPosition(x, y, obj);
+   Vector3d quad[4];
 
-   switch (posInfo.m_heading)
+   if (m_modelManager.IsModelAvailable(itemId))
    {
-   case 0: to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wall_offset; break;
-   case 2: to_right.Set(0.0, -1.0); base.y += posInfo.m_ypos / 8.0; base.x += 1.0 - wall_offset; break;
-   case 4: to_right.Set(-1.0, 0.0); base.x += posInfo.m_xpos / 8.0; base.y += wall_offset; break;
-   case 6: to_right.Set(0.0, 1.0);  base.y += posInfo.m_ypos / 8.0; base.x += wall_offset; break;
+      base.z = obj.GetPosInfo().m_zpos * c_renderHeightScale;
 
-   default:
-      // should not occur; use 0 as value
-      to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wall_offset; break;
-      break;
+      m_modelManager.GetBoundingTriangles(obj, base, allTriangles);
+      return;
    }
+   // critters
+   else if (itemId >= 0x0040 && itemId < 0x0080)
+   {
+      if (!obj.IsNpcObject())
+         return; // shouldn't happen
 
-   const double decalheight = 1.0 / 8.0;
+      double moveU = 0.0, moveV = 0.0;
+      GetCritterTexture(obj, moveU, moveV);
 
-   to_right.Normalize();
-   to_right *= decalheight;
+      CalcSpriteQuad(base, c_critterSpriteWidth, c_critterSpriteHeight, true,
+         moveU, moveV, quad);
+   }
+   // switches/levers/buttons/pull chains
+   else if ((itemId >= 0x0170 && itemId <= 0x017f) ||
+      itemId == 0x0161 || // a_lever
+      itemId == 0x0162 || // a_switch
+      itemId == 0x0166)   // some_writing
+   {
+      CalcDecalQuad(obj, x, y, quad);
+   }
+   // special tmap object
+   else if (itemId == 0x016e || itemId == 0x016f)
+   {
+      CalcTmapObjectQuad(obj, x, y, quad);
+   }
+   else
+   {
+      // normal object
+      double quadWidth = 0.25;
+
+      // items that have to be drawn at the ceiling?
+      if (itemId == 0x00d3 || itemId == 0x00d4) // a_stalactite / a_plant
+         base.z = level.GetTilemap().GetTileInfo(x, y).m_ceiling - quadWidth;
+
+      CalcSpriteQuad(base, 0.5 * quadWidth, quadWidth, false, 0.0, 0.0, quad);
+   }
+
+   allTriangles.push_back(Triangle3dTextured(quad[0], quad[1], quad[2]));
+   allTriangles.push_back(Triangle3dTextured(quad[0], quad[2], quad[3]));
+}
+
+/// Returns the current texture of a critter object, as well as the offsets
+/// to move the billboarded sprite so that the critter's hotspot is at the
+/// object's position.
+/// \param obj critter object
+/// \param moveU u-coordinate offset to move base to hotspot
+/// \param moveV v-coordinate offset to move base to hotspot
+/// \return current texture of critter
+Texture& UnderworldRenderer::GetCritterTexture(const Underworld::Object& obj,
+   double& moveU, double& moveV)
+{
+   Uint16 itemId = obj.GetObjectInfo().m_itemID;
+
+   const Underworld::NpcObject& npc = obj.GetNpcObject();
+   const Underworld::NpcInfo& npcInfo = npc.GetNpcInfo();
+
+   // critter object
+   Critter& crit = m_critterManager.GetCritter(itemId - 0x0040);
+   unsigned int curframe = crit.GetFrame(npcInfo.m_animationState, npcInfo.m_animationFrame);
+   Texture& tex = crit.GetTexture(curframe);
+
+   double u = crit.GetHotspotU(curframe) / tex.GetTexU();
+   double v = crit.GetHotspotV(curframe) / tex.GetTexV();
+
+   moveU = 1.0 - u * 2.0;
+   moveV = v - 1.0;
+
+   // fix for rotworm; hotspot always too high
+   if (itemId == 0x0040) moveV += 0.25;
+
+   return tex;
+}
+
+/// \details renders the following objects:
+/// - 0x0161 a_lever
+/// - 0x0162 a_switch
+/// - 0x0166 some writing
+/// - 0x017x buttons/switches/levers/pull chain
+void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int x, unsigned int y)
+{
+   Vector3d quad[4];
+   CalcDecalQuad(obj, x, y, quad);
 
    // select texture
    const Underworld::ObjectInfo& info = obj.GetObjectInfo();
@@ -394,62 +568,60 @@ void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int
 
    // render quad
    glBegin(GL_QUADS);
-   glTexCoord2d(u1, v2); glVertex3d(base.x - to_right.x, base.y - to_right.y, base.z);
-   glTexCoord2d(u2, v2); glVertex3d(base.x + to_right.x, base.y + to_right.y, base.z);
-   glTexCoord2d(u2, v1); glVertex3d(base.x + to_right.x, base.y + to_right.y, base.z + 2 * decalheight);
-   glTexCoord2d(u1, v1); glVertex3d(base.x - to_right.x, base.y - to_right.y, base.z + 2 * decalheight);
+   glTexCoord2d(u1, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
 
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
-/// \details renders 0x016e / 0x016f special tmap object
-void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
-   const Underworld::Object& obj, unsigned int x, unsigned int y)
+/// Calculates the quad points of a decal object on a wall.
+/// \param obj decal object
+/// \param x tile x coordinate of object
+/// \param y tile y coordinate of object
+/// \param quad quad points; lower left, lower right, upper right, upper left
+void UnderworldRenderer::CalcDecalQuad(const Underworld::Object& obj,
+   unsigned int x, unsigned int y, Vector3d quad[4])
 {
    const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
 
-   Vector3d pos(static_cast<double>(x), static_cast<double>(y),
+   Vector3d base(static_cast<double>(x), static_cast<double>(y),
       posInfo.m_zpos * c_renderHeightScale);
 
-   unsigned int x_fr = posInfo.m_xpos;
-   unsigned int y_fr = posInfo.m_ypos;
-
-   // hack: fixing some tmap decals
-   if (x_fr > 4) x_fr++;
-   if (y_fr > 4) y_fr++;
+   Vector2d to_right;
 
-   // determine direction
-   Vector3d dir;
    switch (posInfo.m_heading)
    {
-   case 0: dir.Set(1.0, 0.0, 0.0); break;
-   case 2: dir.Set(0.0, 1.0, 0.0); break;
-   case 4: dir.Set(-1.0, 0.0, 0.0); break;
-   case 6: dir.Set(0.0, -1.0, 0.0); break;
+   case 0: to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0; break;
+   case 2: to_right.Set(0.0, -1.0); base.y += posInfo.m_ypos / 8.0; base.x += 1.0; break;
+   case 4: to_right.Set(-1.0, 0.0); base.x += posInfo.m_xpos / 8.0; break;
+   case 6: to_right.Set(0.0, 1.0);  base.y += posInfo.m_ypos / 8.0; break;
 
-   case 1: dir.Set(1.0, -1.0, 0.0); break;
-   case 3: dir.Set(-1.0, -1.0, 0.0); break;
-   case 5: dir.Set(-1.0, 1.0, 0.0); break;
-   case 7: dir.Set(1.0, 1.0, 0.0); break;
+   default:
+      // should not occur; use 0 as value
+      to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0; break;
+      break;
    }
 
-   dir.Normalize();
-   dir *= 0.5;
+   const double decalheight = 1.0 / 8.0;
 
-   // add fractional position
-   pos.x += x_fr / 8.0;
-   pos.y += y_fr / 8.0;
+   to_right.Normalize();
+   to_right *= decalheight;
 
-   if (m_selectionMode)
-   {
-      // in selection mode, offset object pos
-      Vector3d offset(dir);
-      offset.RotateZ(-90.0);
-      offset *= 0.01;
+   quad[0].Set(base.x - to_right.x, base.y - to_right.y, base.z);
+   quad[1].Set(base.x + to_right.x, base.y + to_right.y, base.z);
+   quad[2].Set(base.x + to_right.x, base.y + to_right.y, base.z + 2 * decalheight);
+   quad[3].Set(base.x - to_right.x, base.y - to_right.y, base.z + 2 * decalheight);
+}
 
-      pos += offset;
-   }
+/// \details renders 0x016e / 0x016f special tmap object
+void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
+   const Underworld::Object& obj, unsigned int x, unsigned int y)
+{
+   Vector3d quad[4];
+   CalcTmapObjectQuad(obj, x, y, quad);
 
    // enable polygon offset
    glPolygonOffset(-2.0, -2.0);
@@ -465,10 +637,10 @@ void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
    m_textureManager.Use(info.m_itemID + Base::c_stockTexturesObjects);
 
    glBegin(GL_QUADS);
-   glTexCoord2d(u2, v2); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z);
-   glTexCoord2d(u2, v1); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v1); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v2); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v2); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
 #endif
 
@@ -477,15 +649,63 @@ void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
    u2 = v2 = 1.0;
 
    glBegin(GL_QUADS);
-   glTexCoord2d(u2, v2); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z);
-   glTexCoord2d(u2, v1); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v1); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v2); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v2); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
 
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
+/// Calculates the quad points of a 0x016e / 0x016f special tmap object.
+/// \param obj tmap object
+/// \param x tile x coordinate of object
+/// \param y tile y coordinate of object
+/// \param quad quad points, in rendering order
+void UnderworldRenderer::CalcTmapObjectQuad(const Underworld::Object& obj,
+   unsigned int x, unsigned int y, Vector3d quad[4])
+{
+   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
+
+   Vector3d pos(static_cast<double>(x), static_cast<double>(y),
+      posInfo.m_zpos * c_renderHeightScale);
+
+   unsigned int x_fr = posInfo.m_xpos;
+   unsigned int y_fr = posInfo.m_ypos;
+
+   // hack: fixing some tmap decals
+   if (x_fr > 4) x_fr++;
+   if (y_fr > 4) y_fr++;
+
+   // determine direction
+   Vector3d dir;
+   switch (posInfo.m_heading)
+   {
+   case 0: dir.Set(1.0, 0.0, 0.0); break;
+   case 2: dir.Set(0.0, 1.0, 0.0); break;
+   case 4: dir.Set(-1.0, 0.0, 0.0); break;
+   case 6: dir.Set(0.0, -1.0, 0.0); break;
+
+   case 1: dir.Set(1.0, -1.0, 0.0); break;
+   case 3: dir.Set(-1.0, -1.0, 0.0); break;
+   case 5: dir.Set(-1.0, 1.0, 0.0); break;
+   case 7: dir.Set(1.0, 1.0, 0.0); break;
+   }
+
+   dir.Normalize();
+   dir *= 0.5;
+
+   // add fractional position
+   pos.x += x_fr / 8.0;
+   pos.y += y_fr / 8.0;
+
+   quad[0].Set(pos.x + dir.x, pos.y + dir.y, pos.z);
+   quad[1].Set(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
+   quad[2].Set(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
+   quad[3].Set(pos.x - dir.x, pos.y - dir.y, pos.z);
+}
+
 /// Renders a billboarded drawn sprite; the texture has to be use()d before
 /// calling, and the max u and v coordinates have to be passed.
 /// Objects are drawn using the method described in the billboarding tutorial,
@@ -514,32 +734,13 @@ void UnderworldRenderer::RenderSprite(
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-   // scale z axis before any calculation is done
-   base.z *= c_renderHeightScale;
-
-   // move base to new location
-   base += m_billboardRightVector * moveU * width;
-   base += m_billboardUpVector * moveV * height;
-
-   // calculate vectors for quad
-   Vector3d base2(base);
-
-   base -= m_billboardRightVector * width;
-   base2 += m_billboardRightVector * width;
+   Vector3d quad[4];
+   CalcSpriteQuad(base, width, height, ignoreUpVector, moveU, moveV, quad);
 
-   Vector3d high1(base);
-   Vector3d high2(base2);
-
-   if (ignoreUpVector)
-   {
-      high1.z += height;
-      high2.z += height;
-   }
-   else
-   {
-      high1 += m_billboardUpVector * height;
-      high2 += m_billboardUpVector * height;
-   }
+   const Vector3d& base1 = quad[0];
+   const Vector3d& base2 = quad[1];
+   const Vector3d& high2 = quad[2];
+   const Vector3d& high1 = quad[3];
 
    // enable polygon offset
    glPolygonOffset(-2.0, -2.0);
@@ -547,7 +748,7 @@ void UnderworldRenderer::RenderSprite(
 
    // render quad
    glBegin(GL_QUADS);
-   glTexCoord2d(0.0, v);   glVertex3d(base.x, base.y, base.z);
+   glTexCoord2d(0.0, v);   glVertex3d(base1.x, base1.y, base1.z);
    glTexCoord2d(u, v);   glVertex3d(base2.x, base2.y, base2.z);
    glTexCoord2d(u, 0.0); glVertex3d(high2.x, high2.y, high2.z);
    glTexCoord2d(0.0, 0.0); glVertex3d(high1.x, high1.y, high1.z);
@@ -562,7 +763,7 @@ void UnderworldRenderer::RenderSprite(
       glLineWidth(5.0);
 
       glBegin(GL_LINE_LOOP);
-      glVertex3d(base.x, base.y, base.z);
+      glVertex3d(base1.x, base1.y, base1.z);
       glVertex3d(base2.x, base2.y, base2.z);
       glVertex3d(high2.x, high2.y, high2.z);
       glVertex3d(high1.x, high1.y, high1.z);
@@ -576,6 +777,51 @@ void UnderworldRenderer::RenderSprite(
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
+/// Calculates the quad points of a billboarded sprite.
+/// \param base base coordinates of sprite; z coordinate is not scaled yet
+/// \param width relative width of object in relation to a tile
+/// \param height relative height of object in relation to a tile
+/// \param ignoreUpVector ignores billboard up-vector when true
+/// \param moveU u-coordinate offset to move base, e.g. to hotspot
+/// \param moveV v-coordinate offset to move base, e.g. to hotspot
+/// \param quad quad points; lower left, lower right, upper right, upper left
+void UnderworldRenderer::CalcSpriteQuad(Vector3d base,
+   double width, double height, bool ignoreUpVector,
+   double moveU, double moveV, Vector3d quad[4]) const
+{
+   // scale z axis before any calculation is done
+   base.z *= c_renderHeightScale;
+
+   // move base to new location
+   base += m_billboardRightVector * moveU * width;
+   base += m_billboardUpVector * moveV * height;
+
+   // calculate vectors for quad
+   Vector3d base2(base);
+
+   base -= m_billboardRightVector * width;
+   base2 += m_billboardRightVector * width;
+
+   Vector3d high1(base);
+   Vector3d high2(base2);
+
+   if (ignoreUpVector)
+   {
+      high1.z += height;
+      high2.z += height;
+   }
+   else
+   {
+      high1 += m_billboardUpVector * height;
+      high2 += m_billboardUpVector * height;
+   }
+
+   quad[0] = base;
+   quad[1] = base2;
+   quad[2] = high2;
+   quad[3] = high1;
+}
+
 /// calculates object position in 3D world
 Vector3d UnderworldRenderer::CalcObjectPosition(unsigned int x, unsigned int y,
    const Underworld::Object& obj)
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,6 +24,8 @@
 #include "TextureManager.hpp"
 #include "CritterFramesManager.hpp"
 #include "Model3DManager.hpp"
+#include "Quadtree.hpp"
+#include "TilePvs.hpp"
 
 namespace Underworld
 {
@@ -31,6 +33,7 @@ namespace Underworld
 }
 
 class IGameInstance;
+class LevelTilemapRenderer;
 struct RenderOptions;
 
 /// \brief height scale factor
@@ -45,16 +48,18 @@ class UnderworldRenderer
 public:
    /// ctor
    UnderworldRenderer(IGameInstance& game);
+   /// dtor
+   ~UnderworldRenderer();
 
    /// prepares renderer for rendering a new level
    void PrepareLevel(Underworld::Level& level);
 
+   /// invalidates the prepared tile geometry, e.g. after tiles were changed
+   void InvalidateTilemap();
+
    /// called for every game tick
    void Tick(double tickRate);
 
-   /// sets selection mode on or off
-   void SetSelectionMode(bool enabled) { m_selectionMode = enabled; }
-
    /// renders underworld level at given player pos and angles
    void Render(const RenderOptions& renderOptions, const Underworld::Level& level, Vector3d pos,
       double panAngle, double rotateAngle, double fieldOfView);
@@ -62,11 +67,24 @@ public:
    /// returns 3d models manager
    Model3DManager& GetModel3DManager() { return m_modelManager; }
 
+   /// returns triangles covering an object as it is rendered, for picking
+   void GetObjectPickTriangles(const RenderOptions& renderOptions,
+      const Underworld::Level& level, const Underworld::Object& object,
+      unsigned int x, unsigned int y,
+      std::vector<Triangle3dTextured>& allTriangles);
+
    /// calculates object position in 3d world
    static Vector3d CalcObjectPosition(unsigned int x, unsigned int y,
       const Underworld::Object& object);
 
 private:
+   /// collects all wall and floor textures used by a tilemap
+   static void GetUsedTextureIds(const Underworld::Tilemap& tilemap,
+      std::vector<unsigned int>& usedTextureIds);
+
+   /// prepares textures, tile geometry and visible sets for tiles of a level
+   void PrepareTilemap(const Underworld::Level& level);
+
    /// renders all objects of a tile
    void RenderObjects(const RenderOptions& renderOptions,
       const Vector3d& viewerPos, const Underworld::Level& level,
@@ -78,25 +96,47 @@ private:
       const Underworld::Object& object,
       unsigned int x, unsigned int y);
 
+   /// returns current critter texture and hotspot offsets
+   Texture& GetCritterTexture(const Underworld::Object& object,
+      double& moveU, double& moveV);
+
    /// renders a billboarded sprite
    void RenderSprite(const RenderOptions& renderOptions,
       Vector3d base, double width, double height,
       bool ignoreUpVector, double u, double v,
       double moveU = 0.0, double moveV = 0.0);
 
+   /// calculates quad points of a billboarded sprite
+   void CalcSpriteQuad(Vector3d base, double width, double height,
+      bool ignoreUpVector, double moveU, double moveV, Vector3d quad[4]) const;
+
    /// renders decal
    void RenderDecal(const Underworld::Object& object, unsigned int x, unsigned int y);
 
+   /// calculates quad points of a decal
+   static void CalcDecalQuad(const Underworld::Object& object,
+      unsigned int x, unsigned int y, Vector3d quad[4]);
+
    /// renders tmap object
    void RenderTmapObject(const RenderOptions& renderOptions,
       const Underworld::Object& object, unsigned int x, unsigned int y);
 
+   /// calculates quad points of a tmap object
+   static void CalcTmapObjectQuad(const Underworld::Object& object,
+      unsigned int x, unsigned int y, Vector3d quad[4]);
+
    /// draws a billboarded quad
    void DrawBillboardQuad(Vector3d base,
       double quadwidth, double quadheight,
       double u1, double v1, double u2, double v2);
 
 private:
+   /// width of critter sprites, relative to a tile
+   static const double c_critterSpriteWidth;
+
+   /// height of critter sprites, relative to a tile
+   static const double c_critterSpriteHeight;
+
    /// texture manager
    TextureManager m_textureManager;
 
@@ -109,9 +149,19 @@ private:
    /// scale factor for textures
    unsigned int m_scaleFactor;
 
-   /// indicates if in selection (picking) mode
-   bool m_selectionMode;
-
    /// billboard right and up vectors
    Vector3d m_billboardRightVector, m_billboardUpVector;
+
+   /// tilemap renderer for the currently prepared level
+   std::unique_ptr<LevelTilemapRenderer> m_tilemapRenderer;
+
+   /// list of visible tiles in the currently rendered frame
+   std::vector<QuadTileCoordinates> m_visibleTiles;
+
+   /// potentially visible set of tiles for prepared level
+   TilePvs m_tilePvs;
+
+   /// indicates if tiles of the prepared level were modified, and the tile
+   /// geometry has to be prepared again
+   bool m_isTilemapInvalid;
 };
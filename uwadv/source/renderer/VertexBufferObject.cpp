@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2022 Underworld Adventures Team
+// Copyright (c) 2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,9 +21,9 @@
 //
 #include "pch.hpp"
 #include "VertexBufferObject.hpp"
+#include "OpenGL.hpp"
 
 #ifndef ANDROID
-#define GL_GLEXT_PROTOTYPES
 #include <SDL2/SDL_opengl.h>
 #include <SDL2/SDL_opengl_glext.h>
 #else
@@ -34,7 +34,8 @@
 
 VertexBufferObject::VertexBufferObject(GLenum target, GLenum usage)
    :m_target(target),
-   m_usage(usage)
+   m_usage(usage),
+   m_vboName(0)
 {
    UaAssertMsg(
       target == GL_ARRAY_BUFFER_ARB ||
@@ -63,12 +64,12 @@ void VertexBufferObject::Generate()
 {
    UaAssertMsg(m_vboName == 0, "VBO must not already be created");
 
-   glGenBuffers(1, &m_vboName);
+   OpenGL::GetFunctions().m_genBuffers(1, &m_vboName);
 }
 
 void VertexBufferObject::Bind() const
 {
-   glBindBuffer(m_target, m_vboName);
+   OpenGL::GetFunctions().m_bindBuffer(m_target, m_vboName);
 
    GLenum error = glGetError();
    if (error != GL_NO_ERROR)
@@ -77,7 +78,7 @@ void VertexBufferObject::Bind() const
 
 void VertexBufferObject::Upload(const void* data, size_t elementSizeInBytes, size_t numElements)
 {
-   glBufferData(m_target, numElements * elementSizeInBytes, data, m_usage);
+   OpenGL::GetFunctions().m_bufferData(m_target, numElements * elementSizeInBytes, data, m_usage);
 
    GLenum error = glGetError();
    if (error != GL_NO_ERROR)
@@ -86,7 +87,7 @@ void VertexBufferObject::Upload(const void* data, size_t elementSizeInBytes, siz
 
 void VertexBufferObject::Unbind() const
 {
-   glBindBufferARB(m_target, 0);
+   OpenGL::GetFunctions().m_bindBuffer(m_target, 0);
 }
 
 void VertexBufferObject::Free() noexcept
@@ -94,7 +95,7 @@ void VertexBufferObject::Free() noexcept
    if (m_vboName == 0)
       return;
 
-   glDeleteBuffers(1, &m_vboName);
+   OpenGL::GetFunctions().m_deleteBuffers(1, &m_vboName);
 
    GLenum error = glGetError();
    if (error != GL_NO_ERROR)
@@ -25,7 +25,8 @@
 /// \details lets you manage a VBO that can contain (variable sized) data that
 /// can be used for rendering or in a shader program. The VBO contents are
 /// specified at Upload() or usage time (e.g. when calling gl*Pointer()
-/// functions).
+/// functions). The buffer functions are loaded at runtime, so the class may
+/// only be used when OpenGL::IsVertexBufferAvailable() returns true.
 class VertexBufferObject
 {
 public:
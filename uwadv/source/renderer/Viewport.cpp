@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -73,11 +73,7 @@ void Viewport::SetupCamera2D()
 /// Sets up camera for 3D scene rendering.
 /// \param fieldOfView field of view angle
 /// \param farDistance distance from camera to far plane
-/// \param setPickMatrix indicates if pick matrix should also be set
-/// \param pickPosX X position for picking
-/// \param pickPosY Y position for picking
-void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
-   bool setPickMatrix, int pickPosX, int pickPosY)
+void Viewport::SetupCamera3D(double fieldOfView, double farDistance)
 {
    glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
 
@@ -85,14 +81,6 @@ void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
    glMatrixMode(GL_PROJECTION);
    glLoadIdentity();
 
-   if (setPickMatrix)
-   {
-      int windowWidth = 0, windowHeight = 0;
-      m_window.GetWindowSize(windowWidth, windowHeight);
-
-      gluPickMatrix(pickPosX, windowHeight - pickPosY, 5.0, 5.0, m_viewport);
-   }
-
    double aspectRatio = double(m_viewport[2]) / m_viewport[3];
    gluPerspective(fieldOfView, aspectRatio, c_nearDistance, farDistance);
 
@@ -100,3 +88,30 @@ void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
    glMatrixMode(GL_MODELVIEW);
    glLoadIdentity();
 }
+
+/// Calculates the direction of a ray from the camera through a window
+/// position, in camera coordinates. The camera looks along the negative z
+/// axis, with x pointing right and y pointing up, as set up by
+/// SetupCamera3D().
+/// \param fieldOfView field of view angle
+/// \param pickPosX X position in window coordinates
+/// \param pickPosY Y position in window coordinates, from the top
+/// \return normalized ray direction
+Vector3d Viewport::CalcPickRayDirection(double fieldOfView,
+   int pickPosX, int pickPosY) const
+{
+   int windowWidth = 0, windowHeight = 0;
+   m_window.GetWindowSize(windowWidth, windowHeight);
+
+   // normalized device coordinates, in range [-1; 1]
+   double ndcX = 2.0 * (pickPosX - m_viewport[0]) / m_viewport[2] - 1.0;
+   double ndcY = 2.0 * (windowHeight - pickPosY - m_viewport[1]) / m_viewport[3] - 1.0;
+
+   double aspectRatio = double(m_viewport[2]) / m_viewport[3];
+   double tanHalfFov = tan(Deg2rad(fieldOfView * 0.5));
+
+   Vector3d dir(ndcX * tanHalfFov * aspectRatio, ndcY * tanHalfFov, -1.0);
+   dir.Normalize();
+
+   return dir;
+}
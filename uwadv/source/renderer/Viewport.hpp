@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,6 +21,8 @@
 //
 #pragma once
 
+#include "Vector3d.hpp"
+
 class RenderWindow;
 
 /// \brief render viewport
@@ -46,8 +48,11 @@ public:
    void SetupCamera2D();
 
    /// sets up camera for 3d scene rendering
-   void SetupCamera3D(double fieldOfView = 90.0, double farDistance = 16.0,
-      bool setPickMatrix = false, int pickPosX = 0, int pickPosY = 0);
+   void SetupCamera3D(double fieldOfView = 90.0, double farDistance = 16.0);
+
+   /// calculates direction of a picking ray through a window position
+   Vector3d CalcPickRayDirection(double fieldOfView,
+      int pickPosX, int pickPosY) const;
 
 private:
    /// render window
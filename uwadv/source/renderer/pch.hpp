@@ -26,5 +26,4 @@
 #include "Math.hpp"
 #include "Triangle3d.hpp"
 
-#define GL_GLEXT_PROTOTYPES
 #include <SDL2/SDL_opengl.h>
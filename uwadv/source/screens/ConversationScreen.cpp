@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -207,7 +207,8 @@ void ConversationScreen::Init()
       // get local strings
       // note: convslot is used to load strings, not the strblock value set in
       // conv header
-      std::vector<std::string> localStrings = m_gameInstance.GetGameStrings().GetStringBlock(m_codeVM.GetStringBlock());
+      const std::vector<std::string_view>& localStringViews = m_gameInstance.GetGameStrings().GetStringBlock(m_codeVM.GetStringBlock());
+      std::vector<std::string> localStrings{ localStringViews.begin(), localStringViews.end() };
 
       size_t level = m_gameInstance.GetUnderworld().GetPlayer().GetAttribute(Underworld::attrMapLevel);
       m_codeVM.Init(level, m_convObjectPos, this, localStrings);
@@ -398,6 +398,7 @@ void MapViewScreen::AddNewMapNote(unsigned int xpos, unsigned int ypos, std::str
    mapNote.m_text = noteText;
 
    mapNotes.GetMapNotesList().push_back(mapNote);
+   m_game.GetGameInstance().GetUnderworld().GetLevelList().SetLevelModified(m_displayedLevel);
 
    DisplayLevelMap(m_displayedLevel);
 }
@@ -470,6 +471,7 @@ void MapViewScreen::EraseMapNote(unsigned int xpos, unsigned int ypos)
       return;
 
    mapNotes.GetMapNotesList().erase(iter);
+   m_game.GetGameInstance().GetUnderworld().GetLevelList().SetLevelModified(m_displayedLevel);
 
    RemoveMapNoteSelectionImage();
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -33,7 +33,6 @@
 #include "ConversationScreen.hpp"
 #include "Model3D.hpp"
 #include "physics/PhysicsModel.hpp"
-#include "physics/GeometryProvider.hpp"
 #include "ImageManager.hpp"
 #include "FileSystem.hpp"
 
@@ -95,7 +94,7 @@ void OriginalIngameScreen::Init()
 
    m_gameInstance.GetPhysicsModel().Init(
       std::bind(
-         &OriginalIngameScreen::GetSurroundingTriangles, this,
+         &OriginalIngameScreen::GetSurroundingObjectTriangles, this,
          std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 
    // init images/subwindows
@@ -725,6 +724,9 @@ void OriginalIngameScreen::Tick()
       // do renderer-specific tick processing
       m_game.GetRenderer().Tick(GetTickRate());
    }
+
+   // store view state every tick, so that the view doesn't move when paused
+   m_game.GetRenderer().StoreTickViewState(m_gameInstance.GetUnderworld().GetPlayer());
 }
 
 void OriginalIngameScreen::OnFadeOutEnded()
@@ -910,6 +912,20 @@ void OriginalIngameScreen::Notify(UserInterfaceNotification notify,
 
    case notifyLevelChange:
       m_game.GetRenderer().PrepareLevel(m_gameInstance.GetUnderworld().GetCurrentLevel());
+      m_gameInstance.GetPhysicsModel().PrepareLevel(m_gameInstance.GetUnderworld().GetCurrentLevel());
+      break;
+
+   case notifyPlayerTileChanged:
+   {
+      const Underworld::Player& player = m_gameInstance.GetUnderworld().GetPlayer();
+      m_gameInstance.GetPhysicsModel().SetPlayerTile(
+         static_cast<unsigned int>(player.GetXPos()),
+         static_cast<unsigned int>(player.GetYPos()));
+   }
+   break;
+
+   case notifyTilemapChanged:
+      m_game.GetRenderer().InvalidateTilemap();
       break;
 
    case notifySelectTarget:
@@ -989,25 +1005,21 @@ void OriginalIngameScreen::DoSavegameScreenshot(
       xres, yres, screenshotRgbaData);
 }
 
-void OriginalIngameScreen::GetSurroundingTriangles(
+/// Collects triangles of 3d models and critter objects on the tiles around
+/// the given position. Tile triangles are stored in the physics model's
+/// collision mesh.
+void OriginalIngameScreen::GetSurroundingObjectTriangles(
    unsigned int xpos, unsigned int ypos,
    std::vector<Triangle3dTextured>& allTriangles)
 {
    Uint8 xmin, xmax, ymin, ymax;
 
    xmin = static_cast<Uint8>(xpos > 0 ? xpos - 1 : 0);
-   xmax = static_cast<Uint8>(xpos < 64 ? xpos + 1 : 64);
+   xmax = static_cast<Uint8>(xpos + 2 < 64 ? xpos + 2 : 64);
    ymin = static_cast<Uint8>(ypos > 0 ? ypos - 1 : 0);
-   ymax = static_cast<Uint8>(ypos < 64 ? ypos + 1 : 64);
-
-   // tile triangles
-   Physics::GeometryProvider provider(m_gameInstance.GetGameLogic().GetCurrentLevel());
-
-   for (unsigned int x = xmin; x < xmax; x++)
-      for (unsigned int y = ymin; y < ymax; y++)
-         provider.GetTileTriangles(x, y, allTriangles);
+   ymax = static_cast<Uint8>(ypos + 2 < 64 ? ypos + 2 : 64);
 
-   // also collect triangles from 3d models and critter objects
+   // collect triangles from 3d models and critter objects
    {
       const Underworld::ObjectList& objectList =
          m_gameInstance.GetGameLogic().GetCurrentLevel().GetObjectList();
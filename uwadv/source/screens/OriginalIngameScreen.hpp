@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -154,8 +154,8 @@ private:
    /// takes a screenshot for savegame preview
    void DoSavegameScreenshot(unsigned int xres, unsigned int yres);
 
-   /// returns triangles surrounding a tile on the current level
-   void GetSurroundingTriangles(unsigned int xpos,
+   /// returns triangles of objects surrounding a tile on the current level
+   void GetSurroundingObjectTriangles(unsigned int xpos,
       unsigned int ypos, std::vector<Triangle3dTextured>& allTriangles);
 
 private:
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -114,7 +114,14 @@ void LuaScripting::InitNewGame()
 
 void LuaScripting::EvalCritter(Uint16 pos)
 {
+   // critter scripts are optional; not all games define the function
    lua_getglobal(L, "critter_eval");
+   if (!lua_isfunction(L, -1))
+   {
+      lua_pop(L, 1);
+      return;
+   }
+
    lua_pushinteger(L, pos);
    CheckedCall(1, 0);
 }
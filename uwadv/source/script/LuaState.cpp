@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -21,6 +21,7 @@
 //
 #include "pch.hpp"
 #include "LuaState.hpp"
+#include "FrameProfiler.hpp"
 
 extern "C"
 {
@@ -122,11 +123,15 @@ int LuaState::LoadScript(Base::SDL_RWopsPtr rwops, const char* chunkname)
 
 bool LuaState::CheckedCall(int numArgs, int numResults)
 {
+   Base::ProfileScope scope{ Base::framePhaseScripting };
+
    int ret = lua_pcall(L, numArgs, numResults, 0);
    if (ret != 0)
    {
       const char* errorText = lua_tostring(L, -1);
       UaTrace("Error in Lua function call; error code %u: %s\n", ret, errorText);
+
+      lua_pop(L, 1); // error message
       return false;
    }
 
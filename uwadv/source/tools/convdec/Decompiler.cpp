@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2014,2019,2021 Underworld Adventures Team
+// Copyright (c) 2014,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -45,7 +45,8 @@ Decompiler::Decompiler(Uint16 conversationNumber, std::string basePath, GameStri
    if (!Import::LoadConvCode(codeVM, settings, resourceManager, "data/cnv.ark", conversationNumber))
       return;
 
-   std::vector<std::string> stringBlock = strings.GetStringBlock(0x0e00 + conversationNumber);
+   const std::vector<std::string_view>& stringViews = strings.GetStringBlock(0x0e00 + conversationNumber);
+   std::vector<std::string> stringBlock{ stringViews.begin(), stringViews.end() };
 
    m_codeGraph.reset(new Conv::CodeGraph(codeVM.GetCodeSegment(),
       0,
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -95,7 +95,7 @@ void strpak_unpack_strings(const char *infile, const char *outputFilename)
    for (; iter != stop; iter++)
    {
       Uint16 blockId = *iter;
-      std::vector<std::string> stringList = gs.GetStringBlock(blockId);
+      const std::vector<std::string_view>& stringList = gs.GetStringBlock(blockId);
 
       out.WriteLine("");
 
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,6 +25,7 @@
 #include "ResourceManager.hpp"
 #include "ArchiveFile.hpp"
 #include <SDL_pnglite.h>
+#include <algorithm>
 
 void ImageManager::Init()
 {
@@ -95,15 +96,15 @@ void ImageManager::LoadFromArk(IndexedImage& image, const char* arkFilename,
 {
    Base::ArchiveFile arkFile
    {
-      m_resourceManager.GetUnderworldFile(Base::resourceGameUw2, "data/byt.ark"),
+      m_resourceManager.MapUnderworldFile(Base::resourceGameUw2, "data/byt.ark"),
       true
    };
 
    image.Create(320, 200);
 
-   Base::File imageFile = arkFile.GetFile(imageNumber);
+   Base::ByteSpan imageData = arkFile.GetBlock(imageNumber);
    std::vector<Uint8>& pixels = image.GetPixels();
-   imageFile.ReadBuffer(&pixels[0], 320 * 200);
+   std::copy_n(imageData.m_data, std::min<size_t>(imageData.m_size, pixels.size()), pixels.begin());
 
    image.SetPalette(m_allPalettes[paletteIndex]);
 }
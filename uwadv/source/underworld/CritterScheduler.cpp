@@ -0,0 +1,269 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CritterScheduler.cpp
+/// \brief scheduler for critter AI evaluation
+//
+#include "pch.hpp"
+#include "CritterScheduler.hpp"
+#include "Level.hpp"
+#include <algorithm>
+
+using Underworld::CritterScheduler;
+using Underworld::CritterDetailLevel;
+
+/// max. distance of near critters, in tiles
+static const double c_nearDistance = 8.0;
+
+/// max. distance of mid-range critters, in tiles
+static const double c_midDistance = 24.0;
+
+/// default time budget per tick, in seconds
+static const double c_defaultTimeBudget = 0.002;
+
+/// number of ticks after which the critters of the level are collected again
+static const Uint32 c_collectInterval = 64;
+
+CritterScheduler::CritterScheduler()
+   :m_timeBudget(c_defaultTimeBudget),
+   m_tickCount(0),
+   m_nextCollectTick(0)
+{
+   m_tickIntervals[critterDetailNear] = 1;
+   m_tickIntervals[critterDetailMid] = 4;
+   m_tickIntervals[critterDetailFar] = 16;
+
+   Reset();
+}
+
+void CritterScheduler::Init(T_fnEvaluateCritter fnEvaluateCritter)
+{
+   m_fnEvaluateCritter = fnEvaluateCritter;
+}
+
+/// \param detailLevel detail level to set interval for
+/// \param tickInterval number of ticks between evaluations; must be at least 1
+void CritterScheduler::SetTickInterval(CritterDetailLevel detailLevel, unsigned int tickInterval)
+{
+   UaAssert(detailLevel < critterDetailMax);
+   UaAssert(tickInterval > 0);
+
+   m_tickIntervals[detailLevel] = std::max(1u, tickInterval);
+}
+
+/// Since critters are identified by their object list position, the
+/// scheduler must be reset when the level changes. The critters of the new
+/// level are collected in the next tick.
+void CritterScheduler::Reset()
+{
+   m_critters.clear();
+   m_nextCollectTick = m_tickCount;
+
+   m_stats = CritterSchedulerStats{};
+}
+
+/// Updates the detail levels of all critters and evaluates the critters
+/// that are due, until the time budget is used up.
+/// \param level current level
+/// \param playerXPos player x position, in tiles
+/// \param playerYPos player y position, in tiles
+void CritterScheduler::Tick(const Level& level, double playerXPos, double playerYPos)
+{
+   m_tickCount++;
+
+   if (m_tickCount > m_nextCollectTick)
+      CollectCritters(level);
+
+   std::fill(std::begin(m_stats.m_numCritters), std::end(m_stats.m_numCritters), 0);
+   std::fill(std::begin(m_stats.m_numEvaluated), std::end(m_stats.m_numEvaluated), 0);
+   m_stats.m_numDeferred = 0;
+   m_stats.m_evaluationTime = 0.0;
+
+   const ObjectList& objectList = level.GetObjectList();
+
+   m_dueCritters.clear();
+
+   for (size_t index = 0; index < m_critters.size();)
+   {
+      CritterInfo& critter = m_critters[index];
+
+      // remove critters that were deleted or taken out of their tile
+      const ObjectPtr objPtr = critter.m_objectPos < objectList.GetObjectListSize()
+         ? objectList.GetObject(critter.m_objectPos) : ObjectPtr();
+
+      if (objPtr == nullptr || !objPtr->IsNpcObject() ||
+         objPtr->GetPosInfo().m_tileX == c_tileNotAPos)
+      {
+         critter = m_critters.back();
+         m_critters.pop_back();
+         continue;
+      }
+
+      CritterDetailLevel detailLevel = GetDetailLevel(level,
+         objPtr->GetPosInfo().m_tileX, objPtr->GetPosInfo().m_tileY, playerXPos, playerYPos);
+
+      // critters that came nearer don't wait for their longer interval to
+      // run out; spread them over the new interval by object position
+      unsigned int tickInterval = m_tickIntervals[detailLevel];
+      if (critter.m_nextTick >= m_tickCount + tickInterval)
+         critter.m_nextTick = m_tickCount + critter.m_objectPos % tickInterval;
+
+      critter.m_detailLevel = static_cast<Uint8>(detailLevel);
+      m_stats.m_numCritters[detailLevel]++;
+
+      if (critter.m_nextTick <= m_tickCount)
+         m_dueCritters.push_back(index);
+
+      index++;
+   }
+
+   // nearer critters first, then the ones waiting longest
+   std::sort(m_dueCritters.begin(), m_dueCritters.end(), [this](size_t lhs, size_t rhs)
+   {
+      const CritterInfo& lhsInfo = m_critters[lhs];
+      const CritterInfo& rhsInfo = m_critters[rhs];
+
+      return lhsInfo.m_detailLevel != rhsInfo.m_detailLevel
+         ? lhsInfo.m_detailLevel < rhsInfo.m_detailLevel
+         : lhsInfo.m_nextTick < rhsInfo.m_nextTick;
+   });
+
+   const Uint64 budgetCounts = static_cast<Uint64>(m_timeBudget * SDL_GetPerformanceFrequency());
+   const Uint64 startCounter = SDL_GetPerformanceCounter();
+   Uint64 counter = startCounter;
+
+   for (size_t dueIndex = 0; dueIndex < m_dueCritters.size(); dueIndex++)
+   {
+      // at least one critter is evaluated per tick; deferred critters stay
+      // due and are evaluated first in the next tick
+      if (dueIndex > 0 && counter - startCounter >= budgetCounts)
+      {
+         m_stats.m_numDeferred = static_cast<unsigned int>(m_dueCritters.size() - dueIndex);
+         break;
+      }
+
+      CritterInfo& critter = m_critters[m_dueCritters[dueIndex]];
+      critter.m_nextTick = m_tickCount + m_tickIntervals[critter.m_detailLevel];
+
+      m_stats.m_numEvaluated[critter.m_detailLevel]++;
+      m_stats.m_totalEvaluations++;
+
+      if (m_fnEvaluateCritter)
+         m_fnEvaluateCritter(critter.m_objectPos);
+
+      counter = SDL_GetPerformanceCounter();
+   }
+
+   m_stats.m_evaluationTime = double(counter - startCounter) / SDL_GetPerformanceFrequency();
+}
+
+/// Critters already known keep their schedule; new critters are spread
+/// over the ticks by their object position.
+void CritterScheduler::CollectCritters(const Level& level)
+{
+   m_nextCollectTick = m_tickCount + c_collectInterval;
+
+   const ObjectList& objectList = level.GetObjectList();
+   Uint16 objectListSize = objectList.GetObjectListSize();
+
+   std::vector<bool> isKnown(objectListSize, false);
+   for (const CritterInfo& critter : m_critters)
+      if (critter.m_objectPos < objectListSize)
+         isKnown[critter.m_objectPos] = true;
+
+   // position 0 is never used for objects
+   for (Uint16 objectPos = 1; objectPos < objectListSize; objectPos++)
+   {
+      if (isKnown[objectPos])
+         continue;
+
+      const ObjectPtr objPtr = objectList.GetObject(objectPos);
+      if (objPtr == nullptr || !objPtr->IsNpcObject() ||
+         objPtr->GetPosInfo().m_tileX == c_tileNotAPos)
+         continue;
+
+      CritterInfo critter;
+      critter.m_objectPos = objectPos;
+      critter.m_detailLevel = critterDetailFar;
+      critter.m_nextTick = m_tickCount + objectPos % m_tickIntervals[critterDetailFar];
+
+      m_critters.push_back(critter);
+   }
+}
+
+CritterDetailLevel CritterScheduler::GetDetailLevel(const Level& level,
+   unsigned int tileX, unsigned int tileY, double playerXPos, double playerYPos) const
+{
+   double dx = tileX + 0.5 - playerXPos;
+   double dy = tileY + 0.5 - playerYPos;
+   double distanceSquared = dx * dx + dy * dy;
+
+   if (distanceSquared > c_midDistance * c_midDistance)
+      return critterDetailFar;
+
+   unsigned int playerTileX = static_cast<unsigned int>(std::max(0.0, playerXPos));
+   unsigned int playerTileY = static_cast<unsigned int>(std::max(0.0, playerYPos));
+
+   if (distanceSquared <= c_nearDistance * c_nearDistance &&
+      IsTileVisible(level, tileX, tileY, playerTileX, playerTileY))
+      return critterDetailNear;
+
+   return critterDetailMid;
+}
+
+/// Walks along the tiles of the line between the tile centers, using
+/// Bresenham's algorithm; any solid tile between the tiles blocks the view.
+bool CritterScheduler::IsTileVisible(const Level& level, unsigned int fromX, unsigned int fromY,
+   unsigned int toX, unsigned int toY)
+{
+   const Tilemap& tilemap = level.GetTilemap();
+
+   int xpos = static_cast<int>(fromX);
+   int ypos = static_cast<int>(fromY);
+   int endX = static_cast<int>(std::min(toX, c_underworldTilemapSize - 1));
+   int endY = static_cast<int>(std::min(toY, c_underworldTilemapSize - 1));
+
+   int dx = std::abs(endX - xpos);
+   int dy = -std::abs(endY - ypos);
+   int stepX = xpos < endX ? 1 : -1;
+   int stepY = ypos < endY ? 1 : -1;
+   int error = dx + dy;
+
+   for (;;)
+   {
+      if (xpos == endX && ypos == endY)
+         return true;
+
+      int error2 = 2 * error;
+      if (error2 >= dy)
+      {
+         error += dy;
+         xpos += stepX;
+      }
+
+      if (error2 <= dx)
+      {
+         error += dx;
+         ypos += stepY;
+      }
+
+      if ((xpos != endX || ypos != endY) &&
+         tilemap.GetTileInfo(static_cast<unsigned int>(xpos), static_cast<unsigned int>(ypos)).m_type == tileSolid)
+         return false;
+   }
+}
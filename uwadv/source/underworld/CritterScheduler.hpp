@@ -0,0 +1,149 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CritterScheduler.hpp
+/// \brief scheduler for critter AI evaluation
+//
+#pragma once
+
+#include <vector>
+#include <functional>
+
+namespace Underworld
+{
+   class Level;
+
+   /// AI level of detail of a critter
+   enum CritterDetailLevel
+   {
+      critterDetailNear = 0,  ///< near and visible critters; evaluated every tick
+      critterDetailMid,       ///< mid-range or hidden critters
+      critterDetailFar,       ///< far away critters
+
+      critterDetailMax // must be the last element
+   };
+
+   /// critter scheduler statistics
+   struct CritterSchedulerStats
+   {
+      /// number of critters on the level, per detail level
+      unsigned int m_numCritters[critterDetailMax];
+
+      /// number of critters evaluated in the last tick, per detail level
+      unsigned int m_numEvaluated[critterDetailMax];
+
+      /// number of critters that were due in the last tick, but were
+      /// deferred to the next tick since the time budget was used up
+      unsigned int m_numDeferred;
+
+      /// time used to evaluate critters in the last tick, in seconds
+      double m_evaluationTime;
+
+      /// number of critter evaluations since the scheduler was reset
+      unsigned int m_totalEvaluations;
+   };
+
+   /// function type that evaluates a critter, e.g. by calling its AI script
+   typedef std::function<void(Uint16 objectPos)> T_fnEvaluateCritter;
+
+   /// \brief Schedules critter AI evaluation by distance and visibility
+   /// \details Sorts the NPC objects of the current level into detail levels,
+   /// by their distance to the player and by a line of sight test through
+   /// the tilemap. Near critters that the player can see are evaluated every
+   /// tick; mid-range and hidden critters, and far away critters, are only
+   /// evaluated every few ticks, spread out over the ticks. The evaluations
+   /// done in a tick are limited by a time budget; when the budget is used
+   /// up, the remaining due critters are deferred to the next tick, nearer
+   /// and longer waiting critters first. This keeps the tick time flat, even
+   /// on levels with many NPCs.
+   class CritterScheduler
+   {
+   public:
+      /// ctor
+      CritterScheduler();
+
+      /// inits the scheduler
+      void Init(T_fnEvaluateCritter fnEvaluateCritter);
+
+      /// sets time budget for critter evaluation per tick, in seconds
+      void SetTimeBudget(double timeBudget) { m_timeBudget = timeBudget; }
+
+      /// sets tick interval of a detail level
+      void SetTickInterval(CritterDetailLevel detailLevel, unsigned int tickInterval);
+
+      /// resets scheduler, e.g. when the level changed
+      void Reset();
+
+      /// evaluates all critters due in this tick
+      void Tick(const Level& level, double playerXPos, double playerYPos);
+
+      /// returns statistics of the last tick
+      const CritterSchedulerStats& GetStats() const { return m_stats; }
+
+   private:
+      /// scheduling infos of a critter
+      struct CritterInfo
+      {
+         /// object list position of the critter
+         Uint16 m_objectPos;
+
+         /// current detail level
+         Uint8 m_detailLevel;
+
+         /// tick number in which the critter is due to be evaluated next
+         Uint32 m_nextTick;
+      };
+
+      /// collects all NPC objects of the level that are placed in a tile
+      void CollectCritters(const Level& level);
+
+      /// determines detail level of a critter
+      CritterDetailLevel GetDetailLevel(const Level& level, unsigned int tileX, unsigned int tileY,
+         double playerXPos, double playerYPos) const;
+
+      /// returns if there's a line of sight between two tiles
+      static bool IsTileVisible(const Level& level, unsigned int fromX, unsigned int fromY,
+         unsigned int toX, unsigned int toY);
+
+   private:
+      /// function to evaluate a critter
+      T_fnEvaluateCritter m_fnEvaluateCritter;
+
+      /// time budget for critter evaluation per tick, in seconds
+      double m_timeBudget;
+
+      /// tick intervals of all detail levels
+      unsigned int m_tickIntervals[critterDetailMax];
+
+      /// current tick number
+      Uint32 m_tickCount;
+
+      /// tick number at which the critters are collected again
+      Uint32 m_nextCollectTick;
+
+      /// all critters of the level
+      std::vector<CritterInfo> m_critters;
+
+      /// indices into m_critters of critters due in the current tick
+      std::vector<size_t> m_dueCritters;
+
+      /// statistics of the last tick
+      CritterSchedulerStats m_stats;
+   };
+
+} // namespace Underworld
@@ -0,0 +1,89 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FreeSlotSet.cpp
+/// \brief set of free list slots
+//
+#include "pch.hpp"
+#include "FreeSlotSet.hpp"
+#ifdef HAVE_MSVC
+#include <intrin.h>
+#endif
+
+using Underworld::FreeSlotSet;
+
+/// returns index of the lowest set bit; value must not be zero
+static unsigned int GetLowestSetBit(Uint64 value)
+{
+#ifdef HAVE_MSVC
+   unsigned long index = 0;
+   _BitScanForward64(&index, value);
+   return static_cast<unsigned int>(index);
+#else
+   return static_cast<unsigned int>(__builtin_ctzll(value));
+#endif
+}
+
+void FreeSlotSet::Clear()
+{
+   m_numSlots = 0;
+   m_slotBits.clear();
+   m_groupBits.clear();
+}
+
+void FreeSlotSet::Resize(size_t numSlots)
+{
+   size_t oldNumSlots = m_numSlots;
+   m_numSlots = numSlots;
+
+   m_slotBits.resize((numSlots + 63) / 64, 0);
+   m_groupBits.resize((m_slotBits.size() + 63) / 64, 0);
+
+   if (numSlots < oldNumSlots)
+   {
+      // remove bits of the slots past the end, and update the groups
+      if (numSlots % 64 != 0)
+         m_slotBits.back() &= (Uint64(1) << (numSlots % 64)) - 1;
+
+      std::fill(m_groupBits.begin(), m_groupBits.end(), 0);
+
+      for (size_t index = 0; index < m_slotBits.size(); index++)
+         if (m_slotBits[index] != 0)
+            m_groupBits[index / 64] |= Uint64(1) << (index % 64);
+
+      return;
+   }
+
+   for (size_t pos = oldNumSlots; pos < numSlots; pos++)
+      SetFree(pos);
+}
+
+size_t FreeSlotSet::FindFirstFree() const
+{
+   for (size_t groupIndex = 0; groupIndex < m_groupBits.size(); groupIndex++)
+   {
+      Uint64 groupBits = m_groupBits[groupIndex];
+      if (groupBits == 0)
+         continue;
+
+      size_t index = groupIndex * 64 + GetLowestSetBit(groupBits);
+      return index * 64 + GetLowestSetBit(m_slotBits[index]);
+   }
+
+   return c_noFreeSlot;
+}
@@ -0,0 +1,93 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FreeSlotSet.hpp
+/// \brief set of free list slots
+//
+#pragma once
+
+#include <vector>
+
+namespace Underworld
+{
+   /// \brief Set of free slots of a list
+   /// \details Stores a bit for every slot of a list, e.g. the object list or
+   /// the inventory, that indicates if the slot is free. A second level of
+   /// bits indicates which groups of 64 slots contain a free slot, so that the
+   /// first free slot is found by looking at a few words instead of checking
+   /// every slot of the list.
+   class FreeSlotSet
+   {
+   public:
+      /// value returned by FindFirstFree() when there is no free slot
+      static const size_t c_noFreeSlot = ~size_t(0);
+
+      /// ctor
+      FreeSlotSet()
+         :m_numSlots(0)
+      {
+      }
+
+      /// removes all slots
+      void Clear();
+
+      /// resizes set to given number of slots; new slots are free
+      void Resize(size_t numSlots);
+
+      /// returns number of slots
+      size_t GetSize() const { return m_numSlots; }
+
+      /// returns if given slot is free
+      bool IsFree(size_t pos) const
+      {
+         return (m_slotBits[pos / 64] & (Uint64(1) << (pos % 64))) != 0;
+      }
+
+      /// marks slot as free
+      void SetFree(size_t pos)
+      {
+         m_slotBits[pos / 64] |= Uint64(1) << (pos % 64);
+         m_groupBits[pos / 4096] |= Uint64(1) << ((pos / 64) % 64);
+      }
+
+      /// marks slot as used
+      void SetUsed(size_t pos)
+      {
+         Uint64& slotBits = m_slotBits[pos / 64];
+         slotBits &= ~(Uint64(1) << (pos % 64));
+
+         if (slotBits == 0)
+            m_groupBits[pos / 4096] &= ~(Uint64(1) << ((pos / 64) % 64));
+      }
+
+      /// returns position of the free slot with the lowest position, or
+      /// c_noFreeSlot when all slots are used
+      size_t FindFirstFree() const;
+
+   private:
+      /// number of slots
+      size_t m_numSlots;
+
+      /// bits indicating free slots, 64 slots per word
+      std::vector<Uint64> m_slotBits;
+
+      /// bits indicating words of m_slotBits that contain a free slot
+      std::vector<Uint64> m_groupBits;
+   };
+
+} // namespace Underworld
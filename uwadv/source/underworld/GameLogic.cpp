@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019,2021 Underworld Adventures Team
+// Copyright (c) 2006,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -36,6 +36,12 @@ GameLogic::GameLogic(IScripting* scripting)
    m_attackPower = 0;
 
    m_underworld.GetPlayer().GetInventory().SetObjectProperties(GetObjectProperties());
+
+   m_critterScheduler.Init([this](Uint16 objectPos)
+   {
+      if (m_scripting != NULL)
+         m_scripting->EvalCritter(objectPos);
+   });
 }
 
 void GameLogic::EvaluateUnderworld(double time)
@@ -55,9 +61,12 @@ void GameLogic::EvaluateUnderworld(double time)
          m_userInterface->Notify(::notifyUpdatePowergem);
    }
 
-   CheckAutomapTileChanged();
+   CheckPlayerTileChanged();
    CheckMoveTrigger();
 
+   const Player& player = GetUnderworld().GetPlayer();
+   m_critterScheduler.Tick(GetCurrentLevel(), player.GetXPos(), player.GetYPos());
+
    m_lastEvalTime = time;
 }
 
@@ -157,22 +166,32 @@ unsigned int GameLogic::GetInventoryWeight() const
    return inventory.GetInventoryWeight() / 10;
 }
 
-void GameLogic::CheckAutomapTileChanged()
+void GameLogic::CheckPlayerTileChanged()
 {
-   if (GetUnderworld().GetCurrentLevel().GetTilemap().IsAutomapDisabled())
-      return;
-
    const Player& player = GetUnderworld().GetPlayer();
    size_t currentLevel = player.GetAttribute(attrMapLevel);
 
    unsigned int tileX = (unsigned int)player.GetXPos();
    unsigned int tileY = (unsigned int)player.GetYPos();
 
+   if (m_lastPlayerLevel != currentLevel)
+   {
+      m_critterScheduler.Reset();
+
+      // the level the player is on is modified while playing
+      m_underworld.GetLevelList().SetLevelModified(currentLevel);
+      m_underworld.GetLevelList().PrefetchConnectedLevels(currentLevel);
+   }
+
    if (m_lastPlayerLevel != currentLevel ||
       m_lastPlayerTileX != tileX ||
       m_lastPlayerTileY != tileY)
    {
-      RevealAutomapAtTile(tileX, tileY);
+      if (!GetCurrentLevel().GetTilemap().IsAutomapDisabled())
+         RevealAutomapAtTile(tileX, tileY);
+
+      if (m_userInterface != nullptr)
+         m_userInterface->Notify(::notifyPlayerTileChanged);
    }
 
    m_lastPlayerLevel = currentLevel;
@@ -216,80 +235,59 @@ void GameLogic::CheckMoveTrigger()
       m_underworld.GetPlayer().GetHeight(),
    };
 
-   unsigned int tilex = static_cast<unsigned int>(playerPos[0]);
-   unsigned int tiley = static_cast<unsigned int>(playerPos[1]);
+   // check move triggers near the player; triggers that are near, but not
+   // in range, are deactivated
+   ObjectList& objectList = GetCurrentLevel().GetObjectList();
+   objectList.QueryRadius(playerPos[0], playerPos[1], 1.5,
+      1 << objectClassMoveTrigger, m_nearbyObjects);
+
+   for (Uint16 pos : m_nearbyObjects)
+   {
+      // check if move trigger is in range
+      const ObjectPtr& obj = objectList.GetObject(pos);
+      ObjectPositionInfo& posInfo = obj->GetPosInfo();
 
-   // check all surrounding tiles
-   for (int i = -1; i < 2; i++)
-      for (int j = -1; j < 2; j++)
+      double triggerPos[3] =
       {
-         int x = static_cast<int>(tilex) + i;
-         int y = static_cast<int>(tiley) + j;
-         if (x < 0 || y < 0 || x >= 64 || y >= 64)
-            continue;
+         posInfo.m_tileX + (posInfo.m_xpos + 0.5) / 8.0,
+         posInfo.m_tileY + (posInfo.m_ypos + 0.5) / 8.0,
+         double(posInfo.m_zpos),
+      };
+
+      double dx = triggerPos[0] - playerPos[0];
+      double dy = triggerPos[1] - playerPos[1];
+      double dz = triggerPos[2] - playerPos[2];
+
+      double distance = sqrt(dx * dx + dy * dy + dz * dz);
 
-         ObjectList& objectList = GetCurrentLevel().GetObjectList();
+      if (distance < 0.5)
+      {
+         // trigger in range
+
+         // check if trigger already active
+         if (m_activeTriggers.find(pos) == m_activeTriggers.end())
+         {
+            // not active yet
+            m_activeTriggers.insert(pos);
 
-         // check tile objects for move trigger
-         Uint16 pos =
-            objectList.GetListStart(
-               static_cast<Uint8>(x), static_cast<Uint8>(y));
+            UaTrace("move trigger: activate trigger at %04x\n", pos);
 
-         while (pos != 0)
+            if (m_scripting != NULL)
+               m_scripting->TriggerSetOff(pos);
+         }
+         else
+         {
+            // trigger is active; do nothing
+         }
+      }
+      else
+      {
+         // not in range; check if we can deactivate it
+         if (m_activeTriggers.find(pos) != m_activeTriggers.end())
          {
-            // check if move trigger
-            const ObjectPtr& obj = objectList.GetObject(pos);
-            if (obj->GetObjectInfo().m_itemID == 0x01a0)
-            {
-               // found move trigger; check if it's in range
-               ObjectPositionInfo& posInfo = obj->GetPosInfo();
-
-               double triggerPos[3] =
-               {
-                  posInfo.m_tileX + (posInfo.m_xpos + 0.5) / 8.0,
-                  posInfo.m_tileY + (posInfo.m_ypos + 0.5) / 8.0,
-                  double(posInfo.m_zpos),
-               };
-
-               double dx = triggerPos[0] - playerPos[0];
-               double dy = triggerPos[1] - playerPos[1];
-               double dz = triggerPos[2] - playerPos[2];
-
-               double distance = sqrt(dx * dx + dy * dy + dz * dz);
-
-               if (distance < 0.5)
-               {
-                  // trigger in range
-
-                  // check if trigger already active
-                  if (m_activeTriggers.find(pos) == m_activeTriggers.end())
-                  {
-                     // not active yet
-                     m_activeTriggers.insert(pos);
-
-                     UaTrace("move trigger: activate trigger at %04x\n", pos);
-
-                     if (m_scripting != NULL)
-                        m_scripting->TriggerSetOff(pos);
-                  }
-                  else
-                  {
-                     // trigger is active; do nothing
-                  }
-               }
-               else
-               {
-                  // not in range; check if we can deactivate it
-                  if (m_activeTriggers.find(pos) != m_activeTriggers.end())
-                  {
-                     UaTrace("move trigger: deactivate trigger at %04x\n", pos);
-                     m_activeTriggers.erase(pos);
-                  }
-               }
-            }
-
-            // next object in chain
-            pos = obj->GetObjectInfo().m_link;
+            UaTrace("move trigger: deactivate trigger at %04x\n", pos);
+            m_activeTriggers.erase(pos);
          }
       }
+   }
 }
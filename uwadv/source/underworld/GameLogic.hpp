@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,6 +27,7 @@
 #include "Properties.hpp"
 #include "GameStrings.hpp"
 #include "IUserInterface.hpp"
+#include "CritterScheduler.hpp"
 
 class IScripting;
 
@@ -112,9 +113,13 @@ namespace Underworld
          return m_underworld;
       }
 
+      /// returns critter scheduler, e.g. to adjust its time budget or to
+      /// show its statistics
+      CritterScheduler& GetCritterScheduler() { return m_critterScheduler; }
+
    private:
-      /// check if the player changed the tile and automapping should be updated
-      void CheckAutomapTileChanged();
+      /// checks if the player changed the tile; updates automap and notifies user interface
+      void CheckPlayerTileChanged();
 
       /// reveals automap at and around tile
       void RevealAutomapAtTile(unsigned int tileX, unsigned tileY);
@@ -153,6 +158,9 @@ namespace Underworld
       /// set with active triggers
       std::set<Uint16> m_activeTriggers;
 
+      /// objects found near the player; kept to reuse its memory
+      std::vector<Uint16> m_nearbyObjects;
+
       /// object properties
       ObjectProperties m_properties;
 
@@ -161,6 +169,9 @@ namespace Underworld
 
       /// underworld object
       Underworld m_underworld;
+
+      /// scheduler for critter AI evaluation
+      CritterScheduler m_critterScheduler;
    };
 
 } // namespace Underworld
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,22 +27,32 @@ bool GameStrings::IsBlockAvail(Uint16 blockId) const
    return m_blockSet.find(blockId) != m_blockSet.end();
 }
 
-const std::vector<std::string>& GameStrings::GetStringBlock(Uint16 blockId) const
+/// Returns the string block; the block is decoded on first access. The string
+/// views stay valid until the block is replaced by loading another strings file.
+/// \param blockId block ID of string block
+/// \return string block; an empty block when the block cannot be found
+const std::vector<std::string_view>& GameStrings::GetStringBlock(Uint16 blockId) const
 {
-   if (!IsBlockAvail(blockId))
+   auto iter = m_allStrings.find(blockId);
+   if (iter == m_allStrings.end())
    {
       UaTrace("string block %04x cannot be found\n", blockId);
 
-      static std::vector<std::string> dummyBlock;
+      static std::vector<std::string_view> dummyBlock;
       return dummyBlock;
    }
 
-   auto iter = m_allStrings.find(blockId);
-   return iter->second;
+   StringBlock& block = iter->second;
+   if (block.m_fnDecodeStringBlock != nullptr)
+   {
+      block.m_fnDecodeStringBlock(block.m_text, block.m_strings);
+      block.m_fnDecodeStringBlock = nullptr;
+   }
+
+   return block.m_strings;
 }
 
 std::string GameStrings::GetString(Uint16 blockId, size_t stringNumber) const
-
 {
    if (!IsBlockAvail(blockId))
    {
@@ -50,13 +60,27 @@ std::string GameStrings::GetString(Uint16 blockId, size_t stringNumber) const
       return std::string();
    }
 
-   auto block = GetStringBlock(blockId);
+   const std::vector<std::string_view>& block = GetStringBlock(blockId);
 
    if (stringNumber < block.size())
-      return block[stringNumber];
+      return std::string{ block[stringNumber] };
    else
    {
       UaTrace("string %u in block %04x cannot be found\n", stringNumber, blockId);
       return std::string();
    }
 }
+
+/// Adds a string block or replaces an existing one, e.g. when loading strings
+/// from a custom strings file that override the game's strings.
+/// \param blockId block ID of string block
+/// \param fnDecodeStringBlock function to decode the string block
+void GameStrings::SetStringBlock(Uint16 blockId, T_fnDecodeStringBlock fnDecodeStringBlock)
+{
+   m_blockSet.insert(blockId);
+
+   StringBlock& block = m_allStrings[blockId];
+   block.m_fnDecodeStringBlock = fnDecodeStringBlock;
+   block.m_text.clear();
+   block.m_strings.clear();
+}
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,7 +24,10 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <set>
+#include <functional>
+#include <utility>
 #include "Settings.hpp"
 
 namespace Import
@@ -35,18 +38,23 @@ namespace Import
 /// \brief Game strings class
 /// \details Game strings are contained in blocks that contain a list of strings. Each
 /// block contains specific strings, for item descriptions, cutscene text or
-/// conversations.
+/// conversations. Blocks are decoded when they are first accessed. All
+/// strings of a block are stored one after another in a single text buffer.
 class GameStrings
 {
 public:
+   /// function type to decode a string block; appends all strings to the
+   /// text and adds a view for each string, pointing into the text
+   typedef std::function<void(std::string& text, std::vector<std::string_view>& strings)> T_fnDecodeStringBlock;
+
    /// ctor
    GameStrings() {}
 
    /// returns if block ID is available
    bool IsBlockAvail(Uint16 blockId) const;
 
-   /// returns a whole string block
-   const std::vector<std::string>& GetStringBlock(Uint16 blockId) const;
+   /// returns a whole string block; decodes the block when not decoded yet
+   const std::vector<std::string_view>& GetStringBlock(Uint16 blockId) const;
 
    /// returns a set of all string blocks available
    const std::set<Uint16>& GetStringBlockSet() const
@@ -60,21 +68,55 @@ public:
 private:
    friend Import::GameStringsImporter;
 
-   /// returns a set of all string blocks available
-   std::set<Uint16>& GetStringBlockSet()
-   {
-      return m_blockSet;
-   }
+   /// adds or replaces a string block that is decoded on first access
+   void SetStringBlock(Uint16 blockId, T_fnDecodeStringBlock fnDecodeStringBlock);
 
-   /// returns a set of all string blocks available
-   std::map<Uint16, std::vector<std::string>>& GetAllStrings()
+private:
+   /// string block entry
+   struct StringBlock
    {
-      return m_allStrings;
-   }
+      /// ctor
+      StringBlock() = default;
+
+      /// deleted copy ctor; the copied strings would point into the source
+      StringBlock(const StringBlock&) = delete;
+      /// deleted assignment operator
+      StringBlock& operator=(const StringBlock&) = delete;
+
+      /// move ctor
+      StringBlock(StringBlock&& block) noexcept
+      {
+         *this = std::move(block);
+      }
+
+      /// move assignment operator; the strings are moved to the moved text,
+      /// since short texts are stored inside the string object
+      StringBlock& operator=(StringBlock&& block) noexcept
+      {
+         const char* oldText = block.m_text.data();
+
+         m_fnDecodeStringBlock = std::move(block.m_fnDecodeStringBlock);
+         m_text = std::move(block.m_text);
+         m_strings = std::move(block.m_strings);
+
+         for (std::string_view& text : m_strings)
+            text = std::string_view(m_text.data() + (text.data() - oldText), text.size());
+
+         return *this;
+      }
+
+      /// function to decode the block; empty when already decoded
+      T_fnDecodeStringBlock m_fnDecodeStringBlock;
+
+      /// text of all strings in the block
+      std::string m_text;
+
+      /// all strings in the block, pointing into the text
+      std::vector<std::string_view> m_strings;
+   };
 
-private:
    /// a map with all string blocks
-   std::map<Uint16, std::vector<std::string>> m_allStrings;
+   mutable std::map<Uint16, StringBlock> m_allStrings;
 
    /// set with all blocks that are available
    std::set<Uint16> m_blockSet;
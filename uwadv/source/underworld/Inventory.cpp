@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -26,6 +26,7 @@
 #include "Savegame.hpp"
 
 using Underworld::Inventory;
+using Underworld::FreeSlotSet;
 
 Underworld::ObjectProperties g_emptyObjectProperties;
 
@@ -66,6 +67,7 @@ Inventory::Inventory()
    GetObjectInfo(3).m_isQuantity = false;
    GetObjectInfo(7).m_isQuantity = false;
 
+   UpdateFreeSlots();
    BuildSlotList(c_inventorySlotNoItem);
 #endif
 }
@@ -87,6 +89,7 @@ void Inventory::AddItemCombineRule(Uint16 firstItemID, Uint16 secondItemID,
 void Inventory::Create()
 {
    m_objectList.resize(0x0100);
+   UpdateFreeSlots();
 
    m_floatingObjectPos = c_inventorySlotNoItem;
 }
@@ -94,40 +97,48 @@ void Inventory::Create()
 void Inventory::Destroy()
 {
    m_objectList.clear();
+   m_freeSlots.Clear();
    m_slotList.clear();
    m_containerStack.clear();
 
    m_floatingObjectPos = c_inventorySlotNoItem;
 }
 
+/// Allocates the free object slot with the lowest position, after the
+/// paperdoll objects. The slot must be used by setting an item ID.
 Uint16 Inventory::Allocate()
 {
-   // start after paperdoll objects
-   Uint16 pos = slotMax;
-   Uint16 size = static_cast<Uint16>(m_objectList.size());
-   while (pos < size && m_objectList[pos].m_itemID != c_itemIDNone)
-      pos++;
-
-   // hit end of list?
-   if (pos >= m_objectList.size())
+   for (;;)
    {
-      // already at maximum size?
-      if (m_objectList.size() >= 0x10000)
-         throw Base::RuntimeException("Error while enlarging inventory list; already at maximum size");
+      size_t pos = m_freeSlots.FindFirstFree();
+      if (pos == FreeSlotSet::c_noFreeSlot)
+         break;
 
-      // new pos is start of enlarged list
-      pos = static_cast<Uint16>(m_objectList.size());
+      m_freeSlots.SetUsed(pos);
 
-      // enlarge list by factor 1,25
-      size_t newSize = m_objectList.size();
-      newSize += newSize >> 2;
+      // slot may have been used by setting object infos directly
+      if (m_objectList[pos].m_itemID == c_itemIDNone)
+         return static_cast<Uint16>(pos);
+   }
 
-      // limit to Uint16 range
-      if (newSize >= 0x10000)
-         newSize = 0x10000;
+   // already at maximum size?
+   if (m_objectList.size() >= 0x10000)
+      throw Base::RuntimeException("Error while enlarging inventory list; already at maximum size");
 
-      m_objectList.resize(newSize);
-   }
+   // new pos is start of enlarged list
+   Uint16 pos = static_cast<Uint16>(m_objectList.size());
+
+   // enlarge list by factor 1,25
+   size_t newSize = m_objectList.size();
+   newSize += newSize >> 2;
+
+   // limit to Uint16 range
+   if (newSize >= 0x10000)
+      newSize = 0x10000;
+
+   m_objectList.resize(newSize);
+   m_freeSlots.Resize(newSize);
+   m_freeSlots.SetUsed(pos);
 
    return pos;
 }
@@ -138,6 +149,10 @@ void Inventory::Free(Uint16 pos)
    UaAssert(pos < m_objectList.size()); // object must not be part of a tile list
 
    m_objectList[pos].m_itemID = c_itemIDNone;
+
+   // paperdoll slots are never allocated
+   if (pos >= slotMax)
+      m_freeSlots.SetFree(pos);
 }
 
 Uint16 Inventory::GetSlotListPos(size_t index) const
@@ -765,6 +780,8 @@ void Inventory::Load(Base::Savegame& sg)
    for (Uint16 ui = 0; ui < max; ui++)
       m_objectList[ui].Load(sg);
 
+   UpdateFreeSlots();
+
    // load container stack
    max = sg.Read16();
    m_containerStack.resize(max);
@@ -872,3 +889,13 @@ unsigned int Inventory::GetObjectWeight(Uint16 pos) const
 
    return weightInTenth;
 }
+
+void Inventory::UpdateFreeSlots()
+{
+   m_freeSlots.Clear();
+   m_freeSlots.Resize(m_objectList.size());
+
+   for (size_t pos = 0; pos < m_objectList.size(); pos++)
+      if (pos < slotMax || m_objectList[pos].m_itemID != c_itemIDNone)
+         m_freeSlots.SetUsed(pos);
+}
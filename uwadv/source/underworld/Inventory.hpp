@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include "Object.hpp"
+#include "FreeSlotSet.hpp"
 
 namespace Base
 {
@@ -214,10 +215,17 @@ namespace Underworld
       /// in 1/10 stones
       unsigned int GetObjectWeight(Uint16 pos) const;
 
+      /// rebuilds set of free slots from object list
+      void UpdateFreeSlots();
+
    private:
       /// object list
       std::vector<ObjectInfo> m_objectList;
 
+      /// slots of the object list that may be free; slots can also be used
+      /// by setting object infos directly, so allocating checks the slots
+      FreeSlotSet m_freeSlots;
+
       /// list with all objects in current slot list
       std::vector<Uint16> m_slotList;
 
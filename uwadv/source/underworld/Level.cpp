@@ -21,6 +21,7 @@
 //
 #include "pch.hpp"
 #include "Level.hpp"
+#include <algorithm>
 
 Underworld::AutomapFlag Underworld::Level::GetAutomapFlagFromTile(
    unsigned int xpos, unsigned int ypos) const
@@ -85,3 +86,33 @@ void Underworld::Level::RevealCompleteAutomap()
          tileInfo.m_automapFlag = GetAutomapFlagFromTile(posX, posY);
       }
 }
+
+/// Stairs and other passages between levels are move triggers that set off
+/// a teleport trap with a target level.
+/// \param levelIndices vector to store level indices in; each index is
+/// only stored once
+void Underworld::Level::GetConnectedLevels(std::vector<size_t>& levelIndices) const
+{
+   levelIndices.clear();
+
+   const ObjectList& objectList = GetObjectList();
+   Uint16 objectListSize = objectList.GetObjectListSize();
+
+   for (Uint16 pos = 1; pos < objectListSize; pos++)
+   {
+      const ObjectPtr objPtr = objectList.GetObject(pos);
+      if (objPtr == nullptr)
+         continue;
+
+      // teleport trap with target level?
+      const ObjectInfo& objInfo = objPtr->GetObjectInfo();
+      Uint8 zpos = objPtr->GetPosInfo().m_zpos;
+
+      if (objInfo.m_itemID != 0x0181 || zpos == 0)
+         continue;
+
+      size_t levelIndex = zpos - 1u;
+      if (std::find(levelIndices.begin(), levelIndices.end(), levelIndex) == levelIndices.end())
+         levelIndices.push_back(levelIndex);
+   }
+}
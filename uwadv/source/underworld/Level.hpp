@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -71,6 +71,9 @@ namespace Underworld
       /// reveals the comlete automap
       void RevealCompleteAutomap();
 
+      /// collects indices of levels that teleport traps of this level lead to
+      void GetConnectedLevels(std::vector<size_t>& levelIndices) const;
+
       // loading / saving
 
       /// saves level
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -26,21 +26,114 @@
 using Underworld::LevelList;
 using Underworld::Level;
 
+/// default maximum number of loaded levels
+const size_t c_defaultMaxLoadedLevels = 8;
+
+LevelList::LevelList()
+   :m_maxLoadedLevels(c_defaultMaxLoadedLevels)
+{
+}
+
+LevelList::~LevelList()
+{
+   // stop prefetcher before the levels are destroyed
+   m_prefetcher.reset();
+}
+
+/// Replaces all levels with levels that are loaded using the load function
+/// when first accessed.
+/// \param numLevels number of levels
+/// \param fnLoadLevel function to load a level; must be callable from a
+/// worker thread
+void LevelList::Create(size_t numLevels, T_fnLoadLevel fnLoadLevel)
+{
+   m_prefetcher.reset();
+
+   m_levelList.clear();
+   m_levelList.resize(numLevels);
+
+   m_fnLoadLevel = fnLoadLevel;
+   if (m_fnLoadLevel != nullptr)
+      m_prefetcher = std::make_unique<LevelPrefetcher>(m_fnLoadLevel);
+}
+
+size_t LevelList::GetNumLoadedLevels() const
+{
+   size_t numLoadedLevels = 0;
+   for (const LevelEntry& entry : m_levelList)
+      if (entry.m_level != nullptr)
+         numLoadedLevels++;
+
+   return numLoadedLevels;
+}
+
+/// Queues all levels that teleport traps of the given level lead to, and
+/// that aren't loaded yet, for loading in the background. Also takes over
+/// levels that were loaded in the background since the last call, and
+/// unloads levels that weren't modified when too many levels are loaded;
+/// references to other levels than the given one may get invalid.
+/// \param levelIndex index of level, usually the level the player entered
+void LevelList::PrefetchConnectedLevels(size_t levelIndex)
+{
+   UaAssert(levelIndex < GetNumLevels());
+   if (m_prefetcher == nullptr || levelIndex >= GetNumLevels())
+      return;
+
+   TakePrefetchedLevels();
+
+   const Level& level = GetLevel(levelIndex);
+
+   std::vector<size_t> connectedLevels;
+   level.GetConnectedLevels(connectedLevels);
+
+   for (size_t connectedLevel : connectedLevels)
+   {
+      if (connectedLevel < GetNumLevels() &&
+         m_levelList[connectedLevel].m_level == nullptr)
+         m_prefetcher->Prefetch(connectedLevel);
+   }
+
+   UnloadLevels(levelIndex);
+}
+
+/// Levels that were already loaded in the background are discarded.
+void LevelList::CancelPrefetch()
+{
+   if (m_prefetcher != nullptr)
+      m_prefetcher->Cancel();
+}
+
+/// Levels not stored in the savegame are loaded using the load function set
+/// with Create(), when first accessed. Savegames prior to version 5 store
+/// all levels.
 void LevelList::Load(Base::Savegame& sg)
 {
    sg.BeginSection("levels");
 
    size_t numLevels = sg.Read32();
 
+   CancelPrefetch();
+
    m_levelList.clear();
    m_levelList.resize(numLevels);
 
    for (size_t levelIndex = 0; levelIndex < numLevels; levelIndex++)
-      m_levelList[levelIndex].Load(sg);
+   {
+      bool isStored = sg.GetVersion() < 5 || sg.Read8() != 0;
+      if (!isStored)
+         continue;
+
+      LevelEntry& entry = m_levelList[levelIndex];
+      entry.m_level = std::make_unique<Level>();
+      entry.m_level->Load(sg);
+      entry.m_isModified = true;
+   }
 
    sg.EndSection();
 }
 
+/// Only stores levels that may have been modified; when no load function is
+/// set, all loaded levels are stored.
 void LevelList::Save(Base::Savegame& sg) const
 {
    sg.BeginSection("levels");
@@ -48,8 +141,96 @@ void LevelList::Save(Base::Savegame& sg) const
    size_t numLevels = m_levelList.size();
    sg.Write32(static_cast<Uint32>(numLevels));
 
-   for (size_t levelIndex = 0; levelIndex < m_levelList.size(); levelIndex++)
-      m_levelList[levelIndex].Save(sg);
+   for (const LevelEntry& entry : m_levelList)
+   {
+      bool isStored = entry.m_level != nullptr &&
+         (entry.m_isModified || m_fnLoadLevel == nullptr);
+
+      sg.Write8(isStored ? 1 : 0);
+
+      if (isStored)
+         entry.m_level->Save(sg);
+   }
 
    sg.EndSection();
 }
+
+/// Takes the level from the prefetcher when it was loaded in the background,
+/// or waits for it when it's currently being loaded; otherwise loads it
+/// using the load function. When there's no load function, an empty level
+/// is created.
+/// \param levelIndex index of level to load
+void LevelList::LoadLevel(size_t levelIndex) const
+{
+   LevelEntry& entry = m_levelList[levelIndex];
+   UaAssert(entry.m_level == nullptr);
+
+   if (m_prefetcher != nullptr)
+   {
+      entry.m_level = m_prefetcher->TakeLevel(levelIndex);
+      TakePrefetchedLevels();
+   }
+
+   if (entry.m_level == nullptr)
+   {
+      std::unique_ptr<Level> level = std::make_unique<Level>();
+
+      if (m_fnLoadLevel != nullptr)
+         m_fnLoadLevel(levelIndex, *level);
+
+      entry.m_level = std::move(level);
+   }
+
+   entry.m_isModified = false;
+   entry.m_lastUsed = ++m_usageCounter;
+}
+
+void LevelList::TakePrefetchedLevels() const
+{
+   std::vector<std::pair<size_t, std::unique_ptr<Level>>> loadedLevels;
+   m_prefetcher->TakeLoadedLevels(loadedLevels);
+
+   for (auto& loadedLevel : loadedLevels)
+   {
+      if (loadedLevel.first >= m_levelList.size())
+         continue;
+
+      LevelEntry& entry = m_levelList[loadedLevel.first];
+      if (entry.m_level != nullptr)
+         continue; // loaded in the meantime
+
+      entry.m_level = std::move(loadedLevel.second);
+      entry.m_isModified = false;
+      entry.m_lastUsed = ++m_usageCounter;
+   }
+}
+
+/// Levels are only unloaded when they can be loaded again with the load
+/// function.
+/// \param keepLevelIndex index of level that mustn't be unloaded
+void LevelList::UnloadLevels(size_t keepLevelIndex)
+{
+   if (m_fnLoadLevel == nullptr)
+      return;
+
+   size_t numLoadedLevels = GetNumLoadedLevels();
+   while (numLoadedLevels > m_maxLoadedLevels)
+   {
+      LevelEntry* leastRecentlyUsed = nullptr;
+      for (size_t levelIndex = 0; levelIndex < m_levelList.size(); levelIndex++)
+      {
+         LevelEntry& entry = m_levelList[levelIndex];
+         if (entry.m_level == nullptr || entry.m_isModified || levelIndex == keepLevelIndex)
+            continue;
+
+         if (leastRecentlyUsed == nullptr || entry.m_lastUsed < leastRecentlyUsed->m_lastUsed)
+            leastRecentlyUsed = &entry;
+      }
+
+      if (leastRecentlyUsed == nullptr)
+         break; // only modified levels left
+
+      leastRecentlyUsed->m_level.reset();
+      numLoadedLevels--;
+   }
+}
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,6 +22,8 @@
 #pragma once
 
 #include "Level.hpp"
+#include "LevelPrefetcher.hpp"
+#include <memory>
 
 namespace Base
 {
@@ -30,30 +32,85 @@ namespace Base
 
 namespace Underworld
 {
-   /// list of all levels
+   /// \brief List of all levels
+   /// \details Levels can be loaded lazily: when a load function is set with
+   /// Create(), a level is only loaded when it is first accessed. Levels
+   /// connected to the current level can be loaded in the background with
+   /// PrefetchConnectedLevels(). Levels that were marked as modified with
+   /// SetLevelModified() stay loaded; other loaded levels are unloaded again
+   /// by PrefetchConnectedLevels(), least recently used first, when more than
+   /// the maximum number of loaded levels are loaded. Savegames only store
+   /// modified levels.
    class LevelList
    {
    public:
       /// ctor
-      LevelList() {}
+      LevelList();
+
+      /// dtor
+      ~LevelList();
+
+      /// creates given number of levels that are loaded when first accessed
+      void Create(size_t numLevels, T_fnLoadLevel fnLoadLevel);
 
       /// returns number of levels in list
       size_t GetNumLevels() const { return m_levelList.size(); }
 
-      /// returns level
+      /// returns level; call SetLevelModified() when modifying the level
       Level& GetLevel(size_t levelIndex)
       {
          UaAssert(levelIndex < GetNumLevels());
-         return m_levelList[levelIndex];
+         LevelEntry& entry = m_levelList[levelIndex];
+         if (entry.m_level == nullptr)
+            LoadLevel(levelIndex);
+
+         entry.m_lastUsed = ++m_usageCounter;
+         return *entry.m_level;
       }
 
       /// returns level; const version
       const Level& GetLevel(size_t levelIndex) const
       {
          UaAssert(levelIndex < GetNumLevels());
-         return m_levelList[levelIndex];
+         LevelEntry& entry = m_levelList[levelIndex];
+         if (entry.m_level == nullptr)
+            LoadLevel(levelIndex);
+
+         entry.m_lastUsed = ++m_usageCounter;
+         return *entry.m_level;
+      }
+
+      /// marks level as modified; modified levels stay loaded and are stored
+      /// in savegames
+      void SetLevelModified(size_t levelIndex)
+      {
+         UaAssert(levelIndex < GetNumLevels());
+         LevelEntry& entry = m_levelList[levelIndex];
+         if (entry.m_level == nullptr)
+            LoadLevel(levelIndex);
+
+         entry.m_isModified = true;
       }
 
+      /// returns if level is currently loaded
+      bool IsLevelLoaded(size_t levelIndex) const
+      {
+         UaAssert(levelIndex < GetNumLevels());
+         return m_levelList[levelIndex].m_level != nullptr;
+      }
+
+      /// returns number of currently loaded levels
+      size_t GetNumLoadedLevels() const;
+
+      /// sets maximum number of loaded levels; modified levels are never unloaded
+      void SetMaxLoadedLevels(size_t maxLoadedLevels) { m_maxLoadedLevels = maxLoadedLevels; }
+
+      /// loads levels connected to given level in the background
+      void PrefetchConnectedLevels(size_t levelIndex);
+
+      /// cancels loading levels in the background
+      void CancelPrefetch();
+
       // loading/saving
 
       /// loads levelmaps from savegame
@@ -62,12 +119,44 @@ namespace Underworld
       /// saves levelmaps to savegame
       void Save(Base::Savegame& sg) const;
 
-      /// returns all levelmaps in a vector
-      std::vector<Level>& GetVectorLevels() { return m_levelList; }
+   private:
+      /// loads level, from the prefetched levels or using the load function
+      void LoadLevel(size_t levelIndex) const;
+
+      /// takes over levels loaded in the background
+      void TakePrefetchedLevels() const;
+
+      /// unloads least recently used levels that aren't modified
+      void UnloadLevels(size_t keepLevelIndex);
 
    private:
+      /// entry of a level in the list
+      struct LevelEntry
+      {
+         /// level; nullptr when not loaded
+         std::unique_ptr<Level> m_level;
+
+         /// indicates if level may have been modified
+         bool m_isModified = false;
+
+         /// usage counter value of last access
+         unsigned int m_lastUsed = 0;
+      };
+
       /// all underworld levels
-      std::vector<Level> m_levelList;
+      mutable std::vector<LevelEntry> m_levelList;
+
+      /// function to load levels; may be empty
+      T_fnLoadLevel m_fnLoadLevel;
+
+      /// loads levels in the background; only set when levels can be loaded
+      std::unique_ptr<LevelPrefetcher> m_prefetcher;
+
+      /// maximum number of loaded levels
+      size_t m_maxLoadedLevels;
+
+      /// counter increased with every level access
+      mutable unsigned int m_usageCounter = 0;
    };
 
 } // namespace Underworld
@@ -0,0 +1,181 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelPrefetcher.cpp
+/// \brief loads levels in the background
+//
+#include "pch.hpp"
+#include "LevelPrefetcher.hpp"
+#include <algorithm>
+
+using Underworld::LevelPrefetcher;
+using Underworld::Level;
+
+LevelPrefetcher::LevelPrefetcher(T_fnLoadLevel fnLoadLevel)
+   :m_fnLoadLevel(fnLoadLevel)
+{
+}
+
+LevelPrefetcher::~LevelPrefetcher()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+      m_queuedLevels.clear();
+   }
+
+   m_workAvailable.notify_all();
+
+   if (m_thread.joinable())
+      m_thread.join();
+}
+
+/// Levels that are already queued, being loaded or loaded are ignored.
+/// \param levelIndex index of level to load
+void LevelPrefetcher::Prefetch(size_t levelIndex)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_loadingLevel == levelIndex ||
+         std::find(m_queuedLevels.begin(), m_queuedLevels.end(), levelIndex) != m_queuedLevels.end())
+         return;
+
+      for (const auto& loadedLevel : m_loadedLevels)
+         if (loadedLevel.first == levelIndex)
+            return;
+
+      m_queuedLevels.push_back(levelIndex);
+   }
+
+   if (!m_thread.joinable())
+      m_thread = std::thread(&LevelPrefetcher::ThreadProc, this);
+
+   m_workAvailable.notify_one();
+}
+
+/// \param levelIndex index of level to check
+bool LevelPrefetcher::IsPrefetched(size_t levelIndex) const
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   if (m_loadingLevel == levelIndex ||
+      std::find(m_queuedLevels.begin(), m_queuedLevels.end(), levelIndex) != m_queuedLevels.end())
+      return true;
+
+   for (const auto& loadedLevel : m_loadedLevels)
+      if (loadedLevel.first == levelIndex)
+         return true;
+
+   return false;
+}
+
+/// When the level is still queued, it is removed from the queue, since the
+/// caller can load it faster than waiting for the levels queued before it.
+/// \param levelIndex index of level to take
+/// \return loaded level, or nullptr when the level wasn't loaded in the
+/// background
+std::unique_ptr<Level> LevelPrefetcher::TakeLevel(size_t levelIndex)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   auto iter = std::find(m_queuedLevels.begin(), m_queuedLevels.end(), levelIndex);
+   if (iter != m_queuedLevels.end())
+   {
+      m_queuedLevels.erase(iter);
+      return nullptr;
+   }
+
+   m_levelLoaded.wait(lock, [&]() { return m_loadingLevel != levelIndex; });
+
+   for (auto loadedIter = m_loadedLevels.begin(); loadedIter != m_loadedLevels.end(); ++loadedIter)
+   {
+      if (loadedIter->first == levelIndex)
+      {
+         std::unique_ptr<Level> level = std::move(loadedIter->second);
+         m_loadedLevels.erase(loadedIter);
+         return level;
+      }
+   }
+
+   return nullptr;
+}
+
+/// \param loadedLevels vector to append loaded levels and their indices to
+void LevelPrefetcher::TakeLoadedLevels(std::vector<std::pair<size_t, std::unique_ptr<Level>>>& loadedLevels)
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   for (auto& loadedLevel : m_loadedLevels)
+      loadedLevels.push_back(std::move(loadedLevel));
+
+   m_loadedLevels.clear();
+}
+
+/// Waits until the level currently being loaded is done.
+void LevelPrefetcher::Cancel()
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   m_queuedLevels.clear();
+   m_levelLoaded.wait(lock, [&]() { return m_loadingLevel == c_noLevel; });
+   m_loadedLevels.clear();
+}
+
+/// Exceptions thrown while loading a level are ignored; the level is then
+/// loaded again when it's needed, and the exception is thrown to the caller.
+void LevelPrefetcher::ThreadProc()
+{
+   for (;;)
+   {
+      size_t levelIndex;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_workAvailable.wait(lock,
+            [&]() { return m_stop || !m_queuedLevels.empty(); });
+
+         if (m_stop)
+            return;
+
+         levelIndex = m_queuedLevels.front();
+         m_queuedLevels.pop_front();
+         m_loadingLevel = levelIndex;
+      }
+
+      std::unique_ptr<Level> level = std::make_unique<Level>();
+      try
+      {
+         m_fnLoadLevel(levelIndex, *level);
+      }
+      catch (const std::exception& ex)
+      {
+         UaTrace("prefetching level %zu failed: %s\n", levelIndex, ex.what());
+         level.reset();
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (level != nullptr)
+            m_loadedLevels.push_back(std::make_pair(levelIndex, std::move(level)));
+
+         m_loadingLevel = c_noLevel;
+      }
+
+      m_levelLoaded.notify_all();
+   }
+}
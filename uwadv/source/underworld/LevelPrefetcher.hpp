@@ -0,0 +1,109 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelPrefetcher.hpp
+/// \brief loads levels in the background
+//
+#pragma once
+
+#include "Level.hpp"
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Underworld
+{
+   /// function type that loads a level, e.g. from the game files
+   typedef std::function<void(size_t levelIndex, Level& level)> T_fnLoadLevel;
+
+   /// \brief Loads levels in the background
+   /// \details Loads queued levels on a worker thread, in the order they
+   /// were queued. The thread is started with the first queued level. Loaded
+   /// levels are kept until they are taken from the prefetcher. The load
+   /// function is called on the worker thread and must not access
+   /// thread-bound resources, such as the OpenGL context.
+   class LevelPrefetcher
+   {
+   public:
+      /// ctor
+      explicit LevelPrefetcher(T_fnLoadLevel fnLoadLevel);
+
+      /// dtor; stops worker thread
+      ~LevelPrefetcher();
+
+      /// deleted copy ctor
+      LevelPrefetcher(const LevelPrefetcher&) = delete;
+      /// deleted assignment operator
+      LevelPrefetcher& operator=(const LevelPrefetcher&) = delete;
+
+      /// queues level for loading in the background
+      void Prefetch(size_t levelIndex);
+
+      /// returns if level is queued, being loaded or loaded
+      bool IsPrefetched(size_t levelIndex) const;
+
+      /// takes loaded level; waits when the level is currently being loaded
+      std::unique_ptr<Level> TakeLevel(size_t levelIndex);
+
+      /// takes all levels loaded so far
+      void TakeLoadedLevels(std::vector<std::pair<size_t, std::unique_ptr<Level>>>& loadedLevels);
+
+      /// cancels all queued levels and discards loaded levels
+      void Cancel();
+
+   private:
+      /// thread function of worker thread
+      void ThreadProc();
+
+   private:
+      /// index value when no level is being loaded
+      static const size_t c_noLevel = ~size_t(0);
+
+      /// function to load levels
+      T_fnLoadLevel m_fnLoadLevel;
+
+      /// worker thread
+      std::thread m_thread;
+
+      /// mutex protecting the members below
+      mutable std::mutex m_mutex;
+
+      /// signaled when a level is queued, or the prefetcher is stopped
+      std::condition_variable m_workAvailable;
+
+      /// signaled when the worker thread is done loading a level
+      std::condition_variable m_levelLoaded;
+
+      /// indices of levels to load
+      std::deque<size_t> m_queuedLevels;
+
+      /// index of level currently being loaded, or c_noLevel
+      size_t m_loadingLevel = c_noLevel;
+
+      /// levels loaded by the worker thread
+      std::vector<std::pair<size_t, std::unique_ptr<Level>>> m_loadedLevels;
+
+      /// indicates if the worker thread should stop
+      bool m_stop = false;
+   };
+
+} // namespace Underworld
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -175,12 +175,13 @@ void Object::Save(Base::Savegame& sg) const
 void NpcObject::Load(Base::Savegame& sg)
 {
    Object::Load(sg);
-   if (GetObjectInfo().m_itemID != c_itemIDNone)
+   if (IsNpcObject() && GetObjectInfo().m_itemID != c_itemIDNone)
       m_npcInfo.Load(sg);
 }
 
 void NpcObject::Save(Base::Savegame& sg) const
 {
    Object::Save(sg);
-   m_npcInfo.Save(sg);
+   if (IsNpcObject())
+      m_npcInfo.Save(sg);
 }
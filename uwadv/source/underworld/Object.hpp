@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -29,6 +29,7 @@ namespace Base
 namespace Underworld
 {
    class NpcObject;
+   class ObjectList;
 
    /// item id for unused object
    const Uint16 c_itemIDNone = 0xffff;
@@ -205,6 +206,8 @@ namespace Underworld
       }
 
    private:
+      friend ObjectList;
+
       /// object type
       ObjectType m_objectType;
 
@@ -216,7 +219,10 @@ namespace Underworld
    };
 
    /// \brief Object that additionally has NPC infos
-   /// Allowed range for NPC objects is item IDs 0x0040-0x007f.
+   /// Allowed range for NPC objects is item IDs 0x0040-0x007f. The slots of an
+   /// object list are NPC objects, too, and the object type decides if the
+   /// slot holds a normal object or an NPC; the NPC info is only loaded and
+   /// saved for NPCs.
    class NpcObject : public Object
    {
    public:
@@ -244,8 +250,87 @@ namespace Underworld
       NpcInfo m_npcInfo;
    };
 
+   /// \brief Pointer to an object
+   /// \details Points either to an object stored in an object list, without
+   /// owning it, or to a standalone object, e.g. one created with new, that is
+   /// shared by all pointers to it. Pointers to objects in an object list are
+   /// cheap to copy and stay valid when the list is enlarged, but not when the
+   /// list is destroyed or loaded; when the object is freed and the slot is
+   /// allocated again, the pointer refers to the new object.
+   class ObjectPtr
+   {
+   public:
+      /// ctor; null pointer
+      ObjectPtr()
+         :m_object(nullptr)
+      {
+      }
+
+      /// ctor; null pointer
+      ObjectPtr(std::nullptr_t)
+         :m_object(nullptr)
+      {
+      }
+
+      /// ctor; takes ownership of a newly created standalone object
+      template <typename T>
+      explicit ObjectPtr(T* object)
+         :m_object(object),
+         m_standaloneObject(object)
+      {
+      }
+
+      /// ctor; shares ownership of a standalone object
+      template <typename T>
+      ObjectPtr(const std::shared_ptr<T>& object)
+         :m_object(object.get()),
+         m_standaloneObject(object)
+      {
+      }
 
-   /// smart pointer to Object
-   typedef std::shared_ptr<Object> ObjectPtr;
+      /// ctor; refers to an object owned by someone else, e.g. an object list
+      explicit ObjectPtr(Object& object)
+         :m_object(&object)
+      {
+      }
+
+      /// returns pointer to object, or nullptr
+      Object* get() const { return m_object; }
+
+      /// accesses object members
+      Object* operator->() const { return m_object; }
+
+      /// returns object
+      Object& operator*() const { return *m_object; }
+
+      /// returns if the pointer points to an object
+      explicit operator bool() const { return m_object != nullptr; }
+
+      /// resets pointer to null pointer
+      void reset()
+      {
+         m_object = nullptr;
+         m_standaloneObject.reset();
+      }
+
+   private:
+      /// object pointed to
+      Object* m_object;
+
+      /// standalone object; empty for objects in an object list
+      std::shared_ptr<Object> m_standaloneObject;
+   };
+
+   /// compares object pointer with null pointer
+   inline bool operator==(const ObjectPtr& objectPtr, std::nullptr_t)
+   {
+      return objectPtr.get() == nullptr;
+   }
+
+   /// compares object pointer with null pointer
+   inline bool operator!=(const ObjectPtr& objectPtr, std::nullptr_t)
+   {
+      return objectPtr.get() != nullptr;
+   }
 
 } // namespace Underworld
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -27,89 +27,135 @@
 using Underworld::ObjectList;
 using Underworld::ObjectPtr;
 using Underworld::ObjectType;
+using Underworld::NpcObject;
+using Underworld::FreeSlotSet;
+using Underworld::ObjectSpatialIndex;
+using Underworld::ObjectClass;
 
 void ObjectList::Create()
 {
-   m_objectList.resize(0x400);
+   Resize(0x400);
    m_tilemapListStart.resize(c_underworldTilemapSize * c_underworldTilemapSize, g_objectListPosNone);
 }
 
 void ObjectList::Destroy()
 {
-   m_objectList.clear();
+   m_objectPool.clear();
+   m_objectListSize = 0;
+   m_freeSlots.Clear();
+   m_spatialIndex.Reset(0);
    m_tilemapListStart.clear();
 }
 
-/// Allocates a new object by searching next free object position in list. The
-/// new object itself isn't set; use SetObject to do that.
+/// Allocates a new object by taking the free object position with the lowest
+/// position. The new object itself isn't set; use SetObject to do that. The
+/// slot stays allocated until it is freed, even when no object is set.
 /// \note may enlarge object list
 /// \todo integrate SetObject() call by passing ObjectPtr
 Uint16 ObjectList::Allocate()
 {
-   // start with position 1; 0 is reserved
-   Uint16 pos = 1;
-   Uint16 size = static_cast<Uint16>(m_objectList.size());
-   while (pos < size && m_objectList[pos].get() != NULL)
-      pos++;
-
-   // hit end of list?
-   if (pos >= m_objectList.size())
+   UaAssert(m_objectListSize > 0); // list must have been created
+
+   size_t pos = m_freeSlots.FindFirstFree();
+
+   // no free slot left?
+   if (pos == FreeSlotSet::c_noFreeSlot)
    {
       // already at maximum size?
-      if (m_objectList.size() == 0x10000)
+      if (m_objectListSize == 0x10000)
          throw Base::RuntimeException("Error while enlarging object list; already at maximum size");
 
       // new pos is start of enlarged list
-      pos = static_cast<Uint16>(m_objectList.size());
+      pos = m_objectListSize;
 
       // enlarge list by factor 1,25
-      size_t newSize = m_objectList.size();
+      size_t newSize = m_objectListSize;
       newSize += newSize >> 2;
 
       // limit to Uint16 range
       if (newSize >= 0x10000)
          newSize = 0x10000;
 
-      m_objectList.resize(newSize);
+      Resize(newSize);
    }
 
-   return pos;
+   m_freeSlots.SetUsed(pos);
+
+   return static_cast<Uint16>(pos);
 }
 
 void ObjectList::Free(Uint16 objectPos)
 {
-   // object must not be part of a tile list
-   UaAssert(GetObject(objectPos)->GetPosInfo().m_tileX == c_tileNotAPos);
-   UaAssert(GetObject(objectPos)->GetPosInfo().m_tileY == c_tileNotAPos);
-   UaAssert(objectPos < m_objectList.size());
+   UaAssert(objectPos < m_objectListSize);
    UaAssert(objectPos != g_objectListPosNone);
-   UaAssert(m_objectList[objectPos].get() != NULL); // can only free allocated objects
+   UaAssert(GetSlot(objectPos).GetObjectType() != objectNone); // can only free allocated objects
 
-   m_objectList[objectPos].reset();
+   // object must not be part of a tile list
+   UaAssert(GetSlot(objectPos).GetPosInfo().m_tileX == c_tileNotAPos);
+   UaAssert(GetSlot(objectPos).GetPosInfo().m_tileY == c_tileNotAPos);
+
+   ResetSlot(GetSlot(objectPos));
+   m_freeSlots.SetFree(objectPos);
 }
 
+/// \return pointer to the object in the list, or a null pointer when the
+/// slot is unused
 ObjectPtr ObjectList::GetObject(Uint16 objectPos)
 {
-   UaAssert(objectPos < m_objectList.size());
+   UaAssert(objectPos < m_objectListSize);
    UaAssert(objectPos != g_objectListPosNone);
 
-   return m_objectList[objectPos];
+   NpcObject& slot = GetSlot(objectPos);
+   return slot.GetObjectType() == objectNone ? ObjectPtr() : ObjectPtr(slot);
 }
 
 const ObjectPtr ObjectList::GetObject(Uint16 objectPos) const
 {
-   UaAssert(objectPos < m_objectList.size());
+   return const_cast<ObjectList*>(this)->GetObject(objectPos);
+}
+
+/// Copies the object infos into the object list slot; later changes to the
+/// passed object don't change the object in the list. Use GetObject() to
+/// access the object in the list. Passing a null pointer frees the slot.
+void ObjectList::SetObject(Uint16 objectPos, const ObjectPtr& object)
+{
+   UaAssert(objectPos < m_objectListSize);
    UaAssert(objectPos != g_objectListPosNone);
 
-   return m_objectList[objectPos];
+   NpcObject& slot = GetSlot(objectPos);
+   if (object == nullptr)
+   {
+      ResetSlot(slot);
+      m_freeSlots.SetFree(objectPos);
+      return;
+   }
+
+   m_freeSlots.SetUsed(objectPos);
+
+   slot.m_objectType = object->GetObjectType();
+   slot.GetObjectInfo() = object->GetObjectInfo();
+   slot.GetPosInfo() = object->GetPosInfo();
+   slot.GetNpcInfo() = object->IsNpcObject() ? object->GetNpcObject().GetNpcInfo() : NpcInfo();
 }
 
-void ObjectList::SetObject(Uint16 objectPos, const ObjectPtr& object)
+/// Creates the object directly in the object list slot, without creating a
+/// standalone object first, e.g. when importing levels.
+/// \param objectPos object list position
+/// \param objectType type of object to create; objectNormal or objectNpc
+/// \return pointer to the object in the list
+ObjectPtr ObjectList::CreateObject(Uint16 objectPos, ObjectType objectType)
 {
-   UaAssert(objectPos < m_objectList.size());
+   UaAssert(objectPos < m_objectListSize);
    UaAssert(objectPos != g_objectListPosNone);
+   UaAssert(objectType != objectNone);
+
+   NpcObject& slot = GetSlot(objectPos);
+   ResetSlot(slot);
+   slot.m_objectType = objectType;
 
-   m_objectList[objectPos] = object;
+   m_freeSlots.SetUsed(objectPos);
+
+   return ObjectPtr(slot);
 }
 
 Uint16 ObjectList::GetListStart(Uint8 xpos, Uint8 ypos) const
@@ -126,7 +172,7 @@ void ObjectList::SetListStart(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
 {
    UaAssert(xpos < c_underworldTilemapSize);
    UaAssert(ypos < c_underworldTilemapSize);
-   UaAssert(objectPos < m_objectList.size());
+   UaAssert(objectPos < m_objectListSize);
 
    m_tilemapListStart[ypos * c_underworldTilemapSize + xpos] = objectPos;
 }
@@ -135,9 +181,9 @@ void ObjectList::SetListStart(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
 void ObjectList::AddObjectToTileList(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
 {
    UaAssert(objectPos != g_objectListPosNone);
-   UaAssert(objectPos < m_objectList.size());
-   UaAssert(m_objectList[objectPos].get() != NULL);
-   UaAssert(m_objectList[objectPos]->GetObjectInfo().m_link == g_objectListPosNone);
+   UaAssert(objectPos < m_objectListSize);
+   UaAssert(GetSlot(objectPos).GetObjectType() != objectNone);
+   UaAssert(GetSlot(objectPos).GetObjectInfo().m_link == g_objectListPosNone);
 
    // search end of tile
    Uint16 link = GetListStart(xpos, ypos);
@@ -161,22 +207,27 @@ void ObjectList::AddObjectToTileList(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
       GetObject(objectPos)->GetObjectInfo().m_link = g_objectListPosNone;
    }
 
-   m_objectList[objectPos]->GetPosInfo().m_tileX = xpos;
-   m_objectList[objectPos]->GetPosInfo().m_tileY = ypos;
+   GetSlot(objectPos).GetPosInfo().m_tileX = xpos;
+   GetSlot(objectPos).GetPosInfo().m_tileY = ypos;
+
+   m_spatialIndex.Insert(objectPos,
+      ObjectSpatialIndex::GetObjectClass(GetSlot(objectPos).GetObjectInfo().m_itemID), xpos, ypos);
 }
 
 void ObjectList::RemoveObjectFromTileList(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
 {
    UaAssert(objectPos != g_objectListPosNone);
-   UaAssert(objectPos < m_objectList.size());
-   UaAssert(m_objectList[objectPos].get() != NULL);
+   UaAssert(objectPos < m_objectListSize);
+   UaAssert(GetSlot(objectPos).GetObjectType() != objectNone);
 
    // search item in tile list
    Uint16 link = GetListStart(xpos, ypos);
    UaAssert(link != g_objectListPosNone);
 
-   m_objectList[objectPos]->GetPosInfo().m_tileX = c_tileNotAPos;
-   m_objectList[objectPos]->GetPosInfo().m_tileY = c_tileNotAPos;
+   GetSlot(objectPos).GetPosInfo().m_tileX = c_tileNotAPos;
+   GetSlot(objectPos).GetPosInfo().m_tileY = c_tileNotAPos;
+
+   m_spatialIndex.Remove(objectPos, xpos, ypos);
 
    // first item?
    if (link == objectPos)
@@ -207,6 +258,55 @@ void ObjectList::RemoveObjectFromTileList(Uint16 objectPos, Uint8 xpos, Uint8 yp
    UaAssert(false); // when reached here, item didn't belong in this list
 }
 
+/// Uses the spatial index, so only objects of the given classes are visited.
+/// The distance is checked in x and y; objects are at the center of their
+/// fractional position in the tile.
+/// \param xpos x position, in tiles
+/// \param ypos y position, in tiles
+/// \param radius radius, in tiles
+/// \param classMask combination of bits 1 << ObjectClass
+/// \param objectPositions list of object positions found; cleared before
+void ObjectList::QueryRadius(double xpos, double ypos, double radius, unsigned int classMask,
+   std::vector<Uint16>& objectPositions) const
+{
+   objectPositions.clear();
+
+   if (m_objectListSize == 0)
+      return;
+
+   const int maxCell = ObjectSpatialIndex::c_numCellsPerSide - 1;
+   const double cellSize = ObjectSpatialIndex::c_cellSize;
+
+   int minCellX = std::max(0, static_cast<int>(floor((xpos - radius) / cellSize)));
+   int minCellY = std::max(0, static_cast<int>(floor((ypos - radius) / cellSize)));
+   int maxCellX = std::min(maxCell, static_cast<int>(floor((xpos + radius) / cellSize)));
+   int maxCellY = std::min(maxCell, static_cast<int>(floor((ypos + radius) / cellSize)));
+
+   for (unsigned int objectClass = 0; objectClass < objectClassMax; objectClass++)
+   {
+      if ((classMask & (1 << objectClass)) == 0)
+         continue;
+
+      for (int cellY = minCellY; cellY <= maxCellY; cellY++)
+         for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+         {
+            Uint16 objectPos = m_spatialIndex.GetCellListStart(cellX, cellY,
+               static_cast<ObjectClass>(objectClass));
+
+            for (; objectPos != g_objectListPosNone; objectPos = m_spatialIndex.GetNextObject(objectPos))
+            {
+               const ObjectPositionInfo& posInfo = GetSlot(objectPos).GetPosInfo();
+
+               double dx = posInfo.m_tileX + (posInfo.m_xpos + 0.5) / 8.0 - xpos;
+               double dy = posInfo.m_tileY + (posInfo.m_ypos + 0.5) / 8.0 - ypos;
+
+               if (dx * dx + dy * dy <= radius * radius)
+                  objectPositions.push_back(objectPos);
+            }
+         }
+   }
+}
+
 void ObjectList::Load(Base::Savegame& sg)
 {
    sg.BeginSection("objectlist");
@@ -231,29 +331,31 @@ void ObjectList::Load(Base::Savegame& sg)
    // read in object list
    Uint16 size = sg.Read16();
 
+   if (size > m_objectListSize)
+      Resize(size);
+
    for (tileIndex = 0; tileIndex < size; tileIndex++)
    {
       // read in object type
       ObjectType objectType =
          static_cast<ObjectType>(sg.Read8());
 
-      // generate proper object ptr, depending on object type
-      ObjectPtr& object = m_objectList[tileIndex];
-      if (objectType == ::Underworld::objectNone)
-         object.reset();
-      else
-         if (objectType == ::Underworld::objectNormal)
-            object = ObjectPtr(new Object);
-         else
-            if (objectType == ::Underworld::objectNpc)
-               object = ObjectPtr(new NpcObject);
+      // set up slot, depending on object type
+      NpcObject& slot = GetSlot(static_cast<Uint16>(tileIndex));
+      if (objectType != ::Underworld::objectNormal &&
+         objectType != ::Underworld::objectNpc)
+         continue;
+
+      slot.m_objectType = objectType;
+      m_freeSlots.SetUsed(tileIndex);
 
       // load contents
-      if (object.get() != NULL)
-         object->Load(sg);
+      slot.Load(sg);
    }
 
    sg.EndSection();
+
+   RebuildSpatialIndex();
 }
 
 void ObjectList::Save(Base::Savegame& sg) const
@@ -279,22 +381,18 @@ void ObjectList::Save(Base::Savegame& sg) const
       sg.Write16(m_tilemapListStart[tileIndex]);
 
    // write out object list
-   Uint16 size = static_cast<Uint16>(m_objectList.size());
+   Uint16 size = static_cast<Uint16>(m_objectListSize);
    sg.Write16(size);
 
    for (tileIndex = 0; tileIndex < size; tileIndex++)
    {
       // write out object type
-      const ObjectPtr& object = m_objectList[tileIndex];
-      if (object.get() == NULL)
-         sg.Write8(static_cast<Uint8>(::Underworld::objectNone));
-      else
-      {
-         sg.Write8(static_cast<Uint8>(object->GetObjectType()));
+      const NpcObject& slot = GetSlot(static_cast<Uint16>(tileIndex));
+      sg.Write8(static_cast<Uint8>(slot.GetObjectType()));
 
-         // write out object infos, too
-         object->Save(sg);
-      }
+      // write out object infos, too
+      if (slot.GetObjectType() != ::Underworld::objectNone)
+         slot.Save(sg);
    }
 
    sg.EndSection();
@@ -302,8 +400,73 @@ void ObjectList::Save(Base::Savegame& sg) const
 
 /// Compacts object list by rearranging objects and adjusting links and
 /// special links; note that no object list positions must be kept, since
-/// they will be invalidated after calling this function.
-/// \todo implement
+/// they will be invalidated after calling this function. Currently only
+/// releases slots that were allocated but never set.
+/// \todo implement rearranging objects
 void ObjectList::Compact()
 {
+   for (size_t objectPos = 1; objectPos < m_objectListSize; objectPos++)
+      if (GetSlot(static_cast<Uint16>(objectPos)).GetObjectType() == objectNone)
+         m_freeSlots.SetFree(objectPos);
+}
+
+/// Enlarges or shrinks the list; new slots are unused. The pool is enlarged
+/// by adding blocks, so that existing objects aren't moved in memory.
+void ObjectList::Resize(size_t newSize)
+{
+   UaAssert(newSize <= 0x10000);
+
+   size_t numBlocks = (newSize + c_poolBlockSize - 1) / c_poolBlockSize;
+   size_t oldNumBlocks = m_objectPool.size();
+
+   m_objectPool.resize(numBlocks);
+
+   for (size_t blockIndex = oldNumBlocks; blockIndex < numBlocks; blockIndex++)
+   {
+      std::vector<NpcObject>& block = m_objectPool[blockIndex];
+      block.resize(c_poolBlockSize);
+
+      for (NpcObject& slot : block)
+         slot.m_objectType = objectNone;
+   }
+
+   // unused slots of a shrunk list must not keep their objects
+   for (size_t objectPos = newSize; objectPos < numBlocks * c_poolBlockSize; objectPos++)
+      ResetSlot(GetSlot(static_cast<Uint16>(objectPos)));
+
+   m_objectListSize = newSize;
+
+   // position 0 is reserved
+   m_freeSlots.Resize(newSize);
+   if (newSize > 0)
+      m_freeSlots.SetUsed(g_objectListPosNone);
+
+   m_spatialIndex.Resize(newSize);
+}
+
+void ObjectList::ResetSlot(NpcObject& slot)
+{
+   slot.m_objectType = objectNone;
+   slot.GetObjectInfo() = ObjectInfo();
+   slot.GetPosInfo() = ObjectPositionInfo();
+   slot.GetNpcInfo() = NpcInfo();
+}
+
+void ObjectList::RebuildSpatialIndex()
+{
+   m_spatialIndex.Reset(m_objectListSize);
+
+   if (m_tilemapListStart.empty())
+      return;
+
+   for (Uint8 ypos = 0; ypos < c_underworldTilemapSize; ypos++)
+      for (Uint8 xpos = 0; xpos < c_underworldTilemapSize; xpos++)
+      {
+         for (Uint16 link = GetListStart(xpos, ypos); link != g_objectListPosNone;
+            link = GetSlot(link).GetObjectInfo().m_link)
+         {
+            m_spatialIndex.Insert(link,
+               ObjectSpatialIndex::GetObjectClass(GetSlot(link).GetObjectInfo().m_itemID), xpos, ypos);
+         }
+      }
 }
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,8 @@
 
 #include <vector>
 #include "Object.hpp"
+#include "FreeSlotSet.hpp"
+#include "ObjectSpatialIndex.hpp"
 
 // Win32 headers define this
 #undef GetObject
@@ -42,12 +44,20 @@ namespace Underworld
    /// object position for "no position"
    const Uint16 g_objectListPosNone = 0x0000;
 
-   /// object list
+   /// \brief Object list
+   /// \details Objects are stored by value in a pool of object slots, indexed
+   /// by object list position. The pool consists of blocks of slots that are
+   /// never moved, so that objects keep their address when the list is
+   /// enlarged, and the infos of objects with adjacent positions are stored
+   /// contiguously in memory.
    class ObjectList
    {
    public:
       /// ctor
-      ObjectList() {}
+      ObjectList()
+         :m_objectListSize(0)
+      {
+      }
 
       /// create object list
       void Create();
@@ -70,6 +80,9 @@ namespace Underworld
       /// sets new object for given object position
       void SetObject(Uint16 objectPos, const ObjectPtr& object);
 
+      /// creates new object with default infos at given object position
+      ObjectPtr CreateObject(Uint16 objectPos, ObjectType objectType);
+
       /// returns object list start for tile on given coordinates
       Uint16 GetListStart(Uint8 xpos, Uint8 ypos) const;
 
@@ -79,8 +92,12 @@ namespace Underworld
       /// removes object from list for given tile
       void RemoveObjectFromTileList(Uint16 objectPos, Uint8 xpos, Uint8 ypos);
 
+      /// returns all objects in tile lists of given classes near a position
+      void QueryRadius(double xpos, double ypos, double radius, unsigned int classMask,
+         std::vector<Uint16>& objectPositions) const;
+
       /// returns object list size
-      Uint16 GetObjectListSize() const { return static_cast<Uint16>(m_objectList.size()); }
+      Uint16 GetObjectListSize() const { return static_cast<Uint16>(m_objectListSize); }
 
       // loading / saving
 
@@ -99,9 +116,46 @@ namespace Underworld
       /// sets object list start for tile on given coordinates
       void SetListStart(Uint16 objectPos, Uint8 xpos, Uint8 ypos);
 
+      /// resizes object list to given number of slots
+      void Resize(size_t newSize);
+
+      /// adds all objects in tile lists to the spatial index
+      void RebuildSpatialIndex();
+
+      /// returns object slot for given object position
+      NpcObject& GetSlot(Uint16 objectPos)
+      {
+         return m_objectPool[objectPos >> c_poolBlockShift][objectPos & (c_poolBlockSize - 1)];
+      }
+
+      /// returns object slot for given object position; const version
+      const NpcObject& GetSlot(Uint16 objectPos) const
+      {
+         return m_objectPool[objectPos >> c_poolBlockShift][objectPos & (c_poolBlockSize - 1)];
+      }
+
+      /// resets object slot to an unused slot
+      static void ResetSlot(NpcObject& slot);
+
    private:
-      /// object list
-      std::vector<ObjectPtr> m_objectList;
+      /// number of bits of the object list position used as index into a pool block
+      static const unsigned int c_poolBlockShift = 8;
+
+      /// number of object slots in a pool block
+      static const unsigned int c_poolBlockSize = 1 << c_poolBlockShift;
+
+      /// object pool, in blocks of c_poolBlockSize slots
+      std::vector<std::vector<NpcObject>> m_objectPool;
+
+      /// object list size; the pool may have more slots in its last block
+      size_t m_objectListSize;
+
+      /// free object list slots; slots that were allocated, but not set yet,
+      /// are used
+      FreeSlotSet m_freeSlots;
+
+      /// spatial index of the objects in tile lists
+      ObjectSpatialIndex m_spatialIndex;
 
       /// object list start positions for all tiles in tilemap
       std::vector<Uint16> m_tilemapListStart;
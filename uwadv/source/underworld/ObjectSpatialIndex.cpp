@@ -0,0 +1,106 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ObjectSpatialIndex.cpp
+/// \brief spatial index for objects in tile lists
+//
+#include "pch.hpp"
+#include "ObjectSpatialIndex.hpp"
+
+using Underworld::ObjectSpatialIndex;
+using Underworld::ObjectClass;
+
+ObjectClass ObjectSpatialIndex::GetObjectClass(Uint16 itemID)
+{
+   if (itemID >= 0x0040 && itemID < 0x0080)
+      return objectClassNpc;
+
+   if (itemID >= 0x0180 && itemID < 0x01a0)
+      return objectClassTrap;
+
+   if (itemID == 0x01a0)
+      return objectClassMoveTrigger;
+
+   if (itemID > 0x01a0 && itemID < 0x01c0)
+      return objectClassTrigger;
+
+   return objectClassMax;
+}
+
+void ObjectSpatialIndex::Reset(size_t objectListSize)
+{
+   m_cellListStart.assign(c_numCellsPerSide * c_numCellsPerSide * objectClassMax, 0);
+   m_nextObject.assign(objectListSize, 0);
+   m_objectClasses.assign(objectListSize, Uint8(objectClassMax));
+}
+
+void ObjectSpatialIndex::Resize(size_t objectListSize)
+{
+   if (m_cellListStart.empty())
+      m_cellListStart.resize(c_numCellsPerSide * c_numCellsPerSide * objectClassMax, 0);
+
+   m_nextObject.resize(objectListSize, 0);
+   m_objectClasses.resize(objectListSize, Uint8(objectClassMax));
+}
+
+/// Adds the object to the start of the cell list, since the order of objects
+/// in a cell doesn't matter.
+/// \param objectPos object list position
+/// \param objectClass object class, as returned by GetObjectClass()
+/// \param xpos tile x coordinate
+/// \param ypos tile y coordinate
+void ObjectSpatialIndex::Insert(Uint16 objectPos, ObjectClass objectClass, Uint8 xpos, Uint8 ypos)
+{
+   UaAssert(objectPos < m_nextObject.size());
+   UaAssert(xpos < c_numCellsPerSide * c_cellSize && ypos < c_numCellsPerSide * c_cellSize);
+
+   // objects of imported levels may be chained from more than one tile
+   if (objectClass == objectClassMax || m_objectClasses[objectPos] != objectClassMax)
+      return;
+
+   Uint16& listStart = m_cellListStart[GetListIndex(xpos / c_cellSize, ypos / c_cellSize, objectClass)];
+
+   m_nextObject[objectPos] = listStart;
+   m_objectClasses[objectPos] = static_cast<Uint8>(objectClass);
+   listStart = objectPos;
+}
+
+/// \param objectPos object list position
+/// \param xpos tile x coordinate the object was added with
+/// \param ypos tile y coordinate the object was added with
+void ObjectSpatialIndex::Remove(Uint16 objectPos, Uint8 xpos, Uint8 ypos)
+{
+   UaAssert(objectPos < m_nextObject.size());
+
+   ObjectClass objectClass = static_cast<ObjectClass>(m_objectClasses[objectPos]);
+   if (objectClass == objectClassMax)
+      return;
+
+   m_objectClasses[objectPos] = static_cast<Uint8>(objectClassMax);
+
+   // search object in cell list
+   Uint16* link = &m_cellListStart[GetListIndex(xpos / c_cellSize, ypos / c_cellSize, objectClass)];
+   while (*link != 0 && *link != objectPos)
+      link = &m_nextObject[*link];
+
+   UaAssert(*link == objectPos); // when not found, object wasn't added on this tile
+   if (*link == objectPos)
+      *link = m_nextObject[objectPos];
+
+   m_nextObject[objectPos] = 0;
+}
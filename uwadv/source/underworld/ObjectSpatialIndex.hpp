@@ -0,0 +1,104 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ObjectSpatialIndex.hpp
+/// \brief spatial index for objects in tile lists
+//
+#pragma once
+
+#include <vector>
+
+namespace Underworld
+{
+   /// \brief Object classes that are indexed by the spatial index
+   /// \details Queries pass a mask of classes, e.g. 1 << objectClassNpc.
+   enum ObjectClass
+   {
+      objectClassNpc = 0,        ///< NPCs; item IDs 0x0040-0x007f
+      objectClassTrap,           ///< traps; item IDs 0x0180-0x019f
+      objectClassMoveTrigger,    ///< move triggers; item ID 0x01a0
+      objectClassTrigger,        ///< other triggers; item IDs 0x01a1-0x01bf
+      objectClassMax,            ///< not an indexed object class
+   };
+
+   /// \brief Spatial index for objects in tile lists
+   /// \details Divides the tilemap into cells of c_cellSize x c_cellSize tiles
+   /// and keeps a list of objects per cell and object class, so that queries
+   /// for objects of some classes near a position only visit objects of these
+   /// classes, and not all objects in the tile lists of the area. Lists are
+   /// linked through the object list positions, like the tile lists. The
+   /// index is maintained by the object list; the class of an object is
+   /// determined when it's added to a tile list.
+   class ObjectSpatialIndex
+   {
+   public:
+      /// cell size, in tiles
+      static const unsigned int c_cellSize = 4;
+
+      /// number of cells per side of the tilemap
+      static const unsigned int c_numCellsPerSide = 16;
+
+      /// ctor
+      ObjectSpatialIndex() {}
+
+      /// returns object class of an item ID, or objectClassMax
+      static ObjectClass GetObjectClass(Uint16 itemID);
+
+      /// removes all objects and sets number of object list positions
+      void Reset(size_t objectListSize);
+
+      /// resizes index to given number of object list positions
+      void Resize(size_t objectListSize);
+
+      /// adds object on given tile to the index; ignored for objects of no indexed class
+      void Insert(Uint16 objectPos, ObjectClass objectClass, Uint8 xpos, Uint8 ypos);
+
+      /// removes object on given tile from the index
+      void Remove(Uint16 objectPos, Uint8 xpos, Uint8 ypos);
+
+      /// returns first object of given class in cell, or 0 when there's none
+      Uint16 GetCellListStart(unsigned int cellX, unsigned int cellY, ObjectClass objectClass) const
+      {
+         return m_cellListStart[GetListIndex(cellX, cellY, objectClass)];
+      }
+
+      /// returns next object in the same cell list, or 0 at the end of the list
+      Uint16 GetNextObject(Uint16 objectPos) const
+      {
+         return m_nextObject[objectPos];
+      }
+
+   private:
+      /// returns index into m_cellListStart
+      static size_t GetListIndex(unsigned int cellX, unsigned int cellY, ObjectClass objectClass)
+      {
+         return (cellY * c_numCellsPerSide + cellX) * objectClassMax + objectClass;
+      }
+
+   private:
+      /// first object of every cell and class list
+      std::vector<Uint16> m_cellListStart;
+
+      /// next object in cell list, per object list position
+      std::vector<Uint16> m_nextObject;
+
+      /// object class of every indexed object, per object list position
+      std::vector<Uint8> m_objectClasses;
+   };
+
+} // namespace Underworld
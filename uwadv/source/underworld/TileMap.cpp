@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -22,7 +22,6 @@
 #include "pch.hpp"
 #include "Tilemap.hpp"
 #include "Savegame.hpp"
-#include <cmath>
 
 using Underworld::Tilemap;
 using Underworld::TileInfo;
@@ -37,7 +36,14 @@ double Tilemap::GetFloorHeight(double xpos, double ypos) const
 
    double height = 0.0;
 
-   const TileInfo& tile = GetTileInfo(static_cast<Uint8>(xpos), static_cast<Uint8>(ypos));
+   unsigned int tileX = static_cast<unsigned int>(xpos);
+   unsigned int tileY = static_cast<unsigned int>(ypos);
+
+   // position inside the tile; same as fmod(pos, 1.0) for positive values
+   double fracX = xpos - tileX;
+   double fracY = ypos - tileY;
+
+   const TileInfo& tile = GetTileInfo(tileX, tileY);
 
    switch (tile.m_type)
    {
@@ -51,25 +57,25 @@ double Tilemap::GetFloorHeight(double xpos, double ypos) const
 
       // diagonal tiles
    case tileDiagonal_se:
-      if (fmod(xpos, 1.0) - fmod(ypos, 1.0) < 0.0)
+      if (fracX - fracY < 0.0)
          height = tile.m_ceiling;
       else
          height = tile.m_floor;
       break;
    case tileDiagonal_sw:
-      if (fmod(xpos, 1.0) + fmod(ypos, 1.0) > 1.0)
+      if (fracX + fracY > 1.0)
          height = tile.m_ceiling;
       else
          height = tile.m_floor;
       break;
    case tileDiagonal_nw:
-      if (fmod(xpos, 1.0) - fmod(ypos, 1.0) > 0.0)
+      if (fracX - fracY > 0.0)
          height = tile.m_ceiling;
       else
          height = tile.m_floor;
       break;
    case tileDiagonal_ne:
-      if (fmod(xpos, 1.0) + fmod(ypos, 1.0) < 1.0)
+      if (fracX + fracY < 1.0)
          height = tile.m_ceiling;
       else
          height = tile.m_floor;
@@ -78,19 +84,19 @@ double Tilemap::GetFloorHeight(double xpos, double ypos) const
       // sloped tiles
    case tileSlope_n:
       height = tile.m_floor +
-         static_cast<double>(tile.m_slope) * fmod(ypos, 1.0);
+         static_cast<double>(tile.m_slope) * fracY;
       break;
    case tileSlope_s:
       height = (tile.m_floor + tile.m_slope) -
-         static_cast<double>(tile.m_slope)*fmod(ypos, 1.0);
+         static_cast<double>(tile.m_slope)*fracY;
       break;
    case tileSlope_e:
       height = tile.m_floor +
-         static_cast<double>(tile.m_slope)*fmod(xpos, 1.0);
+         static_cast<double>(tile.m_slope)*fracX;
       break;
    case tileSlope_w:
       height = (tile.m_floor + tile.m_slope) -
-         static_cast<double>(tile.m_slope)*fmod(xpos, 1.0);
+         static_cast<double>(tile.m_slope)*fracX;
       break;
 
    default:
@@ -101,16 +107,13 @@ double Tilemap::GetFloorHeight(double xpos, double ypos) const
    return height;
 }
 
-TileInfo& Tilemap::GetTileInfo(unsigned int xpos, unsigned int ypos)
-{
-   xpos %= c_underworldTilemapSize; ypos %= c_underworldTilemapSize;
-   return m_tilesList[ypos * c_underworldTilemapSize + xpos];
-}
-
-const TileInfo& Tilemap::GetTileInfo(unsigned int xpos, unsigned int ypos) const
+/// Adds a stock texture id to the set of used textures. Texture ids outside
+/// of the wall and floor textures are ignored, e.g. invalid ids in map data
+/// or ids set through the debug server.
+void Tilemap::AddUsedTexture(Uint16 textureId)
 {
-   xpos %= c_underworldTilemapSize; ypos %= c_underworldTilemapSize;
-   return m_tilesList[ypos * c_underworldTilemapSize + xpos];
+   if (textureId < c_numTileTextures)
+      m_usedTextures.set(textureId);
 }
 
 void Tilemap::Load(Base::Savegame& sg)
@@ -147,9 +150,7 @@ void Tilemap::Load(Base::Savegame& sg)
 
       tile.m_automapFlag = static_cast<AutomapFlag>(sg.Read8());
 
-      m_setUsedTextures.insert(tile.m_textureWall);
-      m_setUsedTextures.insert(tile.m_textureFloor);
-      m_setUsedTextures.insert(tile.m_textureCeiling);
+      AddUsedTextures(tile);
    }
 
    sg.EndSection();
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019,2021 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,7 +24,7 @@
 #include "Base.hpp"
 #include "Constants.hpp"
 #include <vector>
-#include <set>
+#include <bitset>
 
 namespace Base
 {
@@ -36,8 +36,11 @@ namespace Underworld
    /// default tilemap size for underworld games
    const unsigned int c_underworldTilemapSize = 64;
 
+   /// number of stock texture ids that tiles can use; wall and floor textures
+   const Uint16 c_numTileTextures = Base::c_stockTexturesObjects;
+
    /// tile types
-   enum TilemapTileType
+   enum TilemapTileType : Uint8
    {
       tileSolid = 0x00,       ///< solid tile
       tileOpen = 0x01,       ///< open tile; player can go through tile
@@ -52,7 +55,7 @@ namespace Underworld
    };
 
    /// automap flag
-   enum AutomapFlag
+   enum AutomapFlag : Uint8
    {
       automapDefault = 0x0,   ///< default tile
       automapDoor = 0x1,      ///< tile containing door
@@ -63,37 +66,34 @@ namespace Underworld
       automapUndiscovered = 0x0f,   ///< undiscovered tile
    };
 
-   /// tilemap tile info
+   /// \brief Tilemap tile info
+   /// \details The members are ordered by size and the flags are stored as
+   /// bit fields, so that a tile takes 14 bytes without padding, and code
+   /// going over all tiles of a level touches less memory.
    struct TileInfo
    {
       /// ctor
       TileInfo()
-         :m_type(tileSolid),
-         m_floor(0),
+         :m_floor(0),
          m_ceiling(128),
-         m_slope(8),
          m_textureWall(Base::c_stockTexturesWall),
          m_textureFloor(Base::c_stockTexturesFloor),
          m_textureCeiling(Base::c_stockTexturesFloor),
+         m_type(tileSolid),
+         m_slope(8),
+         m_automapFlag(automapUndiscovered),
          m_isMagicDisabled(false),
          m_isDoorPresent(false),
-         m_isSpecialLightFeature(false),
-         m_automapFlag(automapUndiscovered)
+         m_isSpecialLightFeature(false)
       {
       }
 
-      /// tile type
-      TilemapTileType m_type;
-
       /// floor height
       Uint16 m_floor;
 
       /// ceiling height
       Uint16 m_ceiling;
 
-      /// slope from this tile to next
-      Uint8 m_slope;
-
       /// texture id for wall
       Uint16 m_textureWall;
 
@@ -103,19 +103,28 @@ namespace Underworld
       /// texture id for ceiling
       Uint16 m_textureCeiling;
 
+      /// tile type
+      TilemapTileType m_type;
+
+      /// slope from this tile to next
+      Uint8 m_slope;
+
+      /// automap flag
+      AutomapFlag m_automapFlag;
+
       /// indicates if magic is disabled in this tile
-      bool m_isMagicDisabled;
+      bool m_isMagicDisabled : 1;
 
       /// indicates if a door is present in this tile
-      bool m_isDoorPresent;
+      bool m_isDoorPresent : 1;
 
       /// special light feature \todo rename to a better name
-      bool m_isSpecialLightFeature;
-
-      /// automap flag
-      AutomapFlag m_automapFlag;
+      bool m_isSpecialLightFeature : 1;
    };
 
+   /// set of stock texture ids used by the tiles of a tilemap
+   typedef std::bitset<c_numTileTextures> TileTexturesSet;
+
    /// tilemap
    class Tilemap
    {
@@ -131,7 +140,7 @@ namespace Underworld
       {
          m_tilesList.clear();
          m_tilesList.resize(c_underworldTilemapSize * c_underworldTilemapSize);
-         m_setUsedTextures.clear();
+         m_usedTextures.reset();
          m_isUsed = true;
       }
 
@@ -139,7 +148,7 @@ namespace Underworld
       void Destroy()
       {
          m_tilesList.clear();
-         m_setUsedTextures.clear();
+         m_usedTextures.reset();
          m_isUsed = false;
       }
 
@@ -158,17 +167,33 @@ namespace Underworld
       /// returns floor height on specific position
       double GetFloorHeight(double xpos, double ypos) const;
 
-      /// returns a tile info struct
-      TileInfo& GetTileInfo(unsigned int xpos, unsigned int ypos);
+      /// returns a tile info struct; coordinates wrap around
+      TileInfo& GetTileInfo(unsigned int xpos, unsigned int ypos)
+      {
+         xpos %= c_underworldTilemapSize; ypos %= c_underworldTilemapSize;
+         return m_tilesList[ypos * c_underworldTilemapSize + xpos];
+      }
 
-      /// returns a tile info struct
-      const TileInfo& GetTileInfo(unsigned int xpos, unsigned int ypos) const;
+      /// returns a tile info struct; coordinates wrap around
+      const TileInfo& GetTileInfo(unsigned int xpos, unsigned int ypos) const
+      {
+         xpos %= c_underworldTilemapSize; ypos %= c_underworldTilemapSize;
+         return m_tilesList[ypos * c_underworldTilemapSize + xpos];
+      }
 
       /// returns set of used stock texture ids
-      const std::set<Uint16>& GetUsedTextures() const { return m_setUsedTextures; }
+      const TileTexturesSet& GetUsedTextures() const { return m_usedTextures; }
 
-      /// returns set of used stock texture ids; non-const version
-      std::set<Uint16>& GetUsedTextures() { return m_setUsedTextures; }
+      /// adds stock texture id to the set of used textures
+      void AddUsedTexture(Uint16 textureId);
+
+      /// adds wall, floor and ceiling texture of tile to the set of used textures
+      void AddUsedTextures(const TileInfo& tileInfo)
+      {
+         AddUsedTexture(tileInfo.m_textureWall);
+         AddUsedTexture(tileInfo.m_textureFloor);
+         AddUsedTexture(tileInfo.m_textureCeiling);
+      }
 
       /// returns tiles list
       std::vector<TileInfo>& GetVectorTileInfo() { return m_tilesList; }
@@ -186,7 +211,7 @@ namespace Underworld
       std::vector<TileInfo> m_tilesList;
 
       /// set with all used texture ids
-      std::set<Uint16> m_setUsedTextures;
+      TileTexturesSet m_usedTextures;
 
       /// indicates if tilemap is filled with actual tiles
       bool m_isUsed;
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -23,6 +23,9 @@
 #include "ArchiveFile.hpp"
 #include "Settings.hpp"
 #include "ResourceManager.hpp"
+#include "MemoryReader.hpp"
+#include "Uw2decode.hpp"
+#include <SDL2/SDL_rwops.h>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -49,6 +52,258 @@ namespace UnitTest
          file.GetFile(1);
       }
 
+      /// load uw1 levels from memory mapped file
+      TEST_METHOD(TestArchiveFileMapLevelsUw1)
+      {
+         Base::Settings& settings = GetTestSettings();
+         Base::ResourceManager resourceMgr(settings);
+
+         Base::ArchiveFile file(resourceMgr.MapUnderworldFile(Base::resourceGameUw1, "data/lev.ark"));
+         Assert::IsTrue(file.GetNumFiles() == 9 * 15); // 135 blocks
+
+         // level blocks are followed by the object list and texture mapping
+         for (unsigned int index = 0; index < 9; index++)
+            Assert::IsTrue(file.GetBlock(index).m_size >= 0x7c08);
+      }
+
+      /// appends 16-bit value to archive data
+      static void Append16(std::vector<Uint8>& data, Uint16 value)
+      {
+         data.push_back(static_cast<Uint8>(value & 0xff));
+         data.push_back(static_cast<Uint8>(value >> 8));
+      }
+
+      /// appends 32-bit value to archive data
+      static void Append32(std::vector<Uint8>& data, Uint32 value)
+      {
+         Append16(data, static_cast<Uint16>(value & 0xffff));
+         Append16(data, static_cast<Uint16>(value >> 16));
+      }
+
+      /// creates archive file reading from given archive data
+      static Base::ArchiveFile CreateArchiveFile(const std::vector<Uint8>& data, bool uw2Mode)
+      {
+         return Base::ArchiveFile(
+            Base::MakeRWopsPtr(SDL_RWFromConstMem(data.data(), static_cast<int>(data.size()))),
+            uw2Mode);
+      }
+
+      /// Tests reading uw1 blocks from an archive in memory; the size of uw1
+      /// blocks is determined by the start of the next block.
+      TEST_METHOD(TestArchiveFileInMemoryUw1)
+      {
+         // set up
+         std::vector<Uint8> data;
+         Append16(data, 3);
+         Append32(data, 14);
+         Append32(data, 0); // not available
+         Append32(data, 18);
+         data.insert(data.end(), { 'A', 'B', 'C', 'D', 'E', 'F', 'G' });
+
+         // run
+         Base::ArchiveFile file = CreateArchiveFile(data, false);
+
+         // check
+         Assert::AreEqual<size_t>(3, file.GetNumFiles());
+         Assert::IsTrue(file.IsAvailable(0));
+         Assert::IsFalse(file.IsAvailable(1));
+         Assert::IsTrue(file.IsAvailable(2));
+
+         Base::ByteSpan block0 = file.GetBlock(0);
+         Assert::AreEqual<size_t>(4, block0.m_size);
+         Assert::AreEqual(std::string("ABCD"), std::string(block0.m_data, block0.m_data + block0.m_size));
+
+         Base::ByteSpan block2 = file.GetBlock(2);
+         Assert::AreEqual<size_t>(3, block2.m_size);
+         Assert::AreEqual(std::string("EFG"), std::string(block2.m_data, block2.m_data + block2.m_size));
+
+         Base::File file2 = file.GetFile(2);
+         Assert::AreEqual<long>(3, file2.FileLength());
+         Assert::AreEqual<Uint8>('E', file2.Read8());
+      }
+
+      /// Tests reading uncompressed and compressed uw2 blocks from an archive
+      /// in memory; compressed blocks are only decoded once.
+      TEST_METHOD(TestArchiveFileInMemoryUw2)
+      {
+         // set up
+         std::vector<Uint8> data;
+         Append16(data, 2);
+         Append32(data, 0);
+         Append32(data, 38); // offsets
+         Append32(data, 41);
+         Append32(data, 1); // flags
+         Append32(data, 3);
+         Append32(data, 3); // data sizes
+         Append32(data, 10);
+         Append32(data, 3); // avail sizes
+         Append32(data, 10);
+
+         // uncompressed block
+         data.insert(data.end(), { 'X', 'Y', 'Z' });
+
+         // compressed block: 3 literal bytes, then copy 6 bytes from position 0
+         data.insert(data.end(), { 0x00, 0x00, 0x00, 0x00, 0x07, 'A', 'B', 'C', 0xee, 0xf3 });
+
+         // run
+         Base::ArchiveFile file = CreateArchiveFile(data, true);
+
+         // check
+         Assert::AreEqual<size_t>(2, file.GetNumFiles());
+
+         Base::ByteSpan block0 = file.GetBlock(0);
+         Assert::AreEqual(std::string("XYZ"), std::string(block0.m_data, block0.m_data + block0.m_size));
+
+         Base::ByteSpan block1 = file.GetBlock(1);
+         Assert::AreEqual(std::string("ABCABCABC"), std::string(block1.m_data, block1.m_data + block1.m_size));
+         Assert::IsTrue(block1.m_data == file.GetBlock(1).m_data, L"decoded block must be cached");
+
+         Base::MemoryReader reader{ block1 };
+         Assert::AreEqual<Uint16>(0x4241, reader.Read16());
+         Assert::AreEqual<Uint32>(0x43424143, reader.Read32());
+         reader.Seek(8, Base::seekBegin);
+         Assert::AreEqual<Uint8>('C', reader.Read8());
+         Assert::AreEqual<Uint16>(0, reader.Read16(), L"reading past the end must return 0");
+      }
+
+      /// Tests encoding data in the uw2 compression format and decoding it
+      /// again; uses runs, repeated patterns longer than the 4k window, and
+      /// data that doesn't compress.
+      TEST_METHOD(TestUw2EncodeDecode)
+      {
+         // set up
+         std::vector<Uint8> data;
+         data.insert(data.end(), 100, 0x00);
+         for (unsigned int index = 0; index < 0x3000; index++)
+            data.push_back(static_cast<Uint8>((index * 7) % 251));
+         for (unsigned int index = 0; index < 1000; index++)
+            data.push_back(static_cast<Uint8>((index * index * 31) >> 3));
+         data.insert(data.end(), { 'A', 'B' });
+
+         // run
+         std::vector<Uint8> compressedData;
+         Base::Uw2Encode(Base::ByteSpan(data.data(), data.size()), compressedData);
+
+         Base::ByteSpan source{ compressedData.data(), compressedData.size() };
+         std::vector<Uint8> decodedData(Base::Uw2GetMaxDecodedSize(source));
+
+         Uint32 decodedSize = 0;
+         bool result = Base::Uw2Decode(source, decodedData.data(),
+            static_cast<Uint32>(decodedData.size()), decodedSize);
+
+         // check
+         Assert::IsTrue(compressedData.size() < data.size(), L"data must be compressed");
+         Assert::IsTrue(result);
+         Assert::AreEqual<size_t>(data.size(), decodedSize);
+         decodedData.resize(decodedSize);
+         Assert::IsTrue(data == decodedData);
+
+         Assert::IsFalse(
+            Base::Uw2Decode(source, decodedData.data(), decodedSize - 1, decodedSize),
+            L"decoding into a too small buffer must fail");
+      }
+
+      /// Tests reading an encoded block from an uw2 archive in memory
+      TEST_METHOD(TestArchiveFileEncodedBlockUw2)
+      {
+         // set up
+         std::string text = "Abcabcabcabc! The quick brown fox jumps over the lazy dog. Abcabc!";
+
+         std::vector<Uint8> compressedData;
+         Base::Uw2Encode(
+            Base::ByteSpan(reinterpret_cast<const Uint8*>(text.data()), text.size()),
+            compressedData);
+
+         std::vector<Uint8> data;
+         Append16(data, 1);
+         Append32(data, 0);
+         Append32(data, 22); // offset
+         Append32(data, 3); // flags
+         Append32(data, static_cast<Uint32>(compressedData.size()));
+         Append32(data, static_cast<Uint32>(compressedData.size()));
+         data.insert(data.end(), compressedData.begin(), compressedData.end());
+
+         // run
+         Base::ArchiveFile file = CreateArchiveFile(data, true);
+         Base::ByteSpan block = file.GetBlock(0);
+
+         // check
+         Assert::AreEqual(text, std::string(block.m_data, block.m_data + block.m_size));
+      }
+
+      /// Measures decoding all compressed blocks of uw2's lev.ark, and
+      /// encoding them again
+      TEST_METHOD(TestProfilingUw2DecodeLevArk)
+      {
+         Base::Settings& settings = GetTestSettings();
+         Base::ResourceManager resourceMgr(settings);
+
+         std::shared_ptr<const Base::MemoryMappedFile> levArk =
+            resourceMgr.MapUnderworldFile(Base::resourceGameUw2, "data/lev.ark");
+
+         const unsigned int numIterations = 20;
+         size_t numBlocks = 0;
+         size_t compressedSize = 0;
+         size_t decodedSize = 0;
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+         for (unsigned int iteration = 0; iteration < numIterations; iteration++)
+         {
+            // decoded blocks are cached, so use a new archive file each time
+            Base::ArchiveFile file{ levArk, true };
+
+            for (size_t index = 0; index < file.GetNumFiles(); index++)
+            {
+               if (!file.IsAvailable(index))
+                  continue;
+
+               Base::ByteSpan block = file.GetBlock(index);
+
+               if (iteration == 0)
+               {
+                  numBlocks++;
+                  decodedSize += block.m_size;
+               }
+            }
+         }
+         Uint64 end = SDL_GetPerformanceCounter();
+
+         double decodeTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency() / numIterations;
+
+         // encode all blocks and check that they decode to the same data
+         Base::ArchiveFile file{ levArk, true };
+         std::vector<Uint8> compressedData;
+         std::vector<Uint8> decodedData;
+         double encodeTime = 0.0;
+
+         for (size_t index = 0; index < file.GetNumFiles(); index++)
+         {
+            if (!file.IsAvailable(index))
+               continue;
+
+            Base::ByteSpan block = file.GetBlock(index);
+
+            begin = SDL_GetPerformanceCounter();
+            Base::Uw2Encode(block, compressedData);
+            end = SDL_GetPerformanceCounter();
+
+            encodeTime += double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+            compressedSize += compressedData.size();
+
+            Base::ByteSpan source{ compressedData.data(), compressedData.size() };
+            decodedData.resize(Base::Uw2GetMaxDecodedSize(source));
+
+            Uint32 size = 0;
+            Assert::IsTrue(Base::Uw2Decode(source, decodedData.data(),
+               static_cast<Uint32>(decodedData.size()), size));
+            Assert::AreEqual<size_t>(block.m_size, size);
+            Assert::IsTrue(std::equal(block.m_data, block.m_data + block.m_size, decodedData.begin()));
+         }
+
+         UaTrace("decoding %zu lev.ark blocks with %zu bytes: %1.3f ms; encoding to %zu bytes: %1.3f ms\n",
+            numBlocks, decodedSize, decodeTime, compressedSize, encodeTime);
+      }
+
       /// load uw1 conversations
       TEST_METHOD(TestArchiveFileLoadConversationsUw1)
       {
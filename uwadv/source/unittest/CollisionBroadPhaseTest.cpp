@@ -0,0 +1,319 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CollisionBroadPhaseTest.cpp
+/// \brief tests for the CollisionBroadPhase class
+//
+#include "pch.hpp"
+#include "Math.hpp"
+#include "Plane3d.hpp"
+#include "PhysicsBody.hpp"
+#include "CollisionBroadPhase.hpp"
+#include "CollisionDetection.hpp"
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Physics;
+
+namespace UnitTest
+{
+   /// physics body moving with constant velocity
+   class MovingPhysicsBody : public PhysicsBody
+   {
+   public:
+      /// ctor
+      MovingPhysicsBody(const Vector3d& ellipsoid, const Vector3d& pos, const Vector3d& dir)
+         :m_pos(pos),
+         m_dir(dir)
+      {
+         m_ellipsoid = ellipsoid;
+      }
+
+      /// returns position of body
+      virtual Vector3d GetPosition() const override { return m_pos; }
+
+      /// sets new position of body
+      virtual void SetPosition(const Vector3d& pos) override { m_pos = pos; }
+
+      /// returns current direction vector of body
+      virtual Vector3d GetDirection() const override { return m_dir; }
+
+      /// returns if gravity is active for this body
+      virtual bool IsGravityActive() const override { return false; }
+
+   private:
+      /// body position
+      Vector3d m_pos;
+
+      /// body direction
+      Vector3d m_dir;
+   };
+
+   /// \brief CollisionBroadPhase tests
+   /// Tests that the broad phase never rejects triangles that the exact
+   /// collision check would collide with.
+   TEST_CLASS(CollisionBroadPhaseTest)
+   {
+      /// player sized ellipsoid
+      static Vector3d GetTestEllipsoid()
+      {
+         return Vector3d{ 0.2, 0.2, 11.9 };
+      }
+
+      /// creates random triangles in a box of 3x3 tiles and full height,
+      /// mixing floor-like, wall-like and arbitrary triangles
+      static void CreateRandomTriangles(std::mt19937& random, size_t count,
+         std::vector<Triangle3dTextured>& allTriangles)
+      {
+         std::uniform_real_distribution<double> tilePos{ 30.0, 33.0 };
+         std::uniform_real_distribution<double> heightPos{ 0.0, 128.0 };
+         std::uniform_real_distribution<double> offset{ -1.0, 1.0 };
+
+         for (size_t index = 0; index < count; index++)
+         {
+            Vector3d base{ tilePos(random), tilePos(random), heightPos(random) };
+
+            Vector3d edge1, edge2;
+            switch (index % 3)
+            {
+            case 0: // floor
+               edge1 = Vector3d{ offset(random), offset(random), offset(random) * 0.1 };
+               edge2 = Vector3d{ offset(random), offset(random), offset(random) * 0.1 };
+               break;
+            case 1: // wall
+               edge1 = Vector3d{ offset(random), offset(random) * 0.1, offset(random) * 16.0 };
+               edge2 = Vector3d{ offset(random), offset(random) * 0.1, offset(random) * 16.0 };
+               break;
+            default:
+               edge1 = Vector3d{ offset(random), offset(random), offset(random) * 16.0 };
+               edge2 = Vector3d{ offset(random), offset(random), offset(random) * 16.0 };
+               break;
+            }
+
+            allTriangles.push_back(Triangle3dTextured{
+               Vertex3d(base), Vertex3d(base + edge1), Vertex3d(base + edge2) });
+         }
+      }
+
+      /// returns if the exact plane test in double precision lets the
+      /// triangle pass; the broad phase must not reject such triangles
+      static bool IsExactCandidate(const CollisionTriangle& triangle, const Vector3d& ellipsoid,
+         const Vector3d& basePoint, const Vector3d& velocity, const Vector3d& normalizedVelocity)
+      {
+         Vector3d p1 = triangle.m_points[0], p2 = triangle.m_points[1], p3 = triangle.m_points[2];
+         p1 /= ellipsoid;
+         p2 /= ellipsoid;
+         p3 /= ellipsoid;
+
+         Plane3d plane{ p1, p2, p3 };
+         if (!plane.IsFrontFacingTo(normalizedVelocity))
+            return false;
+
+         double startDistance = plane.SignedDistanceTo(basePoint);
+         double endDistance = plane.SignedDistanceTo(basePoint + velocity);
+
+         return std::min(startDistance, endDistance) <= 1.0 &&
+            std::max(startDistance, endDistance) >= -1.0;
+      }
+
+      /// Tests that all implementations let pass all triangles the exact plane
+      /// test lets pass, and that they reject most of the other triangles.
+      TEST_METHOD(TestImplementationsDontRejectCandidates)
+      {
+         // set up
+         std::mt19937 random{ 42 };
+         std::uniform_real_distribution<double> tilePos{ 30.0, 33.0 };
+         std::uniform_real_distribution<double> heightPos{ 0.0, 128.0 };
+         std::uniform_real_distribution<double> offset{ -1.0, 1.0 };
+
+         std::vector<Triangle3dTextured> allTriangles;
+         CreateRandomTriangles(random, 1000, allTriangles);
+
+         CollisionTriangleList triangleList;
+         triangleList.AddTriangles(allTriangles);
+         CollisionTriangleRange range = triangleList.GetRange();
+
+         Vector3d ellipsoid = GetTestEllipsoid();
+
+         size_t numExactCandidates = 0, numScalarCandidates = 0;
+
+         for (unsigned int query = 0; query < 100; query++)
+         {
+            Vector3d basePoint{ tilePos(random), tilePos(random), heightPos(random) };
+            Vector3d velocity{ offset(random) * 0.2, offset(random) * 0.2, offset(random) };
+
+            basePoint /= ellipsoid;
+            velocity /= ellipsoid;
+
+            Vector3d normalizedVelocity = velocity;
+            normalizedVelocity.Normalize();
+
+            CollisionBroadPhase broadPhase{ ellipsoid, basePoint, velocity, normalizedVelocity };
+
+            const size_t maxTriangles = CollisionBroadPhase::c_maxTriangles;
+
+            for (size_t start = 0; start < range.GetSize(); start += maxTriangles)
+            {
+               size_t count = std::min(range.GetSize() - start, maxTriangles);
+
+               for (unsigned int implementation = CollisionBroadPhase::implNone;
+                  implementation <= CollisionBroadPhase::implAvx2; implementation++)
+               {
+                  CollisionBroadPhase::Implementation impl =
+                     static_cast<CollisionBroadPhase::Implementation>(implementation);
+
+                  if (!CollisionBroadPhase::IsSupported(impl))
+                     continue;
+
+                  // run
+                  Uint64 candidates = broadPhase.FindCandidates(impl, range.m_planes, start, count);
+
+                  // check
+                  for (size_t index = 0; index < count; index++)
+                  {
+                     bool isCandidate = (candidates & (Uint64(1) << index)) != 0;
+
+                     bool isExactCandidate = IsExactCandidate(range.m_begin[start + index],
+                        ellipsoid, basePoint, velocity, normalizedVelocity);
+
+                     if (isExactCandidate)
+                        Assert::IsTrue(isCandidate, L"broad phase must not reject candidate triangle");
+
+                     if (impl == CollisionBroadPhase::implScalar)
+                     {
+                        numExactCandidates += isExactCandidate ? 1 : 0;
+                        numScalarCandidates += isCandidate ? 1 : 0;
+                     }
+                  }
+
+                  if (count < maxTriangles)
+                     Assert::IsTrue((candidates >> count) == 0, L"bits above count must not be set");
+               }
+            }
+         }
+
+         // the tolerance must not let pass much more triangles than necessary
+         Assert::IsTrue(numScalarCandidates < numExactCandidates + numExactCandidates / 10 + 10,
+            L"broad phase must reject most non-candidate triangles");
+      }
+
+      /// Tests that collision detection with every broad phase implementation
+      /// moves the body to the same position as without broad phase.
+      TEST_METHOD(TestCollisionDetectionMatchesWithoutBroadPhase)
+      {
+         // set up
+         std::mt19937 random{ 1234 };
+         std::uniform_real_distribution<double> tilePos{ 30.5, 32.5 };
+         std::uniform_real_distribution<double> heightPos{ 12.0, 116.0 };
+         std::uniform_real_distribution<double> offset{ -1.0, 1.0 };
+
+         std::vector<Triangle3dTextured> allTriangles;
+         CreateRandomTriangles(random, 300, allTriangles);
+
+         for (unsigned int move = 0; move < 200; move++)
+         {
+            Vector3d pos{ tilePos(random), tilePos(random), heightPos(random) };
+            Vector3d dir{ offset(random) * 0.3, offset(random) * 0.3, offset(random) * 4.0 };
+
+            MovingPhysicsBody referenceBody{ GetTestEllipsoid(), pos, dir };
+
+            CollisionDetection referenceDetection{ allTriangles, referenceBody };
+            referenceDetection.SetBroadPhaseImplementation(CollisionBroadPhase::implNone);
+            referenceDetection.TrackObject(referenceBody);
+
+            for (unsigned int implementation = CollisionBroadPhase::implScalar;
+               implementation <= CollisionBroadPhase::implAvx2; implementation++)
+            {
+               CollisionBroadPhase::Implementation impl =
+                  static_cast<CollisionBroadPhase::Implementation>(implementation);
+
+               if (!CollisionBroadPhase::IsSupported(impl))
+                  continue;
+
+               // run
+               MovingPhysicsBody body{ GetTestEllipsoid(), pos, dir };
+
+               CollisionDetection detection{ allTriangles, body };
+               detection.SetBroadPhaseImplementation(impl);
+               detection.TrackObject(body);
+
+               // check
+               Vector3d delta = body.GetPosition() - referenceBody.GetPosition();
+               Assert::AreEqual(0.0, delta.Length(), 1e-12, L"positions must be equal");
+            }
+         }
+      }
+
+      /// Measures collision detection throughput with all broad phase
+      /// implementations, using the triangles of 3x3 tiles.
+      TEST_METHOD(TestProfilingCollisionBroadPhase)
+      {
+         std::mt19937 random{ 7 };
+         std::uniform_real_distribution<double> tilePos{ 30.5, 32.5 };
+         std::uniform_real_distribution<double> heightPos{ 12.0, 116.0 };
+         std::uniform_real_distribution<double> offset{ -1.0, 1.0 };
+
+         std::vector<Triangle3dTextured> allTriangles;
+         CreateRandomTriangles(random, 180, allTriangles);
+
+         CollisionTriangleList triangleList;
+         triangleList.AddTriangles(allTriangles);
+         CollisionTriangleRange range = triangleList.GetRange();
+
+         std::vector<std::pair<Vector3d, Vector3d>> moves;
+         for (unsigned int move = 0; move < 100; move++)
+            moves.push_back(std::make_pair(
+               Vector3d{ tilePos(random), tilePos(random), heightPos(random) },
+               Vector3d{ offset(random) * 0.3, offset(random) * 0.3, offset(random) * 4.0 }));
+
+         const char* implementationNames[] = { "none", "scalar", "SSE2", "AVX2" };
+
+         for (unsigned int implementation = CollisionBroadPhase::implNone;
+            implementation <= CollisionBroadPhase::implAvx2; implementation++)
+         {
+            CollisionBroadPhase::Implementation impl =
+               static_cast<CollisionBroadPhase::Implementation>(implementation);
+
+            if (!CollisionBroadPhase::IsSupported(impl))
+               continue;
+
+            const int max = 20;
+
+            Uint64 begin = SDL_GetPerformanceCounter();
+
+            for (int i = 0; i < max; i++)
+            {
+               for (const auto& move : moves)
+               {
+                  MovingPhysicsBody body{ GetTestEllipsoid(), move.first, move.second };
+
+                  CollisionDetection detection{ &range, 1, body };
+                  detection.SetBroadPhaseImplementation(impl);
+                  detection.TrackObject(body);
+               }
+            }
+
+            Uint64 end = SDL_GetPerformanceCounter();
+
+            double trackTime = double(end - begin) * 1000000.0 / SDL_GetPerformanceFrequency() / (max * moves.size());
+            UaTrace("%s : %1.3f us per tracked body, %zu triangles\n",
+               implementationNames[implementation], trackTime, allTriangles.size());
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,221 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CritterSchedulerTest.cpp
+/// \brief tests for the CritterScheduler class
+//
+#include "pch.hpp"
+#include "CritterScheduler.hpp"
+#include "Level.hpp"
+#include <map>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Underworld;
+
+namespace UnitTest
+{
+   /// \brief CritterScheduler tests
+   /// Tests sorting critters into detail levels and evaluating them in the
+   /// intervals of their detail levels and within the time budget.
+   TEST_CLASS(CritterSchedulerTest)
+   {
+      /// creates a level with all tiles open, except the border
+      static void CreateLevel(Level& level)
+      {
+         level.GetTilemap().Create();
+         level.GetObjectList().Create();
+
+         for (unsigned int ypos = 1; ypos < 63; ypos++)
+            for (unsigned int xpos = 1; xpos < 63; xpos++)
+            {
+               TileInfo& tileInfo = level.GetTilemap().GetTileInfo(xpos, ypos);
+               tileInfo.m_type = tileOpen;
+               tileInfo.m_floor = 16;
+               tileInfo.m_ceiling = 128;
+            }
+      }
+
+      /// adds NPC object to given tile
+      static Uint16 AddCritter(Level& level, unsigned int xpos, unsigned int ypos)
+      {
+         ObjectList& objectList = level.GetObjectList();
+
+         Uint16 objectPos = objectList.Allocate();
+         objectList.SetObject(objectPos, std::make_shared<NpcObject>());
+         objectList.AddObjectToTileList(objectPos, static_cast<Uint8>(xpos), static_cast<Uint8>(ypos));
+
+         return objectPos;
+      }
+
+      /// Tests sorting critters by distance and visibility.
+      TEST_METHOD(TestDetailLevels)
+      {
+         // set up
+         Level level;
+         CreateLevel(level);
+
+         AddCritter(level, 12, 10); // near
+         AddCritter(level, 10, 16); // near, but behind a wall
+         AddCritter(level, 25, 10); // mid-range
+         AddCritter(level, 50, 50); // far
+
+         for (unsigned int xpos = 5; xpos < 15; xpos++)
+            level.GetTilemap().GetTileInfo(xpos, 13).m_type = tileSolid;
+
+         CritterScheduler scheduler;
+
+         // run
+         scheduler.Tick(level, 10.5, 10.5);
+
+         // check
+         const CritterSchedulerStats& stats = scheduler.GetStats();
+         Assert::AreEqual(1u, stats.m_numCritters[critterDetailNear]);
+         Assert::AreEqual(2u, stats.m_numCritters[critterDetailMid]);
+         Assert::AreEqual(1u, stats.m_numCritters[critterDetailFar]);
+      }
+
+      /// Tests that critters are evaluated in the intervals of their detail
+      /// levels, and that removed critters aren't evaluated anymore.
+      TEST_METHOD(TestTickIntervals)
+      {
+         // set up
+         Level level;
+         CreateLevel(level);
+
+         Uint16 nearPos = AddCritter(level, 12, 10);
+         Uint16 midPos = AddCritter(level, 25, 10);
+         Uint16 farPos = AddCritter(level, 50, 50);
+
+         std::map<Uint16, unsigned int> numEvaluations;
+
+         CritterScheduler scheduler;
+         scheduler.Init([&](Uint16 objectPos) { numEvaluations[objectPos]++; });
+
+         // run
+         for (unsigned int tick = 0; tick < 32; tick++)
+            scheduler.Tick(level, 10.5, 10.5);
+
+         // check
+         Assert::AreEqual(32u, numEvaluations[nearPos], L"near critter must be evaluated every tick");
+         Assert::AreEqual(8u, numEvaluations[midPos], L"mid-range critter must be evaluated every 4 ticks");
+         Assert::AreEqual(2u, numEvaluations[farPos], L"far critter must be evaluated every 16 ticks");
+         Assert::AreEqual(42u, scheduler.GetStats().m_totalEvaluations);
+
+         // remove critter from its tile
+         level.GetObjectList().RemoveObjectFromTileList(nearPos, 12, 10);
+
+         scheduler.Tick(level, 10.5, 10.5);
+         Assert::AreEqual(32u, numEvaluations[nearPos], L"removed critter must not be evaluated");
+         Assert::AreEqual(0u, scheduler.GetStats().m_numCritters[critterDetailNear]);
+      }
+
+      /// Tests that due critters are deferred when the time budget is used
+      /// up, and that all deferred critters get evaluated eventually.
+      TEST_METHOD(TestTimeBudget)
+      {
+         // set up
+         Level level;
+         CreateLevel(level);
+
+         for (unsigned int xpos = 10; xpos < 15; xpos++)
+            AddCritter(level, xpos, 12);
+
+         std::map<Uint16, unsigned int> numEvaluations;
+
+         CritterScheduler scheduler;
+         scheduler.Init([&](Uint16 objectPos) { numEvaluations[objectPos]++; });
+         scheduler.SetTimeBudget(0.0);
+
+         // run + check
+         scheduler.Tick(level, 10.5, 10.5);
+
+         Assert::AreEqual(1u, scheduler.GetStats().m_numEvaluated[critterDetailNear],
+            L"at least one critter must be evaluated");
+         Assert::AreEqual(4u, scheduler.GetStats().m_numDeferred);
+
+         for (unsigned int tick = 1; tick < 5; tick++)
+            scheduler.Tick(level, 10.5, 10.5);
+
+         Assert::AreEqual<size_t>(5, numEvaluations.size(), L"all critters must be evaluated");
+         for (const auto& evaluations : numEvaluations)
+            Assert::AreEqual(1u, evaluations.second, L"deferred critters must be evaluated first");
+      }
+
+      /// Measures tick times with many critters that take some time to
+      /// evaluate, compared to evaluating all critters in every tick.
+      TEST_METHOD(TestProfilingCritterScheduler)
+      {
+         Level level;
+         CreateLevel(level);
+
+         std::mt19937 random{ 42 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 1, 62 };
+
+         const unsigned int numCritters = 250;
+         for (unsigned int index = 0; index < numCritters; index++)
+            AddCritter(level, tilePos(random), tilePos(random));
+
+         // simulates the cost of an AI script call
+         const Uint64 evaluationCounts = SDL_GetPerformanceFrequency() / 50000;
+         auto evaluateCritter = [=](Uint16)
+         {
+            Uint64 start = SDL_GetPerformanceCounter();
+            while (SDL_GetPerformanceCounter() - start < evaluationCounts)
+               ;
+         };
+
+         CritterScheduler scheduler;
+         scheduler.Init(evaluateCritter);
+
+         const unsigned int max = 100;
+         double maxTickTime = 0.0, totalTickTime = 0.0;
+         unsigned int numEvaluated = 0, numDeferred = 0;
+
+         for (unsigned int tick = 0; tick < max; tick++)
+         {
+            // player walking through the level
+            double playerPos = 1.0 + 60.0 * tick / max;
+
+            Uint64 begin = SDL_GetPerformanceCounter();
+            scheduler.Tick(level, playerPos, playerPos);
+            Uint64 end = SDL_GetPerformanceCounter();
+
+            double tickTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+            maxTickTime = std::max(maxTickTime, tickTime);
+            totalTickTime += tickTime;
+
+            const CritterSchedulerStats& stats = scheduler.GetStats();
+            for (unsigned int detailLevel = 0; detailLevel < critterDetailMax; detailLevel++)
+               numEvaluated += stats.m_numEvaluated[detailLevel];
+            numDeferred += stats.m_numDeferred;
+         }
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+         for (Uint16 objectPos = 0; objectPos < numCritters; objectPos++)
+            evaluateCritter(objectPos);
+         Uint64 end = SDL_GetPerformanceCounter();
+
+         double allCrittersTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         UaTrace("%u critters: scheduled tick avg %1.3f ms, max %1.3f ms, %u evaluations and %u deferred per tick; "
+            "evaluating all critters: %1.3f ms\n",
+            numCritters, totalTickTime / max, maxTickTime, numEvaluated / max, numDeferred / max, allCrittersTime);
+      }
+   };
+} // namespace UnitTest
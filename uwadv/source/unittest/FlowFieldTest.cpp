@@ -0,0 +1,210 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FlowFieldTest.cpp
+/// \brief tests for the FlowField class
+//
+#include "pch.hpp"
+#include "FlowField.hpp"
+#include "Pathfinder.hpp"
+#include "Level.hpp"
+#include "TestLevels.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Physics;
+
+namespace UnitTest
+{
+   /// \brief FlowField tests
+   /// Tests that following the flow field leads to the target on shortest paths.
+   TEST_CLASS(FlowFieldTest)
+   {
+      /// follows the flow field from given tile and checks that it reaches
+      /// the target with the distance stored in the field
+      static void CheckFollowField(FlowField& flowField, const NavigationGrid& grid,
+         unsigned int xpos, unsigned int ypos, unsigned int flagMask)
+      {
+         Uint16 distance = flowField.GetDistance(xpos, ypos, flagMask);
+         unsigned int travelled = 0;
+
+         for (;;)
+         {
+            NavigationDirection dir = flowField.GetDirection(xpos, ypos, flagMask);
+            if (dir == navigationDirectionMax)
+               break;
+
+            Assert::IsTrue(grid.CanPass(xpos, ypos, dir, flagMask), L"direction must be passable");
+
+            xpos += NavigationGrid::GetDirectionX(dir);
+            ypos += NavigationGrid::GetDirectionY(dir);
+            travelled += NavigationGrid::GetMoveCost(dir);
+
+            Assert::IsTrue(travelled <= distance, L"path must not be longer than distance");
+         }
+
+         Assert::AreEqual<unsigned int>(distance, travelled, L"path must have stored distance");
+         Assert::AreEqual<unsigned int>(0, flowField.GetDistance(xpos, ypos, flagMask),
+            L"path must end at target");
+      }
+
+      /// Tests that the flow field leads to the target on the same distance
+      /// that the A* pathfinder finds, for walking and swimming.
+      TEST_METHOD(TestFlowFieldMatchesPathfinder)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRandomLevel(level, 42, 25, 10);
+         level.GetTilemap().GetTileInfo(32, 32).m_type = Underworld::tileOpen;
+         level.GetTilemap().GetTileInfo(32, 32).m_textureFloor = Base::c_stockTexturesFloor;
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         FlowField flowField{ grid };
+         flowField.SetTarget(32, 32);
+
+         PathfinderAStar pathfinder{ grid };
+         PathList pathList;
+
+         const unsigned int flagMasks[] = { 0, 1 << pathfindFlagCanSwim };
+
+         for (unsigned int flagMask : flagMasks)
+         {
+            pathfinder.SetFlag(pathfindFlagCanSwim, flagMask != 0);
+
+            // run + check
+            for (unsigned int ypos = 1; ypos < 63; ypos++)
+               for (unsigned int xpos = 1; xpos < 63; xpos++)
+               {
+                  if (!grid.IsAccessible(xpos, ypos, flagMask))
+                     continue;
+
+                  bool found = pathfinder.FindPath(xpos, ypos, 32, 32, pathList);
+                  Uint16 distance = flowField.GetDistance(xpos, ypos, flagMask);
+
+                  Assert::AreEqual(found, distance != FlowField::c_unreachable,
+                     L"reachability must match pathfinder");
+
+                  if (!found)
+                     continue;
+
+                  // sum up cost of pathfinder path
+                  unsigned int pathCost = 0, lastx = xpos, lasty = ypos;
+                  for (const auto& step : pathList)
+                  {
+                     pathCost += (step.first != lastx && step.second != lasty)
+                        ? NavigationGrid::GetMoveCost(navigationNorthEast)
+                        : NavigationGrid::GetMoveCost(navigationNorth);
+                     lastx = step.first;
+                     lasty = step.second;
+                  }
+
+                  Assert::AreEqual<unsigned int>(pathCost, distance, L"distance must match pathfinder path");
+
+                  CheckFollowField(flowField, grid, xpos, ypos, flagMask);
+               }
+         }
+      }
+
+      /// Tests that fields are only computed when read after the target changed.
+      TEST_METHOD(TestLazyUpdate)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRandomLevel(level, 7, 0, 0);
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         FlowField flowField{ grid };
+
+         // run + check
+         Assert::AreEqual<unsigned int>(FlowField::c_unreachable, flowField.GetDistance(10, 10, 0),
+            L"tiles must be unreachable without target");
+
+         flowField.SetTarget(20, 20);
+         Assert::AreEqual<unsigned int>(100, flowField.GetDistance(10, 20, 0));
+         Assert::AreEqual<unsigned int>(140, flowField.GetDistance(10, 10, 0));
+         Assert::AreEqual<int>(navigationNorthEast, flowField.GetDirection(10, 10, 0));
+
+         unsigned int numUpdates = flowField.GetNumFieldUpdates();
+
+         flowField.SetTarget(20, 20);
+         flowField.GetDistance(10, 10, 0);
+         Assert::AreEqual(numUpdates, flowField.GetNumFieldUpdates(), L"same target must not update field");
+
+         flowField.SetTarget(21, 20);
+         Assert::AreEqual(numUpdates, flowField.GetNumFieldUpdates(), L"field must be updated when read");
+
+         flowField.GetDistance(10, 10, 0);
+         flowField.GetDistance(10, 10, 0);
+         Assert::AreEqual(numUpdates + 1, flowField.GetNumFieldUpdates(), L"field must be updated once");
+
+         flowField.ClearTarget();
+         Assert::AreEqual<unsigned int>(FlowField::c_unreachable, flowField.GetDistance(10, 10, 0));
+      }
+
+      /// Measures updating a field after the target moved, and reading the
+      /// field for many critters.
+      TEST_METHOD(TestProfilingFlowField)
+      {
+         Underworld::Level level;
+         CreateRandomLevel(level, 42, 25, 10);
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         FlowField flowField{ grid };
+
+         std::mt19937 random{ 1 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 1, 62 };
+
+         const int max = 100;
+         const unsigned int numCritters = 400;
+
+         Uint64 updateTicks = 0, readTicks = 0;
+         unsigned int numMoving = 0;
+
+         for (int i = 0; i < max; i++)
+         {
+            flowField.SetTarget(tilePos(random), tilePos(random));
+
+            Uint64 begin = SDL_GetPerformanceCounter();
+            flowField.GetDistance(0, 0, 0);
+            Uint64 end = SDL_GetPerformanceCounter();
+
+            updateTicks += end - begin;
+
+            begin = SDL_GetPerformanceCounter();
+
+            for (unsigned int critter = 0; critter < numCritters; critter++)
+               if (flowField.GetDirection(tilePos(random), tilePos(random), 0) != navigationDirectionMax)
+                  numMoving++;
+
+            end = SDL_GetPerformanceCounter();
+            readTicks += end - begin;
+         }
+
+         double updateTime = double(updateTicks) * 1000000.0 / SDL_GetPerformanceFrequency() / max;
+         double readTime = double(readTicks) * 1000000.0 / SDL_GetPerformanceFrequency() / max;
+
+         UaTrace("flow field update: %1.3f us, reading %u critter directions: %1.3f us, %u moving\n",
+            updateTime, numCritters, readTime, numMoving / max);
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,212 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameProfilerTest.cpp
+/// \brief tests for the FrameProfiler class
+//
+#include "pch.hpp"
+#include "FrameProfiler.hpp"
+#include "TextFile.hpp"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief FrameProfiler tests
+   /// Tests recording frames and phase spans with Base::FrameProfiler.
+   TEST_CLASS(FrameProfilerTest)
+   {
+      /// Tests that spans are recorded into the current frame and phase
+      /// counts are summed up
+      TEST_METHOD(TestRecordSpans)
+      {
+         // set up
+         Base::FrameProfiler profiler;
+
+         // run
+         Assert::IsFalse(profiler.IsRecording(), L"must not record before first frame");
+
+         profiler.BeginFrame();
+         Assert::IsTrue(profiler.IsRecording(), L"must record after starting frame");
+
+         profiler.AddSpan(Base::framePhaseTick, 100, 150);
+         profiler.AddSpan(Base::framePhasePhysics, 110, 120);
+         profiler.AddSpan(Base::framePhaseTick, 200, 230);
+         profiler.EndFrame();
+
+         Assert::IsFalse(profiler.IsRecording(), L"must not record after ending frame");
+
+         // check
+         std::vector<Base::FrameProfiler::FrameRecord> frames;
+         profiler.GetRecentFrames(frames);
+
+         Assert::AreEqual<size_t>(1, frames.size(), L"one frame must have been recorded");
+         Assert::AreEqual<Uint64>(80, frames[0].m_phaseCounts[Base::framePhaseTick]);
+         Assert::AreEqual<Uint64>(10, frames[0].m_phaseCounts[Base::framePhasePhysics]);
+         Assert::AreEqual<Uint64>(0, frames[0].m_phaseCounts[Base::framePhaseRender]);
+         Assert::AreEqual(3u, frames[0].m_numSpans);
+         Assert::IsTrue(frames[0].m_spans[1].m_phase == Base::framePhasePhysics);
+      }
+
+      /// Tests that the ring buffer only keeps the most recent frames, and
+      /// that frames that weren't ended are discarded
+      TEST_METHOD(TestRingBuffer)
+      {
+         // set up
+         Base::FrameProfiler profiler;
+
+         // run
+         unsigned int numFrames = Base::FrameProfiler::c_numFrames + 10;
+         for (unsigned int frameIndex = 0; frameIndex < numFrames; frameIndex++)
+         {
+            profiler.BeginFrame();
+            profiler.EndFrame();
+         }
+
+         // started again, but not ended
+         profiler.BeginFrame();
+         profiler.BeginFrame();
+         profiler.EndFrame();
+
+         // check
+         std::vector<Base::FrameProfiler::FrameRecord> frames;
+         profiler.GetRecentFrames(frames);
+
+         Assert::AreEqual<size_t>(Base::FrameProfiler::c_numFrames, frames.size());
+         Assert::AreEqual<Uint64>(11, frames.front().m_frameNumber, L"oldest frames must be overwritten");
+         Assert::AreEqual<Uint64>(numFrames, frames.back().m_frameNumber, L"discarded frame must be reused");
+
+         for (size_t index = 1; index < frames.size(); index++)
+            Assert::AreEqual(frames[index - 1].m_frameNumber + 1, frames[index].m_frameNumber);
+      }
+
+      /// Tests that a disabled profiler doesn't record frames or scopes
+      TEST_METHOD(TestDisabled)
+      {
+         // set up
+         Base::FrameProfiler profiler;
+         profiler.SetEnabled(false);
+
+         // run
+         profiler.BeginFrame();
+         bool isRecording = profiler.IsRecording();
+         profiler.EndFrame();
+
+         // check
+         Assert::IsFalse(isRecording, L"disabled profiler must not record");
+
+         std::vector<Base::FrameProfiler::FrameRecord> frames;
+         profiler.GetRecentFrames(frames);
+         Assert::IsTrue(frames.empty(), L"no frames must have been recorded");
+
+         Base::FrameTimeStatistics statistics = profiler.CalcStatistics();
+         Assert::AreEqual(0u, statistics.m_numFrames);
+      }
+
+      /// Tests that profile scopes are only recorded on the thread recording
+      /// the frame of the global profiler instance
+      TEST_METHOD(TestProfileScope)
+      {
+         // set up
+         Base::FrameProfiler& profiler = Base::FrameProfiler::GetInstance();
+
+         // run
+         {
+            Base::ProfileScope scopeOutsideFrame{ Base::framePhaseEvents };
+         }
+
+         profiler.BeginFrame();
+         {
+            Base::ProfileScope scope{ Base::framePhaseRender };
+            SDL_Delay(2);
+         }
+
+         std::thread otherThread([]()
+            {
+               Base::ProfileScope scopeOnOtherThread{ Base::framePhaseScripting };
+            });
+         otherThread.join();
+
+         profiler.EndFrame();
+
+         // check
+         std::vector<Base::FrameProfiler::FrameRecord> frames;
+         profiler.GetRecentFrames(frames);
+
+         Assert::IsFalse(frames.empty(), L"frame must have been recorded");
+
+         const Base::FrameProfiler::FrameRecord& frame = frames.back();
+         Assert::AreEqual(1u, frame.m_numSpans, L"only the scope in the frame must be recorded");
+         Assert::IsTrue(frame.m_spans[0].m_phase == Base::framePhaseRender);
+         Assert::IsTrue(frame.m_phaseCounts[Base::framePhaseRender] > 0);
+         Assert::IsTrue(frame.m_endCounter - frame.m_startCounter >= frame.m_phaseCounts[Base::framePhaseRender]);
+      }
+
+      /// Tests frame time percentiles and writing CSV and Chrome trace files
+      TEST_METHOD(TestStatisticsAndWriteFiles)
+      {
+         // set up
+         TempFolder testFolder;
+         Base::FrameProfiler profiler;
+
+         for (unsigned int frameIndex = 0; frameIndex < 100; frameIndex++)
+         {
+            profiler.BeginFrame();
+            profiler.AddSpan(Base::framePhaseTick, 0, 1);
+            profiler.EndFrame();
+         }
+
+         // run
+         Base::FrameTimeStatistics statistics = profiler.CalcStatistics();
+
+         std::string csvFilename = testFolder.GetPathName() + "/frames.csv";
+         std::string traceFilename = testFolder.GetPathName() + "/frames.json";
+
+         bool csvWritten = profiler.WriteCsv(csvFilename);
+         bool traceWritten = profiler.WriteChromeTrace(traceFilename);
+
+         // check
+         Assert::AreEqual(100u, statistics.m_numFrames);
+         Assert::IsTrue(statistics.m_percentile50 <= statistics.m_percentile90);
+         Assert::IsTrue(statistics.m_percentile90 <= statistics.m_percentile99);
+         Assert::IsTrue(statistics.m_percentile99 <= statistics.m_maxTime);
+
+         Assert::IsTrue(csvWritten, L"CSV file must have been written");
+         Assert::IsTrue(traceWritten, L"trace file must have been written");
+
+         Base::TextFile csvFile{ csvFilename, Base::modeRead };
+         std::string line;
+         csvFile.ReadLine(line);
+         Assert::IsTrue(line.find("frame,start_ms,frame_ms,tick_ms") == 0, L"CSV header must be written");
+
+         unsigned int numLines = 0;
+         while (csvFile.Tell() < csvFile.FileLength())
+         {
+            csvFile.ReadLine(line);
+            numLines++;
+         }
+
+         Assert::AreEqual(100u, numLines, L"CSV file must contain a line for each frame");
+
+         Base::TextFile traceFile{ traceFilename, Base::modeRead };
+         traceFile.ReadLine(line);
+         Assert::IsTrue(line.find("traceEvents") != std::string::npos, L"trace file must contain trace events");
+      }
+   };
+} // namespace UnitTest
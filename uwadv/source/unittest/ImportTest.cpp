@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019 Underworld Adventures Team
+// Copyright (c) 2006,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -30,14 +30,36 @@
 #include "Properties.hpp"
 #include "LevelList.hpp"
 #include "Player.hpp"
+#include "ImageManager.hpp"
+#include "TextureLoader.hpp"
+#include "CrittersLoader.hpp"
+#include "Critter.hpp"
+#include "Model3D.hpp"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
+bool DecodeBuiltInModels(const char* filename,
+   std::vector<Model3DPtr>& allModels, bool dump, bool isUw2);
+
 namespace UnitTest
 {
    /// Tests importing all kinds of original game data files.
    TEST_CLASS(ImportTest)
    {
+      /// appends 16-bit value to file data
+      static void Append16(std::vector<Uint8>& data, Uint16 value)
+      {
+         data.push_back(static_cast<Uint8>(value & 0xff));
+         data.push_back(static_cast<Uint8>(value >> 8));
+      }
+
+      /// appends 32-bit value to file data
+      static void Append32(std::vector<Uint8>& data, Uint32 value)
+      {
+         Append16(data, static_cast<Uint16>(value & 0xffff));
+         Append16(data, static_cast<Uint16>(value >> 16));
+      }
+
       /// Tests importing object properties, uw1
       TEST_METHOD(TestObjectPropertiesImportUw1)
       {
@@ -147,6 +169,150 @@ namespace UnitTest
          UaAssert(levelList.GetNumLevels() == 80);
       }
 
+      /// Measures setting up the uw2 level list, where levels are loaded when
+      /// first accessed, and loading all levels
+      TEST_METHOD(TestProfilingLevelListImportUw2)
+      {
+         Base::Settings& settings = GetTestSettings();
+
+         settings.SetValue(Base::settingGamePrefix, std::string("uw2"));
+         settings.SetValue(Base::settingUnderworldPath, settings.GetString(Base::settingUw2Path));
+
+         Base::ResourceManager resourceManager{ settings };
+         Import::LevelImporter levelImporter(resourceManager);
+
+         Underworld::LevelList levelList;
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+         levelImporter.LoadUw2Levels(levelList);
+         Uint64 end = SDL_GetPerformanceCounter();
+
+         double setupTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         levelList.SetMaxLoadedLevels(levelList.GetNumLevels());
+         const Underworld::LevelList& constLevelList = levelList;
+
+         begin = SDL_GetPerformanceCounter();
+         for (size_t levelIndex = 0; levelIndex < constLevelList.GetNumLevels(); levelIndex++)
+            constLevelList.GetLevel(levelIndex);
+         end = SDL_GetPerformanceCounter();
+
+         double loadTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         UaTrace("setting up uw2 level list: %1.3f ms, loading all %zu levels: %1.3f ms\n",
+            setupTime, levelList.GetNumLoadedLevels(), loadTime);
+      }
+
+      /// Measures importing all game data of uw1, as done when starting a game
+      TEST_METHOD(TestProfilingImportGameUw1)
+      {
+         ProfileImportGame(false);
+      }
+
+      /// Measures importing all game data of uw2, as done when starting a game
+      TEST_METHOD(TestProfilingImportGameUw2)
+      {
+         ProfileImportGame(true);
+      }
+
+      /// Imports all game data with all loaders and traces the time each loader takes
+      static void ProfileImportGame(bool isUw2)
+      {
+         Base::Settings& settings = GetTestSettings();
+
+         std::string underworldPath = settings.GetString(isUw2 ? Base::settingUw2Path : Base::settingUw1Path);
+         settings.SetValue(Base::settingGamePrefix, std::string(isUw2 ? "uw2" : "uw1"));
+         settings.SetValue(Base::settingUnderworldPath, underworldPath);
+         settings.SetGameType(isUw2 ? Base::gameUw2 : Base::gameUw1);
+
+         Base::ResourceManager resourceManager{ settings };
+
+         double totalTime = 0.0;
+         auto measure = [&totalTime](const char* name, std::function<void()> func)
+         {
+            Uint64 begin = SDL_GetPerformanceCounter();
+            func();
+            Uint64 end = SDL_GetPerformanceCounter();
+
+            double time = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+            totalTime += time;
+
+            UaTrace("importing %s: %1.3f ms\n", name, time);
+         };
+
+         GameStrings gameStrings;
+         measure("game strings", [&]()
+            {
+               Import::GameStringsImporter importer{ gameStrings };
+               importer.LoadDefaultStringsPakFile(resourceManager);
+            });
+
+         measure("object properties", [&]()
+            {
+               Underworld::ObjectProperties objectProperties;
+               Import::ImportProperties(resourceManager, objectProperties);
+            });
+
+         measure("all levels", [&]()
+            {
+               Import::LevelImporter levelImporter{ resourceManager };
+
+               Underworld::LevelList levelList;
+               levelImporter.LoadLevels(settings, levelList);
+
+               levelList.SetMaxLoadedLevels(levelList.GetNumLevels());
+               const Underworld::LevelList& constLevelList = levelList;
+
+               for (size_t levelIndex = 0; levelIndex < constLevelList.GetNumLevels(); levelIndex++)
+                  constLevelList.GetLevel(levelIndex);
+            });
+
+         ImageManager imageManager{ resourceManager };
+         measure("images", [&]()
+            {
+               imageManager.Init();
+
+               std::vector<IndexedImage> imageList;
+               imageManager.LoadList(imageList, "objects");
+               imageManager.LoadList(imageList, "tmflat");
+               imageManager.LoadList(imageList, "doors");
+               imageManager.LoadList(imageList, "tmobj");
+            });
+
+         measure("textures", [&]()
+            {
+               Import::TextureLoader textureLoader{ resourceManager };
+
+               std::vector<IndexedImage> textureImages;
+               if (isUw2)
+               {
+                  textureLoader.LoadTextures(textureImages, 0, "data/t64.tr", imageManager.GetPalette(0));
+               }
+               else
+               {
+                  textureLoader.LoadTextures(textureImages, 0, "data/w64.tr", imageManager.GetPalette(0));
+                  textureLoader.LoadTextures(textureImages, textureImages.size(), "data/f32.tr", imageManager.GetPalette(0));
+               }
+            });
+
+         measure("critters", [&]()
+            {
+               Import::CrittersLoader crittersLoader{ settings, resourceManager };
+
+               std::vector<Critter> allCritters;
+               crittersLoader.LoadCritters(allCritters, imageManager.GetPalette(0));
+            });
+
+         measure("builtin models", [&]()
+            {
+               std::vector<Model3DPtr> allModels;
+               DecodeBuiltInModels((underworldPath + (isUw2 ? "uw2.exe" : "uw.exe")).c_str(),
+                  allModels, false, isUw2);
+            });
+
+         UaTrace("importing all %s game data: %1.3f ms\n", isUw2 ? "uw2" : "uw1", totalTime);
+      }
+
       /// Tests loading player infos, uw1
       TEST_METHOD(TestPlayerImportUw1)
       {
@@ -191,5 +357,151 @@ namespace UnitTest
          Assert::IsTrue(gs.IsBlockAvail(0x0e01));
          Assert::IsTrue(!gs.GetString(0x0001, 0).empty());
       }
+
+      /// Tests decoding strings with codes longer than the decoder's lookup table
+      TEST_METHOD(TestGameStringsHuffmanDecoding)
+      {
+         // set up a degenerate huffman tree, with codes up to 13 bits long;
+         // the first node is the deepest one and contains the end marker
+         const std::string symbols = "|abcdefghijklm";
+         const Uint8 numLeafNodes = static_cast<Uint8>(symbols.size());
+         const Uint8 numNodes = numLeafNodes * 2 - 1;
+
+         std::vector<Uint8> nodeData(numNodes * 4, 0xff);
+         for (Uint8 nodeIndex = 0; nodeIndex < numLeafNodes; nodeIndex++)
+            nodeData[nodeIndex * 4] = static_cast<Uint8>(symbols[nodeIndex]);
+
+         for (Uint8 nodeIndex = numLeafNodes; nodeIndex < numNodes; nodeIndex++)
+         {
+            Uint8 leftNode = nodeIndex == numLeafNodes ? 0 : nodeIndex - 1;
+            Uint8 rightNode = nodeIndex - numLeafNodes + 1;
+
+            nodeData[nodeIndex * 4 + 0] = 0;
+            nodeData[nodeIndex * 4 + 2] = leftNode;
+            nodeData[nodeIndex * 4 + 3] = rightNode;
+            nodeData[leftNode * 4 + 1] = nodeIndex;
+            nodeData[rightNode * 4 + 1] = nodeIndex;
+         }
+
+         // encodes string, including the end marker
+         auto encodeString = [&](const std::string& text)
+         {
+            std::vector<Uint8> encoded;
+            unsigned int numBits = 0;
+
+            for (char symbol : text + "|")
+            {
+               // collect bits from leaf to root
+               std::vector<unsigned int> bits;
+               size_t nodeIndex = symbols.find(symbol);
+               while (nodeIndex != numNodes - 1)
+               {
+                  Uint8 parentIndex = nodeData[nodeIndex * 4 + 1];
+                  bits.push_back(nodeData[parentIndex * 4 + 3] == nodeIndex ? 1 : 0);
+                  nodeIndex = parentIndex;
+               }
+
+               for (auto iter = bits.rbegin(); iter != bits.rend(); iter++, numBits++)
+               {
+                  if ((numBits & 7) == 0)
+                     encoded.push_back(0);
+
+                  encoded.back() |= static_cast<Uint8>(*iter << (7 - (numBits & 7)));
+               }
+            }
+
+            return encoded;
+         };
+
+         std::vector<std::vector<std::string>> allBlocks{
+            { "abc", "", "blade", "m" },
+            { "jam" },
+         };
+
+         std::vector<Uint8> data;
+         Append16(data, numNodes);
+         data.insert(data.end(), nodeData.begin(), nodeData.end());
+
+         Append16(data, static_cast<Uint16>(allBlocks.size()));
+         size_t blockOffsetsPos = data.size();
+         data.resize(data.size() + allBlocks.size() * 6);
+
+         for (size_t blockIndex = 0; blockIndex < allBlocks.size(); blockIndex++)
+         {
+            std::vector<Uint8> blockOffset;
+            Append16(blockOffset, static_cast<Uint16>(0x0100 + blockIndex));
+            Append32(blockOffset, static_cast<Uint32>(data.size()));
+            std::copy(blockOffset.begin(), blockOffset.end(), data.begin() + blockOffsetsPos + blockIndex * 6);
+
+            const std::vector<std::string>& stringList = allBlocks[blockIndex];
+            Append16(data, static_cast<Uint16>(stringList.size()));
+
+            std::vector<Uint8> stringData;
+            for (const std::string& text : stringList)
+            {
+               Append16(data, static_cast<Uint16>(stringData.size()));
+
+               std::vector<Uint8> encoded = encodeString(text);
+               stringData.insert(stringData.end(), encoded.begin(), encoded.end());
+            }
+
+            data.insert(data.end(), stringData.begin(), stringData.end());
+         }
+
+         GameStrings gs;
+         Import::GameStringsImporter importer{ gs };
+         importer.LoadStringsPakFile(
+            Base::MakeRWopsPtr(SDL_RWFromConstMem(data.data(), static_cast<int>(data.size()))));
+
+         Assert::AreEqual<size_t>(2, gs.GetStringBlockSet().size());
+         Assert::IsTrue(gs.IsBlockAvail(0x0100));
+         Assert::IsFalse(gs.IsBlockAvail(0x0102));
+
+         for (size_t blockIndex = 0; blockIndex < allBlocks.size(); blockIndex++)
+         {
+            const std::vector<std::string>& stringList = allBlocks[blockIndex];
+            const std::vector<std::string_view>& stringBlock =
+               gs.GetStringBlock(static_cast<Uint16>(0x0100 + blockIndex));
+
+            Assert::AreEqual(stringList.size(), stringBlock.size());
+            for (size_t stringIndex = 0; stringIndex < stringList.size(); stringIndex++)
+               Assert::AreEqual(stringList[stringIndex], std::string{ stringBlock[stringIndex] });
+         }
+
+         Assert::AreEqual(std::string("blade"), gs.GetString(0x0100, 2));
+         Assert::IsTrue(gs.GetString(0x0101, 1).empty());
+      }
+
+      /// Measures loading the strings.pak file and decoding all string blocks, uw2
+      TEST_METHOD(TestProfilingGameStringsLoaderUw2)
+      {
+         Base::Settings& settings = GetTestSettings();
+
+         settings.SetValue(Base::settingGamePrefix, std::string("uw2"));
+         settings.SetValue(Base::settingUnderworldPath, settings.GetString(Base::settingUw2Path));
+
+         Base::ResourceManager resourceManager{ settings };
+
+         GameStrings gs;
+
+         Uint64 start = SDL_GetPerformanceCounter();
+
+         Import::GameStringsImporter importer{ gs };
+         importer.LoadDefaultStringsPakFile(resourceManager);
+
+         Uint64 loaded = SDL_GetPerformanceCounter();
+
+         size_t numStrings = 0;
+         for (Uint16 blockId : gs.GetStringBlockSet())
+            numStrings += gs.GetStringBlock(blockId).size();
+
+         Uint64 end = SDL_GetPerformanceCounter();
+
+         double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+         UaTrace("loading strings.pak: %1.3f ms, decoding %zu strings in %zu blocks: %1.3f ms\n",
+            double(loaded - start) * 1000.0 / frequency,
+            numStrings, gs.GetStringBlockSet().size(),
+            double(end - loaded) * 1000.0 / frequency);
+      }
    };
 } // namespace UnitTest
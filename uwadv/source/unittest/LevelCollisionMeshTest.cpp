@@ -0,0 +1,151 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file LevelCollisionMeshTest.cpp
+/// \brief tests for the LevelCollisionMesh class
+//
+#include "pch.hpp"
+#include "LevelCollisionMesh.hpp"
+#include "GeometryProvider.hpp"
+#include "Level.hpp"
+#include "TestLevels.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Physics;
+
+namespace UnitTest
+{
+   /// \brief LevelCollisionMesh tests
+   /// Tests building and updating the collision mesh of a level
+   TEST_CLASS(LevelCollisionMeshTest)
+   {
+      /// checks that the mesh contains the same triangles for every tile as
+      /// generated by the geometry provider
+      static void CheckMeshMatchesProvider(const LevelCollisionMesh& mesh,
+         const Underworld::Level& level)
+      {
+         GeometryProvider provider{ level };
+
+         for (unsigned int ypos = 0; ypos < Underworld::c_underworldTilemapSize; ypos++)
+            for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
+            {
+               std::vector<Triangle3dTextured> allTriangles;
+               provider.GetTileTriangles(xpos, ypos, allTriangles);
+
+               CollisionTriangleRange range = mesh.GetTileTriangles(xpos, ypos);
+
+               Assert::AreEqual<size_t>(allTriangles.size(), range.m_end - range.m_begin,
+                  L"number of tile triangles must match");
+
+               for (size_t index = 0; index < allTriangles.size(); index++)
+                  for (unsigned int point = 0; point < 3; point++)
+                  {
+                     Vector3d delta = allTriangles[index].m_vertices[point].pos -
+                        range.m_begin[index].m_points[point];
+
+                     Assert::AreEqual(0.0, delta.Length(), 1e-6, L"triangle points must be equal");
+                  }
+            }
+      }
+
+      /// Tests building the mesh for a level.
+      TEST_METHOD(TestBuild)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 15, 15);
+
+         // run
+         LevelCollisionMesh mesh;
+         mesh.Build(level);
+
+         // check
+         Assert::IsTrue(mesh.IsBuilt(), L"mesh must be built");
+         Assert::IsFalse(mesh.HasInvalidatedTiles(), L"mesh must not have invalidated tiles");
+         Assert::IsTrue(mesh.GetTileTriangles(0, 0).IsEmpty(), L"solid tile must not have triangles");
+         Assert::IsFalse(mesh.GetTileTriangles(12, 12).IsEmpty(), L"open tile must have triangles");
+         Assert::IsTrue(mesh.GetTileTriangles(64, 12).IsEmpty(), L"tile outside map must not have triangles");
+
+         CheckMeshMatchesProvider(mesh, level);
+      }
+
+      /// Tests updating invalidated tiles after tiles were modified.
+      TEST_METHOD(TestUpdateInvalidatedTiles)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 15, 15);
+
+         LevelCollisionMesh mesh;
+         mesh.Build(level);
+
+         // run
+         Underworld::Tilemap& tilemap = level.GetTilemap();
+
+         // raising the floor adds walls to the adjacent tiles
+         tilemap.GetTileInfo(12, 12).m_floor = 64;
+         mesh.InvalidateTile(12, 12);
+
+         // opening a solid tile adds triangles
+         tilemap.GetTileInfo(16, 12).m_type = Underworld::tileOpen;
+         tilemap.GetTileInfo(16, 12).m_ceiling = 128;
+         mesh.InvalidateTile(16, 12);
+
+         // closing a tile removes triangles
+         tilemap.GetTileInfo(10, 10).m_type = Underworld::tileSolid;
+         mesh.InvalidateTile(10, 10);
+
+         Assert::IsTrue(mesh.HasInvalidatedTiles(), L"mesh must have invalidated tiles");
+
+         mesh.UpdateInvalidatedTiles();
+
+         // check
+         Assert::IsFalse(mesh.HasInvalidatedTiles(), L"mesh must not have invalidated tiles");
+         CheckMeshMatchesProvider(mesh, level);
+      }
+
+      /// Tests repeatedly modifying tiles, which compacts the mesh.
+      TEST_METHOD(TestRepeatedUpdates)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 20, 20);
+
+         LevelCollisionMesh mesh;
+         mesh.Build(level);
+
+         Underworld::Tilemap& tilemap = level.GetTilemap();
+
+         // run
+         for (unsigned int iteration = 0; iteration < 20; iteration++)
+         {
+            for (unsigned int xpos = 11; xpos < 20; xpos += 2)
+            {
+               tilemap.GetTileInfo(xpos, 15).m_type =
+                  (iteration % 2) == 0 ? Underworld::tileSolid : Underworld::tileOpen;
+               mesh.InvalidateTile(xpos, 15);
+            }
+
+            mesh.UpdateInvalidatedTiles();
+
+            // check
+            CheckMeshMatchesProvider(mesh, level);
+         }
+      }
+   };
+} // namespace UnitTest
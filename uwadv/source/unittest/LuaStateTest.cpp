@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2019 Underworld Adventures Team
+// Copyright (c) 2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -76,6 +76,24 @@ namespace UnitTest
          state.CheckedCall(1, 0);
       }
 
+      /// Tests that a failed CheckedCall() leaves the Lua stack balanced
+      TEST_METHOD(TestCheckedCallErrorKeepsStack)
+      {
+         LuaState state;
+         lua_State* L = state.GetLuaState();
+
+         int top = lua_gettop(L);
+
+         // run
+         lua_getglobal(L, "undefinedFunction");
+         lua_pushinteger(L, 42);
+         bool result = state.CheckedCall(1, 0);
+
+         // check
+         Assert::IsFalse(result);
+         Assert::AreEqual(top, lua_gettop(L));
+      }
+
       /// Tests checking Lua syntax using CheckSyntax(); empty
       TEST_METHOD(TestCheckSyntaxEmptyCode)
       {
@@ -0,0 +1,602 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PathfinderTest.cpp
+/// \brief tests for the NavigationGrid, SectorGraph and pathfinder classes
+//
+#include "pch.hpp"
+#include "NavigationGrid.hpp"
+#include "Pathfinder.hpp"
+#include "Level.hpp"
+#include "LevelList.hpp"
+#include "Settings.hpp"
+#include "ResourceManager.hpp"
+#include "LevelImporter.hpp"
+#include "TestLevels.hpp"
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Physics;
+
+namespace UnitTest
+{
+   /// \brief Pathfinder tests
+   /// Tests building the navigation grid and the sector graph, and finding
+   /// paths with the A* and the hierarchical pathfinder.
+   TEST_CLASS(PathfinderTest)
+   {
+      /// sets a single open tile with given floor height
+      static void SetOpenTile(Underworld::Level& level, unsigned int xpos, unsigned int ypos,
+         Uint16 floor)
+      {
+         Underworld::TileInfo& tileInfo = level.GetTilemap().GetTileInfo(xpos, ypos);
+         tileInfo.m_type = Underworld::tileOpen;
+         tileInfo.m_floor = floor;
+         tileInfo.m_ceiling = 128;
+      }
+
+      /// checks that every step of the path is a move to an adjacent tile
+      /// that the grid allows
+      static void CheckPath(const NavigationGrid& grid, unsigned int flagMask,
+         unsigned int fromx, unsigned int fromy, const PathList& pathList)
+      {
+         unsigned int xpos = fromx, ypos = fromy;
+         for (const auto& step : pathList)
+         {
+            bool foundDirection = false;
+            for (unsigned int dir = navigationNorth; dir < navigationDirectionMax; dir++)
+            {
+               NavigationDirection direction = static_cast<NavigationDirection>(dir);
+               if (xpos + NavigationGrid::GetDirectionX(direction) == step.first &&
+                  ypos + NavigationGrid::GetDirectionY(direction) == step.second)
+               {
+                  Assert::IsTrue(grid.CanPass(xpos, ypos, direction, flagMask),
+                     L"path step must be passable");
+                  foundDirection = true;
+               }
+            }
+
+            Assert::IsTrue(foundDirection, L"path step must move to adjacent tile");
+
+            xpos = step.first;
+            ypos = step.second;
+         }
+      }
+
+      /// adds a door object to given tile
+      static Underworld::ObjectPtr AddDoor(Underworld::Level& level, unsigned int xpos, unsigned int ypos,
+         Uint16 itemID)
+      {
+         Underworld::ObjectList& objectList = level.GetObjectList();
+
+         Uint16 objectPos = objectList.Allocate();
+         Underworld::ObjectPtr door = objectList.CreateObject(objectPos, Underworld::objectNormal);
+         door->GetObjectInfo().m_itemID = itemID;
+
+         objectList.AddObjectToTileList(objectPos, static_cast<Uint8>(xpos), static_cast<Uint8>(ypos));
+
+         level.GetTilemap().GetTileInfo(xpos, ypos).m_isDoorPresent = true;
+
+         return door;
+      }
+
+      /// follows a path of the hierarchical pathfinder by searching again at
+      /// the end of the refined steps, and checks that the target is reached
+      /// \return cost of the complete path
+      static unsigned int FollowHierarchicalPath(PathfinderHierarchical& pathfinder,
+         const NavigationGrid& grid, unsigned int flagMask,
+         unsigned int fromx, unsigned int fromy, unsigned int tox, unsigned int toy)
+      {
+         PathList pathList;
+         unsigned int pathCost = 0, xpos = fromx, ypos = fromy;
+
+         while (xpos != tox || ypos != toy)
+         {
+            Assert::IsTrue(pathfinder.FindPath(xpos, ypos, tox, toy, pathList), L"path must be found");
+            Assert::IsTrue(pathfinder.GetNumRefinedSteps() > 0, L"path must start with refined steps");
+            Assert::IsTrue(pathList.back() == std::make_pair(tox, toy), L"path must end at target");
+
+            PathList refinedSteps{ pathList.begin(), pathList.begin() + pathfinder.GetNumRefinedSteps() };
+            CheckPath(grid, flagMask, xpos, ypos, refinedSteps);
+
+            for (const auto& step : refinedSteps)
+            {
+               pathCost += (step.first != xpos && step.second != ypos)
+                  ? NavigationGrid::GetMoveCost(navigationNorthEast)
+                  : NavigationGrid::GetMoveCost(navigationNorth);
+               xpos = step.first;
+               ypos = step.second;
+            }
+
+            Assert::IsTrue(pathCost < 64 * 64 * NavigationGrid::GetMoveCost(navigationNorth),
+               L"path must not run in circles");
+         }
+
+         return pathCost;
+      }
+
+      /// returns cost of a path found by the A* pathfinder
+      static unsigned int GetPathCost(unsigned int fromx, unsigned int fromy, const PathList& pathList)
+      {
+         unsigned int pathCost = 0, xpos = fromx, ypos = fromy;
+         for (const auto& step : pathList)
+         {
+            pathCost += (step.first != xpos && step.second != ypos)
+               ? NavigationGrid::GetMoveCost(navigationNorthEast)
+               : NavigationGrid::GetMoveCost(navigationNorth);
+            xpos = step.first;
+            ypos = step.second;
+         }
+
+         return pathCost;
+      }
+
+      /// Tests straight and diagonal moves in a room.
+      TEST_METHOD(TestNavigationGridRoom)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 15, 15);
+
+         // run
+         NavigationGrid grid;
+         grid.Build(level);
+
+         // check
+         Assert::IsTrue(grid.IsBuilt());
+         Assert::IsTrue(grid.CanPass(12, 12, navigationNorth, 0));
+         Assert::IsTrue(grid.CanPass(12, 12, navigationSouthWest, 0));
+         Assert::IsFalse(grid.CanPass(10, 12, navigationWest, 0), L"wall must block move");
+         Assert::IsFalse(grid.CanPass(10, 15, navigationNorthWest, 0), L"corner must block move");
+         Assert::AreEqual<int>(0, grid.GetPassableDirections(0, 0, 0), L"solid tile must not be passable");
+      }
+
+      /// Tests diagonal walls, floor heights and terrain types.
+      TEST_METHOD(TestNavigationGridTileProperties)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 15, 15);
+
+         // too high step
+         SetOpenTile(level, 12, 12, 40);
+
+         // slope going up east, leading to higher tile
+         Underworld::TileInfo& slopeInfo = level.GetTilemap().GetTileInfo(13, 14);
+         slopeInfo.m_type = Underworld::tileSlope_e;
+         slopeInfo.m_slope = 24;
+         SetOpenTile(level, 14, 14, 40);
+
+         // water
+         level.GetTilemap().GetTileInfo(14, 11).m_textureFloor = Base::c_stockTexturesFloor + 8;
+
+         // diagonal wall, open to the north east
+         level.GetTilemap().GetTileInfo(11, 14).m_type = Underworld::tileDiagonal_ne;
+
+         // run
+         NavigationGrid grid;
+         grid.Build(level);
+
+         // check
+         const unsigned int canFly = 1 << pathfindFlagCanFly;
+         const unsigned int canSwim = 1 << pathfindFlagCanSwim;
+
+         Assert::IsFalse(grid.CanPass(11, 12, navigationEast, 0), L"high step must block walking");
+         Assert::IsTrue(grid.CanPass(11, 12, navigationEast, canFly), L"high step must not block flying");
+
+         Assert::IsTrue(grid.CanPass(12, 14, navigationEast, 0), L"slope must be walkable");
+         Assert::IsTrue(grid.CanPass(13, 14, navigationEast, 0), L"slope must lead to higher tile");
+         Assert::IsFalse(grid.CanPass(13, 13, navigationNorth, 0), L"slope side must block too high step");
+
+         Assert::IsFalse(grid.CanPass(14, 12, navigationSouth, 0), L"water must block walking");
+         Assert::IsTrue(grid.CanPass(14, 12, navigationSouth, canSwim), L"water must not block swimming");
+         Assert::IsTrue(grid.CanPass(14, 12, navigationSouth, canFly), L"water must not block flying");
+
+         Assert::IsTrue(grid.CanPass(11, 15, navigationSouth, 0), L"open diagonal side must be passable");
+         Assert::IsFalse(grid.CanPass(10, 14, navigationEast, 0), L"diagonal wall must block move");
+         Assert::IsFalse(grid.CanPass(10, 15, navigationSouthEast, 0), L"diagonal wall must block diagonal move");
+      }
+
+      /// Tests finding paths, and updating the grid when a tile is modified.
+      TEST_METHOD(TestFindPath)
+      {
+         // set up; two rooms connected by a corridor at y = 20
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 19, 30);
+
+         for (unsigned int ypos = 10; ypos <= 30; ypos++)
+            if (ypos != 20)
+               level.GetTilemap().GetTileInfo(15, ypos).m_type = Underworld::tileSolid;
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         PathfinderAStar pathfinder{ grid };
+         PathList pathList;
+
+         // run + check
+         Assert::IsTrue(pathfinder.FindPath(12, 12, 18, 12, pathList), L"path must be found");
+         Assert::AreEqual<size_t>(18, pathList.size(), L"path must go through corridor");
+         Assert::IsTrue(pathList.back() == std::make_pair(18u, 12u), L"path must end at target");
+         CheckPath(grid, 0, 12, 12, pathList);
+
+         Assert::IsTrue(pathfinder.FindPath(12, 12, 12, 12, pathList), L"path to start must be found");
+         Assert::IsTrue(pathList.empty(), L"path to start must be empty");
+
+         Assert::IsFalse(pathfinder.FindPath(12, 12, 15, 12, pathList), L"solid tile must not be reachable");
+         Assert::IsFalse(pathfinder.FindPath(12, 12, 40, 40, pathList), L"other area must not be reachable");
+         Assert::IsTrue(pathList.empty(), L"path list must be empty when no path was found");
+
+         // open the wall
+         level.GetTilemap().GetTileInfo(15, 12).m_type = Underworld::tileOpen;
+         grid.UpdateTile(15, 12);
+
+         Assert::IsTrue(pathfinder.FindPath(12, 12, 18, 12, pathList), L"path must be found");
+         Assert::AreEqual<size_t>(6, pathList.size(), L"path must go through opened wall");
+         CheckPath(grid, 0, 12, 12, pathList);
+      }
+
+      /// Tests that the pathfind flags are used.
+      TEST_METHOD(TestFindPathWithFlags)
+      {
+         // set up; room split by a river
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 19, 19);
+
+         for (unsigned int ypos = 10; ypos <= 19; ypos++)
+            level.GetTilemap().GetTileInfo(15, ypos).m_textureFloor = Base::c_stockTexturesFloor + 8;
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         PathfinderAStar pathfinder{ grid };
+         PathList pathList;
+
+         // run + check
+         Assert::IsFalse(pathfinder.FindPath(12, 12, 18, 12, pathList), L"walker must not cross river");
+
+         pathfinder.SetFlag(pathfindFlagCanSwim, true);
+         Assert::IsTrue(pathfinder.FindPath(12, 12, 18, 12, pathList), L"swimmer must cross river");
+         CheckPath(grid, 1 << pathfindFlagCanSwim, 12, 12, pathList);
+
+         pathfinder.SetFlag(pathfindFlagCanSwim, false);
+         Assert::IsFalse(pathfinder.FindPath(12, 12, 18, 12, pathList), L"walker must not cross river");
+      }
+
+      /// Tests that closed doors block moves, and that opening the door
+      /// updates the navigation grid and the sector graph.
+      TEST_METHOD(TestDoors)
+      {
+         // set up; two rooms in different sectors, connected by a door at x = 20
+         Underworld::Level level;
+         CreateRoom(level, 10, 10, 29, 12);
+
+         for (unsigned int ypos = 10; ypos <= 12; ypos++)
+            if (ypos != 11)
+               level.GetTilemap().GetTileInfo(20, ypos).m_type = Underworld::tileSolid;
+
+         Underworld::ObjectPtr door = AddDoor(level, 20, 11, 0x0140);
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         SectorGraph sectorGraph{ grid };
+         sectorGraph.Build();
+
+         PathfinderHierarchical pathfinder{ grid, sectorGraph };
+         PathList pathList;
+
+         // run + check
+         Assert::IsFalse(grid.IsAccessible(20, 11, 0), L"closed door must not be accessible");
+         Assert::IsFalse(pathfinder.FindPath(12, 11, 28, 11, pathList), L"closed door must block path");
+
+         // open the door
+         door->GetObjectInfo().m_itemID = 0x0148;
+         grid.UpdateTile(20, 11);
+         sectorGraph.InvalidateTile(20, 11);
+
+         Assert::IsTrue(sectorGraph.HasInvalidatedSectors());
+         sectorGraph.Update();
+         Assert::IsFalse(sectorGraph.HasInvalidatedSectors());
+
+         Assert::IsTrue(grid.IsAccessible(20, 11, 0), L"open door must be accessible");
+         Assert::AreEqual<unsigned int>(16 * 10,
+            FollowHierarchicalPath(pathfinder, grid, 0, 12, 11, 28, 11),
+            L"path must lead through open door");
+
+         // close it again
+         door->GetObjectInfo().m_itemID = 0x0140;
+         grid.UpdateTile(20, 11);
+         sectorGraph.InvalidateTile(20, 11);
+         sectorGraph.Update();
+
+         Assert::IsFalse(pathfinder.FindPath(12, 11, 28, 11, pathList), L"closed door must block path");
+      }
+
+      /// Tests that the sector graph places entrances on both sides of
+      /// sector borders, and computes costs inside sectors.
+      TEST_METHOD(TestSectorGraph)
+      {
+         // set up; room spanning sectors 0 and 1, with a wall at the border
+         // that has a gap at y = 3
+         Underworld::Level level;
+         CreateRoom(level, 1, 1, 14, 6);
+
+         for (unsigned int ypos = 1; ypos <= 6; ypos++)
+            if (ypos != 3)
+               level.GetTilemap().GetTileInfo(8, ypos).m_type = Underworld::tileSolid;
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         // run
+         SectorGraph sectorGraph{ grid };
+         sectorGraph.Build();
+
+         // check
+         Assert::IsTrue(sectorGraph.IsBuilt());
+
+         const std::vector<Uint16>& nodes0 = sectorGraph.GetSectorNodes(0, 0);
+         const std::vector<Uint16>& nodes1 = sectorGraph.GetSectorNodes(1, 0);
+
+         Assert::AreEqual<size_t>(1, nodes0.size(), L"sector must have one entrance");
+         Assert::AreEqual<size_t>(1, nodes1.size(), L"sector must have one entrance");
+         Assert::AreEqual<unsigned int>(3 * 64 + 7, nodes0[0], L"entrance must be at gap");
+         Assert::AreEqual<unsigned int>(3 * 64 + 8, nodes1[0], L"entrance must be at gap");
+         Assert::AreEqual<size_t>(0, sectorGraph.GetSectorNodes(2, 0).size(), L"solid sector must have no entrance");
+
+         Uint16 costs[SectorGraph::c_numSectorTiles];
+         sectorGraph.GetCostsInSector(3 * 64 + 7, 0, false, costs);
+
+         Assert::AreEqual<unsigned int>(0, costs[SectorGraph::GetSectorTileIndex(3 * 64 + 7)]);
+         Assert::AreEqual<unsigned int>(60, costs[SectorGraph::GetSectorTileIndex(3 * 64 + 1)]);
+         Assert::AreEqual<unsigned int>(SectorGraph::c_unreachable,
+            costs[SectorGraph::GetSectorTileIndex(0)], L"solid tile must be unreachable");
+      }
+
+      /// Tests that the hierarchical pathfinder finds the same targets as
+      /// the A* pathfinder, on paths that are only slightly longer.
+      TEST_METHOD(TestHierarchicalFindPath)
+      {
+         // set up
+         Underworld::Level level;
+         CreateRandomLevel(level, 42, 25);
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         SectorGraph sectorGraph{ grid };
+         sectorGraph.Build();
+
+         PathfinderAStar flatPathfinder{ grid };
+         PathfinderHierarchical pathfinder{ grid, sectorGraph };
+         PathList pathList;
+
+         std::mt19937 random{ 7 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 1, 62 };
+
+         unsigned int flatCost = 0, hierarchicalCost = 0;
+
+         // run + check
+         for (unsigned int query = 0; query < 200; query++)
+         {
+            unsigned int fromx = tilePos(random), fromy = tilePos(random);
+            unsigned int tox = tilePos(random), toy = tilePos(random);
+
+            bool found = flatPathfinder.FindPath(fromx, fromy, tox, toy, pathList);
+            Assert::AreEqual(found, pathfinder.FindPath(fromx, fromy, tox, toy, pathList),
+               L"reachability must match A* pathfinder");
+
+            if (!found || (fromx == tox && fromy == toy))
+               continue;
+
+            flatPathfinder.FindPath(fromx, fromy, tox, toy, pathList);
+            flatCost += GetPathCost(fromx, fromy, pathList);
+
+            hierarchicalCost += FollowHierarchicalPath(pathfinder, grid, 0, fromx, fromy, tox, toy);
+         }
+
+         Assert::IsTrue(flatCost > 0);
+         Assert::IsTrue(hierarchicalCost >= flatCost, L"paths must not be shorter than shortest paths");
+         Assert::IsTrue(hierarchicalCost * 10 <= flatCost * 12, L"paths must be at most 20% longer");
+      }
+
+      /// Measures path queries on a level with random walls, in the size of
+      /// the queries that critters do during a game tick.
+      TEST_METHOD(TestProfilingFindPath)
+      {
+         Underworld::Level level;
+         CreateRandomLevel(level, 42, 25);
+
+         std::mt19937 random{ 42 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 1, 62 };
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+
+         NavigationGrid grid;
+         grid.Build(level);
+
+         Uint64 end = SDL_GetPerformanceCounter();
+         double buildTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         // critters near the player, searching paths to positions nearby
+         std::uniform_int_distribution<int> offset{ -12, 12 };
+
+         std::vector<std::pair<unsigned int, unsigned int>> queries;
+         while (queries.size() < 400 * 2)
+         {
+            unsigned int fromx = tilePos(random), fromy = tilePos(random);
+            unsigned int tox = std::min(62u, unsigned(std::max(1, int(fromx) + offset(random))));
+            unsigned int toy = std::min(62u, unsigned(std::max(1, int(fromy) + offset(random))));
+
+            if (grid.IsAccessible(fromx, fromy, 0) && grid.IsAccessible(tox, toy, 0))
+            {
+               queries.push_back(std::make_pair(fromx, fromy));
+               queries.push_back(std::make_pair(tox, toy));
+            }
+         }
+
+         PathfinderAStar pathfinder{ grid };
+         PathList pathList;
+
+         const int max = 10;
+         size_t numFound = 0, numExpandedNodes = 0;
+
+         begin = SDL_GetPerformanceCounter();
+
+         for (int i = 0; i < max; i++)
+         {
+            for (size_t index = 0; index < queries.size(); index += 2)
+            {
+               if (pathfinder.FindPath(queries[index].first, queries[index].second,
+                  queries[index + 1].first, queries[index + 1].second, pathList))
+                  numFound++;
+
+               numExpandedNodes += pathfinder.GetNumExpandedNodes();
+            }
+         }
+
+         end = SDL_GetPerformanceCounter();
+         double queryTime = double(end - begin) * 1000000.0 / SDL_GetPerformanceFrequency() / max;
+
+         UaTrace("navigation grid build: %1.3f ms\n", buildTime);
+         UaTrace("%zu queries, %zu found: %1.3f us per tick, %zu expanded nodes per tick\n",
+            queries.size() / 2, numFound / max, queryTime, numExpandedNodes / max);
+      }
+
+      /// measures queries between random tiles of all levels, with the A*
+      /// and the hierarchical pathfinder
+      static void ProfileHierarchicalPathfinding(const Underworld::LevelList& levelList, const char* game)
+      {
+         std::mt19937 random{ 42 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 0, 63 };
+
+         const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+         double totalFlatTime = 0.0, totalHierarchicalTime = 0.0;
+         unsigned int numLevels = 0;
+
+         for (size_t levelIndex = 0; levelIndex < levelList.GetNumLevels(); levelIndex++)
+         {
+            const Underworld::Level& level = levelList.GetLevel(levelIndex);
+            if (!level.GetTilemap().IsUsed())
+               continue;
+
+            NavigationGrid grid;
+            grid.Build(level);
+
+            Uint64 begin = SDL_GetPerformanceCounter();
+
+            SectorGraph sectorGraph{ grid };
+            sectorGraph.Build();
+
+            Uint64 end = SDL_GetPerformanceCounter();
+            double buildTime = double(end - begin) * 1000.0 / frequency;
+
+            // queries between connected tiles anywhere on the level
+            std::vector<std::pair<unsigned int, unsigned int>> queries;
+            for (unsigned int tries = 0; tries < 100000 && queries.size() < 200 * 2; tries++)
+            {
+               unsigned int fromx = tilePos(random), fromy = tilePos(random);
+               unsigned int tox = tilePos(random), toy = tilePos(random);
+
+               if (grid.IsAccessible(fromx, fromy, 0) && grid.IsAccessible(tox, toy, 0) &&
+                  grid.IsConnected(fromx, fromy, tox, toy, 0))
+               {
+                  queries.push_back(std::make_pair(fromx, fromy));
+                  queries.push_back(std::make_pair(tox, toy));
+               }
+            }
+
+            if (queries.empty())
+               continue;
+
+            PathfinderAStar flatPathfinder{ grid };
+            PathfinderHierarchical pathfinder{ grid, sectorGraph };
+            PathList pathList;
+
+            size_t flatExpandedNodes = 0, hierarchicalExpandedNodes = 0;
+
+            begin = SDL_GetPerformanceCounter();
+
+            for (size_t index = 0; index < queries.size(); index += 2)
+            {
+               flatPathfinder.FindPath(queries[index].first, queries[index].second,
+                  queries[index + 1].first, queries[index + 1].second, pathList);
+               flatExpandedNodes += flatPathfinder.GetNumExpandedNodes();
+            }
+
+            end = SDL_GetPerformanceCounter();
+            double flatTime = double(end - begin) * 1000000.0 / frequency / (queries.size() / 2);
+
+            begin = SDL_GetPerformanceCounter();
+
+            for (size_t index = 0; index < queries.size(); index += 2)
+            {
+               pathfinder.FindPath(queries[index].first, queries[index].second,
+                  queries[index + 1].first, queries[index + 1].second, pathList);
+               hierarchicalExpandedNodes += pathfinder.GetNumExpandedNodes();
+            }
+
+            end = SDL_GetPerformanceCounter();
+            double hierarchicalTime = double(end - begin) * 1000000.0 / frequency / (queries.size() / 2);
+
+            totalFlatTime += flatTime;
+            totalHierarchicalTime += hierarchicalTime;
+            numLevels++;
+
+            UaTrace("%s level %zu: sector graph build %1.3f ms; per query: A* %1.3f us, %zu nodes, "
+               "hierarchical %1.3f us, %zu nodes\n",
+               game, levelIndex, buildTime,
+               flatTime, flatExpandedNodes * 2 / queries.size(),
+               hierarchicalTime, hierarchicalExpandedNodes * 2 / queries.size());
+         }
+
+         if (numLevels > 0)
+            UaTrace("%s average per query over %u levels: A* %1.3f us, hierarchical %1.3f us\n",
+               game, numLevels, totalFlatTime / numLevels, totalHierarchicalTime / numLevels);
+      }
+
+      /// Measures the latency of path queries with the hierarchical and the
+      /// A* pathfinder, on every level of uw1 and uw2.
+      TEST_METHOD(TestProfilingHierarchicalPathfinding)
+      {
+         Base::Settings& settings = GetTestSettings();
+
+         const char* games[] = { "uw1", "uw2" };
+         for (const char* game : games)
+         {
+            bool isUw2 = std::string(game) == "uw2";
+
+            settings.SetValue(Base::settingGamePrefix, std::string(game));
+            settings.SetValue(Base::settingUnderworldPath,
+               settings.GetString(isUw2 ? Base::settingUw2Path : Base::settingUw1Path));
+
+            Base::ResourceManager resourceManager{ settings };
+            Import::LevelImporter levelImporter(resourceManager);
+
+            Underworld::LevelList levelList;
+            if (isUw2)
+               levelImporter.LoadUw2Levels(levelList);
+            else
+               levelImporter.LoadUw1Levels(levelList);
+
+            ProfileHierarchicalPathfinding(levelList, game);
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,215 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ScaledTextureCacheTest.cpp
+/// \brief tests for the ScaledTextureCache class
+//
+#include "pch.hpp"
+#include "ScaledTextureCache.hpp"
+#include "TempFolder.hpp"
+#include <vector>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief ScaledTextureCache tests
+   /// Tests storing and looking up scaled images in the cache file.
+   TEST_CLASS(ScaledTextureCacheTest)
+   {
+      /// Tests that a stored image can be looked up again, also after
+      /// re-opening the cache file, and that changed images aren't found.
+      TEST_METHOD(TestStoreAndLookup)
+      {
+         // set up
+         TempFolder testFolder;
+         std::string cacheFolder = testFolder.GetPathName() + "/cache/";
+
+         const unsigned int width = 16, height = 16, scaleFactor = 2;
+
+         std::vector<Uint32> source(width * height);
+         for (size_t index = 0; index < source.size(); index++)
+            source[index] = Uint32(index * 7);
+
+         std::vector<Uint32> scaled(source.size() * scaleFactor * scaleFactor);
+         for (size_t index = 0; index < scaled.size(); index++)
+            scaled[index] = Uint32(index * 3 + 1);
+
+         std::vector<Uint32> lookedUp(scaled.size());
+
+         // run
+         {
+            ScaledTextureCache cache;
+            cache.Open(cacheFolder);
+            Assert::IsTrue(cache.IsOpen(), L"cache file must be open");
+
+            Assert::IsFalse(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"empty cache must not contain image");
+
+            cache.Store(source.data(), width, height, scaleFactor, scaled.data());
+
+            Assert::IsTrue(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"stored image must be found");
+            Assert::IsTrue(scaled == lookedUp, L"looked up image must be equal");
+         }
+
+         // check
+         {
+            ScaledTextureCache cache;
+            cache.Open(cacheFolder);
+
+            std::fill(lookedUp.begin(), lookedUp.end(), 0);
+            Assert::IsTrue(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"stored image must be found after re-opening");
+            Assert::IsTrue(scaled == lookedUp, L"looked up image must be equal");
+
+            Assert::IsFalse(cache.Lookup(source.data(), width, height, scaleFactor + 1, lookedUp.data()),
+               L"image with other scale factor must not be found");
+
+            source[42]++;
+            Assert::IsFalse(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"changed image must not be found");
+         }
+      }
+
+      /// Tests that a full cache file keeps its images until it is re-opened,
+      /// and is recreated then, so that new images can be stored again.
+      TEST_METHOD(TestRecreateFullCache)
+      {
+         // set up
+         TempFolder testFolder;
+         std::string cacheFolder = testFolder.GetPathName() + "/cache/";
+
+         const unsigned int width = 16, height = 16, scaleFactor = 2;
+
+         // one record is 32 + 1024 + 4096 bytes long; only two fit
+         const long maxFileSize = 12 * 1024;
+
+         auto createImage = [](unsigned int imageIndex, size_t size, Uint32 factor)
+         {
+            std::vector<Uint32> image(size);
+            for (size_t index = 0; index < size; index++)
+               image[index] = Uint32(index * factor + imageIndex);
+
+            return image;
+         };
+
+         std::vector<Uint32> lookedUp(width * height * scaleFactor * scaleFactor);
+
+         // run
+         {
+            ScaledTextureCache cache{ maxFileSize };
+            cache.Open(cacheFolder);
+
+            for (unsigned int imageIndex = 0; imageIndex < 3; imageIndex++)
+            {
+               std::vector<Uint32> source = createImage(imageIndex, width * height, 7);
+               std::vector<Uint32> scaled = createImage(imageIndex, lookedUp.size(), 3);
+               cache.Store(source.data(), width, height, scaleFactor, scaled.data());
+            }
+
+            Assert::IsTrue(cache.Lookup(createImage(1, width * height, 7).data(),
+               width, height, scaleFactor, lookedUp.data()),
+               L"image stored before the cache was full must be found");
+            Assert::IsFalse(cache.Lookup(createImage(2, width * height, 7).data(),
+               width, height, scaleFactor, lookedUp.data()),
+               L"image not fitting into the cache must not be found");
+         }
+
+         // check
+         {
+            ScaledTextureCache cache{ maxFileSize };
+            cache.Open(cacheFolder);
+
+            Assert::IsFalse(cache.Lookup(createImage(0, width * height, 7).data(),
+               width, height, scaleFactor, lookedUp.data()),
+               L"full cache must have been recreated on re-opening");
+
+            std::vector<Uint32> source = createImage(2, width * height, 7);
+            std::vector<Uint32> scaled = createImage(2, lookedUp.size(), 3);
+            cache.Store(source.data(), width, height, scaleFactor, scaled.data());
+
+            Assert::IsTrue(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"image must be found in recreated cache");
+            Assert::IsTrue(scaled == lookedUp, L"looked up image must be equal");
+         }
+      }
+
+      /// Tests looking up and storing images from multiple threads at once.
+      TEST_METHOD(TestMultipleThreads)
+      {
+         // set up
+         TempFolder testFolder;
+         std::string cacheFolder = testFolder.GetPathName() + "/cache/";
+
+         const unsigned int width = 8, height = 8, scaleFactor = 2;
+         const unsigned int numImages = 16, numThreads = 4;
+
+         ScaledTextureCache cache;
+         cache.Open(cacheFolder);
+
+         auto createImage = [](unsigned int imageIndex, size_t size, Uint32 factor)
+         {
+            std::vector<Uint32> image(size);
+            for (size_t index = 0; index < size; index++)
+               image[index] = Uint32(index * factor + imageIndex);
+
+            return image;
+         };
+
+         // run
+         bool allFound = true;
+         std::vector<std::thread> allThreads;
+         for (unsigned int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+         {
+            allThreads.emplace_back([&]()
+               {
+                  std::vector<Uint32> lookedUp(width * height * scaleFactor * scaleFactor);
+
+                  for (unsigned int imageIndex = 0; imageIndex < numImages; imageIndex++)
+                  {
+                     std::vector<Uint32> source = createImage(imageIndex, width * height, 7);
+                     std::vector<Uint32> scaled = createImage(imageIndex, lookedUp.size(), 3);
+
+                     if (!cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()))
+                        cache.Store(source.data(), width, height, scaleFactor, scaled.data());
+                     else if (scaled != lookedUp)
+                        allFound = false;
+                  }
+               });
+         }
+
+         for (std::thread& thread : allThreads)
+            thread.join();
+
+         // check
+         Assert::IsTrue(allFound, L"looked up images must be equal");
+
+         std::vector<Uint32> lookedUp(width * height * scaleFactor * scaleFactor);
+         for (unsigned int imageIndex = 0; imageIndex < numImages; imageIndex++)
+         {
+            std::vector<Uint32> source = createImage(imageIndex, width * height, 7);
+            Assert::IsTrue(cache.Lookup(source.data(), width, height, scaleFactor, lookedUp.data()),
+               L"stored image must be found");
+            Assert::IsTrue(createImage(imageIndex, lookedUp.size(), 3) == lookedUp,
+               L"looked up image must be equal");
+         }
+      }
+   };
+} // namespace UnitTest
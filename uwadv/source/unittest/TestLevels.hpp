@@ -0,0 +1,81 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TestLevels.hpp
+/// \brief test levels for unit tests
+//
+#pragma once
+
+#include "Level.hpp"
+#include <random>
+
+namespace UnitTest
+{
+   /// Creates a tilemap with all tiles solid, except an open rectangle. The
+   /// open tiles have a floor height of 16 and a ceiling height of 128.
+   inline void CreateRoom(Underworld::Tilemap& tilemap,
+      unsigned int xmin, unsigned int ymin, unsigned int xmax, unsigned int ymax)
+   {
+      tilemap.Create();
+
+      for (unsigned int ypos = ymin; ypos <= ymax; ypos++)
+         for (unsigned int xpos = xmin; xpos <= xmax; xpos++)
+         {
+            Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(xpos, ypos);
+            tileInfo.m_type = Underworld::tileOpen;
+            tileInfo.m_floor = 16;
+            tileInfo.m_ceiling = 128;
+         }
+   }
+
+   /// Creates a level with an empty object list and a tilemap created with
+   /// CreateRoom().
+   inline void CreateRoom(Underworld::Level& level,
+      unsigned int xmin, unsigned int ymin, unsigned int xmax, unsigned int ymax)
+   {
+      CreateRoom(level.GetTilemap(), xmin, ymin, xmax, ymax);
+      level.GetObjectList().Create();
+   }
+
+   /// Creates a level with random walls and water tiles in all tiles but the
+   /// border. The same seed always creates the same level.
+   /// \param level level to create
+   /// \param seed random seed
+   /// \param wallPercent percentage of solid tiles
+   /// \param waterPercent percentage of tiles with a water floor texture
+   inline void CreateRandomLevel(Underworld::Level& level, unsigned int seed,
+      unsigned int wallPercent, unsigned int waterPercent = 0)
+   {
+      CreateRoom(level, 1, 1, 62, 62);
+
+      std::mt19937 random{ seed };
+      std::uniform_int_distribution<unsigned int> percent{ 0, 99 };
+
+      for (unsigned int ypos = 1; ypos < 63; ypos++)
+         for (unsigned int xpos = 1; xpos < 63; xpos++)
+         {
+            Underworld::TileInfo& tileInfo = level.GetTilemap().GetTileInfo(xpos, ypos);
+            if (percent(random) < wallPercent)
+               tileInfo.m_type = Underworld::tileSolid;
+
+            if (waterPercent > 0 && percent(random) < waterPercent)
+               tileInfo.m_textureFloor = Base::c_stockTexturesFloor + 8;
+         }
+   }
+
+} // namespace UnitTest
@@ -0,0 +1,149 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TilePvsTest.cpp
+/// \brief tests for the TilePvs class
+//
+#include "pch.hpp"
+#include "TilePvs.hpp"
+#include "Tilemap.hpp"
+#include "WorkerPool.hpp"
+#include "TestLevels.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief TilePvs tests
+   /// Tests building the potentially visible set of tiles
+   TEST_CLASS(TilePvsTest)
+   {
+      /// Tests that all tiles of an open room are visible from each other,
+      /// and that solid tiles have no visible set.
+      TEST_METHOD(TestOpenRoom)
+      {
+         // set up
+         Underworld::Tilemap tilemap;
+         CreateRoom(tilemap, 10, 10, 15, 15);
+
+         // run
+         Base::WorkerPool workerPool;
+         TilePvs pvs;
+         pvs.Build(tilemap, 16.0, workerPool);
+
+         // check
+         Assert::IsTrue(pvs.IsValid(), L"PVS must be valid");
+         Assert::IsFalse(pvs.IsAvailable(0, 0), L"solid tile must not have a visible set");
+         Assert::IsTrue(pvs.IsAvailable(10, 10), L"open tile must have a visible set");
+
+         for (unsigned int ypos = 10; ypos <= 15; ypos++)
+            for (unsigned int xpos = 10; xpos <= 15; xpos++)
+               Assert::IsTrue(pvs.IsVisible(10, 10, xpos, ypos), L"room tile must be visible");
+
+         Assert::IsFalse(pvs.IsVisible(10, 10, 20, 20), L"tile behind wall must not be visible");
+      }
+
+      /// Tests that a wall between two rooms blocks visibility.
+      TEST_METHOD(TestWallBlocksVisibility)
+      {
+         // set up
+         Underworld::Tilemap tilemap;
+         CreateRoom(tilemap, 10, 10, 20, 12);
+
+         // wall in the middle of the room, with an opening at the upper row
+         tilemap.GetTileInfo(15, 10).m_type = Underworld::tileSolid;
+         tilemap.GetTileInfo(15, 11).m_type = Underworld::tileSolid;
+
+         // run
+         Base::WorkerPool workerPool;
+         TilePvs pvs;
+         pvs.Build(tilemap, 16.0, workerPool);
+
+         // check
+         Assert::IsTrue(pvs.IsVisible(10, 12, 20, 12), L"tile along opening must be visible");
+         Assert::IsTrue(pvs.IsVisible(20, 12, 10, 12), L"visibility must be symmetric");
+         Assert::IsFalse(pvs.IsVisible(11, 10, 19, 10), L"tile behind wall must not be visible");
+      }
+
+      /// Tests that the solid half of a diagonal tile blocks visibility.
+      TEST_METHOD(TestDiagonalBlocksVisibility)
+      {
+         // set up
+         Underworld::Tilemap tilemap;
+         CreateRoom(tilemap, 10, 10, 20, 10);
+
+         // room behind the corridor
+         for (unsigned int ypos = 11; ypos <= 14; ypos++)
+            for (unsigned int xpos = 16; xpos <= 20; xpos++)
+               tilemap.GetTileInfo(xpos, ypos).m_type = Underworld::tileOpen;
+
+         // diagonal tile with open corner to the lower right, blocking the
+         // corridor from the left side; only lines along the corridor's
+         // lower wall touch the open corner
+         tilemap.GetTileInfo(15, 10).m_type = Underworld::tileDiagonal_se;
+
+         // run
+         Base::WorkerPool workerPool;
+         TilePvs pvs;
+         pvs.Build(tilemap, 16.0, workerPool);
+
+         // check
+         Assert::IsTrue(pvs.IsVisible(10, 10, 15, 10), L"diagonal tile itself must be visible");
+         Assert::IsFalse(pvs.IsVisible(10, 10, 19, 13), L"tile behind diagonal wall must not be visible");
+      }
+
+      /// Tests that a tile is visible when the only line of sight passes
+      /// exactly through the corner between two solid tiles.
+      TEST_METHOD(TestLineOfSightThroughCorner)
+      {
+         // set up
+         Underworld::Tilemap tilemap;
+         CreateRoom(tilemap, 10, 10, 20, 20);
+
+         // wall of solid tiles along the diagonal, only touching at corners
+         for (unsigned int pos = 10; pos <= 20; pos++)
+            tilemap.GetTileInfo(pos, pos).m_type = Underworld::tileSolid;
+
+         // run
+         Base::WorkerPool workerPool;
+         TilePvs pvs;
+         pvs.Build(tilemap, 16.0, workerPool);
+
+         // check
+         Assert::IsTrue(pvs.IsVisible(14, 17, 17, 14), L"tile seen through corner must be visible");
+         Assert::IsTrue(pvs.IsVisible(17, 14, 14, 17), L"visibility must be symmetric");
+      }
+
+      /// Tests that tiles farther away than the maximum distance are not visible.
+      TEST_METHOD(TestMaxDistance)
+      {
+         // set up
+         Underworld::Tilemap tilemap;
+         CreateRoom(tilemap, 1, 10, 40, 10);
+
+         // run
+         Base::WorkerPool workerPool;
+         TilePvs pvs;
+         pvs.Build(tilemap, 9.0, workerPool);
+
+         // check
+         Assert::IsTrue(pvs.IsVisible(1, 10, 8, 10), L"near tile must be visible");
+         Assert::IsFalse(pvs.IsVisible(1, 10, 30, 10), L"far tile must not be visible");
+      }
+   };
+} // namespace UnitTest
@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2006,2019,2021 Underworld Adventures Team
+// Copyright (c) 2006,2019,2021,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -25,6 +25,8 @@
 #include "Underworld.hpp"
 #include "ObjectList.hpp"
 #include "Inventory.hpp"
+#include <random>
+#include <atomic>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -192,6 +194,663 @@ namespace UnitTest
          ol.Destroy();
       }
 
+      /// Tests object list functions; objects are copied into the list, keep their
+      /// address when the list is enlarged, and are reset when freed
+      TEST_METHOD(TestObjectList_ObjectStorage)
+      {
+         Underworld::ObjectList ol;
+         ol.Create();
+
+         Underworld::ObjectPtr npc{ new Underworld::NpcObject };
+         npc->GetObjectInfo().m_itemID = 0x0045;
+         npc->GetNpcObject().GetNpcInfo().m_npc_whoami = 42;
+
+         Uint16 npcPos = ol.Allocate();
+         ol.SetObject(npcPos, npc);
+
+         // changing the passed object doesn't change the list
+         npc->GetObjectInfo().m_itemID = 0x0046;
+
+         Underworld::ObjectPtr listNpc = ol.GetObject(npcPos);
+         Assert::IsTrue(listNpc->IsNpcObject());
+         Assert::AreEqual<Uint16>(0x0045, listNpc->GetObjectInfo().m_itemID);
+         Assert::AreEqual<Uint8>(42, listNpc->GetNpcObject().GetNpcInfo().m_npc_whoami);
+
+         Uint16 objectPos = ol.Allocate();
+         Underworld::ObjectPtr object = ol.CreateObject(objectPos, Underworld::objectNormal);
+         Assert::IsFalse(object->IsNpcObject());
+         Assert::IsTrue(Underworld::c_itemIDNone == object->GetObjectInfo().m_itemID);
+
+         // enlarge list
+         Underworld::Object* address = listNpc.get();
+         while (ol.GetObjectListSize() == 0x400)
+            ol.SetObject(ol.Allocate(), Underworld::ObjectPtr(new Underworld::Object));
+
+         Assert::IsTrue(address == ol.GetObject(npcPos).get(), L"object must not be moved");
+
+         // free
+         ol.Free(npcPos);
+         Assert::IsTrue(ol.GetObject(npcPos) == nullptr);
+
+         ol.SetObject(npcPos, Underworld::ObjectPtr(new Underworld::Object));
+         Assert::IsFalse(ol.GetObject(npcPos)->IsNpcObject());
+         Assert::IsTrue(Underworld::c_itemIDNone == ol.GetObject(npcPos)->GetObjectInfo().m_itemID);
+      }
+
+      /// Tests object list functions; saving and loading restores all objects
+      TEST_METHOD(TestObjectList_SaveLoad)
+      {
+         TempFolder testFolder;
+         std::string savegameFile = testFolder.GetPathName() + "/savegame.uas";
+
+         // write savegame
+         {
+            Underworld::ObjectList ol;
+            ol.Create();
+
+            for (Uint16 pos = 1; pos < 0x400; pos += 3)
+            {
+               Underworld::ObjectPtr object = ol.CreateObject(pos,
+                  pos < 0x100 ? Underworld::objectNpc : Underworld::objectNormal);
+
+               object->GetObjectInfo().m_itemID = pos & 0x1ff;
+               object->GetPosInfo().m_zpos = pos & 0x7f;
+
+               if (object->IsNpcObject())
+                  object->GetNpcObject().GetNpcInfo().m_npc_hp = pos & 0xff;
+            }
+
+            ol.AddObjectToTileList(4, 10, 20);
+
+            Base::Savegame savegame(savegameFile, Base::SavegameInfo());
+            ol.Save(savegame);
+         }
+
+         // read back savegame
+         {
+            Base::Savegame savegame(savegameFile);
+
+            Underworld::ObjectList ol;
+            ol.Load(savegame);
+
+            Assert::AreEqual<unsigned int>(0x400, ol.GetObjectListSize());
+            Assert::AreEqual<Uint16>(4, ol.GetListStart(10, 20));
+
+            for (Uint16 pos = 1; pos < 0x400; pos++)
+            {
+               Underworld::ObjectPtr object = ol.GetObject(pos);
+               if ((pos - 1) % 3 != 0)
+               {
+                  Assert::IsTrue(object == nullptr);
+                  continue;
+               }
+
+               Assert::IsTrue(object != nullptr);
+               Assert::AreEqual(pos < 0x100, object->IsNpcObject());
+               Assert::AreEqual<Uint16>(pos & 0x1ff, object->GetObjectInfo().m_itemID);
+               Assert::AreEqual<Uint8>(pos & 0x7f, object->GetPosInfo().m_zpos);
+
+               if (object->IsNpcObject())
+                  Assert::AreEqual<Uint8>(pos & 0xff, object->GetNpcObject().GetNpcInfo().m_npc_hp);
+            }
+         }
+      }
+
+      /// Tests object list functions; radius queries return the same objects as
+      /// searching all tile lists, also after removing objects
+      TEST_METHOD(TestObjectList_QueryRadius)
+      {
+         Underworld::ObjectList ol;
+         ol.Create();
+
+         std::mt19937 random{ 42 };
+         std::uniform_int_distribution<unsigned int> tilePos{ 0, 63 };
+         std::uniform_int_distribution<unsigned int> fractionPos{ 0, 7 };
+         std::uniform_int_distribution<unsigned int> itemID{ 0x0000, 0x01ff };
+
+         std::vector<Uint16> allPos;
+         for (unsigned int index = 0; index < 2000; index++)
+         {
+            Uint16 pos = ol.Allocate();
+            Underworld::ObjectPtr object = ol.CreateObject(pos, Underworld::objectNormal);
+            object->GetObjectInfo().m_itemID = static_cast<Uint16>(itemID(random));
+            object->GetPosInfo().m_xpos = static_cast<Uint8>(fractionPos(random));
+            object->GetPosInfo().m_ypos = static_cast<Uint8>(fractionPos(random));
+
+            ol.AddObjectToTileList(pos,
+               static_cast<Uint8>(tilePos(random)), static_cast<Uint8>(tilePos(random)));
+
+            allPos.push_back(pos);
+         }
+
+         // remove some objects
+         for (size_t index = 0; index < allPos.size(); index += 3)
+         {
+            const Underworld::ObjectPositionInfo& posInfo = ol.GetObject(allPos[index])->GetPosInfo();
+            ol.RemoveObjectFromTileList(allPos[index], posInfo.m_tileX, posInfo.m_tileY);
+         }
+
+         const unsigned int classMasks[] =
+         {
+            1 << Underworld::objectClassNpc,
+            1 << Underworld::objectClassMoveTrigger,
+            (1 << Underworld::objectClassTrap) | (1 << Underworld::objectClassTrigger),
+         };
+
+         std::vector<Uint16> objectPositions;
+         std::uniform_real_distribution<double> position{ -2.0, 66.0 };
+         std::uniform_real_distribution<double> radius{ 0.0, 10.0 };
+
+         for (unsigned int query = 0; query < 200; query++)
+         {
+            double xpos = position(random);
+            double ypos = position(random);
+            double queryRadius = radius(random);
+            unsigned int classMask = classMasks[query % 3];
+
+            ol.QueryRadius(xpos, ypos, queryRadius, classMask, objectPositions);
+            std::sort(objectPositions.begin(), objectPositions.end());
+
+            // search all tile lists
+            std::vector<Uint16> expectedPositions;
+            for (Uint8 tileY = 0; tileY < 64; tileY++)
+               for (Uint8 tileX = 0; tileX < 64; tileX++)
+                  for (Uint16 link = ol.GetListStart(tileX, tileY); link != 0;
+                     link = ol.GetObject(link)->GetObjectInfo().m_link)
+                  {
+                     const Underworld::Object& object = *ol.GetObject(link);
+                     Underworld::ObjectClass objectClass =
+                        Underworld::ObjectSpatialIndex::GetObjectClass(object.GetObjectInfo().m_itemID);
+
+                     if (objectClass == Underworld::objectClassMax ||
+                        (classMask & (1 << objectClass)) == 0)
+                        continue;
+
+                     double dx = tileX + (object.GetPosInfo().m_xpos + 0.5) / 8.0 - xpos;
+                     double dy = tileY + (object.GetPosInfo().m_ypos + 0.5) / 8.0 - ypos;
+                     if (dx * dx + dy * dy <= queryRadius * queryRadius)
+                        expectedPositions.push_back(link);
+                  }
+
+            std::sort(expectedPositions.begin(), expectedPositions.end());
+
+            Assert::IsTrue(expectedPositions == objectPositions, L"query must find all objects in radius");
+         }
+      }
+
+      /// Tests set of free slots; finding the first free slot in large sets
+      TEST_METHOD(TestFreeSlotSet)
+      {
+         Underworld::FreeSlotSet freeSlots;
+         Assert::IsTrue(Underworld::FreeSlotSet::c_noFreeSlot == freeSlots.FindFirstFree());
+
+         freeSlots.Resize(0x10000);
+         Assert::AreEqual<size_t>(0, freeSlots.FindFirstFree());
+
+         for (size_t pos = 0; pos < 0x10000; pos++)
+            freeSlots.SetUsed(pos);
+
+         Assert::IsTrue(Underworld::FreeSlotSet::c_noFreeSlot == freeSlots.FindFirstFree());
+
+         freeSlots.SetFree(0xfffe);
+         freeSlots.SetFree(0x1041);
+         Assert::AreEqual<size_t>(0x1041, freeSlots.FindFirstFree());
+
+         freeSlots.SetUsed(0x1041);
+         Assert::AreEqual<size_t>(0xfffe, freeSlots.FindFirstFree());
+
+         // shrinking removes free slots past the end
+         freeSlots.Resize(0x1000);
+         Assert::IsTrue(Underworld::FreeSlotSet::c_noFreeSlot == freeSlots.FindFirstFree());
+
+         freeSlots.Resize(0x1010);
+         Assert::AreEqual<size_t>(0x1000, freeSlots.FindFirstFree());
+         Assert::IsTrue(freeSlots.IsFree(0x100f));
+         Assert::IsFalse(freeSlots.IsFree(0x0fff));
+      }
+
+      /// Tests object list functions; allocation returns the lowest free position,
+      /// and doesn't return allocated positions again before they are freed
+      TEST_METHOD(TestObjectList_AllocateLowestFree)
+      {
+         Underworld::ObjectList ol;
+         ol.Create();
+
+         Uint16 pos1 = ol.Allocate();
+         Uint16 pos2 = ol.Allocate();
+         Uint16 pos3 = ol.Allocate();
+
+         Assert::AreEqual<Uint16>(1, pos1);
+         Assert::AreEqual<Uint16>(2, pos2, L"allocated slot must not be returned again");
+         Assert::AreEqual<Uint16>(3, pos3);
+
+         ol.CreateObject(pos1, Underworld::objectNormal);
+         ol.CreateObject(pos2, Underworld::objectNormal);
+         ol.CreateObject(pos3, Underworld::objectNormal);
+
+         ol.Free(pos2);
+         Assert::AreEqual<Uint16>(pos2, ol.Allocate());
+         ol.CreateObject(pos2, Underworld::objectNormal);
+
+         // slots set without allocating aren't allocated again
+         ol.CreateObject(5, Underworld::objectNpc);
+         Assert::AreEqual<Uint16>(4, ol.Allocate());
+         Assert::AreEqual<Uint16>(6, ol.Allocate());
+
+         // compacting releases slots that were allocated but never set
+         ol.Compact();
+         Assert::AreEqual<Uint16>(4, ol.Allocate());
+      }
+
+      /// Tests inventory functions; allocation returns the lowest free position
+      TEST_METHOD(TestInventory_AllocateLowestFree)
+      {
+         Underworld::Inventory inv;
+         inv.Destroy();
+         inv.Create();
+
+         Uint16 pos1 = inv.Allocate();
+         Uint16 pos2 = inv.Allocate();
+         Assert::AreEqual<Uint16>(Underworld::slotMax, pos1);
+         Assert::AreEqual<Uint16>(Underworld::slotMax + 1, pos2);
+
+         inv.GetObjectInfo(pos1).m_itemID = 0x0001;
+         inv.GetObjectInfo(pos2).m_itemID = 0x0002;
+
+         // slots used by setting object infos directly aren't allocated
+         inv.GetObjectInfo(pos2 + 1).m_itemID = 0x0003;
+         Assert::AreEqual<Uint16>(pos2 + 2, inv.Allocate());
+
+         inv.Free(pos1);
+         Assert::AreEqual<Uint16>(pos1, inv.Allocate());
+      }
+
+      /// Measures allocating and freeing many objects, in the object list and
+      /// in the inventory, e.g. when scripts spawn and remove objects
+      TEST_METHOD(TestProfilingAllocateFree)
+      {
+         const unsigned int numObjects = 50000;
+         const unsigned int numRounds = 10;
+
+         std::vector<Uint16> allPos;
+         allPos.reserve(numObjects);
+
+         // object list
+         Uint64 begin = SDL_GetPerformanceCounter();
+
+         Underworld::ObjectList ol;
+         ol.Create();
+
+         for (unsigned int index = 0; index < numObjects; index++)
+         {
+            Uint16 pos = ol.Allocate();
+            ol.CreateObject(pos, Underworld::objectNormal);
+            allPos.push_back(pos);
+         }
+
+         for (unsigned int round = 0; round < numRounds; round++)
+         {
+            // free every other object, then allocate them again
+            for (size_t index = round & 1; index < allPos.size(); index += 2)
+               ol.Free(allPos[index]);
+
+            for (size_t index = round & 1; index < allPos.size(); index += 2)
+            {
+               allPos[index] = ol.Allocate();
+               ol.CreateObject(allPos[index], Underworld::objectNormal);
+            }
+         }
+
+         Uint64 end = SDL_GetPerformanceCounter();
+         double objectListTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         // inventory
+         allPos.clear();
+
+         begin = SDL_GetPerformanceCounter();
+
+         Underworld::Inventory inv;
+         inv.Destroy();
+         inv.Create();
+
+         for (unsigned int index = 0; index < numObjects; index++)
+         {
+            Uint16 pos = inv.Allocate();
+            inv.GetObjectInfo(pos).m_itemID = 0x0001;
+            allPos.push_back(pos);
+         }
+
+         for (unsigned int round = 0; round < numRounds; round++)
+         {
+            for (size_t index = round & 1; index < allPos.size(); index += 2)
+               inv.Free(allPos[index]);
+
+            for (size_t index = round & 1; index < allPos.size(); index += 2)
+            {
+               allPos[index] = inv.Allocate();
+               inv.GetObjectInfo(allPos[index]).m_itemID = 0x0001;
+            }
+         }
+
+         end = SDL_GetPerformanceCounter();
+         double inventoryTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         UaTrace("allocating %u objects and freeing/allocating half of them %u times: "
+            "object list %1.3f ms, inventory %1.3f ms\n",
+            numObjects, numRounds, objectListTime, inventoryTime);
+      }
+
+      /// Measures loading an object list from a savegame and iterating over
+      /// all objects, as done every frame when managing critter frames
+      TEST_METHOD(TestProfilingObjectList)
+      {
+         TempFolder testFolder;
+         std::string savegameFile = testFolder.GetPathName() + "/savegame.uas";
+
+         {
+            Underworld::ObjectList ol;
+            ol.Create();
+
+            for (Uint16 pos = 1; pos < 0x400; pos++)
+               ol.CreateObject(pos, pos < 0x100 ? Underworld::objectNpc : Underworld::objectNormal)
+                  ->GetObjectInfo().m_itemID = pos & 0xff;
+
+            Base::Savegame savegame(savegameFile, Base::SavegameInfo());
+            for (unsigned int level = 0; level < 9; level++)
+               ol.Save(savegame);
+         }
+
+         Base::Savegame savegame(savegameFile);
+         Underworld::ObjectList levelObjectLists[9];
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+
+         for (Underworld::ObjectList& ol : levelObjectLists)
+            ol.Load(savegame);
+
+         Uint64 end = SDL_GetPerformanceCounter();
+         double loadTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         const unsigned int numFrames = 1000;
+         unsigned int numCritters = 0;
+
+         begin = SDL_GetPerformanceCounter();
+
+         const Underworld::ObjectList& ol = levelObjectLists[0];
+         for (unsigned int frame = 0; frame < numFrames; frame++)
+         {
+            Uint16 max = ol.GetObjectListSize();
+            for (Uint16 pos = 1; pos < max; pos++)
+            {
+               const Underworld::ObjectPtr object = ol.GetObject(pos);
+               if (object == nullptr)
+                  continue;
+
+               Uint16 itemID = object->GetObjectInfo().m_itemID;
+               if (itemID >= 0x0040 && itemID < 0x0080)
+                  numCritters++;
+            }
+         }
+
+         end = SDL_GetPerformanceCounter();
+         double iterateTime = double(end - begin) * 1000000.0 / SDL_GetPerformanceFrequency() / numFrames;
+
+         UaTrace("loading 9 object lists: %1.3f ms, iterating object list: %1.3f us, %u critters\n",
+            loadTime, iterateTime, numCritters / numFrames);
+      }
+
+      /// creates a level list where level n has a teleport trap to level n+1,
+      /// and counts how often levels are loaded
+      static void CreateLazyLevelList(Underworld::LevelList& levelList,
+         size_t numLevels, std::atomic<unsigned int>& numLoads)
+      {
+         levelList.Create(numLevels,
+            [numLevels, &numLoads](size_t levelIndex, Underworld::Level& level)
+            {
+               numLoads++;
+
+               level.GetTilemap().Create();
+               level.GetTilemap().GetTileInfo(1, 1).m_floor = static_cast<Uint16>(levelIndex);
+               level.GetObjectList().Create();
+
+               if (levelIndex + 1 < numLevels)
+               {
+                  Underworld::ObjectPtr trap = level.GetObjectList().CreateObject(1, Underworld::objectNormal);
+                  trap->GetObjectInfo().m_itemID = 0x0181;
+                  trap->GetPosInfo().m_zpos = static_cast<Uint8>(levelIndex + 2);
+               }
+            });
+      }
+
+      /// Tests loading levels when first accessed, and loading connected
+      /// levels in the background
+      TEST_METHOD(TestLevelList_LazyLoading)
+      {
+         // set up
+         std::atomic<unsigned int> numLoads{ 0 };
+         Underworld::LevelList levelList;
+         CreateLazyLevelList(levelList, 6, numLoads);
+
+         // run + check
+         Assert::AreEqual<size_t>(6, levelList.GetNumLevels());
+         Assert::AreEqual<size_t>(0, levelList.GetNumLoadedLevels(), L"levels must not be loaded on creation");
+         Assert::AreEqual(0u, numLoads.load());
+
+         const Underworld::LevelList& constLevelList = levelList;
+         Assert::AreEqual<Uint16>(2, constLevelList.GetLevel(2).GetTilemap().GetTileInfo(1, 1).m_floor);
+         Assert::IsTrue(levelList.IsLevelLoaded(2));
+         Assert::AreEqual(1u, numLoads.load());
+
+         std::vector<size_t> connectedLevels;
+         constLevelList.GetLevel(2).GetConnectedLevels(connectedLevels);
+         Assert::AreEqual<size_t>(1, connectedLevels.size());
+         Assert::AreEqual<size_t>(3, connectedLevels[0]);
+
+         levelList.PrefetchConnectedLevels(2);
+         Assert::AreEqual<Uint16>(3, constLevelList.GetLevel(3).GetTilemap().GetTileInfo(1, 1).m_floor);
+         Assert::AreEqual(2u, numLoads.load(), L"prefetched level must only be loaded once");
+      }
+
+      /// Tests unloading least recently used levels that weren't modified
+      TEST_METHOD(TestLevelList_UnloadLeastRecentlyUsed)
+      {
+         // set up
+         std::atomic<unsigned int> numLoads{ 0 };
+         Underworld::LevelList levelList;
+         CreateLazyLevelList(levelList, 6, numLoads);
+         levelList.SetMaxLoadedLevels(2);
+
+         const Underworld::LevelList& constLevelList = levelList;
+
+         // run
+         levelList.GetLevel(0).GetTilemap().GetTileInfo(1, 1).m_floor = 42;
+         levelList.SetLevelModified(0);
+         levelList.GetLevel(1);
+         constLevelList.GetLevel(2);
+         constLevelList.GetLevel(3);
+
+         Assert::AreEqual<size_t>(4, levelList.GetNumLoadedLevels(), L"accessing levels must not unload levels");
+
+         // the last level has no connected levels to load in the background
+         levelList.PrefetchConnectedLevels(5);
+
+         // check
+         Assert::AreEqual<size_t>(2, levelList.GetNumLoadedLevels());
+         Assert::IsTrue(levelList.IsLevelLoaded(0), L"modified level must stay loaded");
+         Assert::IsTrue(levelList.IsLevelLoaded(5), L"prefetch level must stay loaded");
+         Assert::IsFalse(levelList.IsLevelLoaded(1), L"accessed level must not be treated as modified");
+         Assert::IsFalse(levelList.IsLevelLoaded(2));
+         Assert::IsFalse(levelList.IsLevelLoaded(3));
+
+         Assert::AreEqual<Uint16>(1, constLevelList.GetLevel(1).GetTilemap().GetTileInfo(1, 1).m_floor);
+         Assert::AreEqual(6u, numLoads.load(), L"unloaded level must be loaded again");
+         Assert::AreEqual<Uint16>(42, constLevelList.GetLevel(0).GetTilemap().GetTileInfo(1, 1).m_floor);
+      }
+
+      /// Tests that savegames only store modified levels, and that the other
+      /// levels are loaded again after loading the savegame
+      TEST_METHOD(TestLevelList_SaveLoadModifiedLevels)
+      {
+         TempFolder testFolder;
+         std::string savegameFile = testFolder.GetPathName() + "/savegame.uas";
+
+         std::atomic<unsigned int> numLoads{ 0 };
+
+         {
+            Underworld::LevelList levelList;
+            CreateLazyLevelList(levelList, 4, numLoads);
+
+            const Underworld::LevelList& constLevelList = levelList;
+            constLevelList.GetLevel(1);
+            levelList.GetLevel(3);
+            levelList.GetLevel(2).GetTilemap().GetTileInfo(1, 1).m_floor = 42;
+            levelList.SetLevelModified(2);
+
+            Base::Savegame savegame(savegameFile, Base::SavegameInfo());
+            levelList.Save(savegame);
+         }
+
+         numLoads = 0;
+
+         Base::Savegame savegame(savegameFile);
+         Underworld::LevelList levelList;
+         CreateLazyLevelList(levelList, 4, numLoads);
+         levelList.Load(savegame);
+
+         Assert::AreEqual<size_t>(4, levelList.GetNumLevels());
+         Assert::AreEqual<size_t>(1, levelList.GetNumLoadedLevels(), L"only modified level must be stored");
+         Assert::AreEqual<Uint16>(42, levelList.GetLevel(2).GetTilemap().GetTileInfo(1, 1).m_floor);
+         Assert::AreEqual(0u, numLoads.load());
+
+         Assert::AreEqual<Uint16>(1, levelList.GetLevel(1).GetTilemap().GetTileInfo(1, 1).m_floor);
+         Assert::AreEqual(1u, numLoads.load());
+      }
+
+      /// Tests saving and loading tilemap, including tile flags and used
+      /// textures
+      TEST_METHOD(TestTilemap_SaveLoad)
+      {
+         TempFolder testFolder;
+         std::string savegameFile = testFolder.GetPathName() + "/savegame.uas";
+
+         {
+            Underworld::Tilemap tilemap;
+            tilemap.Create();
+
+            Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(3, 4);
+            tileInfo.m_type = Underworld::tileSlope_s;
+            tileInfo.m_floor = 40;
+            tileInfo.m_slope = 2;
+            tileInfo.m_textureWall = 0x0012;
+            tileInfo.m_textureFloor = Base::c_stockTexturesFloor + 5;
+            tileInfo.m_isDoorPresent = true;
+            tileInfo.m_isSpecialLightFeature = true;
+            tileInfo.m_automapFlag = Underworld::automapWater;
+
+            Base::Savegame savegame(savegameFile, Base::SavegameInfo());
+            tilemap.Save(savegame);
+         }
+
+         Base::Savegame savegame(savegameFile);
+         Underworld::Tilemap tilemap;
+         tilemap.Load(savegame);
+
+         const Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(3, 4);
+         Assert::AreEqual<int>(Underworld::tileSlope_s, tileInfo.m_type);
+         Assert::AreEqual<Uint16>(40, tileInfo.m_floor);
+         Assert::AreEqual<Uint16>(128, tileInfo.m_ceiling);
+         Assert::AreEqual<Uint8>(2, tileInfo.m_slope);
+         Assert::AreEqual<Uint16>(0x0012, tileInfo.m_textureWall);
+         Assert::IsFalse(tileInfo.m_isMagicDisabled);
+         Assert::IsTrue(tileInfo.m_isDoorPresent);
+         Assert::IsTrue(tileInfo.m_isSpecialLightFeature);
+         Assert::AreEqual<int>(Underworld::automapWater, tileInfo.m_automapFlag);
+
+         Assert::IsTrue(&tileInfo == &tilemap.GetTileInfo(3 + 64, 4 + 64), L"coordinates must wrap around");
+
+         const Underworld::TileTexturesSet& usedTextures = tilemap.GetUsedTextures();
+         Assert::IsTrue(usedTextures.test(0x0012));
+         Assert::IsTrue(usedTextures.test(Base::c_stockTexturesWall));
+         Assert::IsTrue(usedTextures.test(Base::c_stockTexturesFloor));
+         Assert::IsTrue(usedTextures.test(Base::c_stockTexturesFloor + 5));
+         Assert::AreEqual<size_t>(4, usedTextures.count());
+      }
+
+      /// Measures loading the tilemaps of all levels, and going over all
+      /// tiles of a level, like geometry generation and automap do.
+      TEST_METHOD(TestProfilingTilemapTraversal)
+      {
+         TempFolder testFolder;
+         std::string savegameFile = testFolder.GetPathName() + "/savegame.uas";
+
+         {
+            Underworld::Tilemap tilemap;
+            tilemap.Create();
+
+            std::mt19937 random{ 42 };
+            std::uniform_int_distribution<unsigned int> tileType{ Underworld::tileSolid, Underworld::tileSlope_w };
+            std::uniform_int_distribution<unsigned int> texture{ 0, 15 };
+
+            for (Underworld::TileInfo& tileInfo : tilemap.GetVectorTileInfo())
+            {
+               tileInfo.m_type = static_cast<Underworld::TilemapTileType>(tileType(random));
+               tileInfo.m_floor = static_cast<Uint16>(texture(random) * 8);
+               tileInfo.m_textureWall = static_cast<Uint16>(texture(random) * 4);
+               tileInfo.m_textureFloor = static_cast<Uint16>(Base::c_stockTexturesFloor + texture(random));
+               tileInfo.m_isDoorPresent = texture(random) == 0;
+            }
+
+            Base::Savegame savegame(savegameFile, Base::SavegameInfo());
+            for (unsigned int level = 0; level < 9; level++)
+               tilemap.Save(savegame);
+         }
+
+         Base::Savegame savegame(savegameFile);
+         Underworld::Tilemap levelTilemaps[9];
+
+         Uint64 begin = SDL_GetPerformanceCounter();
+
+         for (Underworld::Tilemap& tilemap : levelTilemaps)
+            tilemap.Load(savegame);
+
+         Uint64 end = SDL_GetPerformanceCounter();
+         double loadTime = double(end - begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+         const unsigned int numFrames = 1000;
+         unsigned int numOpenTiles = 0, numDoors = 0, numWater = 0;
+         double sumHeight = 0.0;
+
+         begin = SDL_GetPerformanceCounter();
+
+         const Underworld::Tilemap& tilemap = levelTilemaps[0];
+         for (unsigned int frame = 0; frame < numFrames; frame++)
+         {
+            for (unsigned int ypos = 0; ypos < Underworld::c_underworldTilemapSize; ypos++)
+               for (unsigned int xpos = 0; xpos < Underworld::c_underworldTilemapSize; xpos++)
+               {
+                  const Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(xpos, ypos);
+                  if (tileInfo.m_type != Underworld::tileSolid)
+                     numOpenTiles++;
+
+                  if (tileInfo.m_isDoorPresent)
+                     numDoors++;
+
+                  if (tileInfo.m_textureFloor == Base::c_stockTexturesFloor + 8)
+                     numWater++;
+
+                  sumHeight += tilemap.GetFloorHeight(xpos + 0.5, ypos + 0.5);
+               }
+         }
+
+         end = SDL_GetPerformanceCounter();
+         double traverseTime = double(end - begin) * 1000000.0 / SDL_GetPerformanceFrequency() / numFrames;
+
+         UaTrace("loading 9 tilemaps: %1.3f ms, traversing tilemap: %1.3f us, "
+            "tile size %zu bytes, %u open, %u doors, %u water, height sum %1.0f\n",
+            loadTime, traverseTime, sizeof(Underworld::TileInfo),
+            numOpenTiles / numFrames, numDoors / numFrames, numWater / numFrames, sumHeight / numFrames);
+      }
+
       /// Tests inventory functions; simple object allocation
       TEST_METHOD(TestInventory_ObjectAlloc)
       {
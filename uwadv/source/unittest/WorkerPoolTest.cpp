@@ -0,0 +1,86 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2023 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorkerPoolTest.cpp
+/// \brief tests for the WorkerPool class
+//
+#include "pch.hpp"
+#include "WorkerPool.hpp"
+#include <stdexcept>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief WorkerPool tests
+   /// Tests running work items on worker threads with Base::WorkerPool.
+   TEST_CLASS(WorkerPoolTest)
+   {
+      /// Tests that all work items are processed exactly once, in multiple runs
+      TEST_METHOD(TestAllItemsProcessed)
+      {
+         Base::WorkerPool pool{ 4 };
+
+         for (unsigned int run = 0; run < 100; run++)
+         {
+            std::vector<unsigned int> itemCounts(1000, 0);
+
+            pool.Run(itemCounts.size(), [&](size_t item) { itemCounts[item]++; });
+
+            for (unsigned int count : itemCounts)
+               Assert::AreEqual(1u, count, L"each item must be processed exactly once");
+         }
+      }
+
+      /// Tests that a pool without worker threads processes items, too
+      TEST_METHOD(TestNoWorkerThreads)
+      {
+         Base::WorkerPool pool{ 0 };
+         Assert::AreEqual(0u, pool.GetNumThreads());
+
+         std::vector<unsigned int> itemCounts(10, 0);
+         pool.Run(itemCounts.size(), [&](size_t item) { itemCounts[item]++; });
+
+         for (unsigned int count : itemCounts)
+            Assert::AreEqual(1u, count, L"each item must be processed exactly once");
+      }
+
+      /// Tests that an exception thrown by a work item is passed to the caller
+      TEST_METHOD(TestExceptionInWorkItem)
+      {
+         Base::WorkerPool pool{ 2 };
+
+         Assert::ExpectException<std::runtime_error>(
+            [&]()
+            {
+               pool.Run(100, [](size_t item)
+                  {
+                     if (item == 42)
+                        throw std::runtime_error("work item failed");
+                  });
+            });
+
+         // pool must still be usable
+         std::vector<unsigned int> itemCounts(10, 0);
+         pool.Run(itemCounts.size(), [&](size_t item) { itemCounts[item]++; });
+
+         for (unsigned int count : itemCounts)
+            Assert::AreEqual(1u, count);
+      }
+   };
+} // namespace UnitTest
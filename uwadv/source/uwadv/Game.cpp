@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2005,2006,2019,2022 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2005,2006,2019,2022,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -28,6 +28,8 @@
 #include "screens/StartSplashScreen.hpp"
 #include "import/Import.hpp"
 #include "import/GameStringsImporter.hpp"
+#include "FrameProfiler.hpp"
+#include <algorithm>
 #include <ctime>
 #include <SDL2/SDL.h>
 
@@ -274,6 +276,8 @@ void Game::OnTick(bool& resetTickTimer)
 
 void Game::OnRender()
 {
+   m_renderer.SetTickInterpolation(GetTickInterpolation());
+
    // draw the screen
    m_gameScreenHost.GetCurrentScreen()->Draw();
    m_renderWindow->SwapBuffers();
@@ -311,6 +315,29 @@ void Game::InitSDL()
    m_viewport = std::make_unique<Viewport>(*m_renderWindow.get());
 
    m_renderer.SetViewport(m_viewport.get());
+
+   // set up frame pacing
+   {
+      const Base::Settings& settings = m_gameInstance.GetSettings();
+      bool useVsync = settings.GetBool(Base::settingVsync);
+      int frameRateLimit = std::max(0, settings.GetInt(Base::settingFrameRateLimit));
+
+      bool vsyncAvailable = m_renderWindow->SetVsync(useVsync);
+
+      // without vsync, don't render more frames than the display can show,
+      // and don't spin the main loop at full speed
+      if (!(useVsync && vsyncAvailable) && frameRateLimit == 0)
+      {
+         unsigned int refreshRate = m_renderWindow->GetDisplayRefreshRate();
+         frameRateLimit = refreshRate > 0 ? static_cast<int>(refreshRate) : 60;
+      }
+
+      SetFrameRateLimit(static_cast<unsigned int>(frameRateLimit));
+
+      UaTrace("frame pacing: vsync %s, frame rate limit %i fps\n",
+         useVsync ? (vsyncAvailable ? "on" : "not available") : "off",
+         frameRateLimit);
+   }
 }
 
 void Game::OnEvent(SDL_Event& event)
@@ -328,6 +355,10 @@ void Game::OnEvent(SDL_Event& event)
       if (event.key.keysym.sym == SDLK_RETURN &&
          (event.key.keysym.mod & KMOD_ALT) != 0)
          ToggleFullscreen();
+
+      if (event.key.keysym.sym == SDLK_p &&
+         (event.key.keysym.mod & KMOD_ALT) != 0)
+         WriteFrameProfile();
       break;
 
    case SDL_USEREVENT:
@@ -370,3 +401,28 @@ void Game::ClearScreen()
    m_renderWindow->Clear();
    m_renderWindow->SwapBuffers();
 }
+
+/// Writes the frames recently recorded by the frame profiler as CSV file and
+/// as Chrome trace file into the home folder, and traces the frame time
+/// statistics.
+void Game::WriteFrameProfile()
+{
+   const Base::FrameProfiler& profiler = Base::FrameProfiler::GetInstance();
+
+   Base::FrameTimeStatistics statistics = profiler.CalcStatistics();
+   UaTrace("frame times of last %u frames: average %.2f ms, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+      statistics.m_numFrames,
+      statistics.m_averageTime,
+      statistics.m_percentile50,
+      statistics.m_percentile90,
+      statistics.m_percentile99,
+      statistics.m_maxTime);
+
+   std::string basePath = m_gameInstance.GetResourceManager().GetHomePath() + "frame-profile";
+
+   if (profiler.WriteCsv(basePath + ".csv") &&
+      profiler.WriteChromeTrace(basePath + ".json"))
+      UaTrace("wrote frame profile to %s.csv and %s.json\n", basePath.c_str(), basePath.c_str());
+   else
+      UaTrace("couldn't write frame profile to %s.csv and .json\n", basePath.c_str());
+}
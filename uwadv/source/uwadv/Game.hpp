@@ -1,6 +1,6 @@
 //
 // Underworld Adventures - an Ultima Underworld remake project
-// Copyright (c) 2002,2003,2004,2019 Underworld Adventures Team
+// Copyright (c) 2002,2003,2004,2019,2023 Underworld Adventures Team
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -118,6 +118,9 @@ private:
    /// clears screen with black color
    void ClearScreen();
 
+   /// writes frame profile files and traces frame time statistics
+   void WriteFrameProfile();
+
 private:
    /// game instance
    GameInstance m_gameInstance;